@@ -29,11 +29,15 @@
 //             This application uses the files from the 'Public Domain'
 //             1-Wire Net libraries ('general' and 'userial').
 //
-//  Version: 2.00
+//  Version: 2.01
+//
+//  History: 2.00 -> 2.01  Poll all of the counters with ReadCounterAll
+//                         and show the rate of each.
 //
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "ownet.h"
 #include "cnt1d.h"
 #include "findtype.h"
@@ -44,15 +48,16 @@
 // global serial numbers
 uchar FamilySN[MAXDEVICES][8];
 
+// the 4 counters of each device
+CounterReading Readings[MAXDEVICES * 4];
+
 //----------------------------------------------------------------------
 //  Main Test for the DS2423 - counter
 //
 int main(int argc, char **argv)
 {
    int NumDevices=0;
-   int i;
-   int CounterPage;
-   ulong Count;
+   int i,j;
    int portnum=0;
 
    //------------------------------------------------------
@@ -98,21 +103,32 @@ int main(int argc, char **argv)
       }
       printf("\n\n");
 
+      // counters on pages 12 to 15 of each device
+      for (i = 0; i < NumDevices; i++)
+         for (j = 0; j < 4; j++)
+         {
+            memcpy(Readings[i * 4 + j].SerialNum,FamilySN[i],8);
+            Readings[i * 4 + j].CounterPage = 12 + j;
+            Readings[i * 4 + j].Valid = FALSE;
+         }
+
       // (stops on CTRL-C)
       do
       {
          // read the current counters
+         ReadCounterAll(portnum, Readings, NumDevices * 4);
+
          for (i = 0; i < NumDevices; i++)
          {
             printf("\n");
             PrintSerialNum(FamilySN[i]);
 
-            for (CounterPage = 12; CounterPage <= 15; CounterPage++)
+            for (j = 0; j < 4; j++)
             {
-               if (ReadCounter(portnum, FamilySN[i], CounterPage, &Count))
-               {
-                   printf(" %10ld  ", Count);
-               }
+               CounterReading *cr = &Readings[i * 4 + j];
+
+               if (cr->Status == CNT_OK)
+                  printf(" %10ld (%8.2f/s) ", cr->Count, cr->Rate);
                else
                   printf("\nError reading counter, verify device present:%d\n",
                   (int)owVerify(portnum,FALSE));
@@ -0,0 +1,187 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  crcbench.c - Application to check and time the block CRC functions.
+//               crc8_block and crc16_block are compared with the byte at
+//               a time docrc8/docrc16 and with a bit at a time reference
+//               over random blocks of every length up to MAXLEN and each
+//               is timed over the same data.  No 1-Wire Net is needed.
+//
+//               This application uses the files from the 'Public Domain'
+//               1-Wire Net libraries ('general' or 'userial').
+//
+//  Version: 3.00
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ownet.h"
+#include "owtime.h"
+
+// longest block checked, size of the timed buffer and times it is done
+#define MAXLEN         300
+#define BENCHLEN       4096
+#define BENCHLOOPS     2000
+
+// local functions
+static uchar  RefCRC8(uchar crc, uchar *buf, int len);
+static ushort RefCRC16(ushort crc, uchar *buf, int len);
+
+//----------------------------------------------------------------------
+//  Main for crcbench
+//
+int main(int argc, char **argv)
+{
+   static uchar buf[BENCHLEN];
+   long long start, t_byte8, t_block8, t_byte16, t_block16;
+   int len,i,n,bad = 0;
+   uchar crc8 = 0, *blk, seed8;
+   ushort crc16 = 0, seed16;
+
+   srand(1);
+   for (i = 0; i < BENCHLEN; i++)
+      buf[i] = (uchar)rand();
+
+   // every length with a few seeds, all three must agree
+   for (len = 0; len <= MAXLEN; len++)
+   {
+      for (n = 0; n < 4; n++)
+      {
+         blk = &buf[(len * 7 + n * 13) % (BENCHLEN - MAXLEN)];
+         seed8 = (uchar)(n * 0x55);
+         seed16 = (ushort)(n * 0x1234);
+
+         setcrc8(0,seed8);
+         crc8 = seed8;
+         for (i = 0; i < len; i++)
+            crc8 = docrc8(0,blk[i]);
+         if ((crc8 != crc8_block(seed8,blk,len)) ||
+             (crc8 != RefCRC8(seed8,blk,len)))
+         {
+            printf("CRC8 mismatch, length %d seed %02X\n",len,seed8);
+            bad++;
+         }
+
+         setcrc16(0,seed16);
+         crc16 = seed16;
+         for (i = 0; i < len; i++)
+            crc16 = docrc16(0,blk[i]);
+         if ((crc16 != crc16_block(seed16,blk,len)) ||
+             (crc16 != RefCRC16(seed16,blk,len)))
+         {
+            printf("CRC16 mismatch, length %d seed %04X\n",len,seed16);
+            bad++;
+         }
+      }
+   }
+   printf("lengths 0 to %d checked, %d mismatches\n",MAXLEN,bad);
+
+   // time each over the same buffer
+   start = usGettick();
+   for (n = 0; n < BENCHLOOPS; n++)
+   {
+      setcrc8(0,crc8);
+      for (i = 0; i < BENCHLEN; i++)
+         crc8 = docrc8(0,buf[i]);
+   }
+   t_byte8 = usGettick() - start;
+
+   start = usGettick();
+   for (n = 0; n < BENCHLOOPS; n++)
+      crc8 = crc8_block(crc8,buf,BENCHLEN);
+   t_block8 = usGettick() - start;
+
+   start = usGettick();
+   for (n = 0; n < BENCHLOOPS; n++)
+   {
+      setcrc16(0,crc16);
+      for (i = 0; i < BENCHLEN; i++)
+         crc16 = docrc16(0,buf[i]);
+   }
+   t_byte16 = usGettick() - start;
+
+   start = usGettick();
+   for (n = 0; n < BENCHLOOPS; n++)
+      crc16 = crc16_block(crc16,buf,BENCHLEN);
+   t_block16 = usGettick() - start;
+
+   printf("CRC8   docrc8  %8.2f ns/byte   crc8_block  %8.2f ns/byte\n",
+          t_byte8 * 1000.0 / ((double)BENCHLOOPS * BENCHLEN),
+          t_block8 * 1000.0 / ((double)BENCHLOOPS * BENCHLEN));
+   printf("CRC16  docrc16 %8.2f ns/byte   crc16_block %8.2f ns/byte\n",
+          t_byte16 * 1000.0 / ((double)BENCHLOOPS * BENCHLEN),
+          t_block16 * 1000.0 / ((double)BENCHLOOPS * BENCHLEN));
+   // print the results so the timed loops are not optimized away
+   printf("last CRC8 %02X CRC16 %04X\n",crc8,crc16);
+
+   return (bad == 0) ? 0 : 1;
+}
+
+//--------------------------------------------------------------------------
+// CRC8 of a block computed a bit at a time (X^8 + X^5 + X^4 + 1).
+//
+// 'crc'      - starting CRC8
+// 'buf'      - bytes to perform the CRC8 on
+// 'len'      - number of bytes in 'buf'
+//
+// Returns: the CRC8 after the last byte
+//
+static uchar RefCRC8(uchar crc, uchar *buf, int len)
+{
+   int i,b;
+
+   for (i = 0; i < len; i++)
+   {
+      crc ^= buf[i];
+      for (b = 0; b < 8; b++)
+         crc = (crc & 0x01) ? (uchar)((crc >> 1) ^ 0x8C) : (uchar)(crc >> 1);
+   }
+
+   return crc;
+}
+
+//--------------------------------------------------------------------------
+// CRC16 of a block computed a bit at a time (X^16 + X^15 + X^2 + 1).
+//
+// 'crc'      - starting CRC16
+// 'buf'      - bytes to perform the CRC16 on
+// 'len'      - number of bytes in 'buf'
+//
+// Returns: the CRC16 after the last byte
+//
+static ushort RefCRC16(ushort crc, uchar *buf, int len)
+{
+   int i,b;
+
+   for (i = 0; i < len; i++)
+   {
+      crc ^= buf[i];
+      for (b = 0; b < 8; b++)
+         crc = (crc & 0x0001) ? (ushort)((crc >> 1) ^ 0xA001) : (ushort)(crc >> 1);
+   }
+
+   return crc;
+}
@@ -25,11 +25,15 @@
 //--------------------------------------------------------------------------
 //
 //  owMem.c - Goes through the testing the memory bank for different parts.
-//  Version 2.00
+//  Version 2.01
+//
+//  History: 2.00 -> 2.01  Read page asks for a run of pages and reads them
+//                         with one owReadPages call on the opened bank.
 //
 
 #define DEBUG 1
 #include <stdio.h>
+#include <stdlib.h>
 #include <ctype.h>
 #include "ownet.h"
 #include "rawmem.h"
@@ -78,7 +82,8 @@ void displayBankInformation (SMALLINT bank, int portnum, uchar SNum[8]);
 int getNumber (int min, int max);
 SMALLINT dumpBankBlock (SMALLINT bank, int portnum, uchar SNum[8],
                         int addr, int len);
-SMALLINT dumpBankPage (SMALLINT bank, int portnum, uchar SNum[8], int pg);
+SMALLINT dumpBankPage (SMALLINT bank, int portnum, uchar SNum[8], int pg,
+                       int num_pages);
 SMALLINT dumpBankPagePacket(SMALLINT bank, int portnum, uchar SNum[8], int pg);
 SMALLINT bankWriteBlock (SMALLINT bank, int portnum, uchar SNum[8], int addr,
                          uchar *data, int length);
@@ -94,7 +99,7 @@ uchar AllSN[MAXDEVICES][8];
 
 int main(int argc, char **argv)
 {
-   int len, addr, page, answer, i;
+   int len, addr, page, num_pages, answer, i;
    int done      = FALSE;
    SMALLINT  bank = 1;
    uchar     data[552];
@@ -197,13 +202,19 @@ int main(int argc, char **argv)
                         break;
 
                      case BANK_READ_PAGE :
-                        printf("Enter the page number to read:  ");
+                        printf("Enter the page number to start reading:  ");
 
                         page = getNumber(0, (owGetNumberPages(bank,&AllSN[owd][0])-1));
 
                         printf("\n");
 
-                        if(!dumpBankPage(bank,portnum,&AllSN[owd][0],page))
+                        printf("Enter the number of pages to read:  ");
+
+                        num_pages = getNumber(1, owGetNumberPages(bank,&AllSN[owd][0]) - page);
+
+                        printf("\n");
+
+                        if(!dumpBankPage(bank,portnum,&AllSN[owd][0],page,num_pages))
                            OWERROR_DUMP(stderr);
 
                         break;
@@ -471,58 +482,73 @@ SMALLINT dumpBankBlock (SMALLINT bank, int portnum, uchar SNum[8],
 }
 
 /**
- * Read a page from a memory bank and print in hex
+ * Read a run of pages from a memory bank and print in hex.  The bank is
+ * opened once.  Banks without extra information are read with a single
+ * owReadPages call for the whole run, the others a page at a time.
  *
- * bank    MemoryBank to read a page from
- * portnum port number
- * SNum    The serial number of the device to read.
- * pg      page to read
+ * bank      MemoryBank to read the pages from
+ * portnum   port number
+ * SNum      The serial number of the device to read.
+ * pg        first page to read
+ * num_pages number of pages to read
  *
- * @return 'true' if the bank page was dumped.
+ * @return 'true' if the bank pages were dumped.
  */
-SMALLINT dumpBankPage (SMALLINT bank, int portnum, uchar SNum[8], int pg)
+SMALLINT dumpBankPage (SMALLINT bank, int portnum, uchar SNum[8], int pg,
+                       int num_pages)
 {
-   uchar read_buf[64];
+   uchar *read_buf;
    uchar extra_buf[32];
-   int i;
-   int result;
-
-   // read a page (use the most verbose and secure method)
-   if (owHasPageAutoCRC(bank,SNum))
-   {
-      if(owHasExtraInfo(bank,SNum))
-         result = owReadPageExtraCRC(bank,portnum,&SNum[0],
-                     pg,&read_buf[0],&extra_buf[0]);
-      else
-         result = owReadPageCRC(bank,portnum,&SNum[0],pg,&read_buf[0]);
-   }
-   else
-   {
-      if(owHasExtraInfo(bank,SNum))
-         result = owReadPageExtra(bank,portnum,&SNum[0],
-                     pg,FALSE,&read_buf[0],&extra_buf[0]);
-      else
-         result = owReadPage(bank,portnum,&SNum[0],pg,FALSE,&read_buf[0]);
-   }
+   int i,p;
+   int result = TRUE;
+   OWBank hbank;
 
-   if(!result)
+   // look up the bank functions and geometry once
+   if(!owOpenBank(bank,SNum,&hbank))
       return FALSE;
 
-   printf("Page %d:  ",pg);
+   read_buf = (uchar *)malloc(num_pages * hbank.page_len);
+   if(read_buf == NULL)
+      return FALSE;
 
-   for(i=0;i<owGetPageLength(bank,SNum);i++)
-      printf("%02X ",read_buf[i]);
-   printf("\n");
+   // whole run in one read when there is no extra information per page
+   if(hbank.extra_len == 0)
+      result = owReadPages(bank,portnum,&SNum[0],pg,num_pages,read_buf);
 
-   if(owHasExtraInfo(bank,SNum))
+   for(p=0;result && (p<num_pages);p++)
    {
-      printf("Extra: ");
-      for(i=0;i<owGetExtraInfoLength(bank,SNum);i++)
-         printf("%02X ",extra_buf[i]);
+      // read a page with extra info (use the most verbose and secure method)
+      if(hbank.extra_len > 0)
+      {
+         if(hbank.auto_crc)
+            result = hbank.ops->readPageExtraCRC(bank,portnum,&SNum[0],
+                        pg + p,&read_buf[p * hbank.page_len],&extra_buf[0]);
+         else
+            result = hbank.ops->readPageExtra(bank,portnum,&SNum[0],
+                        pg + p,FALSE,&read_buf[p * hbank.page_len],&extra_buf[0]);
+
+         if(!result)
+            break;
+      }
+
+      printf("Page %d:  ",pg + p);
+
+      for(i=0;i<hbank.page_len;i++)
+         printf("%02X ",read_buf[p * hbank.page_len + i]);
       printf("\n");
+
+      if(hbank.extra_len > 0)
+      {
+         printf("Extra: ");
+         for(i=0;i<hbank.extra_len;i++)
+            printf("%02X ",extra_buf[i]);
+         printf("\n");
+      }
    }
 
-   return TRUE;
+   free(read_buf);
+
+   return result;
 }
 
 /**
@@ -541,16 +567,21 @@ SMALLINT dumpBankPagePacket(SMALLINT bank, int portnum, uchar SNum[8], int pg)
    uchar  extra_buf[32];
    int    read_rslt;
    int    i;
+   OWBank hbank;
+
+   // look up the bank functions and geometry once
+   if(!owOpenBank(bank,SNum,&hbank))
+      return FALSE;
 
    // read a page packet (use the most verbose method)
-   if(owHasExtraInfo(bank,SNum))
+   if(hbank.extra_len > 0)
    {
-      if(!owReadPagePacketExtra(bank,portnum,&SNum[0],pg,FALSE,
+      if(!hbank.ops->readPagePacketExtra(bank,portnum,&SNum[0],pg,FALSE,
                                 &read_buf[0],&read_rslt,&extra_buf[0]))
          return FALSE;
    }
    else
-      if(!owReadPagePacket(bank,portnum,&SNum[0],pg,FALSE,&read_buf[0],&read_rslt))
+      if(!hbank.ops->readPagePacket(bank,portnum,&SNum[0],pg,FALSE,&read_buf[0],&read_rslt))
          return FALSE;
 
    printf("Packet %d, len %d\n",pg,read_rslt);
@@ -558,10 +589,10 @@ SMALLINT dumpBankPagePacket(SMALLINT bank, int portnum, uchar SNum[8], int pg)
       printf("%02X ",read_buf[i]);
    printf("\n");
 
-   if(owHasExtraInfo(bank,SNum))
+   if(hbank.extra_len > 0)
    {
       printf("Extra: ");
-      for(i=0;i<owGetExtraInfoLength(bank,SNum);i++)
+      for(i=0;i<hbank.extra_len;i++)
          printf("%02X ",extra_buf[i]);
       printf("\n");
    }
@@ -0,0 +1,145 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owstat.c - Application to show the bus statistics of 1-Wire Nets.
+//             Each port named on the command line is searched over and
+//             over with the statistics turned on and the counts, latency
+//             percentiles and busy time of each port are printed every
+//             few seconds until a key is pressed.
+//
+//             This application uses the files from the 'Public Domain'
+//             1-Wire Net libraries ('userial').
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  A '-b' rate before the port names sets the
+//                         highest DS2480B baud rate to negotiate
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ownet.h"
+#include "ds2480.h"
+#include "owtime.h"
+#include "owstats.h"
+
+// most ports and devices on each port
+#define MAXPORTS       16
+#define MAXDEVICES     256
+
+// seconds between dumps
+#define DUMP_SECS      5
+
+//----------------------------------------------------------------------
+//  Main for owstat
+//
+int main(int argc, char **argv)
+{
+   int portnum[MAXPORTS];
+   uchar ROMs[MAXDEVICES][8];
+   OWStats stats;
+   long long last;
+   int nports = 0,i,found;
+   SMALLINT max_baud = PARMSET_9600;
+
+   // check for required port name
+   if (argc < 2)
+   {
+      printf("1-Wire Net name required on command line!\n"
+             " (example: \"COM1\" (Win32 DS2480),\"/dev/cua0\" "
+             "(Linux DS2480),\"1\" (Win32 TMEX)\n"
+             " more than one name shows the statistics of each\n"
+             " (-b19200, -b57600 or -b115200 before the names sets the\n"
+             " highest baud rate to use with the DS2480B)\n");
+      exit(1);
+   }
+
+   // acquire each 1-Wire Net and start counting
+   for (i = 1; (i < argc) && (nports < MAXPORTS); i++)
+   {
+      // highest baud rate for the ports that follow
+      if (strncmp(argv[i],"-b",2) == 0)
+      {
+         switch (atol(&argv[i][2]))
+         {
+            case 19200:  max_baud = PARMSET_19200;  break;
+            case 57600:  max_baud = PARMSET_57600;  break;
+            case 115200: max_baud = PARMSET_115200; break;
+            default:     max_baud = PARMSET_9600;   break;
+         }
+         continue;
+      }
+
+      if ((portnum[nports] = owAcquireExBaud(argv[i],max_baud)) < 0)
+      {
+         OWERROR_DUMP(stdout);
+         continue;
+      }
+      printf("Port opened: %s\n",argv[i]);
+      if (owStatsEnable(portnum[nports],TRUE))
+         nports++;
+      else
+         owRelease(portnum[nports]);
+   }
+   if (nports == 0)
+      exit(1);
+
+   last = usGettick();
+   do
+   {
+      for (i = 0; i < nports; i++)
+      {
+         found = owSearchAll(portnum[i],ROMs,MAXDEVICES,0,FALSE);
+         if (found <= 0)
+            OWERROR_CLEAR();
+      }
+
+      // print the statistics every few seconds
+      if ((usGettick() - last) >= (long long)DUMP_SECS * 1000000)
+      {
+         for (i = 0; i < nports; i++)
+         {
+            if (owStatsSnapshot(portnum[i],&stats))
+               owStatsPrint(stdout,portnum[i],&stats);
+            owStatsReset(portnum[i]);
+         }
+         printf("\n");
+         last = usGettick();
+      }
+   }
+   while (!key_abort());
+
+   // release the 1-Wire Nets
+   for (i = 0; i < nports; i++)
+   {
+      owStatsEnable(portnum[i],FALSE);
+      owRelease(portnum[i]);
+   }
+   exit(0);
+
+   return 0;
+}
@@ -0,0 +1,215 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  shabench.c - Application to check and time the SHA-1 MAC engine.
+//               ComputeSHAMAC and ComputeSHAMACMulti are compared bit for
+//               bit with the ComputeSHAVM that sha33.c had before
+//               shamac.c, on random digest buffers, with every engine
+//               the processor can run.  Then each is timed over the same
+//               buffers.  No 1-Wire Net is needed.
+//
+//               This application uses the files from the 'Public Domain'
+//               1-Wire Net libraries ('general' or 'userial').
+//
+//  Version: 3.00
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ownet.h"
+#include "owtime.h"
+#include "shamac.h"
+
+// digest buffers checked and timed, not a multiple of SHAMAC_LANES so
+// the multi-buffer tail is checked too, and times they are timed
+#define NUMBLOCKS      4003
+#define BENCHLOOPS     50
+
+// local functions
+static void RefSHAVM(uchar *MT, long *hash);
+static long RefNLF(long B, long C, long D, int n);
+static int  CheckEngine(uchar MT[][64], uint32_t hash[][5]);
+
+//----------------------------------------------------------------------
+//  Main for shabench
+//
+int main(int argc, char **argv)
+{
+   static uchar MT[NUMBLOCKS][64];
+   static uint32_t hash[NUMBLOCKS][5];
+   static const char *name[2] = { "C", "SHA-NI" };
+   long long start, t_ref, t_one, t_multi;
+   long ref[5];
+   int eng,i,n,bad = 0;
+
+   srand(1);
+   for (n = 0; n < NUMBLOCKS; n++)
+      for (i = 0; i < 64; i++)
+         MT[n][i] = (uchar)rand();
+
+   printf("engine picked: %s\n",name[SHAMACEngine()]);
+
+   // time the reference once
+   start = usGettick();
+   for (i = 0; i < BENCHLOOPS; i++)
+      for (n = 0; n < NUMBLOCKS; n++)
+         RefSHAVM(MT[n],ref);
+   t_ref = usGettick() - start;
+   printf("reference       %8.1f ns/block\n",
+          t_ref * 1000.0 / ((double)BENCHLOOPS * NUMBLOCKS));
+
+   for (eng = SHAMAC_PORTABLE; eng <= SHAMAC_SHANI; eng++)
+   {
+      if (!SHAMACSetEngine(eng))
+      {
+         printf("%-7s not available\n",name[eng]);
+         continue;
+      }
+
+      n = CheckEngine(MT,hash);
+      printf("%-7s %d blocks checked, %d mismatches\n",name[eng],NUMBLOCKS,n);
+      bad += n;
+
+      start = usGettick();
+      for (i = 0; i < BENCHLOOPS; i++)
+         for (n = 0; n < NUMBLOCKS; n++)
+            ComputeSHAMAC(MT[n],hash[n]);
+      t_one = usGettick() - start;
+
+      start = usGettick();
+      for (i = 0; i < BENCHLOOPS; i++)
+         ComputeSHAMACMulti(MT,hash,NUMBLOCKS);
+      t_multi = usGettick() - start;
+
+      printf("%-7s one    %8.1f ns/block   multi %8.1f ns/block\n",name[eng],
+             t_one * 1000.0 / ((double)BENCHLOOPS * NUMBLOCKS),
+             t_multi * 1000.0 / ((double)BENCHLOOPS * NUMBLOCKS));
+   }
+
+   return (bad == 0) ? 0 : 1;
+}
+
+//----------------------------------------------------------------------
+// Compare ComputeSHAMAC and ComputeSHAMACMulti of the engine in use with
+// the reference on every buffer.
+//
+// 'MT'        - the digest buffers
+// 'hash'      - room for the results of ComputeSHAMACMulti
+//
+// Returns: number of buffers with a mismatch
+//
+static int CheckEngine(uchar MT[][64], uint32_t hash[][5])
+{
+   uint32_t one[5];
+   long ref[5];
+   int i,n,bad = 0;
+
+   ComputeSHAMACMulti(MT,hash,NUMBLOCKS);
+
+   for (n = 0; n < NUMBLOCKS; n++)
+   {
+      RefSHAVM(MT[n],ref);
+      ComputeSHAMAC(MT[n],one);
+
+      // the reference may leave bits above 32 in a long
+      for (i = 0; i < 5; i++)
+         if ((one[i] != (uint32_t)ref[i]) || (hash[n][i] != (uint32_t)ref[i]))
+            break;
+
+      if (i < 5)
+      {
+         printf("mismatch in block %d word %d\n",n,i);
+         bad++;
+      }
+   }
+
+   return bad;
+}
+
+//constants used in SHA computation
+static const long KTN[4] = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
+
+// calculation used for the SHA MAC
+static long RefNLF(long B, long C, long D, int n)
+{
+   if(n<20)
+      return ((B&C)|((~B)&D));
+   else if(n<40)
+      return (B^C^D);
+   else if(n<60)
+      return ((B&C)|(B&D)|(C&D));
+   else
+      return (B^C^D);
+}
+
+//----------------------------------------------------------------------
+// The ComputeSHAVM of sha33.c before shamac.c, kept as the reference.
+// This algorithm is the SHA-1 algorithm as specified in the datasheet
+// for the DS1961S, where the last step of the official FIPS-180 SHA
+// routine is omitted (which only involves the addition of constant
+// values).
+//
+// 'MT'        - buffer containing the message digest
+// 'hash'      - result buffer
+//
+static void RefSHAVM(uchar* MT, long* hash)
+{
+   unsigned long MTword[80];
+   int i;
+   long ShftTmp;
+   long Temp;
+
+   for(i=0;i<16;i++)
+   {
+      MTword[i] = ((MT[i*4]&0x00FF) << 24) | ((MT[i*4+1]&0x00FF) << 16) |
+                  ((MT[i*4+2]&0x00FF) << 8) | (MT[i*4+3]&0x00FF);
+   }
+
+   for(;i<80;i++)
+   {
+      ShftTmp = MTword[i-3] ^ MTword[i-8] ^ MTword[i-14] ^ MTword[i-16];
+      MTword[i] = ((ShftTmp << 1) & 0xFFFFFFFE) |
+                  ((ShftTmp >> 31) & 0x00000001);
+   }
+
+   hash[0] = 0x67452301;
+   hash[1] = 0xEFCDAB89;
+   hash[2] = 0x98BADCFE;
+   hash[3] = 0x10325476;
+   hash[4] = 0xC3D2E1F0;
+
+   for(i=0;i<80;i++)
+   {
+      ShftTmp = ((hash[0] << 5) & 0xFFFFFFE0) | ((hash[0] >> 27) & 0x0000001F);
+      Temp = RefNLF(hash[1],hash[2],hash[3],i) + hash[4]
+               + KTN[i/20] + MTword[i] + ShftTmp;
+      hash[4] = hash[3];
+      hash[3] = hash[2];
+      hash[2] = ((hash[1] << 30) & 0xC0000000) | ((hash[1] >> 2) & 0x3FFFFFFF);
+      hash[1] = hash[0];
+      hash[0] = Temp;
+   }
+}
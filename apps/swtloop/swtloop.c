@@ -25,7 +25,11 @@
 //--------------------------------------------------------------------------
 //
 //  swtloop.C - Goes through the testing of the DS2406(DS2407) switch
-//  Version 2.00
+//  Version 2.01
+//
+//  History: 2.00 -> 2.01  The switches are listed from the bus inventory,
+//                         which is scanned again each time a device is
+//                         picked.
 
 
 // Include files
@@ -33,7 +37,7 @@
 #include <stdlib.h>
 #include "ownet.h"
 #include "swt12.h"
-#include "findtype.h"
+#include "owinv.h"
 
 // Constant definition
 #define SWITCH_FAMILY      0x12
@@ -85,7 +89,8 @@ int main(int argc, char **argv)
    printf("Port opened: %s\n",argv[1]);
 
    // this is to get the number of the devices and the serial numbers
-   num = FindDevices(portnum, &SwitchSN[0], SWITCH_FAMILY, MAXDEVICES);
+   owInvScan(portnum);
+   num = owInvFamily(portnum, SWITCH_FAMILY, &SwitchSN[0], MAXDEVICES);
 
    // setting up the first print out for the frist device
    owSerialNum(portnum, SwitchSN[0], FALSE);
@@ -94,6 +99,10 @@ int main(int argc, char **argv)
    n=0;
    do
    {
+      // list the switches on the bus now
+      if(owInvScan(portnum) >= 0)
+         num = owInvFamily(portnum, SWITCH_FAMILY, &SwitchSN[0], MAXDEVICES);
+
       printf("\n\n");
       for(k=0; k < num; k++)
       {
@@ -25,7 +25,12 @@
 //--------------------------------------------------------------------------
 //
 //  swtoper.C - Menu-driven test of DS2406(DS2407) 1-Wire switch
-//  version 3.00
+//  version 3.01
+//
+//  History: 3.00 -> 3.01  The switches are listed from the bus inventory,
+//                         which is scanned again to select a different
+//                         device.  Dropped the extern declarations that
+//                         conflict with swt12.h and ownet.h.
 
 
 // Include files
@@ -34,22 +39,12 @@
 #include <ctype.h>
 #include "ownet.h"
 #include "swt12.h"
+#include "owinv.h"
 
 // Constant definition
 #define SWITCH_FAMILY      0x12
 #define MAXDEVICES         15
 
-// External subroutines
-extern short ReadSwitch12(int,int);
-extern int SetSwitch12(int,uchar *,SwitchProps);
-extern int SwitchStateToString12(int,char *);
-extern SMALLINT owAccess(int);
-extern SMALLINT owAcquire(int,char *);
-extern void owRelease(int);
-extern void owSerialNum(int,uchar *,SMALLINT);
-extern SMALLINT FindDevices(int,uchar FamilySN[][8],SMALLINT,SMALLINT);
-extern void msDelay(int);
-extern int EnterNum(char *,int,long *,long,long);
 
 //---------------------------------------------------------------------------
 // The main program that performs the operations on switches
@@ -96,7 +91,8 @@ int main(int argc, char **argv)
    printf("Port opened: %s\n",argv[1]);
 
    // this is to get the number of the devices and the serial numbers
-   num = FindDevices(portnum, &SwitchSN[0], SWITCH_FAMILY, MAXDEVICES);
+   owInvScan(portnum);
+   num = owInvFamily(portnum, SWITCH_FAMILY, &SwitchSN[0], MAXDEVICES);
 
    // setting up the first print out for the frist device
    owSerialNum(portnum, SwitchSN[0], FALSE);
@@ -185,6 +181,10 @@ int main(int argc, char **argv)
                }
                break;
             case 4: // Switch Devices
+               // list the switches on the bus now
+               if(owInvScan(portnum) >= 0)
+                  num = owInvFamily(portnum, SWITCH_FAMILY, &SwitchSN[0], MAXDEVICES);
+
                // print the device list
                for(j=0; j < num; j++)
                {
@@ -32,7 +32,9 @@
 //             1-Wire Net libraries ('general' and 'userial').
 //
 //
-//  Version: 2.00
+//  Version: 2.01
+//
+//  History: 2.00 -> 2.01  Read all sensors each pass with ReadTemperatureAll.
 //
 
 #include <stdlib.h>
@@ -46,6 +48,7 @@
 
 // global serial numbers
 uchar FamilySN[MAXDEVICES][8];
+TempReading Readings[MAXDEVICES];
 
 // variables
 int family_code;
@@ -55,8 +58,7 @@ int family_code;
 //
 int main(int argc, char **argv)
 {
-   float current_temp;
-   int i = 0;
+   int i = 0, j;
    int NumDevices=0;
    int portnum = 0;
 
@@ -101,20 +103,23 @@ int main(int argc, char **argv)
       {
          PrintSerialNum(FamilySN[i]);
          printf("\n");
+         for (j = 0; j < 8; j++)
+            Readings[i].SerialNum[j] = FamilySN[i][j];
+         Readings[i].Config = 0;
       }
       printf("\n\n");
 
       // (stops on CTRL-C)
       do
       {
-         // read the temperature and print serial number and temperature
+         // convert and read all of the devices, print serial number and temperature
+         ReadTemperatureAll(portnum, Readings, NumDevices);
          for (i = 0; i < NumDevices; i++)
          {
-
-            if (ReadTemperature(portnum, FamilySN[i],&current_temp))
+            if (Readings[i].Status == TEMP_OK)
             {
                PrintSerialNum(FamilySN[i]);
-               printf("     %5.1f \n", current_temp * 9 / 5 + 32);
+               printf("     %5.1f \n", Readings[i].Temp * 9 / 5 + 32);
               // converting temperature from Celsius to Fahrenheit
             }
             else
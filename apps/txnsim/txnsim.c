@@ -0,0 +1,531 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//
+//  txnsim.c - Application to check the DS2480B transactions of owtrnu.c
+//             without an adapter.  The COM functions of the Link file
+//             are replaced by a simulated DS2480B with a few DS18B20
+//             style devices behind it.  owTxnExecute and owTxnPipeline
+//             are run against it and the data, the step status and the
+//             number of writes to the adapter are checked.
+//
+//             This application uses the files from the 'Public Domain'
+//             1-Wire Net library 'userial' without its Link file.
+//
+//  Version: 3.00
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "ownet.h"
+#include "owport.h"
+#include "owtxn.h"
+#include "ds2480.h"
+
+// devices on the simulated 1-Wire Net
+#define NUMDEV         10
+// device with a bad scratchpad CRC
+#define BADCRCDEV      4
+
+// state of a simulated device after the reset
+#define DEV_ROM        0     // waiting for a ROM function
+#define DEV_MATCH      1     // taking the ROM of a Match ROM
+#define DEV_FUNCTION   2     // selected, waiting for a function
+#define DEV_READ       3     // sending the scratchpad
+#define DEV_IDLE       4     // not selected until the next reset
+
+// one simulated device
+typedef struct
+{
+   uchar rom[8];
+   uchar scratch[9];
+   int   state;
+   int   idx;
+} SimDev;
+
+// simulated 1-Wire Net and DS2480B
+static SimDev Dev[NUMDEV];
+static uchar  Param[8];            // DS2480B configuration parameters
+static uchar  Response[4096];      // bytes for the next ReadCOM
+static int    RespHead, RespTail;
+static int    CmdMode = TRUE;      // DS2480B in command mode
+static int    PendCommand = FALSE; // 0xE3 seen in data mode
+static int    Pulse = FALSE;       // strong pull-up on
+static uchar  BitByte;             // byte sent with bit commands
+static int    BitCount;
+static int    Writes;              // WriteCOM calls
+
+// local functions
+static void  SimReset(void);
+static uchar SimByte(uchar w);
+static void  SimCommand(uchar c);
+static void  SimRespond(uchar b);
+static uchar SimCRC8(uchar *buf, int len);
+static int   CheckExecute(int portnum);
+static int   CheckPipeline(int portnum);
+static int   CheckPower(int portnum);
+
+//----------------------------------------------------------------------
+//  Main for txnsim
+//
+int main(int argc, char **argv)
+{
+   int i,k,portnum,bad = 0;
+
+   // DS18B20 style devices, each with its own scratchpad
+   for (i = 0; i < NUMDEV; i++)
+   {
+      Dev[i].rom[0] = 0x28;
+      for (k = 1; k < 7; k++)
+         Dev[i].rom[k] = (uchar)(i * 7 + k);
+      Dev[i].rom[7] = SimCRC8(Dev[i].rom,7);
+      for (k = 0; k < 8; k++)
+         Dev[i].scratch[k] = (uchar)(i + k * 3);
+      Dev[i].scratch[8] = SimCRC8(Dev[i].scratch,8);
+   }
+   Dev[BADCRCDEV].scratch[8] ^= 0x01;
+
+   if ((portnum = owAcquireEx("sim")) < 0)
+   {
+      printf("DS2480B not detected\n");
+      return 1;
+   }
+
+   bad += CheckExecute(portnum);
+   bad += CheckPipeline(portnum);
+   bad += CheckPower(portnum);
+
+   owRelease(portnum);
+
+   printf("%d failures\n",bad);
+   return (bad == 0) ? 0 : 1;
+}
+
+//----------------------------------------------------------------------
+// Read the scratchpad of one device with owTxnExecute.  It must be one
+// write to the DS2480B.
+//
+// Returns: number of failures
+//
+static int CheckExecute(int portnum)
+{
+   OWTxn txn;
+   uchar cmd = 0xBE, *data;
+   int rd,len,bad = 0;
+
+   owTxnInit(&txn);
+   owTxnReset(&txn);
+   owTxnMatchROM(&txn,Dev[2].rom);
+   owTxnWrite(&txn,&cmd,1);
+   rd = owTxnRead(&txn,9,OWTXN_CRC8);
+
+   Writes = 0;
+   if (!owTxnExecute(portnum,&txn))
+   {
+      printf("execute: failed\n");
+      bad++;
+   }
+   data = owTxnData(&txn,rd,&len);
+   if ((len != 9) || memcmp(data,Dev[2].scratch,9))
+   {
+      printf("execute: wrong scratchpad\n");
+      bad++;
+   }
+   if (Writes != 1)
+   {
+      printf("execute: %d writes, expected 1\n",Writes);
+      bad++;
+   }
+
+   printf("execute: %d writes\n",Writes);
+   return bad;
+}
+
+//----------------------------------------------------------------------
+// Read the scratchpad of every device plus two that are not there with
+// owTxnPipeline.  The device with the bad CRC and the missing ones must
+// get OWTXN_CRC_ERROR, the others their scratchpad, and the whole
+// batch must take fewer writes than transactions.
+//
+// Returns: number of failures
+//
+static int CheckPipeline(int portnum)
+{
+   OWTxn txn[NUMDEV + 2], *list[NUMDEV + 2];
+   uchar cmd = 0xBE, rom[8], *data;
+   int i,rd[NUMDEV + 2],len,good,bad = 0;
+
+   for (i = 0; i < NUMDEV + 2; i++)
+   {
+      memcpy(rom,Dev[i % NUMDEV].rom,8);
+      if (i >= NUMDEV)
+         rom[3] ^= 0x55;
+      owTxnInit(&txn[i]);
+      owTxnReset(&txn[i]);
+      owTxnMatchROM(&txn[i],rom);
+      owTxnWrite(&txn[i],&cmd,1);
+      rd[i] = owTxnRead(&txn[i],9,OWTXN_CRC8);
+      list[i] = &txn[i];
+   }
+
+   Writes = 0;
+   good = owTxnPipeline(portnum,list,NUMDEV + 2);
+   if (good != NUMDEV - 1)
+   {
+      printf("pipeline: %d good, expected %d\n",good,NUMDEV - 1);
+      bad++;
+   }
+
+   for (i = 0; i < NUMDEV + 2; i++)
+   {
+      if ((i == BADCRCDEV) || (i >= NUMDEV))
+      {
+         if (owTxnStatus(&txn[i],rd[i]) != OWTXN_CRC_ERROR)
+         {
+            printf("pipeline: transaction %d not a CRC error\n",i);
+            bad++;
+         }
+         continue;
+      }
+
+      data = owTxnData(&txn[i],rd[i],&len);
+      if ((owTxnStatus(&txn[i],rd[i]) != OWTXN_OK) ||
+          memcmp(data,Dev[i].scratch,9))
+      {
+         printf("pipeline: transaction %d wrong\n",i);
+         bad++;
+      }
+   }
+
+   if (Writes >= NUMDEV + 2)
+   {
+      printf("pipeline: %d writes for %d transactions\n",Writes,NUMDEV + 2);
+      bad++;
+   }
+
+   printf("pipeline: %d transactions, %d writes\n",NUMDEV + 2,Writes);
+   return bad;
+}
+
+//----------------------------------------------------------------------
+// Convert with the strong pull-up, wait and read the scratchpad in one
+// transaction.  The delay splits it in two writes and the pull-up must
+// be off at the end.
+//
+// Returns: number of failures
+//
+static int CheckPower(int portnum)
+{
+   OWTxn txn;
+   uchar cmd = 0xBE, *data;
+   int rd,len,bad = 0;
+
+   owTxnInit(&txn);
+   owTxnReset(&txn);
+   owTxnMatchROM(&txn,Dev[2].rom);
+   owTxnPower(&txn,0x44);
+   owTxnDelay(&txn,10);
+   owTxnReset(&txn);
+   owTxnMatchROM(&txn,Dev[2].rom);
+   owTxnWrite(&txn,&cmd,1);
+   rd = owTxnRead(&txn,9,OWTXN_CRC8);
+
+   Writes = 0;
+   if (!owTxnExecute(portnum,&txn))
+   {
+      printf("power: failed\n");
+      bad++;
+   }
+   data = owTxnData(&txn,rd,&len);
+   if (memcmp(data,Dev[2].scratch,9))
+   {
+      printf("power: wrong scratchpad\n");
+      bad++;
+   }
+   if (Writes != 2)
+   {
+      printf("power: %d writes, expected 2\n",Writes);
+      bad++;
+   }
+   if (Pulse || (owGetPort(portnum)->ULevel != MODE_NORMAL))
+   {
+      printf("power: strong pull-up left on\n");
+      bad++;
+   }
+
+   printf("power: %d writes\n",Writes);
+   return bad;
+}
+
+//----------------------------------------------------------------------
+// Simulated 1-Wire Net: reset every device.
+//
+static void SimReset(void)
+{
+   int i;
+
+   for (i = 0; i < NUMDEV; i++)
+   {
+      Dev[i].state = DEV_ROM;
+      Dev[i].idx = 0;
+   }
+   BitCount = 0;
+}
+
+//----------------------------------------------------------------------
+// Simulated 1-Wire Net: send a byte.  The devices that send pull the
+// bits they send as 0 low.
+//
+// 'w'        - byte written
+//
+// Returns: byte read back
+//
+static uchar SimByte(uchar w)
+{
+   SimDev *d;
+   uchar r = w;
+   int i;
+
+   for (i = 0; i < NUMDEV; i++)
+   {
+      d = &Dev[i];
+      switch (d->state)
+      {
+         case DEV_ROM:
+            if (w == 0x55)
+            {
+               d->state = DEV_MATCH;
+               d->idx = 0;
+            }
+            else
+               d->state = (w == 0xCC) ? DEV_FUNCTION : DEV_IDLE;
+            break;
+
+         case DEV_MATCH:
+            if (w != d->rom[d->idx])
+               d->state = DEV_IDLE;
+            else if (++d->idx == 8)
+               d->state = DEV_FUNCTION;
+            break;
+
+         case DEV_FUNCTION:
+            if (w == 0xBE)
+            {
+               d->state = DEV_READ;
+               d->idx = 0;
+            }
+            else
+               d->state = DEV_IDLE;
+            break;
+
+         case DEV_READ:
+            r &= d->scratch[d->idx];
+            if (++d->idx == 9)
+               d->state = DEV_IDLE;
+            break;
+      }
+   }
+
+   return r;
+}
+
+//----------------------------------------------------------------------
+// Simulated DS2480B: run a command mode byte.
+//
+// 'c'        - command byte
+//
+static void SimCommand(uchar c)
+{
+   int b;
+
+   if (c == MODE_DATA)
+   {
+      CmdMode = FALSE;
+      return;
+   }
+
+   if (c == MODE_STOP_PULSE)
+   {
+      if (Pulse)
+         SimRespond(0xF0);
+      Pulse = FALSE;
+      return;
+   }
+
+   // communication commands
+   if ((c & 0x81) == CMD_COMM)
+   {
+      switch (c & FUNCTSEL_MASK)
+      {
+         case FUNCTSEL_RESET:
+            SimReset();
+            SimRespond(0xCD);
+            break;
+
+         case FUNCTSEL_CHMOD:
+            SimRespond((uchar)(c & 0xFC));
+            break;
+
+         case FUNCTSEL_BIT:
+            b = (c & BITPOL_ONE) ? 1 : 0;
+            BitByte = (uchar)((BitByte >> 1) | (b ? 0x80 : 0));
+            if (++BitCount == 8)
+            {
+               SimByte(BitByte);
+               BitCount = 0;
+            }
+            SimRespond((uchar)((c & 0xFC) | (b ? 0x03 : 0x00)));
+            if (c & PRIME5V_TRUE)
+               Pulse = TRUE;
+            break;
+      }
+      return;
+   }
+
+   // configuration commands, a parameter read or write
+   if (((c >> 4) & 0x07) == 0)
+      SimRespond(Param[(c >> 1) & 0x07]);
+   else
+   {
+      Param[(c >> 4) & 0x07] = (uchar)(c & 0x0E);
+      SimRespond((uchar)(c & 0x7E));
+   }
+}
+
+//----------------------------------------------------------------------
+// Simulated DS2480B: queue a byte for ReadCOM.
+//
+static void SimRespond(uchar b)
+{
+   if (RespTail < (int)sizeof(Response))
+      Response[RespTail++] = b;
+}
+
+//----------------------------------------------------------------------
+// CRC8 of the simulated ROMs and scratchpads (X^8 + X^5 + X^4 + 1).
+//
+static uchar SimCRC8(uchar *buf, int len)
+{
+   uchar crc = 0, x;
+   int i,b;
+
+   for (i = 0; i < len; i++)
+   {
+      x = buf[i];
+      for (b = 0; b < 8; b++)
+      {
+         crc = ((crc ^ x) & 0x01) ? (uchar)((crc >> 1) ^ 0x8C)
+                                  : (uchar)(crc >> 1);
+         x >>= 1;
+      }
+   }
+
+   return crc;
+}
+
+//----------------------------------------------------------------------
+// COM functions of the Link file, talking to the simulated DS2480B.
+//
+SMALLINT WriteCOM(int portnum, int outlen, uchar *outbuf)
+{
+   uchar c;
+   int i;
+
+   Writes++;
+   for (i = 0; i < outlen; i++)
+   {
+      c = outbuf[i];
+      if (CmdMode)
+         SimCommand(c);
+      else if (PendCommand)
+      {
+         // a doubled 0xE3 is data, anything else switches mode
+         PendCommand = FALSE;
+         if (c == MODE_COMMAND)
+            SimRespond(SimByte(MODE_COMMAND));
+         else
+         {
+            CmdMode = TRUE;
+            SimCommand(c);
+         }
+      }
+      else if (c == MODE_COMMAND)
+         PendCommand = TRUE;
+      else
+         SimRespond(SimByte(c));
+   }
+
+   return TRUE;
+}
+
+int ReadCOM(int portnum, int inlen, uchar *inbuf)
+{
+   int n = 0;
+
+   while ((n < inlen) && (RespHead < RespTail))
+      inbuf[n++] = Response[RespHead++];
+   if (RespHead == RespTail)
+      RespHead = RespTail = 0;
+
+   return n;
+}
+
+void FlushCOM(int portnum)
+{
+   RespHead = RespTail = 0;
+}
+
+void BreakCOM(int portnum)
+{
+   memset(Param,0,sizeof(Param));
+   CmdMode = TRUE;
+   PendCommand = FALSE;
+}
+
+SMALLINT OpenCOM(int portnum, char *port_zstr)
+{
+   return TRUE;
+}
+
+int OpenCOMEx(char *port_zstr)
+{
+   return 0;
+}
+
+void CloseCOM(int portnum)
+{
+}
+
+void SetBaudCOM(int portnum, uchar new_baud)
+{
+}
+
+void msDelay(int len)
+{
+}
+
+long msGettick(void)
+{
+   return 0;
+}
@@ -28,15 +28,28 @@
 //             on the DS2450 - 1-Wire Quad A/D Converter.
 //
 //
-//  Version: 2.00
+//  Version: 2.03
 //
+//  History: 2.00 -> 2.01  ReadAtoDResults done with one owTxn transaction
+//           2.01 -> 2.02  DoAtoDConversion polls for the end of the
+//                         conversion of a VCC powered DS2450
+//           2.02 -> 2.03  current_speed moved to the OWPort state
 //
 // --------------------------------------------------------------------------
 
 #include <stdio.h>
 #include "ownet.h"
+#include "owport.h"
+#include "owtxn.h"
+#include "owconv.h"
 #include "atod20.h"
 
+// longest conversion of all four channels at 16 bits (ms)
+#define ATOD_MAX_MS        6
+
+// local functions
+static SMALLINT AtoDPower(int,int,uchar *);
+
 // -------------------------------------------------------------------------
 // Setup A to D control data.  This is hardcoded to 5.12Volt scale at
 // 8 bits, but it could be read from a file.
@@ -176,10 +189,16 @@ int DoAtoDConversion(int portnum, int try_overdrive, uchar *SerialNum)
    int i;
    short send_cnt=0;
    ushort lastcrc16;
+   SMALLINT power;
 
    // set the device serial number to the DS2450 device
    owSerialNum(portnum,SerialNum,FALSE);
 
+   // find out once if the end of the conversion can be polled
+   power = owConvPower(portnum,SerialNum);
+   if (power == OWCONV_UNKNOWN)
+      power = AtoDPower(portnum,try_overdrive,SerialNum);
+
    // access the device
    if (Select(portnum,try_overdrive))
    {
@@ -214,6 +233,10 @@ int DoAtoDConversion(int portnum, int try_overdrive, uchar *SerialNum)
             return FALSE;
          }
 
+         // VCC powered, the device answers 1s when the conversion is done
+         if (power == OWCONV_EXTERNAL)
+            return (owConvPoll(portnum,0,ATOD_MAX_MS) >= 0);
+
          // if success then apply the strong pullup
          if(!owWriteBytePower(portnum,((send_cnt-1) & 0x1F)))
             return FALSE;
@@ -252,64 +275,93 @@ int DoAtoDConversion(int portnum, int try_overdrive, uchar *SerialNum)
 int ReadAtoDResults(int portnum, int try_overdrive, uchar *SerialNum,
                          float *prslt, uchar *ctrl)
 {
-   uchar i, send_cnt=0;
+   OWTxn txn;
+   uchar cmd[3] = { 0xAA, 0x00, 0x00 }, *data;
+   int i, rd, len;
    ulong templong;
-   uchar rt=FALSE;
-   uchar send_block[30];
-   ushort lastcrc16;
-
-   setcrc16(portnum,0);
 
    // set the device serial number to the DS2450 device
    owSerialNum(portnum,SerialNum,FALSE);
 
-   // access the device
-   if (Select(portnum,try_overdrive))
+   owTxnInit(&txn);
+
+   // overdrive needs its own speed change so select it first, otherwise
+   // the reset and select go in the same transaction as the read
+   if (try_overdrive)
    {
-      // create a block to send that reads the DS2450
-      send_block[send_cnt++] = 0xAA;
-      lastcrc16 = docrc16(portnum,0xAA);
-
-      // address block
-      send_block[send_cnt++] = 0x00;
-      send_block[send_cnt++] = 0x00;
-      lastcrc16 = docrc16(portnum,0x00);
-      lastcrc16 = docrc16(portnum,0x00);
-
-      // read the bytes
-      for (i = 0; i < 10; i++)
-         send_block[send_cnt++] = 0xFF;
+      if (!Select(portnum,try_overdrive))
+         return FALSE;
+   }
+   else
+   {
+      owTxnReset(&txn);
+      owTxnMatchROM(&txn,SerialNum);
+   }
 
-      // send the block
-      if (owBlock(portnum,FALSE, send_block, send_cnt))
-      {
-         // perform CRC16
-         for (i = send_cnt - 10; i < send_cnt; i++)
-            lastcrc16 = docrc16(portnum,send_block[i]);
+   // read memory command, address block and the bytes with the CRC16
+   owTxnWrite(&txn,cmd,3);
+   rd = owTxnRead(&txn,10,OWTXN_CRC16);
 
-         // verify CRC16 is correct
-         if (lastcrc16 == 0xB001)
-         {
-            // success
-            rt = TRUE;
-         }
+   if (!owTxnExecute(portnum,&txn))
+      return FALSE;
 
-      }
+   // convert the value read to floats
+   data = owTxnData(&txn,rd,&len);
+   for (i = 0; i < 8; i += 2)  // (1.01)
+   {
+      templong = ((data[i + 1] << 8) | data[i]) & 0x0000FFFF;
+      prslt[i / 2] = (float)((float)(templong / 65535.0) *
+         ((ctrl[i + 1] & 0x01) ? 5.12 : 2.56)); // (1.01)
+   }
 
-      // verify read ok
-      if (rt == TRUE)
-      {
-         // convert the value read to floats
-         for (i = 3; i < 11; i += 2)  // (1.01)
-         {
-            templong = ((send_block[i + 1] << 8) | send_block[i]) & 0x0000FFFF;
-            prslt[(i - 3) / 2] = (float)((float)(templong / 65535.0) *
-               ((ctrl[(i - 3) + 1] & 0x01) ? 5.12 : 2.56)); // (1.01)
-         }
-      }
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Find out if a DS2450 is VCC powered from its VCC control byte (memory
+// 0x1C is 0x40) and remember it for owConvPower.
+//
+// 'portnum'       - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                   indicate the symbolic port number.
+// 'try_overdrive' - True(1) if want to try to use overdrive
+// 'SerialNum'     - Serial Number of device
+//
+// Returns: OWCONV_EXTERNAL, OWCONV_PARASITE or OWCONV_UNKNOWN if the
+//          byte could not be read
+//
+static SMALLINT AtoDPower(int portnum, int try_overdrive, uchar *SerialNum)
+{
+   uchar send_block[10];
+   int i;
+   short send_cnt=0;
+   ushort lastcrc16=0;
+   SMALLINT power;
+
+   if (!Select(portnum,try_overdrive))
+      return OWCONV_UNKNOWN;
+
+   // read memory from 0x1C to the end of the control page and the CRC16
+   send_block[send_cnt++] = 0xAA;
+   send_block[send_cnt++] = 0x1C;
+   send_block[send_cnt++] = 0x00;
+   for (i = 0; i < 6; i++)
+      send_block[send_cnt++] = 0xFF;
+
+   if (!owBlock(portnum,FALSE,send_block,send_cnt))
+      return OWCONV_UNKNOWN;
+
+   setcrc16(portnum,0);
+   for (i = 0; i < send_cnt; i++)
+      lastcrc16 = docrc16(portnum,send_block[i]);
+   if (lastcrc16 != 0xB001)
+   {
+      OWERROR(OWERROR_CRC_FAILED);
+      return OWCONV_UNKNOWN;
    }
 
-   return rt;
+   power = (send_block[3] == 0x40) ? OWCONV_EXTERNAL : OWCONV_PARASITE;
+   owConvSetPower(portnum,SerialNum,power);
+   return power;
 }
 
 //--------------------------------------------------------------------------
@@ -325,22 +377,22 @@ int ReadAtoDResults(int portnum, int try_overdrive, uchar *SerialNum,
 //
 int Select(int portnum, int try_overdrive)
 {
-   static uchar current_speed = MODE_NORMAL;
+   OWPort *port = owGetPort(portnum);
 
    // attempt to do overdrive
    if (try_overdrive)
    {
       // verify device is in overdrive
-      if (current_speed == MODE_OVERDRIVE)
+      if (port->AtoDSpeed == MODE_OVERDRIVE)
       {
          if (owAccess(portnum))
             return TRUE;
       }
 
       if (owOverdriveAccess(portnum))
-         current_speed = MODE_OVERDRIVE;
+         port->AtoDSpeed = MODE_OVERDRIVE;
       else
-         current_speed = MODE_NORMAL;
+         port->AtoDSpeed = MODE_NORMAL;
    }
 
    return (owAccess(portnum));
@@ -26,12 +26,29 @@
 //
 //  cnt1D.c - Module to read the DS2423 - counter.
 //
-//  Version: 2.00
+//  Version: 2.01
 //
+//  History: 2.00 -> 2.01  ReadCounter done with one owTxn transaction
+//                         Added ReadCounterAll
 //
 #include "ownet.h"
+#include "owtxn.h"
 #include "cnt1d.h"
 
+// bytes of one counter read: Match ROM and ROM (9), command and
+// address (3) and the 11 bytes read (data byte, counter, zero bits,
+// crc16)
+#define CNT_READ_LEN       23
+
+// counter reads that fit in one transaction (4 steps each)
+#define CNT_BATCH_STEPS    (OWTXN_MAX_STEPS / 4)
+#define CNT_BATCH_BYTES    (OWTXN_MAX_BYTES / CNT_READ_LEN)
+#define CNT_BATCH          ((CNT_BATCH_STEPS < CNT_BATCH_BYTES) ? \
+                            CNT_BATCH_STEPS : CNT_BATCH_BYTES)
+
+// local functions
+static void AddCounterRead(OWTxn *,uchar *,int);
+
 //----------------------------------------------------------------------
 // Read the counter on a specified page of a DS2423.
 //
@@ -49,57 +66,152 @@
 SMALLINT ReadCounter(int portnum, uchar SerialNum[8], int CounterPage,
                      ulong *Count)
 {
-   uchar rt=FALSE;
-   uchar send_block[30];
-   uchar send_cnt=0, i;
-   int address;
-   ushort lastcrc16;
-
-   setcrc16(portnum,0);
+   OWTxn txn;
+   uchar *data;
+   int rd, len, i;
 
    // set the device serial number to the counter device
    owSerialNum(portnum,SerialNum,FALSE);
 
-   // access the device
-   if (owAccess(portnum))
+   // reset, select, command and the read of the data byte, counter,
+   // zero bits and crc16 all go in one transaction
+   owTxnInit(&txn);
+   AddCounterRead(&txn,SerialNum,CounterPage);
+   rd = txn.nsteps - 1;
+
+   if (!owTxnExecute(portnum,&txn))
+      return FALSE;
+
+   // extract the counter value
+   data = owTxnData(&txn,rd,&len);
+   *Count = 0;
+   for (i = 4; i >= 1; i--)
    {
-      // create a block to send that reads the counter
-      // read memory and counter command
-      send_block[send_cnt++] = 0xA5;
-      lastcrc16 = docrc16(portnum,0xA5);
-      // address of last data byte before counter
-      address = (CounterPage << 5) + 31;  // (1.02)
-      send_block[send_cnt++] = (uchar)(address & 0xFF);
-      lastcrc16 = docrc16(portnum,(ushort)(address & 0xFF));
-      send_block[send_cnt++] = (uchar)(address >> 8);
-      lastcrc16 = docrc16(portnum,(ushort)(address >> 8));
-      // now add the read bytes for data byte,counter,zero bits, crc16
-      for (i = 0; i < 11; i++)
-         send_block[send_cnt++] = 0xFF;
-
-      // now send the block
-      if (owBlock(portnum,FALSE,send_block,send_cnt))
+      *Count <<= 8;
+      *Count |= data[i];
+   }
+
+   return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Read the counters of every entry in 'readings'.  The reads are packed
+// CNT_BATCH to a transaction so each batch is one exchange with a
+// DS2480B.  The change in each counter and its rate since the previous
+// good read are worked out for entries that were already 'Valid'.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'readings' - array of counters to read, 'SerialNum' and 'CounterPage'
+//              must be set by the caller and 'Valid' must be FALSE the
+//              first time.  The rest is filled in for each counter.
+// 'num'      - number of entries in 'readings'
+//
+// Returns: number of counters with Status CNT_OK
+//
+int ReadCounterAll(int portnum, CounterReading *readings, int num)
+{
+   OWTxn txn;
+   int rd[CNT_BATCH];
+   int first, n, i, j, len, good=0;
+   uchar *data;
+   ulong count;
+   long now;
+
+   for (first = 0; first < num; first += n)
+   {
+      n = ((num - first) < CNT_BATCH) ? (num - first) : CNT_BATCH;
+
+      owTxnInit(&txn);
+      for (i = 0; i < n; i++)
       {
-         // perform the CRC16 on the last 11 bytes of packet
-         for (i = send_cnt - 11; i < send_cnt; i++)
-            lastcrc16 = docrc16(portnum,send_block[i]);
+         AddCounterRead(&txn,readings[first + i].SerialNum,
+                        readings[first + i].CounterPage);
+         rd[i] = txn.nsteps - 1;
+      }
+
+      // the CRC of each read is checked on its own so one bad counter
+      // does not spoil the rest of the batch
+      owTxnExecute(portnum,&txn);
+      now = msGettick();
 
-         // verify CRC16 is correct
-         if (lastcrc16 == 0xB001)
+      for (i = 0; i < n; i++)
+      {
+         CounterReading *cr = &readings[first + i];
+
+         data = owTxnData(&txn,rd[i],&len);
+         switch (owTxnStatus(&txn,rd[i]))
+         {
+            case OWTXN_OK:
+               break;
+            case OWTXN_CRC_ERROR:
+               // nobody answered the match
+               for (j = 0; j < len; j++)
+                  if (data[j] != 0xFF)
+                     break;
+               cr->Status = (j == len) ? CNT_NO_DEVICE : CNT_CRC_ERROR;
+               continue;
+            case OWTXN_NO_PRESENCE:
+               cr->Status = CNT_NO_DEVICE;
+               continue;
+            default:
+               cr->Status = CNT_READ_ERROR;
+               continue;
+         }
+
+         // extract the counter value
+         count = 0;
+         for (j = 4; j >= 1; j--)
          {
-            // success
-            rt = TRUE;
-            // extract the counter value
-            *Count = 0;
-            for (i = send_cnt - 7; i >= send_cnt - 10; i--)
-            {
-               *Count <<= 8;
-               *Count |= send_block[i];
-            }
+            count <<= 8;
+            count |= data[j];
          }
+
+         // the counter is 32 bits and can wrap
+         if (cr->Valid)
+         {
+            cr->Delta = (count - cr->Count) & 0xFFFFFFFFUL;
+            cr->Rate = (now > cr->Time) ? 
+                       (float)((double)cr->Delta * 1000.0 / (now - cr->Time)) : 0;
+         }
+         else
+         {
+            cr->Delta = 0;
+            cr->Rate = 0;
+         }
+
+         cr->Count = count;
+         cr->Time = now;
+         cr->Valid = TRUE;
+         cr->Status = CNT_OK;
+         good++;
       }
    }
 
-   // return the result flag rt
-   return rt;
+   return good;
+}
+
+//----------------------------------------------------------------------
+// Add the read of one counter to a transaction: reset, Match ROM, the
+// read memory and counter command and the 11 bytes to the CRC16.
+//
+// 'txn'         - transaction to add to
+// 'SerialNum'   - Serial Number of DS2423 that contains the counter
+// 'CounterPage' - page number that the counter is associated with
+//
+static void AddCounterRead(OWTxn *txn, uchar *SerialNum, int CounterPage)
+{
+   uchar cmd[3];
+   int address;
+
+   // address of last data byte before counter
+   address = (CounterPage << 5) + 31;  // (1.02)
+   cmd[0] = 0xA5;
+   cmd[1] = (uchar)(address & 0xFF);
+   cmd[2] = (uchar)(address >> 8);
+
+   owTxnReset(txn);
+   owTxnMatchROM(txn,SerialNum);
+   owTxnWrite(txn,cmd,3);
+   owTxnRead(txn,11,OWTXN_CRC16);
 }
@@ -26,11 +26,34 @@
 //
 //  cnt1D.h - Header Module to read the DS2423 - counter.
 //
-//  Version: 2.00
+//  Version: 2.01
 //
+//  History: 2.00 -> 2.01  Added ReadCounterAll to poll many counters
+//
+
+// status of a CounterReading
+#define CNT_OK              0
+#define CNT_NO_DEVICE       1
+#define CNT_CRC_ERROR       2
+#define CNT_READ_ERROR      3
+
+// one counter of a ReadCounterAll poll
+typedef struct
+{
+   uchar SerialNum[8];   // ROM of the DS2423 (set by caller)
+   int   CounterPage;    // page of the counter, 12 to 15 (set by caller)
+   ulong Count;          // counter value when Status == CNT_OK
+   ulong Delta;          // change since the last good read
+   float Rate;           // Delta in counts per second
+   long  Time;           // msGettick of the last good read
+   int   Valid;          // TRUE once Count holds a good read (set FALSE
+                         // by the caller before the first poll)
+   int   Status;         // CNT_OK or CNT_xxx error
+} CounterReading;
 
 // exportable functions defined in cnt1d.c
 SMALLINT ReadCounter(int,uchar *,int,ulong *);
+int ReadCounterAll(int,CounterReading *,int);
 
 // family codes of devices
 #define COUNT_FAMILY       0x1D
@@ -25,14 +25,16 @@
 //--------------------------------------------------------------------------
 //
 //  crcutil.c - Keeps track of the CRC for 16 and 8 bit operations
-//  version 2.00
+//  version 2.01
+//
+//  History: 2.00 -> 2.01  CRC accumulators moved to the OWPort state.
+//                         Added crc8_block and crc16_block.
 
 // Include files
 #include "ownet.h"
+#include "owport.h"
 
 // Local global variables
-ushort utilcrc16[MAX_PORTNUM];
-uchar utilcrc8[MAX_PORTNUM];
 static const short oddparity[16] = { 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0 };
 static const uchar dscrc_table[] = {
         0, 94,188,226, 97, 63,221,131,194,156,126, 32,163,253, 31, 65,
@@ -52,6 +54,414 @@ static const uchar dscrc_table[] = {
       233,183, 85, 11,136,214, 52,106, 43,117,151,201, 74, 20,246,168,
       116, 42,200,150, 21, 75,169,247,182,232, 10, 84,215,137,107, 53};
 
+#ifndef SMALL_MEMORY_TARGET
+// slicing-by-8 tables, entry [k][x] is the CRC of byte x followed by k
+// zero bytes
+static const uchar crc8_table[8][256] = {
+   {
+        0, 94,188,226, 97, 63,221,131,194,156,126, 32,163,253, 31, 65,
+      157,195, 33,127,252,162, 64, 30, 95,  1,227,189, 62, 96,130,220,
+       35,125,159,193, 66, 28,254,160,225,191, 93,  3,128,222, 60, 98,
+      190,224,  2, 92,223,129, 99, 61,124, 34,192,158, 29, 67,161,255,
+       70, 24,250,164, 39,121,155,197,132,218, 56,102,229,187, 89,  7,
+      219,133,103, 57,186,228,  6, 88, 25, 71,165,251,120, 38,196,154,
+      101, 59,217,135,  4, 90,184,230,167,249, 27, 69,198,152,122, 36,
+      248,166, 68, 26,153,199, 37,123, 58,100,134,216, 91,  5,231,185,
+      140,210, 48,110,237,179, 81, 15, 78, 16,242,172, 47,113,147,205,
+       17, 79,173,243,112, 46,204,146,211,141,111, 49,178,236, 14, 80,
+      175,241, 19, 77,206,144,114, 44,109, 51,209,143, 12, 82,176,238,
+       50,108,142,208, 83, 13,239,177,240,174, 76, 18,145,207, 45,115,
+      202,148,118, 40,171,245, 23, 73,  8, 86,180,234,105, 55,213,139,
+       87,  9,235,181, 54,104,138,212,149,203, 41,119,244,170, 72, 22,
+      233,183, 85, 11,136,214, 52,106, 43,117,151,201, 74, 20,246,168,
+      116, 42,200,150, 21, 75,169,247,182,232, 10, 84,215,137,107, 53},
+   {
+        0,196,145, 85, 59,255,170,110,118,178,231, 35, 77,137,220, 24,
+      236, 40,125,185,215, 19, 70,130,154, 94, 11,207,161,101, 48,244,
+      193,  5, 80,148,250, 62,107,175,183,115, 38,226,140, 72, 29,217,
+       45,233,188,120, 22,210,135, 67, 91,159,202, 14, 96,164,241, 53,
+      155, 95, 10,206,160,100, 49,245,237, 41,124,184,214, 18, 71,131,
+      119,179,230, 34, 76,136,221, 25,  1,197,144, 84, 58,254,171,111,
+       90,158,203, 15, 97,165,240, 52, 44,232,189,121, 23,211,134, 66,
+      182,114, 39,227,141, 73, 28,216,192,  4, 81,149,251, 63,106,174,
+       47,235,190,122, 20,208,133, 65, 89,157,200, 12, 98,166,243, 55,
+      195,  7, 82,150,248, 60,105,173,181,113, 36,224,142, 74, 31,219,
+      238, 42,127,187,213, 17, 68,128,152, 92,  9,205,163,103, 50,246,
+        2,198,147, 87, 57,253,168,108,116,176,229, 33, 79,139,222, 26,
+      180,112, 37,225,143, 75, 30,218,194,  6, 83,151,249, 61,104,172,
+       88,156,201, 13, 99,167,242, 54, 46,234,191,123, 21,209,132, 64,
+      117,177,228, 32, 78,138,223, 27,  3,199,146, 86, 56,252,169,109,
+      153, 93,  8,204,162,102, 51,247,239, 43,126,186,212, 16, 69,129},
+   {
+        0,171, 79,228,158, 53,209,122, 37,142,106,193,187, 16,244, 95,
+       74,225,  5,174,212,127,155, 48,111,196, 32,139,241, 90,190, 21,
+      148, 63,219,112, 10,161, 69,238,177, 26,254, 85, 47,132, 96,203,
+      222,117,145, 58, 64,235, 15,164,251, 80,180, 31,101,206, 42,129,
+       49,154,126,213,175,  4,224, 75, 20,191, 91,240,138, 33,197,110,
+      123,208, 52,159,229, 78,170,  1, 94,245, 17,186,192,107,143, 36,
+      165, 14,234, 65, 59,144,116,223,128, 43,207,100, 30,181, 81,250,
+      239, 68,160, 11,113,218, 62,149,202, 97,133, 46, 84,255, 27,176,
+       98,201, 45,134,252, 87,179, 24, 71,236,  8,163,217,114,150, 61,
+       40,131,103,204,182, 29,249, 82, 13,166, 66,233,147, 56,220,119,
+      246, 93,185, 18,104,195, 39,140,211,120,156, 55, 77,230,  2,169,
+      188, 23,243, 88, 34,137,109,198,153, 50,214,125,  7,172, 72,227,
+       83,248, 28,183,205,102,130, 41,118,221, 57,146,232, 67,167, 12,
+       25,178, 86,253,135, 44,200, 99, 60,151,115,216,162,  9,237, 70,
+      199,108,136, 35, 89,242, 22,189,226, 73,173,  6,124,215, 51,152,
+      141, 38,194,105, 19,184, 92,247,168,  3,231, 76, 54,157,121,210},
+   {
+        0,143,  7,136, 14,129,  9,134, 28,147, 27,148, 18,157, 21,154,
+       56,183, 63,176, 54,185, 49,190, 36,171, 35,172, 42,165, 45,162,
+      112,255,119,248,126,241,121,246,108,227,107,228, 98,237,101,234,
+       72,199, 79,192, 70,201, 65,206, 84,219, 83,220, 90,213, 93,210,
+      224,111,231,104,238, 97,233,102,252,115,251,116,242,125,245,122,
+      216, 87,223, 80,214, 89,209, 94,196, 75,195, 76,202, 69,205, 66,
+      144, 31,151, 24,158, 17,153, 22,140,  3,139,  4,130, 13,133, 10,
+      168, 39,175, 32,166, 41,161, 46,180, 59,179, 60,186, 53,189, 50,
+      217, 86,222, 81,215, 88,208, 95,197, 74,194, 77,203, 68,204, 67,
+      225,110,230,105,239, 96,232,103,253,114,250,117,243,124,244,123,
+      169, 38,174, 33,167, 40,160, 47,181, 58,178, 61,187, 52,188, 51,
+      145, 30,150, 25,159, 16,152, 23,141,  2,138,  5,131, 12,132, 11,
+       57,182, 62,177, 55,184, 48,191, 37,170, 34,173, 43,164, 44,163,
+        1,142,  6,137, 15,128,  8,135, 29,146, 26,149, 19,156, 20,155,
+       73,198, 78,193, 71,200, 64,207, 85,218, 82,221, 91,212, 92,211,
+      113,254,118,249,127,240,120,247,109,226,106,229, 99,236,100,235},
+   {
+        0,205,131, 78, 31,210,156, 81, 62,243,189,112, 33,236,162,111,
+      124,177,255, 50, 99,174,224, 45, 66,143,193, 12, 93,144,222, 19,
+      248, 53,123,182,231, 42,100,169,198, 11, 69,136,217, 20, 90,151,
+      132, 73,  7,202,155, 86, 24,213,186,119, 57,244,165,104, 38,235,
+      233, 36,106,167,246, 59,117,184,215, 26, 84,153,200,  5, 75,134,
+      149, 88, 22,219,138, 71,  9,196,171,102, 40,229,180,121, 55,250,
+       17,220,146, 95, 14,195,141, 64, 47,226,172, 97, 48,253,179,126,
+      109,160,238, 35,114,191,241, 60, 83,158,208, 29, 76,129,207,  2,
+      203,  6, 72,133,212, 25, 87,154,245, 56,118,187,234, 39,105,164,
+      183,122, 52,249,168,101, 43,230,137, 68, 10,199,150, 91, 21,216,
+       51,254,176,125, 44,225,175, 98, 13,192,142, 67, 18,223,145, 92,
+       79,130,204,  1, 80,157,211, 30,113,188,242, 63,110,163,237, 32,
+       34,239,161,108, 61,240,190,115, 28,209,159, 82,  3,206,128, 77,
+       94,147,221, 16, 65,140,194, 15, 96,173,227, 46,127,178,252, 49,
+      218, 23, 89,148,197,  8, 70,139,228, 41,103,170,251, 54,120,181,
+      166,107, 37,232,185,116, 58,247,152, 85, 27,214,135, 74,  4,201},
+   {
+        0, 55,110, 89,220,235,178,133,161,150,207,248,125, 74, 19, 36,
+       91,108, 53,  2,135,176,233,222,250,205,148,163, 38, 17, 72,127,
+      182,129,216,239,106, 93,  4, 51, 23, 32,121, 78,203,252,165,146,
+      237,218,131,180, 49,  6, 95,104, 76,123, 34, 21,144,167,254,201,
+      117, 66, 27, 44,169,158,199,240,212,227,186,141,  8, 63,102, 81,
+       46, 25, 64,119,242,197,156,171,143,184,225,214, 83,100, 61, 10,
+      195,244,173,154, 31, 40,113, 70, 98, 85, 12, 59,190,137,208,231,
+      152,175,246,193, 68,115, 42, 29, 57, 14, 87, 96,229,210,139,188,
+      234,221,132,179, 54,  1, 88,111, 75,124, 37, 18,151,160,249,206,
+      177,134,223,232,109, 90,  3, 52, 16, 39,126, 73,204,251,162,149,
+       92,107, 50,  5,128,183,238,217,253,202,147,164, 33, 22, 79,120,
+        7, 48,105, 94,219,236,181,130,166,145,200,255,122, 77, 20, 35,
+      159,168,241,198, 67,116, 45, 26, 62,  9, 80,103,226,213,140,187,
+      196,243,170,157, 24, 47,118, 65,101, 82, 11, 60,185,142,215,224,
+       41, 30, 71,112,245,194,155,172,136,191,230,209, 84, 99, 58, 13,
+      114, 69, 28, 43,174,153,192,247,211,228,189,138, 15, 56, 97, 86},
+   {
+        0, 61,122, 71,244,201,142,179,241,204,139,182,  5, 56,127, 66,
+      251,198,129,188, 15, 50,117, 72, 10, 55,112, 77,254,195,132,185,
+      239,210,149,168, 27, 38, 97, 92, 30, 35,100, 89,234,215,144,173,
+       20, 41,110, 83,224,221,154,167,229,216,159,162, 17, 44,107, 86,
+      199,250,189,128, 51, 14, 73,116, 54, 11, 76,113,194,255,184,133,
+       60,  1, 70,123,200,245,178,143,205,240,183,138, 57,  4, 67,126,
+       40, 21, 82,111,220,225,166,155,217,228,163,158, 45, 16, 87,106,
+      211,238,169,148, 39, 26, 93, 96, 34, 31, 88,101,214,235,172,145,
+      151,170,237,208, 99, 94, 25, 36,102, 91, 28, 33,146,175,232,213,
+      108, 81, 22, 43,152,165,226,223,157,160,231,218,105, 84, 19, 46,
+      120, 69,  2, 63,140,177,246,203,137,180,243,206,125, 64,  7, 58,
+      131,190,249,196,119, 74, 13, 48,114, 79,  8, 53,134,187,252,193,
+       80,109, 42, 23,164,153,222,227,161,156,219,230, 85,104, 47, 18,
+      171,150,209,236, 95, 98, 37, 24, 90,103, 32, 29,174,147,212,233,
+      191,130,197,248, 75,118, 49, 12, 78,115, 52,  9,186,135,192,253,
+       68,121, 62,  3,176,141,202,247,181,136,207,242, 65,124, 59,  6},
+   {
+        0, 67,134,197, 21, 86,147,208, 42,105,172,239, 63,124,185,250,
+       84, 23,210,145, 65,  2,199,132,126, 61,248,187,107, 40,237,174,
+      168,235, 46,109,189,254, 59,120,130,193,  4, 71,151,212, 17, 82,
+      252,191,122, 57,233,170,111, 44,214,149, 80, 19,195,128, 69,  6,
+       73, 10,207,140, 92, 31,218,153, 99, 32,229,166,118, 53,240,179,
+       29, 94,155,216,  8, 75,142,205, 55,116,177,242, 34, 97,164,231,
+      225,162,103, 36,244,183,114, 49,203,136, 77, 14,222,157, 88, 27,
+      181,246, 51,112,160,227, 38,101,159,220, 25, 90,138,201, 12, 79,
+      146,209, 20, 87,135,196,  1, 66,184,251, 62,125,173,238, 43,104,
+      198,133, 64,  3,211,144, 85, 22,236,175,106, 41,249,186,127, 60,
+       58,121,188,255, 47,108,169,234, 16, 83,150,213,  5, 70,131,192,
+      110, 45,232,171,123, 56,253,190, 68,  7,194,129, 81, 18,215,148,
+      219,152, 93, 30,206,141, 72, 11,241,178,119, 52,228,167, 98, 33,
+      143,204,  9, 74,154,217, 28, 95,165,230, 35, 96,176,243, 54,117,
+      115, 48,245,182,102, 37,224,163, 89, 26,223,156, 76, 15,202,137,
+       39,100,161,226, 50,113,180,247, 13, 78,139,200, 24, 91,158,221}};
+
+static const ushort crc16_table[8][256] = {
+   {
+      0x0000,0xC0C1,0xC181,0x0140,0xC301,0x03C0,0x0280,0xC241,
+      0xC601,0x06C0,0x0780,0xC741,0x0500,0xC5C1,0xC481,0x0440,
+      0xCC01,0x0CC0,0x0D80,0xCD41,0x0F00,0xCFC1,0xCE81,0x0E40,
+      0x0A00,0xCAC1,0xCB81,0x0B40,0xC901,0x09C0,0x0880,0xC841,
+      0xD801,0x18C0,0x1980,0xD941,0x1B00,0xDBC1,0xDA81,0x1A40,
+      0x1E00,0xDEC1,0xDF81,0x1F40,0xDD01,0x1DC0,0x1C80,0xDC41,
+      0x1400,0xD4C1,0xD581,0x1540,0xD701,0x17C0,0x1680,0xD641,
+      0xD201,0x12C0,0x1380,0xD341,0x1100,0xD1C1,0xD081,0x1040,
+      0xF001,0x30C0,0x3180,0xF141,0x3300,0xF3C1,0xF281,0x3240,
+      0x3600,0xF6C1,0xF781,0x3740,0xF501,0x35C0,0x3480,0xF441,
+      0x3C00,0xFCC1,0xFD81,0x3D40,0xFF01,0x3FC0,0x3E80,0xFE41,
+      0xFA01,0x3AC0,0x3B80,0xFB41,0x3900,0xF9C1,0xF881,0x3840,
+      0x2800,0xE8C1,0xE981,0x2940,0xEB01,0x2BC0,0x2A80,0xEA41,
+      0xEE01,0x2EC0,0x2F80,0xEF41,0x2D00,0xEDC1,0xEC81,0x2C40,
+      0xE401,0x24C0,0x2580,0xE541,0x2700,0xE7C1,0xE681,0x2640,
+      0x2200,0xE2C1,0xE381,0x2340,0xE101,0x21C0,0x2080,0xE041,
+      0xA001,0x60C0,0x6180,0xA141,0x6300,0xA3C1,0xA281,0x6240,
+      0x6600,0xA6C1,0xA781,0x6740,0xA501,0x65C0,0x6480,0xA441,
+      0x6C00,0xACC1,0xAD81,0x6D40,0xAF01,0x6FC0,0x6E80,0xAE41,
+      0xAA01,0x6AC0,0x6B80,0xAB41,0x6900,0xA9C1,0xA881,0x6840,
+      0x7800,0xB8C1,0xB981,0x7940,0xBB01,0x7BC0,0x7A80,0xBA41,
+      0xBE01,0x7EC0,0x7F80,0xBF41,0x7D00,0xBDC1,0xBC81,0x7C40,
+      0xB401,0x74C0,0x7580,0xB541,0x7700,0xB7C1,0xB681,0x7640,
+      0x7200,0xB2C1,0xB381,0x7340,0xB101,0x71C0,0x7080,0xB041,
+      0x5000,0x90C1,0x9181,0x5140,0x9301,0x53C0,0x5280,0x9241,
+      0x9601,0x56C0,0x5780,0x9741,0x5500,0x95C1,0x9481,0x5440,
+      0x9C01,0x5CC0,0x5D80,0x9D41,0x5F00,0x9FC1,0x9E81,0x5E40,
+      0x5A00,0x9AC1,0x9B81,0x5B40,0x9901,0x59C0,0x5880,0x9841,
+      0x8801,0x48C0,0x4980,0x8941,0x4B00,0x8BC1,0x8A81,0x4A40,
+      0x4E00,0x8EC1,0x8F81,0x4F40,0x8D01,0x4DC0,0x4C80,0x8C41,
+      0x4400,0x84C1,0x8581,0x4540,0x8701,0x47C0,0x4680,0x8641,
+      0x8201,0x42C0,0x4380,0x8341,0x4100,0x81C1,0x8081,0x4040},
+   {
+      0x0000,0x9001,0x6001,0xF000,0xC002,0x5003,0xA003,0x3002,
+      0xC007,0x5006,0xA006,0x3007,0x0005,0x9004,0x6004,0xF005,
+      0xC00D,0x500C,0xA00C,0x300D,0x000F,0x900E,0x600E,0xF00F,
+      0x000A,0x900B,0x600B,0xF00A,0xC008,0x5009,0xA009,0x3008,
+      0xC019,0x5018,0xA018,0x3019,0x001B,0x901A,0x601A,0xF01B,
+      0x001E,0x901F,0x601F,0xF01E,0xC01C,0x501D,0xA01D,0x301C,
+      0x0014,0x9015,0x6015,0xF014,0xC016,0x5017,0xA017,0x3016,
+      0xC013,0x5012,0xA012,0x3013,0x0011,0x9010,0x6010,0xF011,
+      0xC031,0x5030,0xA030,0x3031,0x0033,0x9032,0x6032,0xF033,
+      0x0036,0x9037,0x6037,0xF036,0xC034,0x5035,0xA035,0x3034,
+      0x003C,0x903D,0x603D,0xF03C,0xC03E,0x503F,0xA03F,0x303E,
+      0xC03B,0x503A,0xA03A,0x303B,0x0039,0x9038,0x6038,0xF039,
+      0x0028,0x9029,0x6029,0xF028,0xC02A,0x502B,0xA02B,0x302A,
+      0xC02F,0x502E,0xA02E,0x302F,0x002D,0x902C,0x602C,0xF02D,
+      0xC025,0x5024,0xA024,0x3025,0x0027,0x9026,0x6026,0xF027,
+      0x0022,0x9023,0x6023,0xF022,0xC020,0x5021,0xA021,0x3020,
+      0xC061,0x5060,0xA060,0x3061,0x0063,0x9062,0x6062,0xF063,
+      0x0066,0x9067,0x6067,0xF066,0xC064,0x5065,0xA065,0x3064,
+      0x006C,0x906D,0x606D,0xF06C,0xC06E,0x506F,0xA06F,0x306E,
+      0xC06B,0x506A,0xA06A,0x306B,0x0069,0x9068,0x6068,0xF069,
+      0x0078,0x9079,0x6079,0xF078,0xC07A,0x507B,0xA07B,0x307A,
+      0xC07F,0x507E,0xA07E,0x307F,0x007D,0x907C,0x607C,0xF07D,
+      0xC075,0x5074,0xA074,0x3075,0x0077,0x9076,0x6076,0xF077,
+      0x0072,0x9073,0x6073,0xF072,0xC070,0x5071,0xA071,0x3070,
+      0x0050,0x9051,0x6051,0xF050,0xC052,0x5053,0xA053,0x3052,
+      0xC057,0x5056,0xA056,0x3057,0x0055,0x9054,0x6054,0xF055,
+      0xC05D,0x505C,0xA05C,0x305D,0x005F,0x905E,0x605E,0xF05F,
+      0x005A,0x905B,0x605B,0xF05A,0xC058,0x5059,0xA059,0x3058,
+      0xC049,0x5048,0xA048,0x3049,0x004B,0x904A,0x604A,0xF04B,
+      0x004E,0x904F,0x604F,0xF04E,0xC04C,0x504D,0xA04D,0x304C,
+      0x0044,0x9045,0x6045,0xF044,0xC046,0x5047,0xA047,0x3046,
+      0xC043,0x5042,0xA042,0x3043,0x0041,0x9040,0x6040,0xF041},
+   {
+      0x0000,0xC051,0xC0A1,0x00F0,0xC141,0x0110,0x01E0,0xC1B1,
+      0xC281,0x02D0,0x0220,0xC271,0x03C0,0xC391,0xC361,0x0330,
+      0xC501,0x0550,0x05A0,0xC5F1,0x0440,0xC411,0xC4E1,0x04B0,
+      0x0780,0xC7D1,0xC721,0x0770,0xC6C1,0x0690,0x0660,0xC631,
+      0xCA01,0x0A50,0x0AA0,0xCAF1,0x0B40,0xCB11,0xCBE1,0x0BB0,
+      0x0880,0xC8D1,0xC821,0x0870,0xC9C1,0x0990,0x0960,0xC931,
+      0x0F00,0xCF51,0xCFA1,0x0FF0,0xCE41,0x0E10,0x0EE0,0xCEB1,
+      0xCD81,0x0DD0,0x0D20,0xCD71,0x0CC0,0xCC91,0xCC61,0x0C30,
+      0xD401,0x1450,0x14A0,0xD4F1,0x1540,0xD511,0xD5E1,0x15B0,
+      0x1680,0xD6D1,0xD621,0x1670,0xD7C1,0x1790,0x1760,0xD731,
+      0x1100,0xD151,0xD1A1,0x11F0,0xD041,0x1010,0x10E0,0xD0B1,
+      0xD381,0x13D0,0x1320,0xD371,0x12C0,0xD291,0xD261,0x1230,
+      0x1E00,0xDE51,0xDEA1,0x1EF0,0xDF41,0x1F10,0x1FE0,0xDFB1,
+      0xDC81,0x1CD0,0x1C20,0xDC71,0x1DC0,0xDD91,0xDD61,0x1D30,
+      0xDB01,0x1B50,0x1BA0,0xDBF1,0x1A40,0xDA11,0xDAE1,0x1AB0,
+      0x1980,0xD9D1,0xD921,0x1970,0xD8C1,0x1890,0x1860,0xD831,
+      0xE801,0x2850,0x28A0,0xE8F1,0x2940,0xE911,0xE9E1,0x29B0,
+      0x2A80,0xEAD1,0xEA21,0x2A70,0xEBC1,0x2B90,0x2B60,0xEB31,
+      0x2D00,0xED51,0xEDA1,0x2DF0,0xEC41,0x2C10,0x2CE0,0xECB1,
+      0xEF81,0x2FD0,0x2F20,0xEF71,0x2EC0,0xEE91,0xEE61,0x2E30,
+      0x2200,0xE251,0xE2A1,0x22F0,0xE341,0x2310,0x23E0,0xE3B1,
+      0xE081,0x20D0,0x2020,0xE071,0x21C0,0xE191,0xE161,0x2130,
+      0xE701,0x2750,0x27A0,0xE7F1,0x2640,0xE611,0xE6E1,0x26B0,
+      0x2580,0xE5D1,0xE521,0x2570,0xE4C1,0x2490,0x2460,0xE431,
+      0x3C00,0xFC51,0xFCA1,0x3CF0,0xFD41,0x3D10,0x3DE0,0xFDB1,
+      0xFE81,0x3ED0,0x3E20,0xFE71,0x3FC0,0xFF91,0xFF61,0x3F30,
+      0xF901,0x3950,0x39A0,0xF9F1,0x3840,0xF811,0xF8E1,0x38B0,
+      0x3B80,0xFBD1,0xFB21,0x3B70,0xFAC1,0x3A90,0x3A60,0xFA31,
+      0xF601,0x3650,0x36A0,0xF6F1,0x3740,0xF711,0xF7E1,0x37B0,
+      0x3480,0xF4D1,0xF421,0x3470,0xF5C1,0x3590,0x3560,0xF531,
+      0x3300,0xF351,0xF3A1,0x33F0,0xF241,0x3210,0x32E0,0xF2B1,
+      0xF181,0x31D0,0x3120,0xF171,0x30C0,0xF091,0xF061,0x3030},
+   {
+      0x0000,0xFC01,0xB801,0x4400,0x3001,0xCC00,0x8800,0x7401,
+      0x6002,0x9C03,0xD803,0x2402,0x5003,0xAC02,0xE802,0x1403,
+      0xC004,0x3C05,0x7805,0x8404,0xF005,0x0C04,0x4804,0xB405,
+      0xA006,0x5C07,0x1807,0xE406,0x9007,0x6C06,0x2806,0xD407,
+      0xC00B,0x3C0A,0x780A,0x840B,0xF00A,0x0C0B,0x480B,0xB40A,
+      0xA009,0x5C08,0x1808,0xE409,0x9008,0x6C09,0x2809,0xD408,
+      0x000F,0xFC0E,0xB80E,0x440F,0x300E,0xCC0F,0x880F,0x740E,
+      0x600D,0x9C0C,0xD80C,0x240D,0x500C,0xAC0D,0xE80D,0x140C,
+      0xC015,0x3C14,0x7814,0x8415,0xF014,0x0C15,0x4815,0xB414,
+      0xA017,0x5C16,0x1816,0xE417,0x9016,0x6C17,0x2817,0xD416,
+      0x0011,0xFC10,0xB810,0x4411,0x3010,0xCC11,0x8811,0x7410,
+      0x6013,0x9C12,0xD812,0x2413,0x5012,0xAC13,0xE813,0x1412,
+      0x001E,0xFC1F,0xB81F,0x441E,0x301F,0xCC1E,0x881E,0x741F,
+      0x601C,0x9C1D,0xD81D,0x241C,0x501D,0xAC1C,0xE81C,0x141D,
+      0xC01A,0x3C1B,0x781B,0x841A,0xF01B,0x0C1A,0x481A,0xB41B,
+      0xA018,0x5C19,0x1819,0xE418,0x9019,0x6C18,0x2818,0xD419,
+      0xC029,0x3C28,0x7828,0x8429,0xF028,0x0C29,0x4829,0xB428,
+      0xA02B,0x5C2A,0x182A,0xE42B,0x902A,0x6C2B,0x282B,0xD42A,
+      0x002D,0xFC2C,0xB82C,0x442D,0x302C,0xCC2D,0x882D,0x742C,
+      0x602F,0x9C2E,0xD82E,0x242F,0x502E,0xAC2F,0xE82F,0x142E,
+      0x0022,0xFC23,0xB823,0x4422,0x3023,0xCC22,0x8822,0x7423,
+      0x6020,0x9C21,0xD821,0x2420,0x5021,0xAC20,0xE820,0x1421,
+      0xC026,0x3C27,0x7827,0x8426,0xF027,0x0C26,0x4826,0xB427,
+      0xA024,0x5C25,0x1825,0xE424,0x9025,0x6C24,0x2824,0xD425,
+      0x003C,0xFC3D,0xB83D,0x443C,0x303D,0xCC3C,0x883C,0x743D,
+      0x603E,0x9C3F,0xD83F,0x243E,0x503F,0xAC3E,0xE83E,0x143F,
+      0xC038,0x3C39,0x7839,0x8438,0xF039,0x0C38,0x4838,0xB439,
+      0xA03A,0x5C3B,0x183B,0xE43A,0x903B,0x6C3A,0x283A,0xD43B,
+      0xC037,0x3C36,0x7836,0x8437,0xF036,0x0C37,0x4837,0xB436,
+      0xA035,0x5C34,0x1834,0xE435,0x9034,0x6C35,0x2835,0xD434,
+      0x0033,0xFC32,0xB832,0x4433,0x3032,0xCC33,0x8833,0x7432,
+      0x6031,0x9C30,0xD830,0x2431,0x5030,0xAC31,0xE831,0x1430},
+   {
+      0x0000,0xC03D,0xC079,0x0044,0xC0F1,0x00CC,0x0088,0xC0B5,
+      0xC1E1,0x01DC,0x0198,0xC1A5,0x0110,0xC12D,0xC169,0x0154,
+      0xC3C1,0x03FC,0x03B8,0xC385,0x0330,0xC30D,0xC349,0x0374,
+      0x0220,0xC21D,0xC259,0x0264,0xC2D1,0x02EC,0x02A8,0xC295,
+      0xC781,0x07BC,0x07F8,0xC7C5,0x0770,0xC74D,0xC709,0x0734,
+      0x0660,0xC65D,0xC619,0x0624,0xC691,0x06AC,0x06E8,0xC6D5,
+      0x0440,0xC47D,0xC439,0x0404,0xC4B1,0x048C,0x04C8,0xC4F5,
+      0xC5A1,0x059C,0x05D8,0xC5E5,0x0550,0xC56D,0xC529,0x0514,
+      0xCF01,0x0F3C,0x0F78,0xCF45,0x0FF0,0xCFCD,0xCF89,0x0FB4,
+      0x0EE0,0xCEDD,0xCE99,0x0EA4,0xCE11,0x0E2C,0x0E68,0xCE55,
+      0x0CC0,0xCCFD,0xCCB9,0x0C84,0xCC31,0x0C0C,0x0C48,0xCC75,
+      0xCD21,0x0D1C,0x0D58,0xCD65,0x0DD0,0xCDED,0xCDA9,0x0D94,
+      0x0880,0xC8BD,0xC8F9,0x08C4,0xC871,0x084C,0x0808,0xC835,
+      0xC961,0x095C,0x0918,0xC925,0x0990,0xC9AD,0xC9E9,0x09D4,
+      0xCB41,0x0B7C,0x0B38,0xCB05,0x0BB0,0xCB8D,0xCBC9,0x0BF4,
+      0x0AA0,0xCA9D,0xCAD9,0x0AE4,0xCA51,0x0A6C,0x0A28,0xCA15,
+      0xDE01,0x1E3C,0x1E78,0xDE45,0x1EF0,0xDECD,0xDE89,0x1EB4,
+      0x1FE0,0xDFDD,0xDF99,0x1FA4,0xDF11,0x1F2C,0x1F68,0xDF55,
+      0x1DC0,0xDDFD,0xDDB9,0x1D84,0xDD31,0x1D0C,0x1D48,0xDD75,
+      0xDC21,0x1C1C,0x1C58,0xDC65,0x1CD0,0xDCED,0xDCA9,0x1C94,
+      0x1980,0xD9BD,0xD9F9,0x19C4,0xD971,0x194C,0x1908,0xD935,
+      0xD861,0x185C,0x1818,0xD825,0x1890,0xD8AD,0xD8E9,0x18D4,
+      0xDA41,0x1A7C,0x1A38,0xDA05,0x1AB0,0xDA8D,0xDAC9,0x1AF4,
+      0x1BA0,0xDB9D,0xDBD9,0x1BE4,0xDB51,0x1B6C,0x1B28,0xDB15,
+      0x1100,0xD13D,0xD179,0x1144,0xD1F1,0x11CC,0x1188,0xD1B5,
+      0xD0E1,0x10DC,0x1098,0xD0A5,0x1010,0xD02D,0xD069,0x1054,
+      0xD2C1,0x12FC,0x12B8,0xD285,0x1230,0xD20D,0xD249,0x1274,
+      0x1320,0xD31D,0xD359,0x1364,0xD3D1,0x13EC,0x13A8,0xD395,
+      0xD681,0x16BC,0x16F8,0xD6C5,0x1670,0xD64D,0xD609,0x1634,
+      0x1760,0xD75D,0xD719,0x1724,0xD791,0x17AC,0x17E8,0xD7D5,
+      0x1540,0xD57D,0xD539,0x1504,0xD5B1,0x158C,0x15C8,0xD5F5,
+      0xD4A1,0x149C,0x14D8,0xD4E5,0x1450,0xD46D,0xD429,0x1414},
+   {
+      0x0000,0xD101,0xE201,0x3300,0x8401,0x5500,0x6600,0xB701,
+      0x4801,0x9900,0xAA00,0x7B01,0xCC00,0x1D01,0x2E01,0xFF00,
+      0x9002,0x4103,0x7203,0xA302,0x1403,0xC502,0xF602,0x2703,
+      0xD803,0x0902,0x3A02,0xEB03,0x5C02,0x8D03,0xBE03,0x6F02,
+      0x6007,0xB106,0x8206,0x5307,0xE406,0x3507,0x0607,0xD706,
+      0x2806,0xF907,0xCA07,0x1B06,0xAC07,0x7D06,0x4E06,0x9F07,
+      0xF005,0x2104,0x1204,0xC305,0x7404,0xA505,0x9605,0x4704,
+      0xB804,0x6905,0x5A05,0x8B04,0x3C05,0xED04,0xDE04,0x0F05,
+      0xC00E,0x110F,0x220F,0xF30E,0x440F,0x950E,0xA60E,0x770F,
+      0x880F,0x590E,0x6A0E,0xBB0F,0x0C0E,0xDD0F,0xEE0F,0x3F0E,
+      0x500C,0x810D,0xB20D,0x630C,0xD40D,0x050C,0x360C,0xE70D,
+      0x180D,0xC90C,0xFA0C,0x2B0D,0x9C0C,0x4D0D,0x7E0D,0xAF0C,
+      0xA009,0x7108,0x4208,0x9309,0x2408,0xF509,0xC609,0x1708,
+      0xE808,0x3909,0x0A09,0xDB08,0x6C09,0xBD08,0x8E08,0x5F09,
+      0x300B,0xE10A,0xD20A,0x030B,0xB40A,0x650B,0x560B,0x870A,
+      0x780A,0xA90B,0x9A0B,0x4B0A,0xFC0B,0x2D0A,0x1E0A,0xCF0B,
+      0xC01F,0x111E,0x221E,0xF31F,0x441E,0x951F,0xA61F,0x771E,
+      0x881E,0x591F,0x6A1F,0xBB1E,0x0C1F,0xDD1E,0xEE1E,0x3F1F,
+      0x501D,0x811C,0xB21C,0x631D,0xD41C,0x051D,0x361D,0xE71C,
+      0x181C,0xC91D,0xFA1D,0x2B1C,0x9C1D,0x4D1C,0x7E1C,0xAF1D,
+      0xA018,0x7119,0x4219,0x9318,0x2419,0xF518,0xC618,0x1719,
+      0xE819,0x3918,0x0A18,0xDB19,0x6C18,0xBD19,0x8E19,0x5F18,
+      0x301A,0xE11B,0xD21B,0x031A,0xB41B,0x651A,0x561A,0x871B,
+      0x781B,0xA91A,0x9A1A,0x4B1B,0xFC1A,0x2D1B,0x1E1B,0xCF1A,
+      0x0011,0xD110,0xE210,0x3311,0x8410,0x5511,0x6611,0xB710,
+      0x4810,0x9911,0xAA11,0x7B10,0xCC11,0x1D10,0x2E10,0xFF11,
+      0x9013,0x4112,0x7212,0xA313,0x1412,0xC513,0xF613,0x2712,
+      0xD812,0x0913,0x3A13,0xEB12,0x5C13,0x8D12,0xBE12,0x6F13,
+      0x6016,0xB117,0x8217,0x5316,0xE417,0x3516,0x0616,0xD717,
+      0x2817,0xF916,0xCA16,0x1B17,0xAC16,0x7D17,0x4E17,0x9F16,
+      0xF014,0x2115,0x1215,0xC314,0x7415,0xA514,0x9614,0x4715,
+      0xB815,0x6914,0x5A14,0x8B15,0x3C14,0xED15,0xDE15,0x0F14},
+   {
+      0x0000,0xC010,0xC023,0x0033,0xC045,0x0055,0x0066,0xC076,
+      0xC089,0x0099,0x00AA,0xC0BA,0x00CC,0xC0DC,0xC0EF,0x00FF,
+      0xC111,0x0101,0x0132,0xC122,0x0154,0xC144,0xC177,0x0167,
+      0x0198,0xC188,0xC1BB,0x01AB,0xC1DD,0x01CD,0x01FE,0xC1EE,
+      0xC221,0x0231,0x0202,0xC212,0x0264,0xC274,0xC247,0x0257,
+      0x02A8,0xC2B8,0xC28B,0x029B,0xC2ED,0x02FD,0x02CE,0xC2DE,
+      0x0330,0xC320,0xC313,0x0303,0xC375,0x0365,0x0356,0xC346,
+      0xC3B9,0x03A9,0x039A,0xC38A,0x03FC,0xC3EC,0xC3DF,0x03CF,
+      0xC441,0x0451,0x0462,0xC472,0x0404,0xC414,0xC427,0x0437,
+      0x04C8,0xC4D8,0xC4EB,0x04FB,0xC48D,0x049D,0x04AE,0xC4BE,
+      0x0550,0xC540,0xC573,0x0563,0xC515,0x0505,0x0536,0xC526,
+      0xC5D9,0x05C9,0x05FA,0xC5EA,0x059C,0xC58C,0xC5BF,0x05AF,
+      0x0660,0xC670,0xC643,0x0653,0xC625,0x0635,0x0606,0xC616,
+      0xC6E9,0x06F9,0x06CA,0xC6DA,0x06AC,0xC6BC,0xC68F,0x069F,
+      0xC771,0x0761,0x0752,0xC742,0x0734,0xC724,0xC717,0x0707,
+      0x07F8,0xC7E8,0xC7DB,0x07CB,0xC7BD,0x07AD,0x079E,0xC78E,
+      0xC881,0x0891,0x08A2,0xC8B2,0x08C4,0xC8D4,0xC8E7,0x08F7,
+      0x0808,0xC818,0xC82B,0x083B,0xC84D,0x085D,0x086E,0xC87E,
+      0x0990,0xC980,0xC9B3,0x09A3,0xC9D5,0x09C5,0x09F6,0xC9E6,
+      0xC919,0x0909,0x093A,0xC92A,0x095C,0xC94C,0xC97F,0x096F,
+      0x0AA0,0xCAB0,0xCA83,0x0A93,0xCAE5,0x0AF5,0x0AC6,0xCAD6,
+      0xCA29,0x0A39,0x0A0A,0xCA1A,0x0A6C,0xCA7C,0xCA4F,0x0A5F,
+      0xCBB1,0x0BA1,0x0B92,0xCB82,0x0BF4,0xCBE4,0xCBD7,0x0BC7,
+      0x0B38,0xCB28,0xCB1B,0x0B0B,0xCB7D,0x0B6D,0x0B5E,0xCB4E,
+      0x0CC0,0xCCD0,0xCCE3,0x0CF3,0xCC85,0x0C95,0x0CA6,0xCCB6,
+      0xCC49,0x0C59,0x0C6A,0xCC7A,0x0C0C,0xCC1C,0xCC2F,0x0C3F,
+      0xCDD1,0x0DC1,0x0DF2,0xCDE2,0x0D94,0xCD84,0xCDB7,0x0DA7,
+      0x0D58,0xCD48,0xCD7B,0x0D6B,0xCD1D,0x0D0D,0x0D3E,0xCD2E,
+      0xCEE1,0x0EF1,0x0EC2,0xCED2,0x0EA4,0xCEB4,0xCE87,0x0E97,
+      0x0E68,0xCE78,0xCE4B,0x0E5B,0xCE2D,0x0E3D,0x0E0E,0xCE1E,
+      0x0FF0,0xCFE0,0xCFD3,0x0FC3,0xCFB5,0x0FA5,0x0F96,0xCF86,
+      0xCF79,0x0F69,0x0F5A,0xCF4A,0x0F3C,0xCF2C,0xCF1F,0x0F0F},
+   {
+      0x0000,0xCCC1,0xD981,0x1540,0xF301,0x3FC0,0x2A80,0xE641,
+      0xA601,0x6AC0,0x7F80,0xB341,0x5500,0x99C1,0x8C81,0x4040,
+      0x0C01,0xC0C0,0xD580,0x1941,0xFF00,0x33C1,0x2681,0xEA40,
+      0xAA00,0x66C1,0x7381,0xBF40,0x5901,0x95C0,0x8080,0x4C41,
+      0x1802,0xD4C3,0xC183,0x0D42,0xEB03,0x27C2,0x3282,0xFE43,
+      0xBE03,0x72C2,0x6782,0xAB43,0x4D02,0x81C3,0x9483,0x5842,
+      0x1403,0xD8C2,0xCD82,0x0143,0xE702,0x2BC3,0x3E83,0xF242,
+      0xB202,0x7EC3,0x6B83,0xA742,0x4103,0x8DC2,0x9882,0x5443,
+      0x3004,0xFCC5,0xE985,0x2544,0xC305,0x0FC4,0x1A84,0xD645,
+      0x9605,0x5AC4,0x4F84,0x8345,0x6504,0xA9C5,0xBC85,0x7044,
+      0x3C05,0xF0C4,0xE584,0x2945,0xCF04,0x03C5,0x1685,0xDA44,
+      0x9A04,0x56C5,0x4385,0x8F44,0x6905,0xA5C4,0xB084,0x7C45,
+      0x2806,0xE4C7,0xF187,0x3D46,0xDB07,0x17C6,0x0286,0xCE47,
+      0x8E07,0x42C6,0x5786,0x9B47,0x7D06,0xB1C7,0xA487,0x6846,
+      0x2407,0xE8C6,0xFD86,0x3147,0xD706,0x1BC7,0x0E87,0xC246,
+      0x8206,0x4EC7,0x5B87,0x9746,0x7107,0xBDC6,0xA886,0x6447,
+      0x6008,0xACC9,0xB989,0x7548,0x9309,0x5FC8,0x4A88,0x8649,
+      0xC609,0x0AC8,0x1F88,0xD349,0x3508,0xF9C9,0xEC89,0x2048,
+      0x6C09,0xA0C8,0xB588,0x7949,0x9F08,0x53C9,0x4689,0x8A48,
+      0xCA08,0x06C9,0x1389,0xDF48,0x3909,0xF5C8,0xE088,0x2C49,
+      0x780A,0xB4CB,0xA18B,0x6D4A,0x8B0B,0x47CA,0x528A,0x9E4B,
+      0xDE0B,0x12CA,0x078A,0xCB4B,0x2D0A,0xE1CB,0xF48B,0x384A,
+      0x740B,0xB8CA,0xAD8A,0x614B,0x870A,0x4BCB,0x5E8B,0x924A,
+      0xD20A,0x1ECB,0x0B8B,0xC74A,0x210B,0xEDCA,0xF88A,0x344B,
+      0x500C,0x9CCD,0x898D,0x454C,0xA30D,0x6FCC,0x7A8C,0xB64D,
+      0xF60D,0x3ACC,0x2F8C,0xE34D,0x050C,0xC9CD,0xDC8D,0x104C,
+      0x5C0D,0x90CC,0x858C,0x494D,0xAF0C,0x63CD,0x768D,0xBA4C,
+      0xFA0C,0x36CD,0x238D,0xEF4C,0x090D,0xC5CC,0xD08C,0x1C4D,
+      0x480E,0x84CF,0x918F,0x5D4E,0xBB0F,0x77CE,0x628E,0xAE4F,
+      0xEE0F,0x22CE,0x378E,0xFB4F,0x1D0E,0xD1CF,0xC48F,0x084E,
+      0x440F,0x88CE,0x9D8E,0x514F,0xB70E,0x7BCF,0x6E8F,0xA24E,
+      0xE20E,0x2ECF,0x3B8F,0xF74E,0x110F,0xDDCE,0xC88E,0x044F}};
+#endif
+
 //--------------------------------------------------------------------------
 // Reset crc16 to the value passed in
 //
@@ -59,7 +469,7 @@ static const uchar dscrc_table[] = {
 //
 void setcrc16(int portnum, ushort reset)
 {
-   utilcrc16[portnum] = reset;
+   owGetPort(portnum)->utilcrc16 = reset;
    return;
 }
 
@@ -72,7 +482,7 @@ void setcrc16(int portnum, ushort reset)
 //
 void setcrc8(int portnum, uchar reset)
 {
-   utilcrc8[portnum] = reset;
+   owGetPort(portnum)->utilcrc8 = reset;
    return;
 }
 
@@ -88,18 +498,20 @@ void setcrc8(int portnum, uchar reset)
 //
 ushort docrc16(int portnum, ushort cdata)
 {
-   cdata = (cdata ^ (utilcrc16[portnum] & 0xff)) & 0xff;
-   utilcrc16[portnum] >>= 8;
+   OWPort *port = owGetPort(portnum);
+
+   cdata = (cdata ^ (port->utilcrc16 & 0xff)) & 0xff;
+   port->utilcrc16 >>= 8;
 
    if (oddparity[cdata & 0xf] ^ oddparity[cdata >> 4])
-     utilcrc16[portnum] ^= 0xc001;
+     port->utilcrc16 ^= 0xc001;
 
    cdata <<= 6;
-   utilcrc16[portnum]   ^= cdata;
+   port->utilcrc16   ^= cdata;
    cdata <<= 1;
-   utilcrc16[portnum]   ^= cdata;
+   port->utilcrc16   ^= cdata;
 
-   return utilcrc16[portnum];
+   return port->utilcrc16;
 }
 
 //--------------------------------------------------------------------------
@@ -114,6 +526,94 @@ ushort docrc16(int portnum, ushort cdata)
 //
 uchar docrc8(int portnum, uchar x)
 {
-   utilcrc8[portnum] = dscrc_table[utilcrc8[portnum] ^ x];
-   return utilcrc8[portnum];
+   OWPort *port = owGetPort(portnum);
+
+   port->utilcrc8 = dscrc_table[port->utilcrc8 ^ x];
+   return port->utilcrc8;
+}
+
+//--------------------------------------------------------------------------
+// Calculate the CRC8 of a block of bytes.  The port accumulator is not
+// used so this can be called from any thread.
+//
+// 'seed'     - starting CRC8, 0 for a new calculation or a previous
+//              result to continue one
+// 'buf'      - bytes to perform the CRC8 on
+// 'len'      - number of bytes in 'buf'
+//
+// Returns: the CRC8 after the last byte, 0 if the block ended with
+//          a correct CRC8
+//
+uchar crc8_block(uchar seed, uchar *buf, int len)
+{
+   uchar crc = seed;
+
+#ifndef SMALL_MEMORY_TARGET
+   // 8 bytes at a time
+   while (len >= 8)
+   {
+      crc = crc8_table[7][crc ^ buf[0]] ^ crc8_table[6][buf[1]] ^
+            crc8_table[5][buf[2]] ^ crc8_table[4][buf[3]] ^
+            crc8_table[3][buf[4]] ^ crc8_table[2][buf[5]] ^
+            crc8_table[1][buf[6]] ^ crc8_table[0][buf[7]];
+      buf += 8;
+      len -= 8;
+   }
+#endif
+
+   while (len-- > 0)
+      crc = dscrc_table[crc ^ *buf++];
+
+   return crc;
+}
+
+//--------------------------------------------------------------------------
+// Calculate the CRC16 of a block of bytes.  The port accumulator is not
+// used so this can be called from any thread.
+//
+// 'seed'     - starting CRC16, 0 (or the page number) for a new
+//              calculation or a previous result to continue one
+// 'buf'      - bytes to perform the CRC16 on
+// 'len'      - number of bytes in 'buf'
+//
+// Returns: the CRC16 after the last byte, 0xB001 if the block ended
+//          with a correct inverted CRC16
+//
+ushort crc16_block(ushort seed, uchar *buf, int len)
+{
+   ushort crc = seed;
+#ifdef SMALL_MEMORY_TARGET
+   ushort cdata;
+
+   while (len-- > 0)
+   {
+      cdata = (*buf++ ^ (crc & 0xff)) & 0xff;
+      crc >>= 8;
+
+      if (oddparity[cdata & 0xf] ^ oddparity[cdata >> 4])
+        crc ^= 0xc001;
+
+      cdata <<= 6;
+      crc ^= cdata;
+      cdata <<= 1;
+      crc ^= cdata;
+   }
+#else
+   // 8 bytes at a time
+   while (len >= 8)
+   {
+      crc = crc16_table[7][(crc ^ buf[0]) & 0xff] ^
+            crc16_table[6][((crc >> 8) ^ buf[1]) & 0xff] ^
+            crc16_table[5][buf[2]] ^ crc16_table[4][buf[3]] ^
+            crc16_table[3][buf[4]] ^ crc16_table[2][buf[5]] ^
+            crc16_table[1][buf[6]] ^ crc16_table[0][buf[7]];
+      buf += 8;
+      len -= 8;
+   }
+
+   while (len-- > 0)
+      crc = (crc >> 8) ^ crc16_table[0][(crc ^ *buf++) & 0xff];
+#endif
+
+   return crc;
 }
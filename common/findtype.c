@@ -26,13 +26,20 @@
 //
 //  findtype.c - Test module to find all devices of one type.
 //
-//  Version: 2.00
+//  Version: 2.03
+//
+//  History: 2.00 -> 2.01  Use owSearchAll, stop at the end of the family.
+//           2.01 -> 2.02  The devices come from an owInvScan of the port.
+//           2.02 -> 2.03  Bit 7 of the family code is ignored again and
+//                         at most MAXDEVICES-1 devices are returned, as
+//                         in 2.00.
 //
 //----------------------------------------------------------------------
 //
 //
 #include "ownet.h"
 #include "findtype.h"
+#include "owinv.h"
 
 //----------------------------------------------------------------------
 // Search for devices
@@ -51,28 +58,27 @@
 //
 SMALLINT FindDevices(int portnum, uchar FamilySN[][8], SMALLINT family_code, int MAXDEVICES)
 {
-   int NumDevices=0;
+   int num,max = MAXDEVICES - 1;
+
+   // one search of the port, the inventory then also answers owInvFind
+   // and owInvFamily for the other families without searching again
+   num = owInvScan(portnum);
 
-   // find the devices
-   // set the search to first find that family code
-   owFamilySearchSetup(portnum,family_code);
+   if (max <= 0)
+      return 0;
 
-   // loop to find all of the devices up to MAXDEVICES
-   NumDevices = 0;
-   do
+   // no memory for the inventory or more devices than it keeps, search
+   // for the family code with bit 7 clear and then with it set
+   if ((num < 0) || (num >= OWINV_DEVICES))
    {
-      // perform the search
-      if (!owNext(portnum,TRUE, FALSE))
-         break;
-         
-      owSerialNum(portnum,FamilySN[NumDevices], TRUE);
-      if ((FamilySN[NumDevices][0] & 0x7F) == (family_code & 0x7F))
-      {
-         NumDevices++;
-      }
+      num = owSearchAll(portnum,FamilySN,max,(SMALLINT)(family_code & 0x7F),FALSE);
+      if ((num < max) && (family_code & 0x7F))
+         num += owSearchAll(portnum,&FamilySN[num],max - num,
+                            (SMALLINT)((family_code & 0x7F) | 0x80),FALSE);
+      return num;
    }
-   while (NumDevices < (MAXDEVICES - 1));
 
-   // check if not at least 1 device
-   return NumDevices;
+   // the devices of that family code, either way bit 7 is, up to
+   // MAXDEVICES-1
+   return owInvFamily(portnum,family_code,FamilySN,max);
 }
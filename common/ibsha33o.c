@@ -26,16 +26,18 @@
 //
 //  ibsha33o.C - SHA-iButton utility functions
 //
-//  Version:   2.00
-//  History:
+//  Version:   2.03
+//  History:   2.00 -> 2.01  ComputeSHAEE uses the MAC engine in shamac.c
+//             2.01 -> 2.02  in_overdrive moved to the OWPort state
+//             2.02 -> 2.03  SelectSHAEE ends the owsess.c session before
+//                           its Overdrive Skip ROM
 //
 #include <stdio.h>
 #include "ownet.h"
+#include "owport.h"
+#include "owsess.h"
 #include "ibsha33.h"
-
-// globals
-int in_overdrive[MAX_PORTNUM];
-
+#include "shamac.h"
 
 //----------------------------------------------------------------------
 // Read the scratchpad with CRC16 verification
@@ -778,7 +780,7 @@ int SelectSHAEE(int portnum)
       if (rt != 1)
       {
          // if in overdrive, drop back
-         if (in_overdrive[portnum])
+         if (owGetPort(portnum)->InOverdrive)
          {
             // set to normal speed
             if(MODE_NORMAL != owSpeed(portnum,MODE_NORMAL))
@@ -786,13 +788,15 @@ int SelectSHAEE(int portnum)
                OWERROR(OWERROR_WRITE_BYTE_FAILED);
                return FALSE;
             }
-            in_overdrive[portnum] = FALSE;
+            owGetPort(portnum)->InOverdrive = FALSE;
          }
       }
       // present but not in overdrive
-      else if (!in_overdrive[portnum])
+      else if (!owGetPort(portnum)->InOverdrive)
       {
-         // put all devices in overdrive
+         // put all devices in overdrive, the device of the session is
+         // deselected and may not be at its session speed any more
+         owSessionEnd(portnum);
          if (owTouchReset(portnum))
          {
             if (owWriteByte(portnum,0x3C))
@@ -803,7 +807,7 @@ int SelectSHAEE(int portnum)
                   OWERROR(OWERROR_WRITE_BYTE_FAILED);
                   return FALSE;
                }
-               in_overdrive[portnum] = TRUE;
+               owGetPort(portnum)->InOverdrive = TRUE;
             }
          }
          rt = 0;
@@ -835,38 +839,20 @@ int SelectSHAEE(int portnum)
 //
 void ComputeSHAEE(unsigned int *MT,long *A,long *B, long *C, long *D,long *E)
 {
-   unsigned long MTword[80];
+   uchar MTbyte[64];
+   uint32_t hash[5];
    int i;
-   long ShftTmp;
-   long Temp;
-
-   for(i=0;i<16;i++)
-      MTword[i] = (MT[i*4] << 24) | (MT[i*4+1] << 16) |
-                  (MT[i*4+2] << 8) | MT[i*4+3];
 
-   for(i=16;i<80;i++)
-   {
-      ShftTmp = MTword[i-3] ^ MTword[i-8] ^ MTword[i-14] ^ MTword[i-16];
-      MTword[i] = ((ShftTmp << 1) & 0xfffffffe) |
-                  ((ShftTmp >> 31) & 0x00000001);
-   }
+   for(i=0;i<64;i++)
+      MTbyte[i] = (uchar)MT[i];
 
-   *A=0x67452301;
-   *B=0xefcdab89;
-   *C=0x98badcfe;
-   *D=0x10325476;
-   *E=0xc3d2e1f0;
+   ComputeSHAMAC(MTbyte,hash);
 
-   for(i=0;i<80;i++)
-   {
-      ShftTmp = ((*A << 5) & 0xffffffe0) | ((*A >> 27) & 0x0000001f);
-      Temp = NLF(*B,*C,*D,i) + *E + KTN(i) + MTword[i] + ShftTmp;
-      *E = *D;
-      *D = *C;
-      *C = ((*B << 30) & 0xc0000000) | ((*B >> 2) & 0x3fffffff);
-      *B = *A;
-      *A = Temp;
-   }
+   *A = (long)hash[0];
+   *B = (long)hash[1];
+   *C = (long)hash[2];
+   *D = (long)hash[3];
+   *E = (long)hash[4];
 }
 
 // calculation used for the MAC
@@ -435,9 +435,7 @@ SMALLINT readPagePacketAppReg(SMALLINT bank, int portnum, uchar *SNum, int page,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort)((getStartingAddressAppReg(bank,SNum)/PAGE_LENGTH) + page));
-   for(i=0;i<(raw_buf[0]+3);i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort)((getStartingAddressAppReg(bank,SNum)/PAGE_LENGTH) + page),raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0xB001)
    {
@@ -508,9 +506,7 @@ SMALLINT readPagePacketExtraAppReg(SMALLINT bank, int portnum, uchar *SNum,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort) ((getStartingAddressAppReg(bank,SNum)/PAGE_LENGTH) + page));
-   for(i=0;i<(raw_buf[0]+3);i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort) ((getStartingAddressAppReg(bank,SNum)/PAGE_LENGTH) + page),raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0xB001)
    {
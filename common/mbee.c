@@ -386,9 +386,7 @@ SMALLINT readPagePacketEE(SMALLINT bank, int portnum, uchar *SNum, int page,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort) ((getStartingAddressEE(bank,SNum)/PAGE_LENGTH) + page));
-   for(i=0;i<raw_buf[0]+3;i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort) ((getStartingAddressEE(bank,SNum)/PAGE_LENGTH) + page),raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0xB001)
    {
@@ -778,9 +778,7 @@ SMALLINT readPagePacketEE77(SMALLINT bank, int portnum, uchar *SNum, int page,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort)page);
-   for(i=0;i<raw_buf[0]+3;i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort)page,raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0xB001)
    {
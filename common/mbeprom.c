@@ -594,9 +594,7 @@ SMALLINT readPagePacketEPROM(SMALLINT bank, int portnum, uchar *SNum, int page,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort) ((getStartingAddressEPROM(bank,SNum)/PAGE_LENGTH_EPROM) + page));
-   for(i=0;i<(raw_buf[0]+3);i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort) ((getStartingAddressEPROM(bank,SNum)/PAGE_LENGTH_EPROM) + page),raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0xB001)
    {
@@ -666,9 +664,7 @@ SMALLINT readPagePacketExtraEPROM(SMALLINT bank, int portnum, uchar *SNum,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort) ((getStartingAddressEPROM(bank,SNum)/PAGE_LENGTH_EPROM) + page));
-   for(i=0;i<(raw_buf[0]+3);i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort) ((getStartingAddressEPROM(bank,SNum)/PAGE_LENGTH_EPROM) + page),raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0xB001)
    {
@@ -25,10 +25,13 @@
 //--------------------------------------------------------------------------
 //
 //  mbNV.c - Reads and writes to memory locations for the NV memory bank.
-//  version 1.00
+//  version 1.01
+//
+//  History: 1.00 -> 1.01  readNV streams any length in OW_BLOCK_MAX blocks.
 //
 
 // Include Files
+#include <string.h>
 #include "ownet.h"
 #include "mbnv.h"
 #include "mbscr.h"
@@ -91,8 +94,8 @@ SMALLINT readNV(SMALLINT bank, int portnum, uchar *SNum, int str_add,
                 SMALLINT rd_cont, uchar *buff, int len)
 {
 
-   int i,addr,pgs,extra;
-   uchar raw_buf[PAGE_LENGTH_NV];
+   int i,n,addr,head_len = 0;
+   uchar raw_buf[OW_BLOCK_MAX];
 
    // check if read exceeds memory
    if ((str_add + len) > getSizeNV(bank,SNum))
@@ -120,29 +123,33 @@ SMALLINT readNV(SMALLINT bank, int portnum, uchar *SNum, int str_add,
       raw_buf[0] = READ_MEMORY_COMMAND_NV;
       raw_buf[1] = addr & 0xFF;
       raw_buf[2] = ((addr & 0xFFFF) >> 8) & 0xFF;
+      head_len = 3;
+   }
+
+   // one Read Memory command streams across the pages so read the data 
+   // in blocks without re-selecting, the first block also carries the 
+   // command and address
+   i = 0;
+   do
+   {
+      n = len - i;
+      if (n > (OW_BLOCK_MAX - head_len))
+         n = OW_BLOCK_MAX - head_len;
+
+      // pre-fill with 0xFF 
+      memset(&raw_buf[head_len],0xFF,n);
 
-      // do the first block for command, address
-      if(!owBlock(portnum,FALSE,raw_buf,3))
+      if(!owBlock(portnum,FALSE,raw_buf,(SMALLINT)(head_len + n)))
       {
          OWERROR(OWERROR_BLOCK_FAILED);
          return FALSE;
       }
 
+      memcpy(&buff[i],&raw_buf[head_len],n);
+      i += n;
+      head_len = 0;
    }
-
-   // pre-fill readBuf with 0xFF 
-   pgs   = len / PAGE_LENGTH_NV;
-   extra = len % PAGE_LENGTH_NV;
-
-   for(i=0;i<(pgs*PAGE_LENGTH_NV)+extra;i++)
-      buff[i] = 0xFF;
-
-   // send second block to read data, return result
-   if(!owBlock(portnum,FALSE,buff,len))
-   {
-      OWERROR(OWERROR_BLOCK_FAILED);
-      return FALSE;
-   }
+   while (i < len);
 
    return TRUE;
 }
@@ -510,9 +517,7 @@ SMALLINT readPagePacketNV(SMALLINT bank, int portnum, uchar *SNum, int page,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort) ((getStartingAddressNV(bank,SNum)/PAGE_LENGTH_NV) + page));
-   for(i=0;i<(raw_buf[0]+3);i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort) ((getStartingAddressNV(bank,SNum)/PAGE_LENGTH_NV) + page),raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0xB001)
    {
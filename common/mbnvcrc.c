@@ -30,6 +30,7 @@
 //
 
 // Include files
+#include <string.h>
 #include "ownet.h"
 #include "mbnv.h"
 #include "mbnvcrc.h"
@@ -162,6 +163,115 @@ SMALLINT readPageCRCNVCRC(SMALLINT bank, int portnum, uchar *SNum, int page,
                   extra,getExtraInfoLengthNV(bank,SNum));
 }
 
+/**
+ * Read a run of memory pages with CRC verification provided by the
+ * device.  One Read Page with CRC command is sent and the pages are
+ * clocked out in blocks of up to OW_BLOCK_MAX bytes, each page checked
+ * against the CRC16 the device sends after it.  Banks that can not 
+ * continue a read from page to page are read a page at a time.
+ *
+ * bank      to tell what memory bank of the ibutton to use.
+ * portnum   the port number of the port being used for the
+ *           1-Wire Network.
+ * SNum      the serial number for the part.
+ * page      the first page to read
+ * num_pages the number of pages to read
+ * buff      byte array for num_pages * 32 bytes of page data
+ *
+ * @return - returns '0' if the read wasn't completed.
+ *                   '1' if the operation is complete.
+ */
+SMALLINT readPagesCRCNVCRC(SMALLINT bank, int portnum, uchar *SNum, int page,
+                           int num_pages, uchar *buff)
+{
+   uchar blk[OW_BLOCK_MAX];
+   uchar extra[8];
+   int i,n,per_blk,addr,rec,extra_len,head_len;
+   ushort lastcrc16;
+
+   extra_len = getExtraInfoLengthNV(bank,SNum);
+
+   // pages with verification bytes are addressed one at a time
+   if (!readPossible(bank,SNum) || (numVerifyBytes(bank,SNum) != 0))
+   {
+      for(i=0;i<num_pages;i++)
+         if(!readCRC(bank,portnum,SNum,page + i,FALSE,
+                     &buff[i * PAGE_LENGTH_NVCRC],extra,extra_len))
+            return FALSE;
+
+      return TRUE;
+   }
+
+   // only needs to be implemented if supported by hardware
+   if (!hasPageAutoCRCNV(bank,SNum))
+   {
+      OWERROR(OWERROR_CRC_NOT_SUPPORTED);
+      return FALSE;
+   }
+
+   // check if read exceeds memory
+   if ((page < 0) || ((page + num_pages) > getNumberPagesNV(bank,SNum)))
+   {
+      OWERROR(OWERROR_READ_OUT_OF_RANGE);
+      return FALSE;
+   }
+
+   owSerialNum(portnum,SNum,FALSE);
+
+   // select the device
+   if (!owAccess(portnum))
+   {
+      OWERROR(OWERROR_DEVICE_SELECT_FAIL);
+      return FALSE;
+   }
+
+   // build start reading memory block
+   addr = page * PAGE_LENGTH_NVCRC + getStartingAddressNV(bank,SNum);
+   blk[0] = READ_PAGE_WITH_CRC;
+   blk[1] = addr & 0xFF;
+   blk[2] = ((addr & 0xFFFF) >> 8) & 0xFF;
+   head_len = 3;
+
+   // each page is followed by its extra info and CRC16
+   rec = PAGE_LENGTH_NVCRC + extra_len + 2;
+
+   for(i=0;i<num_pages;i+=per_blk)
+   {
+      per_blk = (OW_BLOCK_MAX - head_len) / rec;
+      if (per_blk > (num_pages - i))
+         per_blk = num_pages - i;
+
+      // pre-fill with 0xFF 
+      memset(&blk[head_len],0xFF,per_blk * rec);
+
+      if(!owBlock(portnum,FALSE,blk,(SMALLINT)(head_len + per_blk * rec)))
+      {
+         OWERROR(OWERROR_BLOCK_FAILED);
+         return FALSE;
+      }
+
+      for(n=0;n<per_blk;n++)
+      {
+         // the CRC of the first page also covers the command and address
+         lastcrc16 = (n == 0) ? crc16_block(0,blk,head_len) : 0;
+         lastcrc16 = crc16_block(lastcrc16,&blk[head_len + n * rec],rec);
+
+         if(lastcrc16 != 0xB001)
+         {
+            OWERROR(OWERROR_CRC_FAILED);
+            return FALSE;
+         }
+
+         memcpy(&buff[(i + n) * PAGE_LENGTH_NVCRC],&blk[head_len + n * rec],
+                PAGE_LENGTH_NVCRC);
+      }
+
+      head_len = 0;
+   }
+
+   return TRUE;
+}
+
 /**
  * Read a Universal Data Packet and extra information.  
  *
@@ -203,9 +313,8 @@ SMALLINT readPagePacketExtraNVCRC(SMALLINT bank, int portnum, uchar *SNum,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort) ((getStartingAddressNV(bank,SNum)/PAGE_LENGTH_NVCRC) + page));
-   for(i=0;i<(raw_buf[0]+3);i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort) ((getStartingAddressNV(bank,SNum)/PAGE_LENGTH_NVCRC) + page),
+                           raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0xB001)
    {
@@ -292,9 +401,7 @@ SMALLINT readCRC(SMALLINT bank, int portnum, uchar *SNum, int page, SMALLINT rd_
       raw_buf[2] = ((addr & 0xFFFF) >> 8) & 0xFF;
 
       // perform CRC16 on first part
-      setcrc16(portnum,lastcrc16);
-      for(i=0;i<3;i++)
-         lastcrc16 = docrc16(portnum,raw_buf[i]);
+      lastcrc16 = crc16_block(lastcrc16,raw_buf,3);
 
       // do the first block for command, TA1, TA2
       if(!owBlock(portnum,FALSE,raw_buf,3))
@@ -318,9 +425,7 @@ SMALLINT readCRC(SMALLINT bank, int portnum, uchar *SNum, int page, SMALLINT rd_
 
 
    // check the CRC
-   setcrc16(portnum,lastcrc16);
-   for(i=0;i<(PAGE_LENGTH_NVCRC+extra_len+2);i++)
-      lastcrc16 = docrc16(portnum,read_buf[i]);
+   lastcrc16 = crc16_block(lastcrc16,read_buf,PAGE_LENGTH_NVCRC+extra_len+2);
 
    if(lastcrc16 != 0xB001)
    {
@@ -350,7 +455,7 @@ SMALLINT readCRC(SMALLINT bank, int portnum, uchar *SNum, int page, SMALLINT rd_
  */
 SMALLINT readPossible(SMALLINT bank, uchar *SNum)
 {
-   SMALLINT possible;
+   SMALLINT possible = TRUE;
    
    switch(SNum[0])
    {
@@ -384,7 +489,7 @@ SMALLINT readPossible(SMALLINT bank, uchar *SNum)
  */
 SMALLINT numVerifyBytes(SMALLINT bank, uchar *SNum)
 {
-   SMALLINT verify;
+   SMALLINT verify = 0;
 
    switch(SNum[0])
    {
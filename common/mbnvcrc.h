@@ -41,6 +41,8 @@ SMALLINT readPageExtraCRCNVCRC(SMALLINT bank, int portnum, uchar *SNum, int page
                                uchar *read_buff, uchar *extra);
 SMALLINT readPageCRCNVCRC(SMALLINT bank, int portnum, uchar *SNum, int page,
                           uchar *buff);
+SMALLINT readPagesCRCNVCRC(SMALLINT bank, int portnum, uchar *SNum, int page,
+                           int num_pages, uchar *buff);
 SMALLINT readPagePacketExtraNVCRC(SMALLINT bank, int portnum, uchar *SNum, 
                                   int page, SMALLINT rd_cont, uchar *buff,
                                   int *len, uchar *extra);
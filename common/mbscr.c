@@ -453,9 +453,7 @@ SMALLINT readPagePacketScratch(SMALLINT bank, int portnum, uchar *SNum, int page
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort)((getStartingAddressScratch(bank,SNum)/PAGE_LENGTH_SCR) + page));
-   for(i=0;i<raw_buf[0]+3;i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort)((getStartingAddressScratch(bank,SNum)/PAGE_LENGTH_SCR) + page),raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0xB001)
    {
@@ -527,9 +525,7 @@ SMALLINT readPagePacketExtraScratch(SMALLINT bank, int portnum, uchar *SNum,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort)((getStartingAddressScratch(bank,SNum)/PAGE_LENGTH_SCR) + page));
-   for(i=0;i<raw_buf[0]+3;i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort)((getStartingAddressScratch(bank,SNum)/PAGE_LENGTH_SCR) + page),raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0xB001)
    {
@@ -178,9 +178,7 @@ SMALLINT readScratchPadCRC(int portnum, uchar *buff, int len, uchar *extra)
    num_crc = 35 - (addr & 0x001F) + 3;
 
    // check crc of entire block
-   setcrc16(portnum,0);
-   for(i=0;i<num_crc;i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block(0,raw_buf,num_crc);
 
    if(lastcrc16 != 0xB001)
    {
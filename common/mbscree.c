@@ -95,9 +95,7 @@ SMALLINT writeScratchPadEE(int portnum,int str_add, uchar *writeBuf, int len)
    if(send_len == (PAGE_LENGTH_SCRATCH_EE+5))
    {
       // verify the CRC is correct
-      setcrc16(portnum,0);
-      for(i=0;i<(raw_buf[0]+3);i++)
-         lastcrc16 = docrc16(portnum,raw_buf[i]);
+      lastcrc16 = crc16_block(0,raw_buf,raw_buf[0]+3);
 
       if(lastcrc16 == 0xB001)
       {
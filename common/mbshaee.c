@@ -25,12 +25,15 @@
 //--------------------------------------------------------------------------
 //
 //  mbSHAEE.c - Reads and writes to memory locations for the SHAEE memory bank.
-//  version 1.00
+//  version 1.01
+//
+//  History: 1.00 -> 1.01  ComputeSHA uses the MAC engine in shamac.c
 //
 
 // Include Files
 #include "ownet.h"
 #include "mbshaee.h"
+#include "shamac.h"
 
 long KTN (int n);
 long NLF (long B, long C, long D, int n);
@@ -472,9 +475,7 @@ SMALLINT readPagePacketSHAEE(SMALLINT bank, int portnum, uchar *SNum, int page,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort)((getStartingAddressSHAEE(bank,SNum)/PAGE_LENGTH_SHAEE) + page));
-   for(i=0;i<(raw_buf[0]+3);i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort)((getStartingAddressSHAEE(bank,SNum)/PAGE_LENGTH_SHAEE) + page),raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0x0000B001)
    {
@@ -551,9 +552,7 @@ SMALLINT readPagePacketExtraSHAEE(SMALLINT bank, int portnum, uchar *SNum,
    }
 
    // verify the CRC is correct
-   setcrc16(portnum,(ushort)((getStartingAddressSHAEE(bank,SNum)/PAGE_LENGTH_SHAEE) + page));
-   for(i=0;i<(raw_buf[0]+3);i++)
-      lastcrc16 = docrc16(portnum,raw_buf[i]);
+   lastcrc16 = crc16_block((ushort)((getStartingAddressSHAEE(bank,SNum)/PAGE_LENGTH_SHAEE) + page),raw_buf,raw_buf[0]+3);
 
    if(lastcrc16 == 0x0000B001)
    {
@@ -1870,38 +1869,20 @@ void setChallenge(uchar *new_challenge)
 //
 void ComputeSHA(unsigned int *MT,long *A,long *B, long *C, long *D,long *E)
 {
-   unsigned long MTword[80];
+   uchar MTbyte[64];
+   uint32_t hash[5];
    int i;
-   long ShftTmp;
-   long Temp;
 
-   for(i=0;i<16;i++)
-      MTword[i] = (MT[i*4] << 24) | (MT[i*4+1] << 16) |
-                  (MT[i*4+2] << 8) | MT[i*4+3];
+   for(i=0;i<64;i++)
+      MTbyte[i] = (uchar)MT[i];
 
-   for(i=16;i<80;i++)
-   {
-      ShftTmp = MTword[i-3] ^ MTword[i-8] ^ MTword[i-14] ^ MTword[i-16];
-      MTword[i] = ((ShftTmp << 1) & 0xfffffffe) |
-                  ((ShftTmp >> 31) & 0x00000001);
-   }
-
-   *A=0x67452301;
-   *B=0xefcdab89;
-   *C=0x98badcfe;
-   *D=0x10325476;
-   *E=0xc3d2e1f0;
+   ComputeSHAMAC(MTbyte,hash);
 
-   for(i=0;i<80;i++)
-   {
-      ShftTmp = ((*A << 5) & 0xffffffe0) | ((*A >> 27) & 0x0000001f);
-      Temp = NLF(*B,*C,*D,i) + *E + KTN(i) + MTword[i] + ShftTmp;
-      *E = *D;
-      *D = *C;
-      *C = ((*B << 30) & 0xc0000000) | ((*B >> 2) & 0x3fffffff);
-      *B = *A;
-      *A = Temp;
-   }
+   *A = (long)hash[0];
+   *B = (long)hash[1];
+   *C = (long)hash[2];
+   *D = (long)hash[3];
+   *E = (long)hash[4];
 }
 
 // calculation used for the MAC
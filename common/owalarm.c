@@ -0,0 +1,261 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owalarm.c - Alarm polling.  The handlers of a port are kept in the
+//              OWPort 'alarm'.  The alarming devices are all found
+//              before any of them is read so the handlers do not upset
+//              the search.
+//
+//  Version: 3.00
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "ownet.h"
+#include "owport.h"
+#include "owalarm.h"
+#include "temp10.h"
+#include "swt12.h"
+#include "time04.h"
+
+// DS18x20 families
+#define DS1820_FAM         0x10
+#define DS1822_FAM         0x22
+#define DS18B20_FAM        0x28
+// DS2406 family
+#define DS2406_FAM         0x12
+
+// handler of one family
+typedef struct
+{
+   uchar          family;
+   OWAlarmHandler handler;
+   void          *arg;
+} AlarmHandler;
+
+// handlers kept in the OWPort 'alarm'
+typedef struct
+{
+   int          num;
+   AlarmHandler h[OWALARM_HANDLERS];
+} AlarmTable;
+
+//--------------------------------------------------------------------------
+// Register the handler for the alarming devices of a family.  A handler
+// already registered for the family is replaced.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'family'   - family code
+// 'handler'  - function to read the device and clear its alarm, NULL to
+//              remove the handler of the family
+// 'arg'      - passed to 'handler'
+//
+// Returns:  TRUE  registered
+//           FALSE no memory or OWALARM_HANDLERS families already have one
+//
+SMALLINT owAlarmRegister(int portnum, uchar family, OWAlarmHandler handler, void *arg)
+{
+   OWPort *port = owGetPort(portnum);
+   AlarmTable *table = (AlarmTable *)port->alarm;
+   int i;
+
+   if (table == NULL)
+   {
+      if (handler == NULL)
+         return TRUE;
+      table = (AlarmTable *)calloc(1,sizeof(AlarmTable));
+      if (table == NULL)
+      {
+         OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+         return FALSE;
+      }
+      port->alarm = table;
+   }
+
+   for (i = 0; i < table->num; i++)
+      if (table->h[i].family == family)
+         break;
+
+   if (handler == NULL)
+   {
+      if (i < table->num)
+      {
+         table->num--;
+         table->h[i] = table->h[table->num];
+      }
+      return TRUE;
+   }
+
+   if (i == OWALARM_HANDLERS)
+      return FALSE;
+   if (i == table->num)
+      table->num++;
+
+   table->h[i].family = family;
+   table->h[i].handler = handler;
+   table->h[i].arg = arg;
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Register the handlers of this module: DS18x20 temperature alarms,
+// DS2406 activity latches and DS1994 clock alarms.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+void owAlarmDefaults(int portnum)
+{
+   owAlarmRegister(portnum,DS1820_FAM,owAlarmTemp,NULL);
+   owAlarmRegister(portnum,DS1822_FAM,owAlarmTemp,NULL);
+   owAlarmRegister(portnum,DS18B20_FAM,owAlarmTemp,NULL);
+   owAlarmRegister(portnum,DS2406_FAM,owAlarmSwitch12,NULL);
+   owAlarmRegister(portnum,TIME_FAM,owAlarmClock,NULL);
+}
+
+//--------------------------------------------------------------------------
+// Find the devices in an alarm state with a conditional search and read
+// each of them with the handler of its family.  The current serial
+// number of the port is left as it was.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'alarms'   - receives an entry for each alarming device, in search
+//              order
+// 'max'      - number of entries 'alarms' can hold, the devices past it
+//              are left for the next poll
+//
+// Returns:  number of entries filled in
+//
+int owAlarmPoll(int portnum, OWAlarm *alarms, int max)
+{
+   AlarmTable *table = (AlarmTable *)owGetPort(portnum)->alarm;
+   uchar saved[8];
+   SMALLINT rslt;
+   int i,j,num = 0;
+
+   owSerialNum(portnum,saved,TRUE);
+
+   // find them all first, reading one would end the search
+   rslt = owFirst(portnum,TRUE,TRUE);
+   while (rslt && (num < max))
+   {
+      memset(&alarms[num],0,sizeof(OWAlarm));
+      owSerialNum(portnum,alarms[num].SerialNum,TRUE);
+      num++;
+      rslt = owNext(portnum,TRUE,TRUE);
+   }
+
+   for (i = 0; i < num; i++)
+   {
+      alarms[i].Status = OWALARM_NO_HANDLER;
+      for (j = 0; (table != NULL) && (j < table->num); j++)
+         if (table->h[j].family == alarms[i].SerialNum[0])
+         {
+            alarms[i].Status = table->h[j].handler(portnum,&alarms[i],table->h[j].arg) ?
+                               OWALARM_OK : OWALARM_READ_ERROR;
+            break;
+         }
+   }
+
+   owSerialNum(portnum,saved,FALSE);
+   return num;
+}
+
+//--------------------------------------------------------------------------
+// Remove every handler of a port.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+void owAlarmStop(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+
+   free(port->alarm);
+   port->alarm = NULL;
+}
+
+//--------------------------------------------------------------------------
+// DS18x20 handler.  The alarm flag is set by a conversion outside of
+// TL..TH, so the temperature of that conversion is read without starting
+// another.  The flag clears at the first conversion back in range, the
+// application starts those, for example with ConvertTemperatureAll
+// before each poll.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'alarm'    - device to read, 'Temp' is filled in
+// 'arg'      - not used
+//
+// Returns:  TRUE if the temperature was read
+//
+SMALLINT owAlarmTemp(int portnum, OWAlarm *alarm, void *arg)
+{
+   return ReadLastTemperature(portnum,alarm->SerialNum,&alarm->Temp);
+}
+
+//--------------------------------------------------------------------------
+// DS2406 handler.  The device alarms as set up in its status memory,
+// usually on the activity latch, which is cleared by the read.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'alarm'    - device to read, 'Info' is filled in with the channel info
+//              byte read before the latches were cleared
+// 'arg'      - not used
+//
+// Returns:  TRUE if the channel info byte was read
+//
+SMALLINT owAlarmSwitch12(int portnum, OWAlarm *alarm, void *arg)
+{
+   owSerialNum(portnum,alarm->SerialNum,FALSE);
+   alarm->Info = ReadSwitch12(portnum,TRUE);
+   return (alarm->Info >= 0);
+}
+
+//--------------------------------------------------------------------------
+// DS1994/DS2404 handler.  Reading the status register clears the alarm
+// indicators (RTF, ITF and CCF).
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'alarm'    - device to read, 'Info' is filled in with the status
+//              register
+// 'arg'      - not used
+//
+// Returns:  TRUE if the status register was read
+//
+SMALLINT owAlarmClock(int portnum, OWAlarm *alarm, void *arg)
+{
+   uchar status;
+
+   if (!getStatusRegister(portnum,alarm->SerialNum,&status))
+      return FALSE;
+   alarm->Info = status;
+   return TRUE;
+}
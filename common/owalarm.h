@@ -0,0 +1,73 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owalarm.h - Alarm polling.  owAlarmPoll runs one conditional search
+//              (0xEC) and reads only the devices that answer it with the
+//              handler registered for their family, which also clears
+//              the alarm.  On a quiet bus a poll is one search that
+//              finds nothing.
+//
+//  Version: 3.00
+//
+
+#ifndef OWALARM_H
+#define OWALARM_H
+
+#include "ownet.h"
+
+// status of an OWAlarm
+#define OWALARM_OK             0
+#define OWALARM_READ_ERROR     1     // the handler could not read the device
+#define OWALARM_NO_HANDLER     2     // no handler for the family
+
+// families that can have a handler on each port
+#define OWALARM_HANDLERS       16
+
+// one alarming device found by owAlarmPoll
+typedef struct
+{
+   uchar SerialNum[8];
+   int   Status;               // OWALARM_xxx
+   float Temp;                 // DS18x20 temperature
+   int   Info;                 // DS2406 channel info byte, DS1994 status
+                               // register
+} OWAlarm;
+
+// reads an alarming device into 'alarm' and clears its alarm
+typedef SMALLINT (*OWAlarmHandler)(int portnum, OWAlarm *alarm, void *arg);
+
+// functions defined in owalarm.c
+SMALLINT owAlarmRegister(int portnum, uchar family, OWAlarmHandler handler, void *arg);
+void     owAlarmDefaults(int portnum);
+int      owAlarmPoll(int portnum, OWAlarm *alarms, int max);
+void     owAlarmStop(int portnum);
+
+// handlers of owAlarmDefaults
+SMALLINT owAlarmTemp(int portnum, OWAlarm *alarm, void *arg);
+SMALLINT owAlarmSwitch12(int portnum, OWAlarm *alarm, void *arg);
+SMALLINT owAlarmClock(int portnum, OWAlarm *alarm, void *arg);
+
+#endif
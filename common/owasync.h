@@ -0,0 +1,74 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owasync.h - Asynchronous DS2480B packet exchanges for the Linux link
+//              (linuxlnk.c).  A request holds a packet to write and the
+//              number of response bytes to read.  The I/O of every started
+//              port is driven from one epoll file descriptor that the
+//              caller can put in its own event loop, no call blocks unless
+//              asked to wait.  Linux only (epoll and timerfd).
+//
+//  Version: 3.00
+//
+
+#ifndef OWASYNC_H
+#define OWASYNC_H
+
+#include "ownet.h"
+
+// request status
+#define OWASYNC_OK             0     // all bytes written and read
+#define OWASYNC_PENDING        1     // queued or in progress
+#define OWASYNC_TIMEOUT        2     // response did not arrive in time
+#define OWASYNC_IOERROR        3     // read or write failed
+#define OWASYNC_CANCELLED      4     // port stopped before it ran
+
+// a packet exchange with the adapter on a port, owned by the caller
+// until it comes back from owAsyncComplete
+typedef struct owAsyncRequest
+{
+   uchar     *sendbuf;              // packet to write
+   int        sendlen;              // length of the packet
+   uchar     *readbuf;              // buffer for the response
+   int        readlen;              // number of response bytes expected
+   int        portnum;              // port the request was submitted to
+   int        status;               // OWASYNC_xxx
+   int        count;                // response bytes read
+   void      *arg;                  // for the caller
+   int        sent;                 // bytes written (internal)
+   long long  deadline;             // time out in us (internal)
+   struct owAsyncRequest *next;     // queue link (internal)
+} owAsyncRequest;
+
+// functions defined in linuxlnk.c
+int             owAsyncFd(void);
+SMALLINT        owAsyncStart(int portnum);
+void            owAsyncStop(int portnum);
+SMALLINT        owAsyncSubmit(int portnum, owAsyncRequest *req, uchar *sendbuf,
+                              int sendlen, uchar *readbuf, int readlen);
+owAsyncRequest *owAsyncComplete(int timeout_ms);
+
+#endif
@@ -0,0 +1,301 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owbus.c - Multi-bus runtime.  owBusStart gives an acquired port its
+//            own worker thread and request queue.  Requests are handed
+//            to a port with owBusSubmit and come back, from any port, in
+//            the order they finish from owBusComplete.  A port must only
+//            be used from its worker thread once it has been started.
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  owBusStop takes the worker off the port under
+//                         BusLock before freeing it
+//
+
+#include "ownet.h"
+#include "owport.h"
+#include "owbus.h"
+
+#ifdef OW_THREADS
+
+#include <pthread.h>
+#include <errno.h>
+#include <sys/time.h>
+
+// worker state for one port, kept in OWPort 'bus'
+typedef struct
+{
+   int             portnum;
+   pthread_t       thread;
+   pthread_mutex_t lock;
+   pthread_cond_t  ready;
+   owBusRequest   *head;           // requests waiting for the worker
+   owBusRequest   *tail;
+   SMALLINT        stop;
+} owBusWorker;
+
+// held for reading while a request is queued on a worker and for
+// writing while a worker is attached to or taken off its port, so a
+// worker is never freed under owBusSubmit
+static pthread_rwlock_t BusLock = PTHREAD_RWLOCK_INITIALIZER;
+
+// finished requests from all of the ports
+static pthread_mutex_t DoneLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  DoneReady = PTHREAD_COND_INITIALIZER;
+static owBusRequest   *DoneHead = NULL;
+static owBusRequest   *DoneTail = NULL;
+
+// local functions
+static void *BusWorker(void *);
+
+//--------------------------------------------------------------------------
+// Start the worker thread for a port.  The port must already be
+// acquired.
+//
+// 'portnum'  - number 0 to OWPORT_MAX-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+// Returns: TRUE(1)  worker running
+//          FALSE(0) could not start the thread
+//
+SMALLINT owBusStart(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+   owBusWorker *worker;
+
+   pthread_rwlock_wrlock(&BusLock);
+
+   // already running
+   if (port->bus != NULL)
+   {
+      pthread_rwlock_unlock(&BusLock);
+      return TRUE;
+   }
+
+   worker = (owBusWorker *)calloc(1,sizeof(owBusWorker));
+   if (worker == NULL)
+   {
+      pthread_rwlock_unlock(&BusLock);
+      OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+      return FALSE;
+   }
+   worker->portnum = portnum;
+   pthread_mutex_init(&worker->lock,NULL);
+   pthread_cond_init(&worker->ready,NULL);
+
+   if (pthread_create(&worker->thread,NULL,BusWorker,worker) != 0)
+   {
+      pthread_cond_destroy(&worker->ready);
+      pthread_mutex_destroy(&worker->lock);
+      free(worker);
+      pthread_rwlock_unlock(&BusLock);
+      OWERROR(OWERROR_SYSTEM_RESOURCE_INIT_FAILED);
+      return FALSE;
+   }
+
+   port->bus = worker;
+   pthread_rwlock_unlock(&BusLock);
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Stop the worker thread of a port.  Requests already submitted are
+// finished first, new ones are refused.
+//
+// 'portnum'  - number 0 to OWPORT_MAX-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+void owBusStop(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+   owBusWorker *worker;
+
+   // take the worker off the port, no owBusSubmit can be using it after
+   pthread_rwlock_wrlock(&BusLock);
+   worker = (owBusWorker *)port->bus;
+   port->bus = NULL;
+   pthread_rwlock_unlock(&BusLock);
+
+   if (worker == NULL)
+      return;
+
+   pthread_mutex_lock(&worker->lock);
+   worker->stop = TRUE;
+   pthread_cond_signal(&worker->ready);
+   pthread_mutex_unlock(&worker->lock);
+
+   pthread_join(worker->thread,NULL);
+   pthread_cond_destroy(&worker->ready);
+   pthread_mutex_destroy(&worker->lock);
+   free(worker);
+}
+
+//--------------------------------------------------------------------------
+// Queue a request on the worker thread of a port.
+//
+// 'portnum'  - number 0 to OWPORT_MAX-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'req'      - request to fill in and queue, it must stay valid until
+//              it is returned by owBusComplete
+// 'func'     - function to run on the worker thread
+// 'arg'      - argument for 'func'
+//
+// Returns: TRUE(1)  request queued
+//          FALSE(0) the port has no worker
+//
+SMALLINT owBusSubmit(int portnum, owBusRequest *req, owBusFunc func, void *arg)
+{
+   owBusWorker *worker;
+
+   pthread_rwlock_rdlock(&BusLock);
+   worker = (owBusWorker *)owGetPort(portnum)->bus;
+   if (worker == NULL)
+   {
+      pthread_rwlock_unlock(&BusLock);
+      OWERROR(OWERROR_PORTNUM_ERROR);
+      return FALSE;
+   }
+
+   req->func = func;
+   req->arg = arg;
+   req->portnum = portnum;
+   req->result = 0;
+   req->error = 0;
+   req->next = NULL;
+
+   pthread_mutex_lock(&worker->lock);
+   if (worker->tail != NULL)
+      worker->tail->next = req;
+   else
+      worker->head = req;
+   worker->tail = req;
+   pthread_cond_signal(&worker->ready);
+   pthread_mutex_unlock(&worker->lock);
+   pthread_rwlock_unlock(&BusLock);
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Get the next finished request from any port.
+//
+// 'timeout_ms' - milliseconds to wait for a request to finish, 0 to
+//                poll or -1 to wait forever
+//
+// Returns: the finished request, NULL if none finished in time
+//
+owBusRequest *owBusComplete(int timeout_ms)
+{
+   owBusRequest *req;
+   struct timespec until;
+   struct timeval now;
+
+   if (timeout_ms > 0)
+   {
+      gettimeofday(&now,NULL);
+      until.tv_sec = now.tv_sec + timeout_ms / 1000;
+      until.tv_nsec = now.tv_usec * 1000L + (timeout_ms % 1000) * 1000000L;
+      if (until.tv_nsec >= 1000000000L)
+      {
+         until.tv_sec++;
+         until.tv_nsec -= 1000000000L;
+      }
+   }
+
+   pthread_mutex_lock(&DoneLock);
+   while ((DoneHead == NULL) && (timeout_ms != 0))
+   {
+      if (timeout_ms < 0)
+         pthread_cond_wait(&DoneReady,&DoneLock);
+      else if (pthread_cond_timedwait(&DoneReady,&DoneLock,&until) == ETIMEDOUT)
+         break;
+   }
+
+   req = DoneHead;
+   if (req != NULL)
+   {
+      DoneHead = req->next;
+      if (DoneHead == NULL)
+         DoneTail = NULL;
+      req->next = NULL;
+   }
+   pthread_mutex_unlock(&DoneLock);
+
+   return req;
+}
+
+//--------------------------------------------------------------------------
+// Worker thread for one port.  Runs the queued requests in order and
+// moves each to the finished queue.  The error stack is per thread so
+// the errors raised by a request are its own.
+//
+// 'arg'      - the owBusWorker of the port
+//
+static void *BusWorker(void *arg)
+{
+   owBusWorker *worker = (owBusWorker *)arg;
+   owBusRequest *req;
+
+   for (;;)
+   {
+      pthread_mutex_lock(&worker->lock);
+      while ((worker->head == NULL) && !worker->stop)
+         pthread_cond_wait(&worker->ready,&worker->lock);
+      req = worker->head;
+      if (req == NULL)
+      {
+         // stopped with nothing left to do
+         pthread_mutex_unlock(&worker->lock);
+         break;
+      }
+      worker->head = req->next;
+      if (worker->head == NULL)
+         worker->tail = NULL;
+      pthread_mutex_unlock(&worker->lock);
+
+      // run the request with a clean error stack
+      OWERROR_CLEAR();
+      req->result = req->func(worker->portnum,req->arg);
+      req->error = owHasErrors() ? owGetErrorNum() : 0;
+      OWERROR_CLEAR();
+
+      // hand it back
+      req->next = NULL;
+      pthread_mutex_lock(&DoneLock);
+      if (DoneTail != NULL)
+         DoneTail->next = req;
+      else
+         DoneHead = req;
+      DoneTail = req;
+      pthread_cond_broadcast(&DoneReady);
+      pthread_mutex_unlock(&DoneLock);
+   }
+
+   return NULL;
+}
+
+#endif
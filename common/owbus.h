@@ -0,0 +1,61 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owbus.h - Multi-bus runtime.  Each started port gets a worker thread
+//            with its own request queue so the I/O on several adapters
+//            can overlap.  Requires OW_THREADS (POSIX threads).
+//
+//  Version: 3.00
+//
+
+#ifndef OWBUS_H
+#define OWBUS_H
+
+#include "ownet.h"
+
+// function run on the worker thread of a port, the return value is
+// placed in the request 'result'
+typedef int (*owBusFunc)(int portnum, void *arg);
+
+// a request for a port, owned by the caller until it comes back from
+// owBusComplete
+typedef struct owBusRequest
+{
+   owBusFunc  func;                 // function to run
+   void      *arg;                  // argument passed to 'func'
+   int        portnum;              // port the request was submitted to
+   int        result;               // return value of 'func'
+   int        error;                // top error raised by 'func', 0 if none
+   struct owBusRequest *next;       // queue link (internal)
+} owBusRequest;
+
+// functions defined in owbus.c
+SMALLINT      owBusStart(int portnum);
+void          owBusStop(int portnum);
+SMALLINT      owBusSubmit(int portnum, owBusRequest *req, owBusFunc func, void *arg);
+owBusRequest *owBusComplete(int timeout_ms);
+
+#endif
@@ -25,362 +25,534 @@
 //--------------------------------------------------------------------------
 //
 //  owCache.c - Stores the latest buttons information for faster access
-//  version 1.00
+//  version 1.01
+//
+//  History: 1.00 -> 1.01  Each port has its own cache sized by
+//                         owCacheConfig.  Entries are found through a hash
+//                         table and kept on a least recently used list so
+//                         adding to a full cache is O(1).  Added per device
+//                         invalidation and counters.
 //
 
 // Include Files
+#include <stdlib.h>
+#include <string.h>
 #include "ownet.h"
 #include "owfile.h"
+#include "owport.h"
+
+// no entry
+#define NIL   -1
+
+// page cache of one port
+typedef struct
+{
+   int     capacity;        // number of entries
+   int     page_len;        // longest page data an entry holds
+   ulong   timeout;         // ms a page stays valid
+   int     mask;            // number of hash buckets - 1
+   int    *bucket;          // first entry of each hash chain
+   Dentry *entry;           // the entries
+   uchar  *data;            // page data, page_len bytes per entry
+   int     head;            // most recently used entry
+   int     tail;            // least recently used entry
+   int     free;            // first unused entry
+   OWCacheStats stats;      // counters, count/capacity/page_len kept current
+} PageCache;
 
-// global data space
-static Dentry Space[DEPTH];    // data space for page entries
-static uchar Hash[DEPTH];      // table to hold pointer to space
-static uchar BitMap[DEPTH];    // record of space available
+// local functions
+static PageCache *GetCache(int portnum);
+static SMALLINT   BuildCache(PageCache *cache, int capacity, int page_len, 
+                             ulong timeout);
+static int        HashFunction(PageCache *cache, uchar *SNum, int page, 
+                               uchar space);
+static int        LookupPage(PageCache *cache, uchar *SNum, int page, 
+                             uchar space);
+static int        NewEntry(PageCache *cache);
+static void       FreeEntry(PageCache *cache, int ptr);
+static void       UnlinkLRU(PageCache *cache, int ptr);
+static void       LinkLRU(PageCache *cache, int ptr);
 
 
 //--------------------------------------------------------------------------
-// Initialize the data hash values
+// Set the size of the page cache of a port.  Any pages cached on the
+// port are dropped.  A capacity of 0 turns the cache off for the port.
+// Without a call the cache has DEPTH entries of CACHE_PAGE_LEN bytes
+// that are valid for CACHE_TIMEOUT ms.
+//
+// portnum   the port number of the port being used for the
+//           1-Wire Network.
+// capacity  the number of pages to hold
+// page_len  the longest page data to hold, longer pages are not cached
+// timeout   the number of ms a page stays valid
+//
+// return TRUE if the cache could be allocated
 //
-void InitDHash(void)
+SMALLINT owCacheConfig(int portnum, int capacity, int page_len, ulong timeout)
 {
-   short i;
-   
-   // set all the pointers to the empty state
-   for (i = 0; i < DEPTH; i++)
+   PageCache *cache;
+
+   cache = GetCache(portnum);
+   if (cache == NULL)
+      return FALSE;
+
+   return BuildCache(cache,capacity,page_len,timeout);
+}
+
+//--------------------------------------------------------------------------
+// Drop every cached page of one device.
+//
+// portnum   the port number of the port being used for the
+//           1-Wire Network.
+// SNum      the serial number of the device
+//
+void owCacheInvalidate(int portnum, uchar *SNum)
+{
+   PageCache *cache;
+   int pg,ptr;
+
+   cache = GetCache(portnum);
+   if ((cache == NULL) || (cache->stats.count == 0))
+      return;
+
+   // a device has at most MAX_NUM_PGS pages in each memory space so
+   // look each one up rather than walk the whole cache
+   for (pg = 0; pg < MAX_NUM_PGS; pg++)
+   {
+      ptr = LookupPage(cache,SNum,pg,REGMEM);
+      if (ptr != NIL)
+      {
+         FreeEntry(cache,ptr);
+         cache->stats.invalidations++;
+      }
+
+      ptr = LookupPage(cache,SNum,pg,STATUSMEM);
+      if (ptr != NIL)
+      {
+         FreeEntry(cache,ptr);
+         cache->stats.invalidations++;
+      }
+   }
+}
+
+//--------------------------------------------------------------------------
+// Drop every cached page on a port.
+//
+// portnum   the port number of the port being used for the
+//           1-Wire Network.
+//
+void owCacheFlush(int portnum)
+{
+   PageCache *cache;
+
+   cache = GetCache(portnum);
+   if (cache == NULL)
+      return;
+
+   while (cache->head != NIL)
    {
-      Hash[i] = 0xFF;
-      BitMap[i] = 0xFF;
-      Space[i].Fptr = 0xFF;
-      Space[i].Bptr = 0xFF;   
-      Space[i].Hptr = 0xFF;
+      FreeEntry(cache,cache->head);
+      cache->stats.invalidations++;
    }
 }
+
+//--------------------------------------------------------------------------
+// Get the page cache counters of a port.
+//
+// portnum   the port number of the port being used for the
+//           1-Wire Network.
+// stats     the counters are copied here
+//
+void owCacheGetStats(int portnum, OWCacheStats *stats)
+{
+   PageCache *cache;
+
+   cache = GetCache(portnum);
+   if (cache == NULL)
+      memset(stats,0,sizeof(OWCacheStats));
+   else
+      *stats = cache->stats;
+}
   
 //--------------------------------------------------------------------------
-// Add a page to the hash table.  If the page is already in the hash table
-// it is updated and a new time stamp is given.  If the page is new then
-// it is added to the table. The data in buf is put in the page and the 
-// Space location number is returned.
+// Add a page to the cache.  If the page is already in the cache it is
+// updated and a new time stamp is given.  If the page is new then it
+// takes an unused entry or the least recently used one.  The data in 
+// buf is put in the page and the entry number is returned.
 //
 // portnum  the port number of the port being used for the
 //          1-Wire Network.
 // SNum     the serial number for the part that the read is
 //          to be done on.
 // pg       the page to add
+// mflag    STATUSMEM for status memory or REGMEM for normal memory, or'd
+//          with REDIRMEM if buf[0] is the page this page redirects to
 // buf      the buffer of the page data
 // len      len of data for the page
 //
-// return the space number for the new page
+// return the entry number for the page or -1 if it was not cached
 //
-uchar AddPage(int portnum, uchar *SNum, PAGE_TYPE pg, uchar *buf, int len)        
+int AddPage(int portnum, uchar *SNum, PAGE_TYPE pg, uchar mflag, 
+            uchar *buf, int len)        
 {
-   uchar hs,p=0xFF; 
-   short i=0,m;
-   PAGE_TYPE page;
-   int tlen;
-   uchar cache_page[32];
+   PageCache *cache;
+   int hs,p;
 
-   page = pg;
+   cache = GetCache(portnum);
+   if ((cache == NULL) || (cache->capacity == 0))
+      return NIL;
                               
-   // attempt to see if page already there                           
-   if(!FindPage(portnum,SNum,&page,(uchar)(len & 0x80),FALSE,
-                &cache_page[0],&tlen,&p))
-      return FALSE;
+   // see if page already there                           
+   p = LookupPage(cache,SNum,pg,(uchar)(mflag & STATUSMEM));
+
+   // a page too long to hold must not leave an old copy behind
+   if ((len < 0) || (len > cache->page_len))
+   {
+      if (p != NIL)
+         FreeEntry(cache,p);
+      return NIL;
+   }
    
-   if (p == 0xFF)
+   if (p == NIL)
    {
       // page not found so add one
-      hs = HashFunction(SNum,page);
-      p = FindNew(hs);
-      
-      // attach the device to the chain (if there is one)
-      // no other page in hash location
-      if (Hash[hs] == 0xFF)   
-      {
-         Hash[hs] = p;             // hash p to new page
-         Space[p].Fptr = 0xFF;     // np front p to nothing
-         Space[p].Bptr = 0xFF;     // np back p to nothing
-         Space[p].Hptr = hs;       // np hash p to hash location
-      }    
-      // some other page already there                
-      else                            
-      {                                                       
-         // insert as first page
-         Space[p].Fptr = Hash[hs]; // np front p to old first page
-         Space[Hash[hs]].Bptr = p; // old first page back p to np
-         Hash[hs] = p;             // hash p to np 
-         Space[p].Hptr = hs;       // np hash p to hash location
-      }
+      p = NewEntry(cache);
+      hs = HashFunction(cache,SNum,pg,(uchar)(mflag & STATUSMEM));
+      cache->entry[p].Hnext = cache->bucket[hs];
+      cache->bucket[hs] = p;
 
-      // set the page number
-      Space[p].Page = page;
-      // set the rom
-      for (i = 0; i < 8; i++)
-         Space[p].ROM[i] = SNum[i];            
+      // set the page number and rom
+      cache->entry[p].Page = pg;
+      memcpy(cache->entry[p].ROM,SNum,8);
    }
+   else
+      UnlinkLRU(cache,p);
    
    // set the data
-   Space[p].Data[0] = len;
-   m = ((len & 0x1F) <= 0x1D) ? (len & 0x1F) : 0;
-   for (i = 0; i < m; i++)
-      Space[p].Data[i+1] = buf[i];   
+   cache->entry[p].Flags = mflag & (STATUSMEM | REDIRMEM);
+   cache->entry[p].Len = len;
+   memcpy(&cache->data[p * cache->page_len],buf,len);
 
-   // set the time stamp limit of X seconds
-   Space[p].Tstamp = msGettick() + CACHE_TIMEOUT; // (3.10)
-   
-   // return the Space number of the new page         
-   return p;
-}
+   // set the time stamp limit
+   cache->entry[p].Tstamp = msGettick() + cache->timeout;
 
-                  
-//--------------------------------------------------------------------------
-// Find a empty page in Space and return its pointer. First look at the 
-// expected spot.  If an empty or expired page is not found then search
-// thru the pages.  If one cannot be found then void the oldest one. 
-//
-// hashnum  the number of the page that might be empty.
-//
-// return the space location
-//                  
-uchar FindNew(uchar hashnum) 
-{
-   ulong tm,otm;
-   static uchar spot = 0;  // spot pointer
-   uchar t = 0xFF;     
-   uchar oldest,i;   
-   uchar freepg;
-            
-   // if current spot is empty then use that 
-   if (BitMap[spot] == 0xFF)
-      t = spot;
-   // not empty so first try and find an empty spot in bitmap
-   else
-   {                        
-      // get the current time
-      tm = msGettick();        
-      // set the oldest time to the current spot
-      otm = Space[spot].Tstamp;              
-      oldest = spot;
-                    
-      // check to see if spot is void
-      if (tm > Space[spot].Tstamp)
-      {
-         freepg = FreePage(spot);
-         t = spot;
-      }           
-      else
-      {                 
-         // loop through all of the bitmap
-         for (i = 0; i < DEPTH; i++)
-         {
-            if (BitMap[i] == 0xFF)  // check for empty
-            {
-               t = i;
-               break;         
-            }
-            else if (tm > Space[i].Tstamp) // check for expired
-            {
-               freepg = FreePage((uchar)i);
-               t = i;
-               break;
-            }
-            else if (Space[i].Tstamp < otm) // find oldest
-            {
-               otm = Space[i].Tstamp;
-               oldest = i;
-            }
-         }         
-         
-         // check to see if not found one
-         if (i == DEPTH)
-         {
-            // free the current spot            
-            freepg = FreePage(oldest);
-            t = oldest;   
-         }
-      }
-   } 
-   
-   // set next spot to the current spot + 1                                          
-   spot = (spot == (DEPTH-1)) ? 0 : spot + 1; 
+   // now the most recently used
+   LinkLRU(cache,p);
    
-   // set the bitmap to say where the page is going
-   BitMap[t] = hashnum;                            
-   
-   // return the space location
-   return t;
+   return p;
 }
              
-             
 //--------------------------------------------------------------------------
-// Search the hash cache to find the page discribed by the rom and page.
-// If it is found and it has not expired, then return its Space number
-// or 0xFF if it can not be found. 'mflag' is the memory section flag 
-// where 0x00 is normal memory space and 0x80 is status memory space.
+// Search the cache to find the page described by the rom and page.
+// If it is found and it has not expired, then return its data.
+// 'mflag' is the memory section flag where 0x00 is normal memory space 
+// and 0x80 is status memory space.  If the page is cached as redirected
+// then 'page' is changed to the page it redirects to and FALSE is 
+// returned.
 //
 // portnum   the port number of the port being used for the
 //           1-Wire Network.
 // SNum      the serial number for the part that the read is
 //           to be done on.
-// page      the page to start looking
+// page      the page to look for
 // mflag     the flag to compare in looking for the right page
-// time      the expired time to check
+// time      TRUE to drop the page if it has expired
 // buf       the buffer of the page data
 // len       the length of the data on the page
-// space_num the space number in the table for the data of the page
+// space_num the entry number in the cache for the data of the page
 //
 // return true if the page data was found 
 //             
 SMALLINT FindPage(int portnum, uchar *SNum, PAGE_TYPE *page, uchar mflag, 
-                  uchar time, uchar *buf, int *len, uchar *space_num)
+                  uchar time, uchar *buf, int *len, int *space_num)
 {
-   static uchar DidInit=0;
-   uchar hs,ptr=0xFF; 
-   short i=0;                    
-   ulong tm;
+   PageCache *cache;
+   int ptr;
     
-   // initialize the file page cache (DSS 3.11) automatically
-   if (!DidInit)
-   {
-      InitDHash(); 
-      DidInit = 1;   
-   }
+   cache = GetCache(portnum);
+   if ((cache == NULL) || (cache->capacity == 0))
+      return FALSE;
+
+   ptr = LookupPage(cache,SNum,*page,(uchar)(mflag & STATUSMEM));
        
-   hs = HashFunction(SNum,*page);
-   
-   // if not empty
-   if (Hash[hs] != 0xFF)
-   {          
-      // get the current time
-      tm = msGettick();
-      
-      ptr = Hash[hs];  // point to first at hash spot
-      do     
-      {      
-         // check to see if this record is expired
-         if (time)
-         {
-            if (tm > Space[ptr].Tstamp)
-            {                              
-               ptr = FreePage(ptr);
-               continue; // skip to loop check
-            }
-         }      
-         
-         // check to see if this page is the correct one (and correct mem space)
-         if ((Space[ptr].Page == *page) && (mflag == (Space[ptr].Data[0] & 0x80)))
-         {
-            for (i = 0; i < 8; i++)
-               if (Space[ptr].ROM[i] != SNum[i])
-                  break;
-                   
-            if (i == 8)
-               break;
-          }                           
-          // point to next page at hash location
-          ptr = Space[ptr].Fptr;
-      }
-      while (ptr != 0xFF);
+   // check to see if this record is expired
+   if ((ptr != NIL) && time &&
+       ((long)(msGettick() - cache->entry[ptr].Tstamp) > 0))
+   {
+      FreeEntry(cache,ptr);
+      cache->stats.expired++;
+      ptr = NIL;
    }
 
-   // check if need to copy over the data
-   if (ptr != 0xFF)
+   if (ptr == NIL)
    {
-      if ((Space[ptr].Data[0] & 0x1F) <= 0x1D)
-      {
-         *len = Space[ptr].Data[0];
-         for (i = 1; i <= (*len & 0x1F); i++)
-            buf[i-1] = Space[ptr].Data[i];        
-      }
-      else
-         ptr = 0xFF;
-   }
-         
-   // check result
-   if(ptr == 0xFF)
+      cache->stats.misses++;
       return FALSE;
+   }
+   cache->stats.hits++;
+
+   // now the most recently used
+   UnlinkLRU(cache,ptr);
+   LinkLRU(cache,ptr);
 
    *space_num = ptr;
+
+   // follow a redirection
+   if (cache->entry[ptr].Flags & REDIRMEM)
+   {
+      *page = (PAGE_TYPE) cache->data[ptr * cache->page_len];
+      return FALSE;
+   }
+
+   *len = cache->entry[ptr].Len;
+   memcpy(buf,&cache->data[ptr * cache->page_len],*len);
+
    return TRUE;                          
 }                                
-  
-  
+
 //--------------------------------------------------------------------------
-// Free's the page number passed to it.  Fixes pointers in the Hash 
-// structure. Returns the next device in the hash structure unless this
-// is the last page in the hash location and return 0xFF.
+// Get the page cache of a port, making the default one the first time.
 //
-// ptr  the hash location of the data
+// portnum   the port number of the port being used for the
+//           1-Wire Network.
 //
-// return the next page
-//                                                       
-uchar FreePage(uchar ptr)
-{                       
-   uchar hsptr;
-   
-   // get the hash location
-   hsptr = Space[ptr].Hptr;
-   
-   // if chained
-   if (Space[ptr].Fptr != 0xFF)
-   {                        
-      // check if first in chain
-      if (Hash[hsptr] == ptr)
-      {
-         Hash[hsptr] = Space[ptr].Fptr;  // set hash p to next in ch
-         Space[Hash[hsptr]].Bptr = hsptr;        // set next in chain p to hash
-         BitMap[ptr] = 0xFF;             // free page
-         ptr = Hash[hsptr];              // change current p
-      }  
-      //  middle of chain
-      else
-      {
-         // previous in ch p to next in ch
-         Space[Space[ptr].Bptr].Fptr = Space[ptr].Fptr; 
-         // next in ch p to prevoious in ch
-         Space[Space[ptr].Fptr].Bptr = Space[ptr].Bptr;
-         BitMap[ptr] = 0xFF;          // free page
-         ptr = Space[Space[ptr].Bptr].Fptr;  // change current p
-      }   
-   }   
-   // if first and only on hash spot
-   else if (Hash[hsptr] == ptr)
+// return the cache or NULL if it could not be allocated
+//
+static PageCache *GetCache(int portnum)
+{
+   OWPort *port;
+   PageCache *cache;
+
+   port = owGetPort(portnum);
+   if (port->cache != NULL)
+      return (PageCache *)port->cache;
+
+   cache = (PageCache *)calloc(1,sizeof(PageCache));
+   if (cache == NULL)
    {
-      Hash[hsptr] = 0xFF;  // have hash p to nothing
-      BitMap[ptr] = 0xFF;  // free page
-      ptr = 0xFF;    // point to nothing            
-   }      
-   // else last in a chain
-   else
+      OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+      return NULL;
+   }
+
+   if (!BuildCache(cache,DEPTH,CACHE_PAGE_LEN,CACHE_TIMEOUT))
    {
-      // previous in ch p to nothing
-      Space[Space[ptr].Bptr].Fptr = 0xFF; 
-      BitMap[ptr] = 0xFF;          // free page
-      ptr = 0xFF;  // point to nothing               
-   }                    
-   
-   return 0xFF;  // return the next page or nothing
-}         
+      free(cache);
+      return NULL;
+   }
+
+   port->cache = cache;
+   return cache;
+}
+
+//--------------------------------------------------------------------------
+// (Re)allocate the tables of a cache.  On a failure the cache is left
+// empty with a capacity of 0.
+//
+// cache     the cache to build
+// capacity  the number of pages to hold
+// page_len  the longest page data to hold
+// timeout   the number of ms a page stays valid
+//
+// return TRUE if the tables could be allocated
+//
+static SMALLINT BuildCache(PageCache *cache, int capacity, int page_len, 
+                           ulong timeout)
+{
+   int i,buckets;
+
+   free(cache->bucket);
+   free(cache->entry);
+   free(cache->data);
+   memset(cache,0,sizeof(PageCache));
+   cache->head = NIL;
+   cache->tail = NIL;
+   cache->free = NIL;
+   cache->timeout = timeout;
+
+   if ((capacity <= 0) || (page_len <= 0))
+      return TRUE;
+
+   // keep the chains short with at least two buckets an entry
+   for (buckets = 16; buckets < (capacity * 2); buckets <<= 1)
+      ;
+
+   cache->bucket = (int *)malloc(buckets * sizeof(int));
+   cache->entry = (Dentry *)malloc(capacity * sizeof(Dentry));
+   cache->data = (uchar *)malloc((size_t)capacity * page_len);
+   if ((cache->bucket == NULL) || (cache->entry == NULL) || 
+       (cache->data == NULL))
+   {
+      OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+      free(cache->bucket);
+      free(cache->entry);
+      free(cache->data);
+      cache->bucket = NULL;
+      cache->entry = NULL;
+      cache->data = NULL;
+      return FALSE;
+   }
+
+   for (i = 0; i < buckets; i++)
+      cache->bucket[i] = NIL;
+
+   // all entries on the free list
+   for (i = 0; i < capacity; i++)
+      cache->entry[i].Next = (i == (capacity - 1)) ? NIL : i + 1;
+   cache->free = 0;
+
+   cache->mask = buckets - 1;
+   cache->capacity = capacity;
+   cache->page_len = page_len;
+   cache->stats.capacity = capacity;
+   cache->stats.page_len = page_len;
+
+   return TRUE;
+}
 
-                    
 //--------------------------------------------------------------------------
-// The hashing function takes the data provided and returns a hash 
-// number in the range 0 to DEPTH-1.    
+// The hashing function takes the data provided and returns a bucket 
+// number in the range 0 to the number of buckets - 1.    
 //
+// cache the cache to hash for
 // SNum  the serial number for the part that the read is
-//          to be done on.
+//       to be done on.
 // page  the page that is being added or looked for
+// space STATUSMEM or REGMEM
 //
 // returns the hash number of the given data                   
 //
-uchar HashFunction(uchar *SNum, int page)                    
+static int HashFunction(PageCache *cache, uchar *SNum, int page, uchar space)                    
 {
    ulong h;
-   uchar tmp_page;
-   
-   tmp_page = (uchar) page;
-   
-   h = (SNum[1] << 12) | (SNum[2] << 8) | (SNum[7] << 4) | tmp_page;
+   int i;
    
-   return (uchar)(h % DEPTH);
-}
\ No newline at end of file
+   // FNV-1a over the serial number (less the CRC) and the page
+   h = 2166136261UL;
+   for (i = 0; i < 7; i++)
+      h = (h ^ SNum[i]) * 16777619UL;
+   h = (h ^ (page & 0xFF)) * 16777619UL;
+   h = (h ^ ((page >> 8) ^ space)) * 16777619UL;
+
+   return (int)((h ^ (h >> 16)) & cache->mask);
+}
+
+//--------------------------------------------------------------------------
+// Find the entry of a page.
+//
+// cache the cache to look in
+// SNum  the serial number for the part 
+// page  the page to look for
+// space STATUSMEM or REGMEM
+//
+// return the entry number or NIL if not cached
+//
+static int LookupPage(PageCache *cache, uchar *SNum, int page, uchar space)
+{
+   int ptr;
+   Dentry *e;
+
+   if (cache->capacity == 0)
+      return NIL;
+
+   for (ptr = cache->bucket[HashFunction(cache,SNum,page,space)]; 
+        ptr != NIL; ptr = e->Hnext)
+   {
+      e = &cache->entry[ptr];
+      if ((e->Page == (PAGE_TYPE)page) && ((e->Flags & STATUSMEM) == space) &&
+          (memcmp(e->ROM,SNum,8) == 0))
+         return ptr;
+   }
+
+   return NIL;
+}
+
+//--------------------------------------------------------------------------
+// Get an entry to hold a new page, the least recently used one if
+// there are no unused entries left.  The entry is not on any list.
+//
+// cache the cache to take the entry from
+//
+// return the entry number
+//
+static int NewEntry(PageCache *cache)
+{
+   int ptr;
+
+   if (cache->free == NIL)
+   {
+      FreeEntry(cache,cache->tail);
+      cache->stats.evictions++;
+   }
+
+   ptr = cache->free;
+   cache->free = cache->entry[ptr].Next;
+   cache->stats.count++;
+
+   return ptr;
+}
+
+//--------------------------------------------------------------------------
+// Take an entry off its hash chain and the used list and put it on
+// the free list.
+//
+// cache the cache of the entry
+// ptr   the entry number
+//
+static void FreeEntry(PageCache *cache, int ptr)
+{
+   int *link;
+
+   // hash chains are short so walk to the link that points here
+   link = &cache->bucket[HashFunction(cache,cache->entry[ptr].ROM,
+                         cache->entry[ptr].Page,
+                         (uchar)(cache->entry[ptr].Flags & STATUSMEM))];
+   while (*link != ptr)
+      link = &cache->entry[*link].Hnext;
+   *link = cache->entry[ptr].Hnext;
+
+   UnlinkLRU(cache,ptr);
+
+   cache->entry[ptr].Next = cache->free;
+   cache->free = ptr;
+   cache->stats.count--;
+}
+
+//--------------------------------------------------------------------------
+// Take an entry off the used list.
+//
+// cache the cache of the entry
+// ptr   the entry number
+//
+static void UnlinkLRU(PageCache *cache, int ptr)
+{
+   Dentry *e = &cache->entry[ptr];
+
+   if (e->Prev != NIL)
+      cache->entry[e->Prev].Next = e->Next;
+   else
+      cache->head = e->Next;
+
+   if (e->Next != NIL)
+      cache->entry[e->Next].Prev = e->Prev;
+   else
+      cache->tail = e->Prev;
+}
+
+//--------------------------------------------------------------------------
+// Put an entry at the most recently used end of the used list.
+//
+// cache the cache of the entry
+// ptr   the entry number
+//
+static void LinkLRU(PageCache *cache, int ptr)
+{
+   Dentry *e = &cache->entry[ptr];
+
+   e->Prev = NIL;
+   e->Next = cache->head;
+   if (cache->head != NIL)
+      cache->entry[cache->head].Prev = ptr;
+   else
+      cache->tail = ptr;
+   cache->head = ptr;
+}
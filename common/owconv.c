@@ -0,0 +1,266 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owconv.c - Conversion waits.  The power mode and the conversion time
+//             learned for each device are kept in a small table in the
+//             OWPort 'conv'.  For a VDD powered device the time is the
+//             one last measured by owConvPoll, for a parasite powered
+//             device it is what the driver worked out from the device
+//             configuration.
+//
+//  Version: 3.00
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "ownet.h"
+#include "owport.h"
+#include "owtime.h"
+#include "owsess.h"
+#include "owconv.h"
+
+// Read Power Supply command of the DS18x20 family
+#define READ_POWER_SUPPLY  0xB4
+
+// what is remembered about one device
+typedef struct
+{
+   uchar    ROM[8];
+   SMALLINT power;                   // OWCONV_xxx
+   int      ms;                      // conversion time, 0 if not known
+} ConvDevice;
+
+// table kept in the OWPort 'conv'
+typedef struct
+{
+   int        num;                   // entries in use
+   int        next;                  // entry replaced when full
+   ConvDevice dev[OWCONV_DEVICES];
+} ConvTable;
+
+// local functions
+static ConvDevice *FindDevice(int portnum, uchar *SNum, SMALLINT add);
+
+//--------------------------------------------------------------------------
+// Get how a device is powered, as remembered by owConvSetPower or
+// owConvReadPower.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'SNum'     - serial number of the device
+//
+// Returns:  OWCONV_EXTERNAL, OWCONV_PARASITE or OWCONV_UNKNOWN
+//
+SMALLINT owConvPower(int portnum, uchar *SNum)
+{
+   ConvDevice *dev = FindDevice(portnum,SNum,FALSE);
+
+   return (dev != NULL) ? dev->power : OWCONV_UNKNOWN;
+}
+
+//--------------------------------------------------------------------------
+// Remember how a device is powered.  Drivers for devices without a
+// Read Power Supply command find it out their own way.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'SNum'     - serial number of the device
+// 'power'    - OWCONV_EXTERNAL, OWCONV_PARASITE or OWCONV_UNKNOWN
+//
+void owConvSetPower(int portnum, uchar *SNum, SMALLINT power)
+{
+   ConvDevice *dev = FindDevice(portnum,SNum,TRUE);
+
+   if ((dev != NULL) && (dev->power != power))
+   {
+      dev->power = power;
+      dev->ms = 0;
+   }
+}
+
+//--------------------------------------------------------------------------
+// Find out how a DS18x20 is powered with the Read Power Supply command
+// and remember it.  A parasite powered device pulls the read time slot
+// low.  With a Skip ROM every device on the bus answers at once, which
+// tells if a conversion started with Skip ROM can be polled.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'SNum'     - serial number of the device, NULL for every device on
+//              the bus (not remembered)
+//
+// Returns:  OWCONV_EXTERNAL, OWCONV_PARASITE (any device for NULL) or
+//           OWCONV_UNKNOWN if the device did not answer
+//
+SMALLINT owConvReadPower(int portnum, uchar *SNum)
+{
+   uchar block[10];
+   SMALLINT power;
+   int len = 0;
+
+   // the ROM function deselects the session device
+   owSessionEnd(portnum);
+
+   if (SNum != NULL)
+   {
+      block[len++] = 0x55;
+      memcpy(&block[len],SNum,8);
+      len += 8;
+   }
+   else
+      block[len++] = 0xCC;
+   block[len++] = READ_POWER_SUPPLY;
+   if (!owBlock(portnum,TRUE,block,(SMALLINT)len))
+      return OWCONV_UNKNOWN;
+
+   power = (owTouchBit(portnum,1) == 1) ? OWCONV_EXTERNAL : OWCONV_PARASITE;
+   if (SNum != NULL)
+      owConvSetPower(portnum,SNum,power);
+   return power;
+}
+
+//--------------------------------------------------------------------------
+// Get the conversion time learned for a device.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'SNum'     - serial number of the device
+// 'def_ms'   - time returned when nothing was learned
+//
+// Returns:  milliseconds
+//
+int owConvTime(int portnum, uchar *SNum, int def_ms)
+{
+   ConvDevice *dev = FindDevice(portnum,SNum,FALSE);
+
+   if ((dev == NULL) || (dev->ms == 0))
+      return def_ms;
+   return dev->ms;
+}
+
+//--------------------------------------------------------------------------
+// Remember the conversion time of a device.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'SNum'     - serial number of the device
+// 'ms'       - milliseconds the conversion takes
+//
+void owConvSetTime(int portnum, uchar *SNum, int ms)
+{
+   ConvDevice *dev = FindDevice(portnum,SNum,TRUE);
+
+   if (dev != NULL)
+      dev->ms = ms;
+}
+
+//--------------------------------------------------------------------------
+// Wait for a VDD powered device to finish a conversion.  The device
+// must have been sent its convert command without the strong pull-up.
+// After 'min_ms' the bus is read a byte (8 read time slots) at a time
+// until the device answers with a 1.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'min_ms'   - time to sleep before the first read, for example part of
+//              the time learned with owConvTime
+// 'max_ms'   - worst case conversion time, give up after it
+//
+// Returns:  milliseconds the conversion took (rounded up), -1 if it
+//           did not finish in 'max_ms'
+//
+int owConvPoll(int portnum, int min_ms, int max_ms)
+{
+   long long start = usGettick(), deadline, now;
+
+   deadline = start + (long long)max_ms * 1000;
+   if (min_ms > 0)
+      usDelayUntil(start + (long long)min_ms * 1000);
+
+   do
+   {
+      if (owTouchByte(portnum,0xFF) != 0)
+      {
+         now = usGettick();
+         return (int)((now - start + 999) / 1000);
+      }
+      now = usGettick();
+   }
+   while (now < deadline);
+
+   return -1;
+}
+
+//--------------------------------------------------------------------------
+// Find the entry of a device in the table of a port.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'SNum'     - serial number of the device
+// 'add'      - TRUE to add an entry if the device is not in the table
+//
+// Returns:  the entry, NULL if not found (or no memory to add it)
+//
+static ConvDevice *FindDevice(int portnum, uchar *SNum, SMALLINT add)
+{
+   OWPort *port = owGetPort(portnum);
+   ConvTable *table = (ConvTable *)port->conv;
+   ConvDevice *dev;
+   int i;
+
+   if (table == NULL)
+   {
+      if (!add)
+         return NULL;
+      table = (ConvTable *)calloc(1,sizeof(ConvTable));
+      if (table == NULL)
+      {
+         OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+         return NULL;
+      }
+      port->conv = table;
+   }
+
+   for (i = 0; i < table->num; i++)
+      if (memcmp(table->dev[i].ROM,SNum,8) == 0)
+         return &table->dev[i];
+
+   if (!add)
+      return NULL;
+
+   // take a free entry or replace the oldest
+   if (table->num < OWCONV_DEVICES)
+      dev = &table->dev[table->num++];
+   else
+   {
+      dev = &table->dev[table->next];
+      table->next = (table->next + 1) % OWCONV_DEVICES;
+   }
+   memcpy(dev->ROM,SNum,8);
+   dev->power = OWCONV_UNKNOWN;
+   dev->ms = 0;
+   return dev;
+}
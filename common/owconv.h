@@ -0,0 +1,57 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owconv.h - Conversion waits.  A device powered from VDD signals the
+//             end of a conversion by answering read time slots with 1s,
+//             so owConvPoll returns as soon as it is done instead of
+//             sleeping for the worst case.  How each device is powered
+//             and how long its conversions take is remembered per port.
+//
+//  Version: 3.00
+//
+
+#ifndef OWCONV_H
+#define OWCONV_H
+
+#include "ownet.h"
+
+// how a device is powered
+#define OWCONV_UNKNOWN         0     // not found out yet
+#define OWCONV_EXTERNAL        1     // VDD, the conversion can be polled
+#define OWCONV_PARASITE        2     // 1-Wire, needs the strong pull-up
+
+// devices remembered on each port, the oldest is dropped when full
+#define OWCONV_DEVICES         64
+
+// functions defined in owconv.c
+SMALLINT owConvPower(int portnum, uchar *SNum);
+void     owConvSetPower(int portnum, uchar *SNum, SMALLINT power);
+SMALLINT owConvReadPower(int portnum, uchar *SNum);
+int      owConvTime(int portnum, uchar *SNum, int def_ms);
+void     owConvSetTime(int portnum, uchar *SNum, int ms);
+int      owConvPoll(int portnum, int min_ms, int max_ms);
+
+#endif
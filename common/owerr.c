@@ -26,7 +26,14 @@
 //
 // owerr.c - Library functions for error handling with 1-Wire library
 //
-// Version: 1.00
+// Version: 1.04
+//
+// History: 1.00 -> 1.01  Error stack is per thread with OW_THREADS.
+//          1.01 -> 1.02  Errors record the port, device, operation and
+//                        time and are counted per port by error code.
+//          1.02 -> 1.03  The port error log and counts are locked with
+//                        OW_THREADS.
+//          1.03 -> 1.04  An error ends the owsess.c session of the port.
 //
 
 #include <string.h>
@@ -34,6 +41,21 @@
 #include <stdio.h>
 #endif
 #include "ownet.h"
+#include "owport.h"
+#include "owsess.h"
+
+#ifdef OW_THREADS
+#include <pthread.h>
+
+// held while a port error log or its counts are changed or read, any
+// thread can raise an error charged to a port
+static pthread_mutex_t ErrLogLock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_ERRLOG()        pthread_mutex_lock(&ErrLogLock)
+#define UNLOCK_ERRLOG()      pthread_mutex_unlock(&ErrLogLock)
+#else
+#define LOCK_ERRLOG()
+#define UNLOCK_ERRLOG()
+#endif
 
 #ifndef SIZE_OWERROR_STACK
    #ifdef SMALL_MEMORY_TARGET
@@ -53,6 +75,7 @@
 typedef struct
 {
    int owErrorNum;
+   OWErrorInfo info;
 #ifdef DEBUG
    int lineno;
    char *filename;
@@ -61,10 +84,13 @@ typedef struct
 
 // Ring-buffer used for stack.
 // In case of overflow, deepest error is over-written.
-static owErrorStruct owErrorStack[SIZE_OWERROR_STACK];
+static OW_TLS owErrorStruct owErrorStack[SIZE_OWERROR_STACK];
 
 // Stack pointer to top-most error.
-static int owErrorPointer = 0;
+static OW_TLS int owErrorPointer = 0;
+
+// Operation tag recorded with each error, see owErrorOp.
+static OW_TLS int owErrorOpTag = OWOP_NONE;
 
 
 //---------------------------------------------------------------------------
@@ -78,6 +104,12 @@ int owHasErrors(void);
 #else
    void owRaiseError(int);
 #endif
+int owErrorOp(int);
+int owGetErrorInfo(OWErrorInfo *);
+int owGetPortErrors(int,OWErrorInfo *,int);
+ulong owGetErrorCount(int,int);
+void owClearErrorCounts(int);
+static void RecordError(int,OWErrorInfo *);
 #ifndef SMALL_MEMORY_TARGET
    void owPrintErrorMsg(FILE *);
    void owPrintErrorMsgStd(void);
@@ -142,6 +174,7 @@ int owHasErrors(void)
    {
       owErrorPointer = (owErrorPointer + 1) % SIZE_OWERROR_STACK;
       owErrorStack[ owErrorPointer ].owErrorNum = err;
+      RecordError(err,&owErrorStack[ owErrorPointer ].info);
       owErrorStack[ owErrorPointer ].lineno = lineno;
       owErrorStack[ owErrorPointer ].filename = filename;
    }
@@ -156,16 +189,172 @@ int owHasErrors(void)
    {
       owErrorPointer = (owErrorPointer + 1) % SIZE_OWERROR_STACK;
       owErrorStack[ owErrorPointer ].owErrorNum = err;
+      RecordError(err,&owErrorStack[ owErrorPointer ].info);
    }
 #endif
 
+//--------------------------------------------------------------------------
+// Fill in the context of an error being raised and charge it to the
+// last port this thread used.  Nothing here formats a string so it is
+// cheap enough for the CRC and presence failures of a busy port.
+//
+// 'err'      - the error code being raised
+// 'info'     - filled in with the context of the error
+//
+static void RecordError(int err, OWErrorInfo *info)
+{
+   OWPort *port;
+
+   info->error = err;
+   info->portnum = owLastPort;
+   info->op = owErrorOpTag;
+   info->time = msGettick();
+
+   if (owLastPort < 0)
+   {
+      memset(info->SerialNum,0,8);
+      return;
+   }
+
+   port = owGetPort(owLastPort);
+
+   // the session device is the one being talked to if there is one,
+   // and after an error (a bad CRC after a Resume ROM that no device
+   // took) the next owSessionSelect does a full select
+   if (port->SessState != OWSESS_NONE)
+   {
+      memcpy(info->SerialNum,port->SessROM,8);
+      port->SessState = OWSESS_NONE;
+   }
+   else
+      memcpy(info->SerialNum,port->SerialNum,8);
+
+   LOCK_ERRLOG();
+   if ((err >= 0) && (err < OWERROR_COUNT))
+      port->ErrCount[err]++;
+   port->ErrLog[port->ErrNext] = *info;
+   port->ErrNext = (port->ErrNext + 1) % OWERROR_LOG;
+   UNLOCK_ERRLOG();
+}
+
+//--------------------------------------------------------------------------
+// Set the operation tag recorded with the errors this thread raises
+// from now on.  The values are up to the application, for example one
+// tag for each step of a polling loop.
+//
+// 'op'       - operation tag, OWOP_NONE to clear it
+//
+// Returns:  the tag that was set before
+//
+int owErrorOp(int op)
+{
+   int prev = owErrorOpTag;
+
+   owErrorOpTag = op;
+   return prev;
+}
+
+//--------------------------------------------------------------------------
+// The 'owGetErrorInfo' is the same as 'owGetErrorNum' but also returns
+// the context the error was raised in.  NOTE: This function has the side
+// effect of popping the current error off the stack.
+//
+// 'info'     - filled in with the context of the top-most error
+//
+// Returns:   int :  The error code of the top-most error on the stack
+//
+int owGetErrorInfo(OWErrorInfo *info)
+{
+   if (owErrorStack[ owErrorPointer ].owErrorNum)
+      *info = owErrorStack[ owErrorPointer ].info;
+   else
+   {
+      memset(info,0,sizeof(OWErrorInfo));
+      info->portnum = -1;
+   }
+
+   return owGetErrorNum();
+}
+
+//--------------------------------------------------------------------------
+// Get the most recent errors raised while a port was in use, newest
+// first.  The errors stay in the port log, it holds the last
+// OWERROR_LOG of them no matter which thread raised them.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'info'     - array filled in with the errors
+// 'max'      - number of entries in 'info'
+//
+// Returns:  number of entries filled in
+//
+int owGetPortErrors(int portnum, OWErrorInfo *info, int max)
+{
+   OWPort *port = owGetPort(portnum);
+   int i,pos,num = 0;
+
+   LOCK_ERRLOG();
+   for (i = 1; (i <= OWERROR_LOG) && (num < max); i++)
+   {
+      pos = (port->ErrNext + OWERROR_LOG - i) % OWERROR_LOG;
+      if (port->ErrLog[pos].error == OWERROR_NO_ERROR_SET)
+         break;
+      info[num++] = port->ErrLog[pos];
+   }
+   UNLOCK_ERRLOG();
+
+   return num;
+}
+
+//--------------------------------------------------------------------------
+// Get the number of times an error was raised while a port was in use
+// since the last owClearErrorCounts.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'err'      - error code to get the count of, OWERROR_xxx
+//
+// Returns:  number of times 'err' was raised
+//
+ulong owGetErrorCount(int portnum, int err)
+{
+   OWPort *port = owGetPort(portnum);
+   ulong count;
+
+   if ((err < 0) || (err >= OWERROR_COUNT))
+      return 0;
+
+   LOCK_ERRLOG();
+   count = port->ErrCount[err];
+   UNLOCK_ERRLOG();
+
+   return count;
+}
+
+//--------------------------------------------------------------------------
+// Clear the error counts and the recent error log of a port.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+void owClearErrorCounts(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+
+   LOCK_ERRLOG();
+   memset(port->ErrCount,0,sizeof(port->ErrCount));
+   memset(port->ErrLog,0,sizeof(port->ErrLog));
+   port->ErrNext = 0;
+   UNLOCK_ERRLOG();
+}
+
 
 // SMALL_MEMORY_TARGET - embedded microcontrollers, where these
 // messaging functions might not make any sense.
 #ifndef SMALL_MEMORY_TARGET
    //Array of meaningful error messages to associate with codes.
    //Not used on targets with low memory (i.e. PIC).
-   static char *owErrorMsg[117] =
+   static char *owErrorMsg[OWERROR_COUNT] =
    {
    /*000*/ "No Error Was Set",
    /*001*/ "No Devices found on 1-Wire Network",
@@ -283,7 +472,8 @@ int owHasErrors(void)
    /*113*/ "Mission can not be stopped while one is not in progress",
    /*114*/ "Error stopping the mission",
    /*115*/ "Port number is outside (0,MAX_PORTNUM) interval",
-   /*116*/ "Level of the 1-Wire was not changed"
+   /*116*/ "Level of the 1-Wire was not changed",
+   /*117*/ "Conversion did not finish in the time allowed"
    };
 
    char *owGetErrorMsg(int err)
@@ -26,7 +26,9 @@
 //
 //  owFile.h - Contains the types and constants for file I/O. 
 //
-//  version 1.00
+//  version 1.01
+//
+//  History: 1.00 -> 1.01  Page cache is sized per port with LRU eviction.
 //
 
 #include "ownet.h"
@@ -43,8 +45,9 @@
 #define STATUSMEM     0x80
 #define REDIRMEM      0x40
 #define REGMEM        0 
-#define DEPTH         254
-#define CACHE_TIMEOUT 8000
+#define DEPTH         254    // default page cache entries per port
+#define CACHE_PAGE_LEN 32    // default longest page data in the cache
+#define CACHE_TIMEOUT 8000   // default ms a cached page stays valid
 // Directory options
 #define SET_DIR            0
 #define READ_DIR           1
@@ -117,28 +120,42 @@ typedef struct
    } Page[MAX_NUM_PGS];    // 256 possible jobs
 } ProgramJob;   
 
-// type to hold a data entry in the DHash
+// type to hold a data entry in the page cache
 typedef struct
 {
    uchar     ROM[8];        // rom of device page is from
    ulong     Tstamp;        // time stamp when page void
-   uchar     Fptr;          // forward pointer to next entry in chain
-   uchar     Bptr;          // back pointer to previous entry in chain
-   uchar     Hptr;          // hash pointer to hash position
+   int       Hnext;         // next entry in the hash chain
+   int       Prev;          // next more recently used entry
+   int       Next;          // next less recently used entry (or free entry)
    PAGE_TYPE Page;          // page number   
-   uchar     Data[32];      // page data including length
-   uchar     Redir;         // redirection page
+   uchar     Flags;         // STATUSMEM and REDIRMEM bits
+   int       Len;           // length of the page data
 }  Dentry;
+
+// page cache counters returned by owCacheGetStats
+typedef struct
+{
+   ulong hits;              // FindPage found the page
+   ulong misses;            // FindPage did not find the page
+   ulong expired;           // entries dropped because they timed out
+   ulong evictions;         // least recently used entries reused
+   ulong invalidations;     // entries dropped by owCacheInvalidate/Flush
+   int   count;             // entries in use
+   int   capacity;          // entries available
+   int   page_len;          // longest page data an entry holds
+} OWCacheStats;
 #endif //OWFILE_H
 
 // function prototypes for owcache.c
-void     InitDHash(void);  
-uchar    AddPage(int portnum, uchar *SNum, PAGE_TYPE pg, uchar *buf, int len);        
+SMALLINT owCacheConfig(int portnum, int capacity, int page_len, ulong timeout);
+void     owCacheInvalidate(int portnum, uchar *SNum);
+void     owCacheFlush(int portnum);
+void     owCacheGetStats(int portnum, OWCacheStats *stats);
+int      AddPage(int portnum, uchar *SNum, PAGE_TYPE pg, uchar mflag, 
+                 uchar *buf, int len);        
 SMALLINT FindPage(int portnum, uchar *SNum, PAGE_TYPE *page, uchar mflag, uchar time, 
-                  uchar *buf, int *len, uchar *space_num);
-uchar FreePage(uchar ptr);
-static uchar FindNew(uchar hashnum); 
-static uchar HashFunction(uchar *SNum, int page);                    
+                  uchar *buf, int *len, int *space_num);
 
 // function prototypes for owfile.c
 SMALLINT      owFirstFile(int, uchar *, FileEntry *); 
@@ -0,0 +1,320 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owinv.c - Bus inventory.  The inventory of a port is kept in the
+//            OWPort 'inv' as two snapshots, the last scan and the one
+//            before.  In a snapshot the ROMs are kept in search order
+//            with an open addressing hash table over them and a list of
+//            the devices of each family.
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  owInvFamily ignores bit 7 of the family code
+//                         like FindDevices did
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "ownet.h"
+#include "owport.h"
+#include "owinv.h"
+
+// one scan
+typedef struct
+{
+   int   num;                        // devices found
+   OWRom rom[OWINV_DEVICES];         // in search order
+   short next[OWINV_DEVICES];        // next device of the family, -1 at end
+   short family[256];                // first device of each family, -1 none
+   short hash[OWINV_HASH];           // device + 1 in each slot, 0 empty
+} InvSnapshot;
+
+// inventory kept in the OWPort 'inv'
+typedef struct
+{
+   int         scans;                // owInvScan calls that worked
+   int         last;                 // snapshot of the last scan
+   InvSnapshot snap[2];
+} Inventory;
+
+// local functions
+static int      HashSlot(OWRom rom);
+static int      SnapFind(InvSnapshot *snap, OWRom rom);
+static void     SnapBuild(InvSnapshot *snap, uchar ROMs[][8], int num);
+
+//--------------------------------------------------------------------------
+// Search the whole port once and make the result the inventory.  The
+// inventory of the scan before is kept for owInvDiff.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+// Returns:  number of devices found, -1 if there is no memory for the
+//           inventory
+//
+int owInvScan(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+   Inventory *inv = (Inventory *)port->inv;
+   uchar ROMs[OWINV_DEVICES][8];
+   int num;
+
+   if (inv == NULL)
+   {
+      inv = (Inventory *)calloc(1,sizeof(Inventory));
+      if (inv == NULL)
+      {
+         OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+         return -1;
+      }
+      // both snapshots start out empty
+      SnapBuild(&inv->snap[0],ROMs,0);
+      SnapBuild(&inv->snap[1],ROMs,0);
+      port->inv = inv;
+   }
+
+   num = owSearchAll(portnum,ROMs,OWINV_DEVICES,0,FALSE);
+
+   inv->last ^= 1;
+   SnapBuild(&inv->snap[inv->last],ROMs,num);
+   inv->scans++;
+   return num;
+}
+
+//--------------------------------------------------------------------------
+// Check if a device was found by the last scan.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'SNum'     - serial number of the device
+//
+// Returns:  TRUE if it was found
+//
+SMALLINT owInvFind(int portnum, uchar *SNum)
+{
+   Inventory *inv = (Inventory *)owGetPort(portnum)->inv;
+
+   if (inv == NULL)
+      return FALSE;
+
+   return (SnapFind(&inv->snap[inv->last],owRomToInt(SNum)) >= 0);
+}
+
+//--------------------------------------------------------------------------
+// Get the devices of one family found by the last scan, in the same
+// form as FindDevices.  Bit 7 of the family code is ignored, so 0x33
+// also gets the 0xB3 devices.  The port is scanned first if it never
+// was.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'family'   - family code, 0 for every device
+// 'FamilySN' - receives the serial numbers in search order
+// 'max'      - number of entries in 'FamilySN'
+//
+// Returns:  number of serial numbers copied
+//
+int owInvFamily(int portnum, SMALLINT family, uchar FamilySN[][8], int max)
+{
+   Inventory *inv = (Inventory *)owGetPort(portnum)->inv;
+   InvSnapshot *snap;
+   int i,fam,cnt = 0;
+
+   if ((inv == NULL) || (inv->scans == 0))
+   {
+      if (owInvScan(portnum) < 0)
+         return 0;
+      inv = (Inventory *)owGetPort(portnum)->inv;
+   }
+   snap = &inv->snap[inv->last];
+
+   if (family == 0)
+   {
+      for (i = 0; (i < snap->num) && (cnt < max); i++)
+         owIntToRom(snap->rom[i],FamilySN[cnt++]);
+   }
+   else
+   {
+      // the family code with bit 7 clear and then with it set
+      for (fam = family & 0x7F; fam <= 0xFF; fam += 0x80)
+         for (i = snap->family[fam]; (i >= 0) && (cnt < max); i = snap->next[i])
+            owIntToRom(snap->rom[i],FamilySN[cnt++]);
+   }
+
+   return cnt;
+}
+
+//--------------------------------------------------------------------------
+// List the devices that arrived or left between the last two scans.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'arrived'  - TRUE for the devices found by the last scan and not the
+//              one before, FALSE for the devices that left
+// 'SNums'    - receives the serial numbers
+// 'max'      - number of entries in 'SNums'
+//
+// Returns:  number of serial numbers copied
+//
+int owInvDiff(int portnum, SMALLINT arrived, uchar SNums[][8], int max)
+{
+   Inventory *inv = (Inventory *)owGetPort(portnum)->inv;
+   InvSnapshot *in,*notin;
+   int i,cnt = 0;
+
+   if (inv == NULL)
+      return 0;
+
+   in = &inv->snap[arrived ? inv->last : inv->last ^ 1];
+   notin = &inv->snap[arrived ? inv->last ^ 1 : inv->last];
+
+   for (i = 0; (i < in->num) && (cnt < max); i++)
+      if (SnapFind(notin,in->rom[i]) < 0)
+         owIntToRom(in->rom[i],SNums[cnt++]);
+
+   return cnt;
+}
+
+//--------------------------------------------------------------------------
+// Free the inventory of a port.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+void owInvFree(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+
+   free(port->inv);
+   port->inv = NULL;
+}
+
+//--------------------------------------------------------------------------
+// Make the integer form of a serial number.
+//
+// 'SNum'     - the 8 bytes of the serial number, family code first
+//
+// Returns:  the ROM with byte 'n' in bits 8n to 8n+7
+//
+OWRom owRomToInt(uchar *SNum)
+{
+   OWRom rom = 0;
+   int i;
+
+   for (i = 7; i >= 0; i--)
+      rom = (rom << 8) | SNum[i];
+
+   return rom;
+}
+
+//--------------------------------------------------------------------------
+// Make the 8 byte form of a serial number.
+//
+// 'rom'      - the ROM as an integer
+// 'SNum'     - receives the 8 bytes, family code first
+//
+void owIntToRom(OWRom rom, uchar *SNum)
+{
+   int i;
+
+   for (i = 0; i < 8; i++)
+   {
+      SNum[i] = (uchar)(rom & 0xFF);
+      rom >>= 8;
+   }
+}
+
+//--------------------------------------------------------------------------
+// First hash table slot of a ROM.  The family code and the CRC are left
+// out, the 48 bit serial number is mixed with a multiplicative hash.
+//
+static int HashSlot(OWRom rom)
+{
+   rom = ((rom >> 8) & 0xFFFFFFFFFFFFULL) * 0x9E3779B97F4A7C15ULL;
+   return (int)(rom >> (64 - OWINV_HASH_BITS));
+}
+
+//--------------------------------------------------------------------------
+// Look up a ROM in a snapshot.
+//
+// Returns:  its position in search order, -1 if it is not there
+//
+static int SnapFind(InvSnapshot *snap, OWRom rom)
+{
+   int slot = HashSlot(rom);
+
+   while (snap->hash[slot] != 0)
+   {
+      if (snap->rom[snap->hash[slot] - 1] == rom)
+         return snap->hash[slot] - 1;
+      slot = (slot + 1) & (OWINV_HASH - 1);
+   }
+
+   return -1;
+}
+
+//--------------------------------------------------------------------------
+// Fill in a snapshot from the serial numbers of a search.
+//
+// 'snap'     - snapshot to fill in
+// 'ROMs'     - serial numbers in search order
+// 'num'      - number of serial numbers
+//
+static void SnapBuild(InvSnapshot *snap, uchar ROMs[][8], int num)
+{
+   short tail[256];
+   int i,slot,fam;
+
+   memset(snap->hash,0,sizeof(snap->hash));
+   for (i = 0; i < 256; i++)
+      snap->family[i] = tail[i] = -1;
+   snap->num = 0;
+
+   for (i = 0; i < num; i++)
+   {
+      snap->rom[snap->num] = owRomToInt(ROMs[i]);
+
+      // a device found twice is only kept once
+      if (SnapFind(snap,snap->rom[snap->num]) >= 0)
+         continue;
+
+      slot = HashSlot(snap->rom[snap->num]);
+      while (snap->hash[slot] != 0)
+         slot = (slot + 1) & (OWINV_HASH - 1);
+      snap->hash[slot] = (short)(snap->num + 1);
+
+      // add to the end of the list of its family
+      fam = ROMs[i][0];
+      snap->next[snap->num] = -1;
+      if (tail[fam] < 0)
+         snap->family[fam] = (short)snap->num;
+      else
+         snap->next[tail[fam]] = (short)snap->num;
+      tail[fam] = (short)snap->num;
+
+      snap->num++;
+   }
+}
@@ -0,0 +1,59 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owinv.h - Bus inventory.  One search fills a table of the devices on
+//            a port that answers "is this device there" and "which
+//            devices of this family are there" without searching again.
+//            The table of the scan before is kept so the devices that
+//            arrived or left between two scans can be listed.
+//
+//  Version: 3.00
+//
+
+#ifndef OWINV_H
+#define OWINV_H
+
+#include "ownet.h"
+
+// a ROM as one integer, the family code is the low byte
+typedef unsigned long long OWRom;
+
+// devices kept from one scan
+#define OWINV_DEVICES          128
+// hash table slots, a power of two at least twice OWINV_DEVICES
+#define OWINV_HASH_BITS        8
+#define OWINV_HASH             (1 << OWINV_HASH_BITS)
+
+// functions defined in owinv.c
+int      owInvScan(int portnum);
+SMALLINT owInvFind(int portnum, uchar *SNum);
+int      owInvFamily(int portnum, SMALLINT family, uchar FamilySN[][8], int max);
+int      owInvDiff(int portnum, SMALLINT arrived, uchar SNums[][8], int max);
+void     owInvFree(int portnum);
+OWRom    owRomToInt(uchar *SNum);
+void     owIntToRom(OWRom rom, uchar *SNum);
+
+#endif
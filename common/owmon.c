@@ -0,0 +1,455 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owmon.c - Presence monitor.  The index of a port is kept in the OWPort
+//            'mon'.  Each poll sends a search ROM along the path of every
+//            indexed device, writing its bits instead of choosing them.
+//            The bits read back show if the device is still there and if
+//            any device leaves the path where no indexed device does, in
+//            which case the bus is searched for the newcomer.  A port
+//            with nothing indexed costs one reset per poll.
+//
+//  Version: 3.00
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "ownet.h"
+#include "owport.h"
+#include "owsess.h"
+#include "owmon.h"
+
+// search ROM command
+#define SEARCH_ROM         0xF0
+
+// one indexed device
+typedef struct
+{
+   uchar ROM[8];
+   uchar branch[8];                  // bits where an indexed ROM leaves this path
+   int   misses;                     // polls in a row it was not found
+} MonDevice;
+
+// monitor kept in the OWPort 'mon'
+typedef struct
+{
+   SMALLINT      family;             // family reported, 0 for all
+   OWMonCallback cb;
+   void         *arg;
+   int           num;                // devices in the index
+   MonDevice     dev[OWMON_DEVICES]; // sorted in search order
+   OWMonEvent    queue[OWMON_QUEUE]; // events when there is no callback
+   int           qfirst;             // oldest event in the queue
+   int           qnum;               // events in the queue
+} MonState;
+
+// local functions
+static SMALLINT RomBit(uchar *ROM, int bit);
+static int      RomCompare(uchar *a, uchar *b);
+static int      RomFind(MonState *mon, uchar *ROM, SMALLINT *found);
+static void     SetBranches(MonState *mon);
+static SMALLINT CheckPath(int portnum, MonDevice *dev, SMALLINT *newcomer);
+static SMALLINT SearchNew(int portnum, MonState *mon, int *events);
+static SMALLINT RaiseEvent(int portnum, MonState *mon, int event, uchar *ROM);
+
+//--------------------------------------------------------------------------
+// Start monitoring a port.  Nothing is indexed until the first poll so
+// every device already on the bus arrives then.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'family'   - family code of the devices to raise events for, 0 for all.
+//              Other devices are indexed all the same so they are not
+//              searched for again.
+// 'cb'       - function called for each event, NULL to queue the events
+//              for owMonGetEvent
+// 'arg'      - passed to 'cb'
+//
+// Returns:  TRUE  the port is monitored, if it already was it is left
+//                 as it was
+//           FALSE no memory for the monitor
+//
+SMALLINT owMonStart(int portnum, SMALLINT family, OWMonCallback cb, void *arg)
+{
+   OWPort *port = owGetPort(portnum);
+   MonState *mon;
+
+   if (port->mon != NULL)
+      return TRUE;
+
+   mon = (MonState *)calloc(1,sizeof(MonState));
+   if (mon == NULL)
+   {
+      OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+      return FALSE;
+   }
+   mon->family = family;
+   mon->cb = cb;
+   mon->arg = arg;
+   port->mon = mon;
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Look for arrivals and departures on a monitored port.  Every indexed
+// device costs one search ROM, the whole bus is only searched when a
+// device that is not indexed answers.  A device departs when it is
+// missed OWMON_MISSES polls in a row.  The callback must not stop the
+// monitor.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+// Returns:  number of events raised, -1 if the port is not monitored
+//
+int owMonPoll(int portnum)
+{
+   MonState *mon = (MonState *)owGetPort(portnum)->mon;
+   SMALLINT newcomer = FALSE, changed = FALSE, found;
+   int i,events = 0;
+
+   if (mon == NULL)
+      return -1;
+
+   // the search ROMs end the session
+   owSessionEnd(portnum);
+
+   if (mon->num == 0)
+      newcomer = owTouchReset(portnum);
+   else
+   {
+      for (i = 0; i < mon->num; i++)
+      {
+         found = CheckPath(portnum,&mon->dev[i],&newcomer);
+         if (found < 0)
+         {
+            // no presence, nothing is on the bus
+            for (; i < mon->num; i++)
+               mon->dev[i].misses++;
+            break;
+         }
+         mon->dev[i].misses = found ? 0 : mon->dev[i].misses + 1;
+      }
+   }
+
+   if (newcomer && SearchNew(portnum,mon,&events))
+      changed = TRUE;
+
+   // drop the devices that have departed
+   for (i = 0; i < mon->num; )
+   {
+      if (mon->dev[i].misses >= OWMON_MISSES)
+      {
+         events += RaiseEvent(portnum,mon,OWMON_DEPARTED,mon->dev[i].ROM);
+         changed = TRUE;
+         mon->num--;
+         memmove(&mon->dev[i],&mon->dev[i + 1],(mon->num - i) * sizeof(MonDevice));
+      }
+      else
+         i++;
+   }
+
+   if (changed)
+      SetBranches(mon);
+
+   return events;
+}
+
+//--------------------------------------------------------------------------
+// Take the oldest queued event of a port monitored without a callback.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'ev'       - receives the event
+//
+// Returns:  TRUE  an event was taken
+//           FALSE the queue is empty
+//
+SMALLINT owMonGetEvent(int portnum, OWMonEvent *ev)
+{
+   MonState *mon = (MonState *)owGetPort(portnum)->mon;
+
+   if ((mon == NULL) || (mon->qnum == 0))
+      return FALSE;
+
+   *ev = mon->queue[mon->qfirst];
+   mon->qfirst = (mon->qfirst + 1) % OWMON_QUEUE;
+   mon->qnum--;
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Get the devices present at the last poll that have the family given
+// to owMonStart.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'SNums'    - receives 8 bytes for each serial number, in search order
+// 'max'      - number of serial numbers 'SNums' can hold
+//
+// Returns:  number of serial numbers copied
+//
+int owMonDevices(int portnum, uchar *SNums, int max)
+{
+   MonState *mon = (MonState *)owGetPort(portnum)->mon;
+   int i,cnt = 0;
+
+   if (mon == NULL)
+      return 0;
+
+   for (i = 0; (i < mon->num) && (cnt < max); i++)
+   {
+      if ((mon->family != 0) && (mon->dev[i].ROM[0] != mon->family))
+         continue;
+      memcpy(&SNums[cnt * 8],mon->dev[i].ROM,8);
+      cnt++;
+   }
+
+   return cnt;
+}
+
+//--------------------------------------------------------------------------
+// Stop monitoring a port.  Queued events are lost.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+void owMonStop(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+
+   free(port->mon);
+   port->mon = NULL;
+}
+
+//--------------------------------------------------------------------------
+// Get a bit of a ROM in the order the search ROM sends them.
+//
+static SMALLINT RomBit(uchar *ROM, int bit)
+{
+   return (ROM[bit >> 3] >> (bit & 0x07)) & 0x01;
+}
+
+//--------------------------------------------------------------------------
+// Compare two ROMs in the order a search finds them.
+//
+// Returns:  <0, 0 or >0 as 'a' is found before, is or is found after 'b'
+//
+static int RomCompare(uchar *a, uchar *b)
+{
+   int i;
+
+   for (i = 0; i < 64; i++)
+      if (RomBit(a,i) != RomBit(b,i))
+         return RomBit(a,i) - RomBit(b,i);
+
+   return 0;
+}
+
+//--------------------------------------------------------------------------
+// Binary search of the index.
+//
+// 'mon'      - monitor of the port
+// 'ROM'      - serial number to look for
+// 'found'    - set TRUE if it is in the index
+//
+// Returns:  its position, or where to insert it if not found
+//
+static int RomFind(MonState *mon, uchar *ROM, SMALLINT *found)
+{
+   int lo = 0, hi = mon->num, mid, cmp;
+
+   *found = FALSE;
+   while (lo < hi)
+   {
+      mid = (lo + hi) / 2;
+      cmp = RomCompare(ROM,mon->dev[mid].ROM);
+      if (cmp == 0)
+      {
+         *found = TRUE;
+         return mid;
+      }
+      if (cmp < 0)
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+
+   return lo;
+}
+
+//--------------------------------------------------------------------------
+// Work out for each indexed device the bits where the path of another
+// indexed device leaves its own.  That is the first bit where the two
+// ROMs differ.
+//
+static void SetBranches(MonState *mon)
+{
+   int i,j,bit;
+
+   for (i = 0; i < mon->num; i++)
+      memset(mon->dev[i].branch,0,8);
+
+   for (i = 0; i < mon->num; i++)
+      for (j = i + 1; j < mon->num; j++)
+      {
+         for (bit = 0; bit < 64; bit++)
+            if (RomBit(mon->dev[i].ROM,bit) != RomBit(mon->dev[j].ROM,bit))
+               break;
+         if (bit < 64)
+         {
+            mon->dev[i].branch[bit >> 3] |= (uchar)(0x01 << (bit & 0x07));
+            mon->dev[j].branch[bit >> 3] |= (uchar)(0x01 << (bit & 0x07));
+         }
+      }
+}
+
+//--------------------------------------------------------------------------
+// Send a search ROM that follows the path of an indexed device.  Each
+// of the 64 bits is two read time slots, the first reads 0 if a device
+// still selected has a 0 and the second reads 0 if one has a 1, then
+// the bit of the device is written.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'dev'      - device to look for
+// 'newcomer' - set TRUE if a device leaves the path where no indexed
+//              device does
+//
+// Returns:  TRUE  the device answered every bit
+//           FALSE the device is not on the bus
+//           -1    no presence pulse
+//
+static SMALLINT CheckPath(int portnum, MonDevice *dev, SMALLINT *newcomer)
+{
+   uchar block[25];
+   SMALLINT s,zero,one;
+   int i;
+
+   if (!owTouchReset(portnum))
+      return -1;
+
+   block[0] = SEARCH_ROM;
+   memset(&block[1],0xFF,24);
+   for (i = 0; i < 64; i++)
+      if (!RomBit(dev->ROM,i))
+         block[1 + (i * 3 + 2) / 8] &= (uchar)~(0x01 << ((i * 3 + 2) & 0x07));
+
+   if (!owBlock(portnum,FALSE,block,25))
+      return FALSE;
+
+   for (i = 0; i < 64; i++)
+   {
+      s = RomBit(dev->ROM,i);
+      zero = !RomBit(&block[1],i * 3);
+      one = !RomBit(&block[1],i * 3 + 1);
+
+      if ((s ? zero : one) && !RomBit(dev->branch,i))
+         *newcomer = TRUE;
+      if (!(s ? one : zero))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Search the whole bus and index the devices that are not indexed yet.
+// The current serial number of the port is left as it was.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'mon'      - monitor of the port
+// 'events'   - incremented for each arrival raised
+//
+// Returns:  TRUE if a device was added to the index
+//
+static SMALLINT SearchNew(int portnum, MonState *mon, int *events)
+{
+   uchar saved[8],ROM[8];
+   SMALLINT rslt,found,added = FALSE;
+   int pos;
+
+   owSerialNum(portnum,saved,TRUE);
+
+   rslt = owFirst(portnum,TRUE,FALSE);
+   while (rslt)
+   {
+      owSerialNum(portnum,ROM,TRUE);
+      pos = RomFind(mon,ROM,&found);
+      if (found)
+         mon->dev[pos].misses = 0;
+      else if (mon->num < OWMON_DEVICES)
+      {
+         memmove(&mon->dev[pos + 1],&mon->dev[pos],(mon->num - pos) * sizeof(MonDevice));
+         memset(&mon->dev[pos],0,sizeof(MonDevice));
+         memcpy(mon->dev[pos].ROM,ROM,8);
+         mon->num++;
+         *events += RaiseEvent(portnum,mon,OWMON_ARRIVED,ROM);
+         added = TRUE;
+      }
+      rslt = owNext(portnum,TRUE,FALSE);
+   }
+
+   owSerialNum(portnum,saved,FALSE);
+   return added;
+}
+
+//--------------------------------------------------------------------------
+// Pass an event to the callback or queue it.  Only devices of the
+// family given to owMonStart are reported.
+//
+// Returns:  TRUE if the event was raised
+//
+static SMALLINT RaiseEvent(int portnum, MonState *mon, int event, uchar *ROM)
+{
+   OWMonEvent *ev,tmp;
+
+   if ((mon->family != 0) && (ROM[0] != mon->family))
+      return FALSE;
+
+   if (mon->cb != NULL)
+      ev = &tmp;
+   else
+   {
+      if (mon->qnum == OWMON_QUEUE)
+      {
+         mon->qfirst = (mon->qfirst + 1) % OWMON_QUEUE;
+         mon->qnum--;
+      }
+      ev = &mon->queue[(mon->qfirst + mon->qnum) % OWMON_QUEUE];
+      mon->qnum++;
+   }
+
+   ev->portnum = portnum;
+   ev->event = event;
+   memcpy(ev->SerialNum,ROM,8);
+   ev->time = msGettick();
+
+   if (mon->cb != NULL)
+      mon->cb(ev,mon->arg);
+   return TRUE;
+}
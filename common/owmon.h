@@ -0,0 +1,71 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owmon.h - Presence monitor.  The devices found on a port are kept in
+//            an index sorted in search order.  owMonPoll checks each of
+//            them with one directed search and only enumerates the bus
+//            when a device shows up that is not in the index.  Arrivals
+//            and departures go to a callback or to a queue.
+//
+//  Version: 3.00
+//
+
+#ifndef OWMON_H
+#define OWMON_H
+
+#include "ownet.h"
+
+// events
+#define OWMON_ARRIVED          1
+#define OWMON_DEPARTED         2
+
+// devices indexed on each port
+#define OWMON_DEVICES          64
+// events kept when there is no callback, the oldest is dropped when full
+#define OWMON_QUEUE            32
+// polls in a row a device can be missed before it has departed
+#define OWMON_MISSES           2
+
+// an arrival or a departure
+typedef struct
+{
+   int   portnum;
+   int   event;                // OWMON_ARRIVED or OWMON_DEPARTED
+   uchar SerialNum[8];
+   long  time;                 // msGettick when seen
+} OWMonEvent;
+
+// called from owMonPoll for each event
+typedef void (*OWMonCallback)(OWMonEvent *ev, void *arg);
+
+// functions defined in owmon.c
+SMALLINT owMonStart(int portnum, SMALLINT family, OWMonCallback cb, void *arg);
+int      owMonPoll(int portnum);
+SMALLINT owMonGetEvent(int portnum, OWMonEvent *ev);
+int      owMonDevices(int portnum, uchar *SNums, int max);
+void     owMonStop(int portnum);
+
+#endif
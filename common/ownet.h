@@ -186,6 +186,9 @@
    #define MAX_PORTNUM    16
 #endif
 
+// largest block owBlock takes on every link
+#define OW_BLOCK_MAX   160
+
 // mode bit flags
 #define MODE_NORMAL                    0x00
 #define MODE_OVERDRIVE                 0x01
@@ -346,10 +349,38 @@ extern int owHasErrors(void);
 #define OWERROR_HYGRO_STOP_MISSION_ERROR        114
 #define OWERROR_PORTNUM_ERROR                   115
 #define OWERROR_LEVEL_FAILED                    116
+#define OWERROR_CONVERSION_TIMEOUT              117
+
+// number of error codes above, counted per port by owGetErrorCount
+#define OWERROR_COUNT                           118
+
+// number of recent errors each port keeps for owGetPortErrors
+#define OWERROR_LOG                             16
+
+// operation tag for owErrorOp when nothing has been set
+#define OWOP_NONE                               0
+
+// what was going on when an error was raised
+typedef struct
+{
+   int   error;            // OWERROR_ code
+   int   portnum;          // port in use by the thread, -1 if none
+   uchar SerialNum[8];     // device selected on the port
+   int   op;               // tag set with owErrorOp, OWOP_NONE if none
+   long  time;             // msGettick when raised
+} OWErrorInfo;
+
+extern int   owErrorOp(int op);
+extern int   owGetErrorInfo(OWErrorInfo *info);
+extern int   owGetPortErrors(int portnum, OWErrorInfo *info, int max);
+extern ulong owGetErrorCount(int portnum, int err);
+extern void  owClearErrorCounts(int portnum);
 
 // One Wire functions defined in ownetu.c
 SMALLINT  owFirst(int portnum, SMALLINT do_reset, SMALLINT alarm_only);
 SMALLINT  owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only);
+int       owSearchAll(int portnum, uchar ROMs[][8], int max, SMALLINT search_family,
+                      SMALLINT alarm_only);
 void      owSerialNum(int portnum, uchar *serialnum_buf, SMALLINT do_read);
 void      owFamilySearchSetup(int portnum, SMALLINT search_family);
 void      owSkipFamily(int portnum);
@@ -409,10 +440,18 @@ void PrintHex(uchar* buffer, int cnt);
 void PrintChars(uchar* buffer, int cnt);
 void PrintSerialNum(uchar* buffer);
 
+// per-port context defined in owport.c, the members are private to the
+// libraries so an application only passes the handle around
+typedef struct OWPort OWPort;
+OWPort   *owGetPort(int portnum);
+int       owPortNum(OWPort *port);
+
 // external functions defined in crcutil.c
 void setcrc16(int portnum, ushort reset);
 ushort docrc16(int portnum, ushort cdata);
 void setcrc8(int portnum, uchar reset);
 uchar docrc8(int portnum, uchar x);
+uchar crc8_block(uchar seed, uchar *buf, int len);
+ushort crc16_block(ushort seed, uchar *buf, int len);
 
 #endif //OWNET_H
@@ -25,7 +25,10 @@
 //--------------------------------------------------------------------------
 //
 //  owPgRW.c - Reads and writes pages for the File I/O operations.
-//  version 1.00
+//  version 1.01
+//
+//  History: 1.00 -> 1.01  Read_Page follows redirections held in the
+//                         page cache.
 //
 
 // Include Files
@@ -58,13 +61,13 @@ SMALLINT Read_Page(int portnum, uchar *SNum, uchar *buff, uchar flag,
                    PAGE_TYPE *pg, int *len)
 {
 	SMALLINT  bank;
-	PAGE_TYPE page;
+	PAGE_TYPE page,rdpage;
    int       jobopen = FALSE;
    int       cnt = 0;
-	uchar     extra[3],space;
+	uchar     extra[3];
 	uchar     temp_buff[32];
 	uchar     rd_buf[2];
-   uchar     addpg;
+   int       space,addpg;
    int       i;	
 
 	
@@ -86,16 +89,16 @@ SMALLINT Read_Page(int portnum, uchar *SNum, uchar *buff, uchar flag,
       }
 
       // nope so look for page in cache
+      rdpage = *pg;
       if(FindPage(portnum,SNum,pg,flag,TRUE,buff,len,&space))  
       {
-         if(*len == 0x41)
-         {
-            *pg = buff[0];
-         }
-         else if(flag != STATUSMEM)
-         {
+         if(flag != STATUSMEM)
      		   return TRUE;
-         }
+      }
+      else if(*pg != rdpage)
+      {
+         // cached redirection so look for the new page
+         continue;
       }
 
       bank = getBank(portnum,SNum,*pg,flag);
@@ -132,7 +135,7 @@ SMALLINT Read_Page(int portnum, uchar *SNum, uchar *buff, uchar flag,
          if(extra[0] != 0xFF)
          {
       	   rd_buf[0] = ~extra[0];
-      		addpg = AddPage(portnum,SNum,*pg,&rd_buf[0],STATUSMEM);
+      		addpg = AddPage(portnum,SNum,*pg,STATUSMEM | REDIRMEM,&rd_buf[0],1);
       		*pg = (PAGE_TYPE) rd_buf[0];      
             continue;
          }
@@ -141,9 +144,7 @@ SMALLINT Read_Page(int portnum, uchar *SNum, uchar *buff, uchar flag,
             *len = 8;
             for(i=0;i<*len;i++)
                buff[i] = temp_buff[i];
-            addpg = AddPage(portnum,SNum,*pg,&buff[0],STATUSMEM);
-//  		   	   AddPage(portnum,SNum,*pg,&buff[0],*len);
-//               AddPage(portnum,SNum,*pg,&buff[0],0x41);
+            addpg = AddPage(portnum,SNum,*pg,STATUSMEM,&buff[0],*len);
             return TRUE;
 
          }
@@ -180,7 +181,7 @@ SMALLINT Read_Page(int portnum, uchar *SNum, uchar *buff, uchar flag,
          if(extra[0] != 0xFF)
          {
          	rd_buf[0] = ~extra[0];
-      		addpg = AddPage(portnum,SNum,*pg,&rd_buf[0],REDIRMEM);
+      		addpg = AddPage(portnum,SNum,*pg,REDIRMEM,&rd_buf[0],1);
       		*pg = (PAGE_TYPE) rd_buf[0];  
             continue;
          }
@@ -210,7 +211,7 @@ SMALLINT Read_Page(int portnum, uchar *SNum, uchar *buff, uchar flag,
                *len = temp_buff[0];
             }
 
-            addpg = AddPage(portnum,SNum,*pg,&buff[0],*len);
+            addpg = AddPage(portnum,SNum,*pg,REGMEM,&buff[0],*len);
             return TRUE;
          }
     	}
@@ -237,7 +238,7 @@ SMALLINT Write_Page(int portnum, uchar *SNum, uchar *buff, PAGE_TYPE pg, int len
 {
 	SMALLINT  bank;
 	PAGE_TYPE page;
-   uchar     addpg;
+   int       addpg;
    
    // check for length too long for a page
    if (len > 29)
@@ -261,7 +262,7 @@ SMALLINT Write_Page(int portnum, uchar *SNum, uchar *buff, PAGE_TYPE pg, int len
    	return FALSE;
 	else
    {
-		addpg = AddPage(portnum,SNum,pg,buff,len);
+		addpg = AddPage(portnum,SNum,pg,REGMEM,buff,len);
    }
 		
 	return TRUE;
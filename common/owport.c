@@ -0,0 +1,176 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owport.c - Per-port state table.  The OWPort structs are allocated
+//             one at a time the first time a port number is used and are
+//             never moved or freed, so a pointer returned by owGetPort
+//             stays good for the life of the program.  With OW_THREADS
+//             the allocation is done under a lock so any thread can be
+//             the first to use a port.
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  Table entries are published and read with
+//                         atomic release and acquire operations
+//
+
+#include "owport.h"
+
+#ifdef OW_THREADS
+#include <pthread.h>
+
+// held while allocating
+static pthread_mutex_t PortLock = PTHREAD_MUTEX_INITIALIZER;
+
+// the table is read without the lock, so entries are published with a
+// release store once they are filled in and read with an acquire load
+#define LOAD_ENTRY(e)        __atomic_load_n(&(e),__ATOMIC_ACQUIRE)
+#define STORE_ENTRY(e,v)     __atomic_store_n(&(e),(v),__ATOMIC_RELEASE)
+#else
+#define LOAD_ENTRY(e)        (e)
+#define STORE_ENTRY(e,v)     ((e) = (v))
+#endif
+
+// the table of ports, OWPORT_GROUPS groups of OWPORT_GROUP pointers
+static OWPort **PortGroup[OWPORT_GROUPS];
+
+// state used for a bad port number so the callers do not fault,
+// 'portnum' is the first member
+static OWPort BadPort = { -1 };
+
+// last port found by this thread, errors raised are charged to it
+OW_TLS int owLastPort = -1;
+
+// local functions
+static OWPort *NewPort(int portnum);
+
+//--------------------------------------------------------------------------
+// Get the state for a port, allocating it the first time the port
+// is used.
+//
+// 'portnum'  - number 0 to OWPORT_MAX-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+// Returns: pointer to the state of the port
+//
+OWPort *owGetPort(int portnum)
+{
+   OWPort **group;
+   OWPort *port;
+
+   if ((portnum >= 0) && (portnum < OWPORT_MAX))
+   {
+      group = LOAD_ENTRY(PortGroup[portnum / OWPORT_GROUP]);
+      if (group != NULL)
+      {
+         port = LOAD_ENTRY(group[portnum % OWPORT_GROUP]);
+         if (port != NULL)
+         {
+            owLastPort = portnum;
+            return port;
+         }
+      }
+   }
+
+   // errors raised while allocating are not charged to any port
+   owLastPort = -1;
+
+#ifdef OW_THREADS
+   // another thread may have allocated it while waiting
+   pthread_mutex_lock(&PortLock);
+   group = ((portnum >= 0) && (portnum < OWPORT_MAX)) ?
+           PortGroup[portnum / OWPORT_GROUP] : NULL;
+   if ((group != NULL) && (group[portnum % OWPORT_GROUP] != NULL))
+      port = group[portnum % OWPORT_GROUP];
+   else
+      port = NewPort(portnum);
+   pthread_mutex_unlock(&PortLock);
+#else
+   port = NewPort(portnum);
+#endif
+
+   if (port != &BadPort)
+      owLastPort = portnum;
+   return port;
+}
+
+//--------------------------------------------------------------------------
+// Get the port number of a port handle from owGetPort, for use with the
+// rest of the API.
+//
+// 'port'     - handle of the port
+//
+// Returns: port number, -1 for the handle of a bad port number
+//
+int owPortNum(OWPort *port)
+{
+   return (port != NULL) ? port->portnum : -1;
+}
+
+//--------------------------------------------------------------------------
+// Allocate the state for a port.
+//
+// 'portnum'  - number 0 to OWPORT_MAX-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+// Returns: pointer to the new state, BadPort on an error
+//
+static OWPort *NewPort(int portnum)
+{
+   OWPort **group;
+   OWPort *port;
+
+   if ((portnum < 0) || (portnum >= OWPORT_MAX))
+   {
+      OWERROR(OWERROR_PORTNUM_ERROR);
+      return &BadPort;
+   }
+
+   // allocate the group
+   group = PortGroup[portnum / OWPORT_GROUP];
+   if (group == NULL)
+   {
+      group = (OWPort **)calloc(OWPORT_GROUP,sizeof(OWPort *));
+      if (group == NULL)
+      {
+         OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+         return &BadPort;
+      }
+      STORE_ENTRY(PortGroup[portnum / OWPORT_GROUP],group);
+   }
+
+   // allocate the port, each on its own so busy ports do not share
+   port = (OWPort *)calloc(1,sizeof(OWPort));
+   if (port == NULL)
+   {
+      OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+      return &BadPort;
+   }
+   port->portnum = portnum;
+   STORE_ENTRY(group[portnum % OWPORT_GROUP],port);
+
+   return port;
+}
@@ -0,0 +1,146 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owport.h - Per-port state for the 1-Wire Net libraries.  Everything
+//             the libraries keep for one port (CRC accumulators, search
+//             state, DS2480B state and the serial link) is in one OWPort
+//             struct found with owGetPort.  This header is private to the
+//             libraries, applications see OWPort as an opaque handle
+//             (ownet.h) and use the port number API.
+//
+//  Version: 3.00
+//
+
+#ifndef OWPORT_H
+#define OWPORT_H
+
+#include "ownet.h"
+
+// ports are allocated on demand, a group of OWPORT_GROUP at a time
+#define OWPORT_GROUP           16
+#define OWPORT_GROUPS          256
+#define OWPORT_MAX             (OWPORT_GROUP * OWPORT_GROUPS)
+
+// with OW_THREADS each thread has its own copy of an OW_TLS variable
+#ifdef OW_THREADS
+   #ifdef _MSC_VER
+      #define OW_TLS __declspec(thread)
+   #else
+      #define OW_TLS __thread
+   #endif
+#else
+   #define OW_TLS
+#endif
+
+// serial link statistics kept by the link file (linuxlnk.c)
+typedef struct
+{
+   ulong read_calls;        // ReadCOM requests
+   ulong read_syscalls;     // read() calls made for those requests
+   ulong poll_calls;        // poll() waits for data or output room
+   ulong write_syscalls;    // write() calls
+   ulong bytes_read;        // bytes returned by ReadCOM
+   ulong bytes_written;     // bytes accepted by WriteCOM
+   ulong read_timeouts;     // ReadCOM requests that came back short
+   ulong read_us_total;     // total microseconds spent in ReadCOM
+   ulong read_us_max;       // longest single ReadCOM in microseconds
+} COMStats;
+
+// all of the state for one port, the OWPort handle of ownet.h
+struct OWPort
+{
+   int      portnum;                // port number of this state, keep first
+
+   // CRC accumulators (crcutil.c)
+   ushort   utilcrc16;
+   uchar    utilcrc8;
+
+   // search state (ownetu.c)
+   uchar    SerialNum[8];
+   int      LastDiscrepancy;
+   int      LastFamilyDiscrepancy;
+   uchar    LastDevice;
+
+   // DS2480B state (ds2480ut.c, owllu.c)
+   SMALLINT ULevel;                 // current DS2480B 1-Wire Net level
+   SMALLINT UBaud;                  // current DS2480B baud rate
+   SMALLINT UPrefBaud;              // baud rate found by DS2480MaxBaud
+   SMALLINT UMode;                  // current DS2480B command or data mode state
+   SMALLINT USpeed;                 // current DS2480B 1-Wire Net communication speed
+   SMALLINT UVersion;               // current DS2480B version
+   SMALLINT ProgramAvailable;       // 12 volt programming available
+
+   // serial link (linuxlnk.c)
+   int      fd;                     // open file descriptor, 0 if closed
+   int      txpending;              // bytes written and not yet read back
+   COMStats comstats;
+
+   // worker thread when the port is run by owbus.c
+   void    *bus;
+
+   // request queue when the port is run by owAsyncStart (linuxlnk.c)
+   void    *async;
+
+   // file page cache (owcache.c)
+   void    *cache;
+
+   // bus statistics when turned on with owStatsEnable (owstats.c)
+   void    *stats;
+
+   // device power modes and conversion times (owconv.c)
+   void    *conv;
+
+   // presence monitor started with owMonStart (owmon.c)
+   void    *mon;
+
+   // alarm handlers registered with owAlarmRegister (owalarm.c)
+   void    *alarm;
+
+   // bus inventory filled by owInvScan (owinv.c)
+   void    *inv;
+
+   // SHA iButtons were put in overdrive by SelectSHA (shaib.c, ibsha33o.c)
+   SMALLINT InOverdrive;
+
+   // speed the last DS1921 (thermo21.c) and DS2450 (atod20.c) select
+   // left the device at, MODE_NORMAL or MODE_OVERDRIVE
+   SMALLINT ThermoSpeed;
+   SMALLINT AtoDSpeed;
+
+   // device session (owsess.c)
+   uchar    SessROM[8];             // device selected by owSessionSelect
+   SMALLINT SessState;              // OWSESS_NONE, _NORMAL or _OVERDRIVE
+
+   // errors raised while this port was in use (owerr.c)
+   ulong    ErrCount[OWERROR_COUNT];
+   OWErrorInfo ErrLog[OWERROR_LOG]; // ring of the most recent errors
+   int      ErrNext;                // next ErrLog entry to write
+};
+
+// last port found with owGetPort by this thread, -1 if none (owport.c)
+extern OW_TLS int owLastPort;
+
+#endif
@@ -68,8 +68,8 @@ SMALLINT owCreateProgramJob(int portnum, uchar *SNum)
       return FALSE;
    }
       
-   // flush all of the cached pages
-   InitDHash();
+   // flush the cached pages of the device
+   owCacheInvalidate(portnum,SNum);
 
    // read the bitmap 
    if(!ReadBitMap(portnum,SNum,&job.EBitmap[0]))
@@ -170,8 +170,8 @@ SMALLINT owDoProgramJob(int portnum, uchar *SNum)
       return FALSE;
    }
    
-   // flush all of the cached pages
-   InitDHash();
+   // flush the cached pages of the device
+   owCacheInvalidate(portnum,SNum);
    
    maxp = maxPages(portnum,SNum);
 
@@ -288,8 +288,8 @@ SMALLINT owDoProgramJob(int portnum, uchar *SNum)
    }
 
    
-   // flush all of the cached pages
-   InitDHash();
+   // flush the cached pages of the device
+   owCacheInvalidate(portnum,SNum);
 
    // loop through all of the pages and check too see how many pages need to 
    // be re-directed.  From that see if there is enough room on the device
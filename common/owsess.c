@@ -0,0 +1,209 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owsess.c - Device sessions.  The device last selected with
+//             owSessionSelect is kept in the OWPort along with the speed
+//             it was selected at.  Anything else that addresses a device
+//             (owAccess, owVerify, a search, an owTxn) and any 1-Wire
+//             reset in the link layer ends the session, and so does an
+//             error raised while the port is in use.
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  The session is ended by every link layer reset
+//                         and by an error.  Resume only reports the
+//                         presence.
+//
+
+#include <string.h>
+#include "ownet.h"
+#include "owport.h"
+#include "owsess.h"
+
+// local functions
+static SMALLINT CanResume(uchar family);
+static SMALLINT CanOverdrive(uchar family);
+static SMALLINT Resume(int portnum);
+
+// families with the Resume ROM command (0xA5)
+static uchar ResumeFamilies[] =
+   { 0x18, 0x1C, 0x29, 0x2D, 0x33, 0x37, 0x3A, 0x41, 0x43 };
+
+// families that can do overdrive
+static uchar OverdriveFamilies[] =
+   { 0x04, 0x06, 0x08, 0x0A, 0x0B, 0x0C, 0x0F, 0x12, 0x14, 0x18, 0x1A,
+     0x1C, 0x1D, 0x1F, 0x20, 0x21, 0x23, 0x29, 0x2D, 0x33, 0x37, 0x3A,
+     0x41, 0x43 };
+
+//--------------------------------------------------------------------------
+// Select a device.  If it is the device selected last time on this
+// port it is resumed, otherwise it is selected with an overdrive Match
+// ROM when its family can do overdrive and with a Match ROM at normal
+// speed when it can not or the overdrive select fails.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'SNum'     - serial number of the device to select
+//
+// Returns:  TRUE (1)  : the device is selected and ready for a command
+//           FALSE (0) : the device could not be selected
+//
+SMALLINT owSessionSelect(int portnum, uchar *SNum)
+{
+   OWPort *port = owGetPort(portnum);
+   SMALLINT state = port->SessState;
+
+   // same device as last time
+   if ((state != OWSESS_NONE) && (memcmp(port->SessROM,SNum,8) == 0))
+   {
+      owLevel(portnum,MODE_NORMAL);
+      owSpeed(portnum,(state == OWSESS_OVERDRIVE) ? MODE_OVERDRIVE 
+                                                  : MODE_NORMAL);
+
+      if (CanResume(SNum[0]))
+      {
+         if (Resume(portnum))
+         {
+            // the reset before the Resume ROM ended the session
+            port->SessState = state;
+            return TRUE;
+         }
+      }
+      else
+      {
+         owSerialNum(portnum,SNum,FALSE);
+         if (owAccess(portnum))
+         {
+            // owAccess ended the session
+            port->SessState = state;
+            return TRUE;
+         }
+      }
+
+      // could not get it back at the old speed, start over
+   }
+
+   owSessionEnd(portnum);
+   owSerialNum(portnum,SNum,FALSE);
+
+#ifndef __MC68K__
+   if (CanOverdrive(SNum[0]))
+   {
+      if (owOverdriveAccess(portnum))
+      {
+         memcpy(port->SessROM,SNum,8);
+         port->SessState = OWSESS_OVERDRIVE;
+         return TRUE;
+      }
+   }
+#endif
+
+   // normal speed Match ROM, the reset also takes any device in
+   // overdrive back to normal speed
+   owSpeed(portnum,MODE_NORMAL);
+   if (owAccess(portnum))
+   {
+      memcpy(port->SessROM,SNum,8);
+      port->SessState = OWSESS_NORMAL;
+      return TRUE;
+   }
+
+   return FALSE;
+}
+
+//--------------------------------------------------------------------------
+// Forget the device selected on a port.  Called by everything else that
+// selects a device and by a caller that got a bad CRC from the device
+// so the next owSessionSelect does a full select.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+void owSessionEnd(int portnum)
+{
+   owGetPort(portnum)->SessState = OWSESS_NONE;
+}
+
+//--------------------------------------------------------------------------
+// Get the speed of the device selected on a port.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+// Returns:  OWSESS_NONE, OWSESS_NORMAL or OWSESS_OVERDRIVE
+//
+SMALLINT owSessionSpeed(int portnum)
+{
+   return owGetPort(portnum)->SessState;
+}
+
+//--------------------------------------------------------------------------
+// Reset and Resume ROM the device selected last.  Nothing on the bus
+// answers a Resume ROM, so this can not tell if the device was resumed.
+// The caller checks the CRC of what it reads, and the error it raises
+// when it is bad ends the session (owerr.c).
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+// Returns:  TRUE (1)  : reset had a presence and the command was sent
+//           FALSE (0) : no presence
+//
+static SMALLINT Resume(int portnum)
+{
+   uchar cmd = 0xA5;
+
+   return owBlock(portnum,TRUE,&cmd,1);
+}
+
+//--------------------------------------------------------------------------
+// Check the family code tables.
+//
+// 'family'   - family code of the device
+//
+// Returns:  TRUE (1) if the family is in the table
+//
+static SMALLINT CanResume(uchar family)
+{
+   int i;
+
+   for (i = 0; i < (int)sizeof(ResumeFamilies); i++)
+      if (ResumeFamilies[i] == family)
+         return TRUE;
+
+   return FALSE;
+}
+
+static SMALLINT CanOverdrive(uchar family)
+{
+   int i;
+
+   for (i = 0; i < (int)sizeof(OverdriveFamilies); i++)
+      if (OverdriveFamilies[i] == family)
+         return TRUE;
+
+   return FALSE;
+}
@@ -0,0 +1,50 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owsess.h - Device sessions.  owSessionSelect remembers the device it
+//             last selected on each port so selecting it again is a
+//             reset and Resume ROM instead of a full Match ROM, and
+//             devices that can do overdrive are run in overdrive.
+//
+//  Version: 3.00
+//
+
+#ifndef OWSESS_H
+#define OWSESS_H
+
+#include "ownet.h"
+
+// session state kept in the OWPort
+#define OWSESS_NONE            0     // no device selected
+#define OWSESS_NORMAL          1     // device selected at normal speed
+#define OWSESS_OVERDRIVE       2     // device selected in overdrive
+
+// functions defined in owsess.c
+SMALLINT owSessionSelect(int portnum, uchar *SNum);
+void     owSessionEnd(int portnum);
+SMALLINT owSessionSpeed(int portnum);
+
+#endif
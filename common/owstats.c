@@ -0,0 +1,355 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owstats.c - Bus statistics.  The counters of a port are allocated by
+//              owStatsEnable and kept in the OWPort.  The link and
+//              network files call owStatsStart and owStatsEnd around the
+//              calls that are timed, which do nothing but look at the
+//              OWPort while the statistics of the port are off.  The
+//              counters are changed, copied and freed under StatsLock so
+//              owStatsEnable can turn a port off while its bus worker is
+//              still counting.
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  Timed with usGettick instead of a clock of its
+//                         own.  The counters are locked so they are not
+//                         freed while being counted.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "ownet.h"
+#include "owport.h"
+#include "owtime.h"
+#include "owstats.h"
+
+#ifdef OW_THREADS
+#include <pthread.h>
+
+// held while the counters of a port are changed, copied or freed, the
+// thread running a port and the one reading its statistics differ
+static pthread_mutex_t StatsLock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_STATS()         pthread_mutex_lock(&StatsLock)
+#define UNLOCK_STATS()       pthread_mutex_unlock(&StatsLock)
+#else
+#define LOCK_STATS()
+#define UNLOCK_STATS()
+#endif
+
+// statistics kept in the OWPort 'stats'
+typedef struct
+{
+   OWStats   s;
+   long long power_start;            // when the pull-up went on, 0 if off
+} PortStats;
+
+// names used by owStatsPrint
+static char *StatNames[OWSTAT_KINDS] =
+   { "reset", "block", "search", "level", "power", "txn",
+     "COM read", "COM write" };
+
+// local functions
+static void Record(OWStatTimer *timer, long long us, SMALLINT ok);
+
+//--------------------------------------------------------------------------
+// Turn the statistics of a port on or off.  Turning them on starts
+// with all of the counters at zero.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'enable'   - TRUE (1) to count, FALSE (0) to stop and free the counters
+//
+// Returns:  TRUE (1)  : done
+//           FALSE (0) : could not allocate the counters
+//
+SMALLINT owStatsEnable(int portnum, SMALLINT enable)
+{
+   OWPort *port = owGetPort(portnum);
+   PortStats *ps;
+
+   if (!enable)
+   {
+      // no one is counting into them once they are off the port
+      LOCK_STATS();
+      ps = (PortStats *)port->stats;
+      port->stats = NULL;
+      UNLOCK_STATS();
+      free(ps);
+      return TRUE;
+   }
+
+   if (port->stats == NULL)
+   {
+      ps = (PortStats *)calloc(1,sizeof(PortStats));
+      if (ps == NULL)
+      {
+         OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+         return FALSE;
+      }
+      ps->s.since_us = usGettick();
+
+      LOCK_STATS();
+      if (port->stats == NULL)
+      {
+         port->stats = ps;
+         ps = NULL;
+      }
+      UNLOCK_STATS();
+
+      // turned on by another thread in the meantime
+      free(ps);
+   }
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Get a copy of the statistics of a port.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'stats'    - structure to receive the statistics
+//
+// Returns:  TRUE (1)  : copied
+//           FALSE (0) : the statistics of the port are off
+//
+SMALLINT owStatsSnapshot(int portnum, OWStats *stats)
+{
+   OWPort *port = owGetPort(portnum);
+   PortStats *ps;
+
+   LOCK_STATS();
+   ps = (PortStats *)port->stats;
+   if (ps != NULL)
+      *stats = ps->s;
+   UNLOCK_STATS();
+
+   return (ps != NULL);
+}
+
+//--------------------------------------------------------------------------
+// Set the statistics of a port back to zero.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+void owStatsReset(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+   PortStats *ps;
+
+   LOCK_STATS();
+   ps = (PortStats *)port->stats;
+   if (ps != NULL)
+   {
+      memset(&ps->s,0,sizeof(OWStats));
+      ps->s.since_us = usGettick();
+   }
+   UNLOCK_STATS();
+}
+
+//--------------------------------------------------------------------------
+// Start timing a call.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+// Returns:  the start time to give to owStatsEnd, 0 when the
+//           statistics of the port are off
+//
+long long owStatsStart(int portnum)
+{
+   long long now;
+
+   if (owGetPort(portnum)->stats == NULL)
+      return 0;
+
+   now = usGettick();
+   return (now != 0) ? now : 1;
+}
+
+//--------------------------------------------------------------------------
+// Finish timing a call and count it.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'kind'     - what was timed, OWSTAT_xxx
+// 'start'    - time returned by owStatsStart
+// 'ok'       - TRUE (1) if the call worked, FALSE (0) if it failed
+//
+void owStatsEnd(int portnum, int kind, long long start, SMALLINT ok)
+{
+   OWPort *port;
+   PortStats *ps;
+   long long now;
+
+   if (start == 0)
+      return;
+
+   now = usGettick();
+   port = owGetPort(portnum);
+
+   LOCK_STATS();
+   ps = (PortStats *)port->stats;
+   if (ps != NULL)
+      Record(&ps->s.timer[kind],now - start,ok);
+   UNLOCK_STATS();
+}
+
+//--------------------------------------------------------------------------
+// Note a change of the 1-Wire Net level so the time the strong pull-up
+// (or program voltage) is on can be counted.  Called where the link
+// file sets 'ULevel'.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'level'    - the new level, MODE_NORMAL, MODE_STRONG5 or MODE_PROGRAM
+//
+void owStatsLevel(int portnum, SMALLINT level)
+{
+   OWPort *port = owGetPort(portnum);
+   PortStats *ps;
+   long long now;
+
+   if (port->stats == NULL)
+      return;
+
+   now = usGettick();
+
+   LOCK_STATS();
+   ps = (PortStats *)port->stats;
+   if (ps != NULL)
+   {
+      if (level != MODE_NORMAL)
+      {
+         if (ps->power_start == 0)
+            ps->power_start = now;
+      }
+      else if (ps->power_start != 0)
+      {
+         Record(&ps->s.timer[OWSTAT_POWER],now - ps->power_start,TRUE);
+         ps->power_start = 0;
+      }
+   }
+   UNLOCK_STATS();
+}
+
+//--------------------------------------------------------------------------
+// Estimate a percentile of the call times from the histogram.
+//
+// 'timer'    - counters of one kind of call
+// 'pct'      - percentile, 1 to 100
+//
+// Returns:  upper bound in microseconds of the histogram bucket the
+//           percentile falls in, 0 if nothing was counted
+//
+long long owStatsPercentile(OWStatTimer *timer, int pct)
+{
+   ulong want,sum = 0;
+   long long bound;
+   int i;
+
+   if (timer->count == 0)
+      return 0;
+
+   want = (ulong)(((double)timer->count * pct + 99) / 100);
+   for (i = 0; i < (OWSTAT_BUCKETS - 1); i++)
+   {
+      sum += timer->hist[i];
+      if (sum >= want)
+         break;
+   }
+
+   // the last bucket has no upper bound, neither is past the longest
+   bound = (long long)1 << (i + 1);
+   if ((i == (OWSTAT_BUCKETS - 1)) || (bound > timer->max_us))
+      return timer->max_us;
+   return bound;
+}
+
+//--------------------------------------------------------------------------
+// Print the statistics of a port, one line for each kind of call.  The
+// busy column is the time spent in the calls as a percent of the time
+// the statistics cover, a bus with resets, blocks and searches near 100
+// has no room left.
+//
+// 'fp'       - where to print
+// 'portnum'  - port number printed in the heading
+// 'stats'    - statistics from owStatsSnapshot
+//
+void owStatsPrint(FILE *fp, int portnum, OWStats *stats)
+{
+   OWStatTimer *t;
+   double secs;
+   int i;
+
+   secs = (double)(usGettick() - stats->since_us) / 1e6;
+   fprintf(fp,"Port %d: %.3f seconds\n",portnum,secs);
+   fprintf(fp,"%-10s %10s %8s %10s %10s %10s %10s %6s\n","","calls",
+           "failed","avg us","p50 us","p99 us","max us","busy%");
+
+   for (i = 0; i < OWSTAT_KINDS; i++)
+   {
+      t = &stats->timer[i];
+      if (t->count == 0)
+         continue;
+      fprintf(fp,"%-10s %10lu %8lu %10.1f %10.1f %10.1f %10.1f %6.1f\n",
+              StatNames[i],t->count,t->failed,
+              (double)t->total_us / t->count,
+              (double)owStatsPercentile(t,50),
+              (double)owStatsPercentile(t,99),
+              (double)t->max_us,
+              (secs > 0) ? ((double)t->total_us / 1e4 / secs) : 0.0);
+   }
+}
+
+//--------------------------------------------------------------------------
+// Count one call.
+//
+// 'timer'    - counters of the kind of call
+// 'us'       - time the call took in microseconds
+// 'ok'       - TRUE (1) if the call worked
+//
+static void Record(OWStatTimer *timer, long long us, SMALLINT ok)
+{
+   long long v = us >> 1;
+   int b = 0;
+
+   while ((v != 0) && (b < (OWSTAT_BUCKETS - 1)))
+   {
+      v >>= 1;
+      b++;
+   }
+
+   timer->count++;
+   if (!ok)
+      timer->failed++;
+   timer->total_us += us;
+   if (us > timer->max_us)
+      timer->max_us = us;
+   timer->hist[b]++;
+}
@@ -0,0 +1,87 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owstats.h - Bus statistics.  When turned on for a port with
+//              owStatsEnable, the resets, blocks, searches, level changes,
+//              transactions and COM reads and writes of the port are
+//              counted and timed with the usGettick clock of owtime.c
+//              into log2 latency histograms.  When off the cost is one
+//              test.
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  Timed in microseconds with usGettick
+//
+
+#ifndef OWSTATS_H
+#define OWSTATS_H
+
+#include <stdio.h>
+#include "ownet.h"
+
+// what is timed
+#define OWSTAT_RESET           0     // owTouchReset
+#define OWSTAT_BLOCK           1     // owBlock
+#define OWSTAT_SEARCH          2     // owFirst, owNext and owSearchAll
+#define OWSTAT_LEVEL           3     // owLevel calls that change the level
+#define OWSTAT_POWER           4     // time strong pull-up or 12V was on
+#define OWSTAT_TXN             5     // owTxnExecute and owTxnPipeline
+#define OWSTAT_COMREAD         6     // ReadCOM
+#define OWSTAT_COMWRITE        7     // WriteCOM
+#define OWSTAT_KINDS           8
+
+// histogram bucket 0 is under 2 us, bucket i is 2^i to 2^(i+1) us
+// and the last bucket holds everything longer
+#define OWSTAT_BUCKETS         24
+
+// counts and times of one kind of call
+typedef struct
+{
+   ulong     count;                  // calls
+   ulong     failed;                 // calls that returned FALSE
+   long long total_us;               // time in all of the calls
+   long long max_us;                 // longest call
+   ulong     hist[OWSTAT_BUCKETS];   // calls by time
+} OWStatTimer;
+
+// statistics of one port
+typedef struct
+{
+   long long   since_us;             // usGettick when counting started
+   OWStatTimer timer[OWSTAT_KINDS];
+} OWStats;
+
+// functions defined in owstats.c
+SMALLINT  owStatsEnable(int portnum, SMALLINT enable);
+SMALLINT  owStatsSnapshot(int portnum, OWStats *stats);
+void      owStatsReset(int portnum);
+long long owStatsStart(int portnum);
+void      owStatsEnd(int portnum, int kind, long long start, SMALLINT ok);
+void      owStatsLevel(int portnum, SMALLINT level);
+long long owStatsPercentile(OWStatTimer *timer, int pct);
+void      owStatsPrint(FILE *fp, int portnum, OWStats *stats);
+
+#endif
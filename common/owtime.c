@@ -0,0 +1,110 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owtime.c - Monotonic microsecond clock and absolute deadline delays.
+//             Where there is a CLOCK_MONOTONIC the clock never goes back
+//             or wraps and a delay sleeps to an absolute time so a signal
+//             does not stretch it.  Other Unix systems use the time of
+//             day, since the Linux link builds msGettick and msDelay on
+//             these.  Elsewhere they are built on the msGettick and
+//             msDelay of the link file.
+//
+//  Version: 3.02
+//
+//  History: 3.00 -> 3.01  Without CLOCK_MONOTONIC a Unix system uses
+//                         gettimeofday and nanosleep instead of msGettick
+//                         and msDelay, which call back into this file.
+//           3.01 -> 3.02  Removed usDelay, nothing used it and the
+//                         micro-controller link files have their own.
+//
+
+#include <time.h>
+#include <errno.h>
+#include "ownet.h"
+#include "owtime.h"
+
+// time of day fallback where there is no monotonic clock
+#if !defined(CLOCK_MONOTONIC) && (defined(__unix__) || defined(__APPLE__))
+   #define OW_TOD_CLOCK
+   #include <sys/time.h>
+#endif
+
+//--------------------------------------------------------------------------
+// Get the time of the monotonic clock.
+//
+// Returns:  microseconds from an arbitrary start
+//
+long long usGettick(void)
+{
+#ifdef CLOCK_MONOTONIC
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#elif defined(OW_TOD_CLOCK)
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+   return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+#else
+   return (long long)msGettick() * 1000;
+#endif
+}
+
+//--------------------------------------------------------------------------
+// Delay until the monotonic clock reaches a time.  Returns at once if
+// the time has already passed.
+//
+// 'deadline' - usGettick time to wait for
+//
+void usDelayUntil(long long deadline)
+{
+#ifdef CLOCK_MONOTONIC
+   struct timespec ts;
+
+   ts.tv_sec = (time_t)(deadline / 1000000);
+   ts.tv_nsec = (long)(deadline % 1000000) * 1000;
+   while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+      ;
+#elif defined(OW_TOD_CLOCK)
+   struct timespec ts;
+   long long left;
+
+   // sleep what is left again if a signal cut it short
+   while ((left = deadline - usGettick()) > 0)
+   {
+      ts.tv_sec = (time_t)(left / 1000000);
+      ts.tv_nsec = (long)(left % 1000000) * 1000;
+      nanosleep(&ts, NULL);
+   }
+#else
+   long long left = deadline - usGettick();
+
+   // msDelay waits at least the time asked for
+   if (left > 0)
+      msDelay((int)((left + 999) / 1000));
+#endif
+}
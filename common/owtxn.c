@@ -0,0 +1,345 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owtxn.c - Transaction builder.  The steps are only recorded here, the
+//            link transport file runs them with owTxnExecute and then
+//            calls owTxnVerify to check the CRC of the read slices.
+//
+//  Version: 3.00
+//
+
+#include <string.h>
+#include "ownet.h"
+#include "owtxn.h"
+
+// local functions
+static int AddStep(OWTxn *txn, uchar type, int len);
+
+//--------------------------------------------------------------------------
+// Start a new empty transaction.
+//
+// 'txn'       - transaction to clear
+//
+void owTxnInit(OWTxn *txn)
+{
+   txn->len = 0;
+   txn->nsteps = 0;
+   txn->overflow = FALSE;
+}
+
+//--------------------------------------------------------------------------
+// Add a reset and presence detect.  The strong pull-up of an earlier
+// owTxnPower step is turned off first.
+//
+// 'txn'       - transaction to add to
+//
+// Returns:  step number, -1 if the transaction is full
+//
+int owTxnReset(OWTxn *txn)
+{
+   return AddStep(txn,OWTXN_RESET,0);
+}
+
+//--------------------------------------------------------------------------
+// Add a Match ROM of a device.
+//
+// 'txn'       - transaction to add to
+// 'SNum'      - serial number of the device to select
+//
+// Returns:  step number, -1 if the transaction is full
+//
+int owTxnMatchROM(OWTxn *txn, uchar *SNum)
+{
+   int slice;
+
+   slice = AddStep(txn,OWTXN_BYTES,9);
+   if (slice >= 0)
+   {
+      txn->buf[txn->step[slice].offset] = 0x55;
+      memcpy(&txn->buf[txn->step[slice].offset + 1],SNum,8);
+      txn->step[slice].rom = TRUE;
+   }
+
+   return slice;
+}
+
+//--------------------------------------------------------------------------
+// Add a Skip ROM to talk to every device (or the only one) on the Net.
+//
+// 'txn'       - transaction to add to
+//
+// Returns:  step number, -1 if the transaction is full
+//
+int owTxnSkipROM(OWTxn *txn)
+{
+   int slice;
+
+   slice = AddStep(txn,OWTXN_BYTES,1);
+   if (slice >= 0)
+   {
+      txn->buf[txn->step[slice].offset] = 0xCC;
+      txn->step[slice].rom = TRUE;
+   }
+
+   return slice;
+}
+
+//--------------------------------------------------------------------------
+// Add a Resume to talk to the device selected by the last Match ROM.
+//
+// 'txn'       - transaction to add to
+//
+// Returns:  step number, -1 if the transaction is full
+//
+int owTxnResumeROM(OWTxn *txn)
+{
+   int slice;
+
+   slice = AddStep(txn,OWTXN_BYTES,1);
+   if (slice >= 0)
+   {
+      txn->buf[txn->step[slice].offset] = 0xA5;
+      txn->step[slice].rom = TRUE;
+   }
+
+   return slice;
+}
+
+//--------------------------------------------------------------------------
+// Add command or data bytes to write.
+//
+// 'txn'       - transaction to add to
+// 'data'      - bytes to write
+// 'len'       - number of bytes
+//
+// Returns:  step number, -1 if the transaction is full
+//
+int owTxnWrite(OWTxn *txn, uchar *data, int len)
+{
+   int slice;
+
+   slice = AddStep(txn,OWTXN_BYTES,len);
+   if (slice >= 0)
+      memcpy(&txn->buf[txn->step[slice].offset],data,len);
+
+   return slice;
+}
+
+//--------------------------------------------------------------------------
+// Add read slots.  The data read is found with owTxnData once the
+// transaction has run.  A CRC8 check covers just the slice.  A CRC16
+// check covers the bytes after the ROM function (or after the last
+// CRC16 slice) up to the end of the slice, which is how the memory
+// commands send their CRC16.
+//
+// 'txn'       - transaction to add to
+// 'len'       - number of bytes to read
+// 'crc_type'  - OWTXN_CRC_NONE, OWTXN_CRC8 or OWTXN_CRC16
+//
+// Returns:  step number, -1 if the transaction is full
+//
+int owTxnRead(OWTxn *txn, int len, SMALLINT crc_type)
+{
+   int slice;
+
+   slice = AddStep(txn,OWTXN_BYTES,len);
+   if (slice >= 0)
+   {
+      memset(&txn->buf[txn->step[slice].offset],0xFF,len);
+      txn->step[slice].crc = (uchar)crc_type;
+   }
+
+   return slice;
+}
+
+//--------------------------------------------------------------------------
+// Add a byte to write followed by the strong pull-up, as for a
+// temperature conversion.  The pull-up stays on until the next reset.
+//
+// 'txn'       - transaction to add to
+// 'sendbyte'  - byte to write
+//
+// Returns:  step number, -1 if the transaction is full
+//
+int owTxnPower(OWTxn *txn, SMALLINT sendbyte)
+{
+   int slice;
+
+   slice = AddStep(txn,OWTXN_POWER,1);
+   if (slice >= 0)
+      txn->buf[txn->step[slice].offset] = (uchar)sendbyte;
+
+   return slice;
+}
+
+//--------------------------------------------------------------------------
+// Add a wait.  The steps before it are sent to the adapter first.
+//
+// 'txn'       - transaction to add to
+// 'ms'        - milliseconds to wait
+//
+// Returns:  step number, -1 if the transaction is full
+//
+int owTxnDelay(OWTxn *txn, int ms)
+{
+   int slice;
+
+   slice = AddStep(txn,OWTXN_DELAY,0);
+   if (slice >= 0)
+      txn->step[slice].ms = ms;
+
+   return slice;
+}
+
+//--------------------------------------------------------------------------
+// Get the bytes of a step after the transaction has run.
+//
+// 'txn'       - transaction that was run
+// 'slice'     - step number returned when the step was added
+// 'len'       - (output) number of bytes, may be NULL
+//
+// Returns:  pointer to the bytes, NULL for a bad step number
+//
+uchar *owTxnData(OWTxn *txn, int slice, int *len)
+{
+   if ((slice < 0) || (slice >= txn->nsteps))
+      return NULL;
+
+   if (len != NULL)
+      *len = txn->step[slice].len;
+
+   return &txn->buf[txn->step[slice].offset];
+}
+
+//--------------------------------------------------------------------------
+// Get the result of a step after the transaction has run.
+//
+// 'txn'       - transaction that was run
+// 'slice'     - step number returned when the step was added
+//
+// Returns:  OWTXN_OK or OWTXN_xxx error
+//
+SMALLINT owTxnStatus(OWTxn *txn, int slice)
+{
+   if ((slice < 0) || (slice >= txn->nsteps))
+      return OWTXN_NOT_RUN;
+
+   return txn->step[slice].status;
+}
+
+//--------------------------------------------------------------------------
+// Check the CRC of every read slice that asked for one.  Called by
+// owTxnExecute once all of the steps have run.
+//
+// 'txn'       - transaction that was run
+//
+// Returns:  TRUE  every step ran and every CRC is good
+//           FALSE a step failed, the step status has the reason
+//
+SMALLINT owTxnVerify(OWTxn *txn)
+{
+   int i,crc_start = -1;
+   SMALLINT rt = TRUE;
+   OWTxnStep *st;
+
+   for (i = 0; i < txn->nsteps; i++)
+   {
+      st = &txn->step[i];
+      if (st->status != OWTXN_OK)
+      {
+         rt = FALSE;
+         continue;
+      }
+
+      // a reset or ROM function starts a new command
+      if ((st->type == OWTXN_RESET) || st->rom)
+      {
+         crc_start = -1;
+         continue;
+      }
+
+      if ((st->type != OWTXN_BYTES) && (st->type != OWTXN_POWER))
+         continue;
+
+      if (crc_start < 0)
+         crc_start = st->offset;
+
+      if (st->crc == OWTXN_CRC8)
+      {
+         if (crc8_block(0,&txn->buf[st->offset],st->len) != 0)
+            st->status = OWTXN_CRC_ERROR;
+      }
+      else if (st->crc == OWTXN_CRC16)
+      {
+         if (crc16_block(0,&txn->buf[crc_start],
+                         st->offset + st->len - crc_start) != 0xB001)
+            st->status = OWTXN_CRC_ERROR;
+         crc_start = st->offset + st->len;
+      }
+
+      if (st->status != OWTXN_OK)
+      {
+         OWERROR(OWERROR_CRC_FAILED);
+         rt = FALSE;
+      }
+   }
+
+   return rt;
+}
+
+//--------------------------------------------------------------------------
+// Add a step with room for 'len' bytes.
+//
+// 'txn'       - transaction to add to
+// 'type'      - OWTXN_xxx step type
+// 'len'       - number of bytes of the step
+//
+// Returns:  step number, -1 if the transaction is full
+//
+static int AddStep(OWTxn *txn, uchar type, int len)
+{
+   OWTxnStep *st;
+
+   if ((txn->nsteps >= OWTXN_MAX_STEPS) || (len < 0) ||
+       ((txn->len + len) > OWTXN_MAX_BYTES))
+   {
+      txn->overflow = TRUE;
+      OWERROR(OWERROR_BLOCK_TOO_BIG);
+      return -1;
+   }
+
+   st = &txn->step[txn->nsteps];
+   st->type = type;
+   st->crc = OWTXN_CRC_NONE;
+   st->rom = FALSE;
+   st->status = OWTXN_NOT_RUN;
+   st->offset = (short)txn->len;
+   st->len = (short)len;
+   st->ms = 0;
+
+   txn->len += len;
+   return txn->nsteps++;
+}
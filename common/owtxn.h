@@ -0,0 +1,104 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  owtxn.h - Transaction builder.  A caller appends the steps of a
+//            device access (reset, ROM function, command bytes, read
+//            slots, power delivery and delays) to an OWTxn and the link
+//            runs them with as few exchanges with the adapter as it can,
+//            one for each run of steps between delays on the DS2480B.
+//
+//  Version: 3.00
+//
+
+#ifndef OWTXN_H
+#define OWTXN_H
+
+#include "ownet.h"
+
+// limits of one transaction
+#define OWTXN_MAX_BYTES        192
+#define OWTXN_MAX_STEPS        32
+
+// step types
+#define OWTXN_RESET            0     // reset and presence detect
+#define OWTXN_BYTES            1     // write (and read back) bytes
+#define OWTXN_POWER            2     // write one byte then strong pull-up
+#define OWTXN_DELAY            3     // wait, the strong pull-up stays on
+
+// check done on a read slice after the transaction runs
+#define OWTXN_CRC_NONE         0
+#define OWTXN_CRC8             1     // CRC8 over the slice
+#define OWTXN_CRC16            2     // CRC16 from the command bytes
+
+// step status after the transaction runs
+#define OWTXN_OK               0
+#define OWTXN_NOT_RUN          1
+#define OWTXN_NO_PRESENCE      2
+#define OWTXN_CRC_ERROR        3
+#define OWTXN_LINK_ERROR       4
+
+// one step of a transaction
+typedef struct
+{
+   uchar  type;              // OWTXN_RESET, _BYTES, _POWER or _DELAY
+   uchar  crc;               // OWTXN_CRC_xxx check of an OWTXN_BYTES slice
+   uchar  rom;               // TRUE if the bytes are a ROM function
+   uchar  status;            // OWTXN_OK or OWTXN_xxx error
+   short  offset;            // position of the bytes in 'buf'
+   short  len;               // number of bytes
+   int    ms;                // OWTXN_DELAY time
+} OWTxnStep;
+
+// a transaction, the bytes of every step are kept in 'buf' and are
+// replaced with what was read from the 1-Wire Net when it runs
+typedef struct
+{
+   uchar     buf[OWTXN_MAX_BYTES];
+   int       len;
+   OWTxnStep step[OWTXN_MAX_STEPS];
+   int       nsteps;
+   SMALLINT  overflow;       // TRUE if a step did not fit
+} OWTxn;
+
+// functions defined in owtxn.c
+void     owTxnInit(OWTxn *txn);
+int      owTxnReset(OWTxn *txn);
+int      owTxnMatchROM(OWTxn *txn, uchar *SNum);
+int      owTxnSkipROM(OWTxn *txn);
+int      owTxnResumeROM(OWTxn *txn);
+int      owTxnWrite(OWTxn *txn, uchar *data, int len);
+int      owTxnRead(OWTxn *txn, int len, SMALLINT crc_type);
+int      owTxnPower(OWTxn *txn, SMALLINT sendbyte);
+int      owTxnDelay(OWTxn *txn, int ms);
+uchar   *owTxnData(OWTxn *txn, int slice, int *len);
+SMALLINT owTxnStatus(OWTxn *txn, int slice);
+SMALLINT owTxnVerify(OWTxn *txn);
+
+// functions defined in the link transport file (owtrnu.c, owtran.c, ...)
+SMALLINT owTxnExecute(int portnum, OWTxn *txn);
+int      owTxnPipeline(int portnum, OWTxn **txns, int num);
+
+#endif
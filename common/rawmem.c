@@ -25,7 +25,12 @@
 //--------------------------------------------------------------------------
 //
 //  read_write.c - Reads and writes to memory locations of different buttons.
-//  version 1.00
+//  version 1.01
+//
+//  History: 1.00 -> 1.01  The bank functions are found from a table per
+//                         kind of memory bank instead of a switch in each
+//                         call.  Added owOpenBank.
+//                         Added owReadPages.
 //
 
 // Include Files
@@ -46,6 +51,85 @@
 #include "mbee.h"
 #include "pw77.h"
 
+// local functions
+static const OWBankOps *FindBankOps(SMALLINT bank, uchar *SNum);
+static SMALLINT readScratch77(SMALLINT bank, int portnum, uchar *SNum, 
+                              int str_add, SMALLINT rd_cont, uchar *buff, 
+                              int len);
+static SMALLINT writeScratch77(SMALLINT bank, int portnum, uchar *SNum, 
+                               int str_add, uchar *buff, int len);
+
+// EE Memory Bank
+static const OWBankOps EEOps = 
+{
+   readEE, writeEE, readPageEE, readPageExtraEE, readPageExtraCRCEE,
+   readPageCRCEE, readPagePacketEE, readPagePacketExtraEE, writePagePacketEE
+};
+
+// AppReg Memory Bank
+static const OWBankOps AppRegOps = 
+{
+   readAppReg, writeAppReg, readPageAppReg, readPageExtraAppReg, 
+   readPageExtraCRCAppReg, readPageCRCAppReg, readPagePacketAppReg, 
+   readPagePacketExtraAppReg, writePagePacketAppReg
+};
+
+// NV Memory Bank
+static const OWBankOps NVOps = 
+{
+   readNV, writeNV, readPageNV, readPageExtraNV, readPageExtraCRCNV,
+   readPageCRCNV, readPagePacketNV, readPagePacketExtraNV, writePagePacketNV
+};
+
+// NVCRC Memory Bank, reads pages with the device CRC
+static const OWBankOps NVCRCOps = 
+{
+   readNV, writeNV, readPageNVCRC, readPageExtraNVCRC, readPageExtraCRCNVCRC,
+   readPageCRCNVCRC, readPagePacketNV, readPagePacketExtraNVCRC, 
+   writePagePacketNV
+};
+
+// Scratch Memory Bank
+static const OWBankOps ScratchOps = 
+{
+   readScratch, writeScratch, readPageScratch, readPageExtraScratch, 
+   readPageExtraCRCScratch, readPageCRCScratch, readPagePacketScratch, 
+   readPagePacketExtraScratch, writePagePacketScratch
+};
+
+// SHAEE Memory Bank
+static const OWBankOps SHAEEOps = 
+{
+   readSHAEE, writeSHAEE, readPageSHAEE, readPageExtraSHAEE, 
+   readPageExtraCRCSHAEE, readPageCRCSHAEE, readPagePacketSHAEE, 
+   readPagePacketExtraSHAEE, writePagePacketSHAEE
+};
+
+// EPROM Memory Bank
+static const OWBankOps EPROMOps = 
+{
+   readEPROM, writeEPROM, readPageEPROM, readPageExtraEPROM, 
+   readPageExtraCRCEPROM, readPageCRCEPROM, readPagePacketEPROM, 
+   readPagePacketExtraEPROM, writePagePacketEPROM
+};
+
+// EE77 Memory Bank
+static const OWBankOps EE77Ops = 
+{
+   readEEPsw77, writeEE77, readPageEE77, readPageExtraEE77, 
+   readPageExtraCRCEE77, readPageCRCEE77, readPagePacketEE77, 
+   readPagePacketExtraEE77, writePagePacketEE77
+};
+
+// Scratch Ex77 Memory Bank
+static const OWBankOps Scratch77Ops = 
+{
+   readScratch77, writeScratch77, readPageScratchEx77, 
+   readPageExtraScratchEx77, readPageExtraCRCScratchEx77, 
+   readPageCRCScratchEx77, readPagePacketScratchEx77, 
+   readPagePacketExtraScratchEx77, writePagePacketScratchEx77
+};
+
 /**
  * Reads memory in this bank with no CRC checking (device or
  * data). The resulting data from this API may or may not be what is on
@@ -81,71 +165,13 @@
 SMALLINT owRead(SMALLINT bank, int portnum, uchar *SNum, int str_add,
                 SMALLINT rd_cont, uchar *buff, int len)
 {
-   SMALLINT ret = 0;
-   uchar extra[5];
-
-   switch(SNum[0] & 0x7F)
-   {
-      case 0x14:  //EE Memory Bank and AppReg Memory Bank
-         if(bank > 0)
-            ret = readEE(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         else if(bank == 0)
-            ret = readAppReg(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         break;
-
-      case 0x04: case 0x06: case 0x08: case 0x0A:
-      case 0x0C: case 0x23: //NV Memory Bank and Scratch Memory Bank
-         if(bank > 0)
-            ret = readNV(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         else if(bank == 0)
-            ret = readScratch(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         break;
-
-      case (0x18):  //NV Memory Bank and Scratch SHA Memory Bank
-         if(bank > 0)
-            ret = readNV(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         else if(bank == 0)
-            ret = readScratch(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         break;
-
-      case 0x1A: case 0x1D:  //NVCRC Memory Bank and Scratch Ex Memory Bank
-         if(bank > 0)
-            ret = readNV(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         else if(bank == 0)
-            ret = readScratch(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         break;
-
-      case 0x21:  //NVCRC Memory Bank and Scratch CRC Memory Bank
-         if(bank > 0)
-            ret = readNV(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         else if(bank == 0)
-            ret = readScratch(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         break;
-
-      case 0x33: case 0xB3:  //SHAEE Memory Bank
-         ret = readSHAEE(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         break;
-
-      case 0x09: case 0x0B: case 0x0F: case 0x12: case 0x13:  //EPROM Memory Bank
-         ret = readEPROM(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         break;
-
-      case 0x37: case 0x77:
-         if(bank > 0)
-         {
-            ret = readEEPsw77(bank,portnum,SNum,str_add,rd_cont,buff,len);
-         }
-         else if(bank == 0)
-         {
-            ret = readScratchPadCRC77(portnum,SNum,buff,len,&extra[0]);
-         }
-         break;
+   const OWBankOps *ops;
 
-      default:
-         break;
-   }
+   ops = FindBankOps(bank,SNum);
+   if(ops == NULL)
+      return FALSE;
 
-   return ret;
+   return ops->read(bank,portnum,SNum,str_add,rd_cont,buff,len);
 }
 
 /**
@@ -172,71 +198,13 @@ SMALLINT owRead(SMALLINT bank, int portnum, uchar *SNum, int str_add,
 SMALLINT owWrite(SMALLINT bank, int portnum, uchar *SNum, int str_add,
                  uchar *buff, int len)
 {
-   SMALLINT ret = 0;
-
-   switch(SNum[0] & 0x7F)
-   {
-      case 0x14:  //EE Memory Bank and AppReg Memory Bank
-         if(bank > 0)
-            ret = writeEE(bank,portnum,SNum,str_add,buff,len);
-         else if(bank == 0)
-            ret = writeAppReg(bank,portnum,SNum,str_add,buff,len);
-         break;
-
-      case 0x04: case 0x06: case 0x08: case 0x0A:
-      case 0x0C: case 0x23:  //NV Memory Bank and Scratch Memory Bank
-         if(bank > 0)
-            ret = writeNV(bank,portnum,SNum,str_add,buff,len);
-         else if(bank == 0)
-            ret = writeScratch(bank,portnum,SNum,str_add,buff,len);
-         break;
-
-      case 0x18:  //NV Memory Bank and Scratch SHA Memory Bank
-         if(bank > 0)
-            ret = writeNV(bank,portnum,SNum,str_add,buff,len);
-         else if(bank == 0)
-            ret = writeScratch(bank,portnum,SNum,str_add,buff,len);
-         break;
-
-      case 0x1A: case 0x1D:  //NVCRC Memory Bank and Scratch Ex Memory Bank
-         if(bank > 0)
-            ret = writeNV(bank,portnum,SNum,str_add,buff,len);
-         else if(bank == 0)
-            ret = writeScratch(bank,portnum,SNum,str_add,buff,len);
-         break;
-
-      case 0x21:  //NVCRC Memory Bank and Scratch CRC Memory Bank
-         if(bank > 0)
-            ret = writeNV(bank,portnum,SNum,str_add,buff,len);
-         else if(bank == 0)
-            ret = writeScratch(bank,portnum,SNum,str_add,buff,len);
-         break;
-
-      case 0x33: case 0xB3:  //SHAEE Memory Bank
-         ret = writeSHAEE(bank,portnum,SNum,str_add,buff,len);
-         break;
-
-      case 0x09: case 0x0B: case 0x0F: case 0x12: case 0x13:  //EPROM Memory Bank
-         ret = writeEPROM(bank,portnum,SNum,str_add,buff,len);
-         break;
-
-      case 0x37: case 0x77:
-         if(bank > 0)
-         {
-            ret = writeEE77(bank,portnum,SNum,str_add,buff,len);
-         }
-         else if(bank == 0)
-         {
-            ret = writeScratchPadEx77(portnum,SNum,str_add,buff,len);
-         }
-         break;
+   const OWBankOps *ops;
 
+   ops = FindBankOps(bank,SNum);
+   if(ops == NULL)
+      return FALSE;
 
-      default:
-         break;
-   }
-
-   return ret;
+   return ops->write(bank,portnum,SNum,str_add,buff,len);
 }
 
 /**
@@ -275,72 +243,13 @@ SMALLINT owWrite(SMALLINT bank, int portnum, uchar *SNum, int str_add,
 SMALLINT owReadPage(SMALLINT bank, int portnum, uchar *SNum, int page,
                     SMALLINT rd_cont, uchar *buff)
 {
-   SMALLINT ret = 0;
-
-   switch(SNum[0] & 0x7F)
-   {
-      case 0x14:  //EE Memory Bank and AppReg Memory Bank
-         if(bank > 0)
-            ret = readPageEE(bank,portnum,SNum,page,rd_cont,buff);
-         else if(bank == 0)
-            ret = readPageAppReg(bank,portnum,SNum,page,rd_cont,buff);
-         break;
-
-      case 0x04: case 0x06: case 0x08: case 0x0A:
-      case 0x0C: case 0x23:  //NV Memory Bank and Scratch Memory Bank
-         if(bank > 0)
-            ret = readPageNV(bank,portnum,SNum,page,rd_cont,buff);
-         else if(bank == 0)
-            ret = readPageScratch(bank,portnum,SNum,page,rd_cont,buff);
-         break;
-
-      case (0x18):  //NV Memory Bank and Scratch SHA Memory Bank
-         if(bank == 3)
-            ret = readPageNV(bank,portnum,SNum,page,rd_cont,buff);
-         else if(bank > 0)
-            ret = readPageNVCRC(bank,portnum,SNum,page,rd_cont,buff);
-         else if(bank == 0)
-            ret = readPageScratch(bank,portnum,SNum,page,rd_cont,buff);
-         break;
-
-      case 0x1A: case 0x1D:  //NVCRC Memory Bank and Scratch Ex Memory Bank
-         if(bank > 0)
-            ret = readPageNVCRC(bank,portnum,SNum,page,rd_cont,buff);
-         else if(bank == 0)
-            ret = readPageScratch(bank,portnum,SNum,page,rd_cont,buff);
-         break;
-
-      case 0x21:  //NVCRC Memory Bank and Scratch CRC Memory Bank
-         if(bank > 0)
-            ret = readPageNVCRC(bank,portnum,SNum,page,rd_cont,buff);
-         else if(bank == 0)
-            ret = readPageScratch(bank,portnum,SNum,page,rd_cont,buff);
-         break;
-
-      case 0x33: case 0xB3:  //SHAEE Memory Bank
-         ret = readPageSHAEE(bank,portnum,SNum,page,rd_cont,buff);
-         break;
+   const OWBankOps *ops;
 
-      case 0x09: case 0x0B: case 0x0F: case 0x12: case 0x13:  //EPROM Memory Bank
-         ret = readPageEPROM(bank,portnum,SNum,page,rd_cont,buff);
-         break;
-
-      case 0x37: case 0x77:
-         if(bank > 0)
-         {
-            ret = readPageEE77(bank,portnum,SNum,page,rd_cont,buff);
-         }
-         else if(bank == 0)
-         {
-            ret = readPageScratchEx77(bank,portnum,SNum,page,rd_cont,buff);
-         }
-         break;
-
-      default:
-         break;
-   }
+   ops = FindBankOps(bank,SNum);
+   if(ops == NULL)
+      return FALSE;
 
-   return ret;
+   return ops->readPage(bank,portnum,SNum,page,rd_cont,buff);
 }
 
 /**
@@ -380,73 +289,13 @@ SMALLINT owReadPage(SMALLINT bank, int portnum, uchar *SNum, int page,
 SMALLINT owReadPageExtra(SMALLINT bank, int portnum, uchar *SNum, int page,
                          SMALLINT rd_cont, uchar *buff, uchar *extra)
 {
-   SMALLINT ret = 0;
-
-   switch(SNum[0] & 0x7F)
-   {
-      case 0x14:  //EE Memory Bank and AppReg Memory Bank
-         if(bank > 0)
-            ret = readPageExtraEE(bank,portnum,SNum,page,rd_cont,buff,extra);
-         else if(bank == 0)
-            ret = readPageExtraAppReg(bank,portnum,SNum,page,rd_cont,buff,extra);
-         break;
-
-      case 0x04: case 0x06: case 0x08: case 0x0A:
-      case 0x0C: case 0x23:  //NV Memory Bank and Scratch Memory Bank
-         if(bank > 0)
-            ret = readPageExtraNV(bank,portnum,SNum,page,rd_cont,buff,extra);
-         else if(bank == 0)
-            ret = readPageExtraScratch(bank,portnum,SNum,page,rd_cont,buff,extra);
-         break;
+   const OWBankOps *ops;
 
-      case (0x18):  //NV Memory Bank and Scratch SHA Memory Bank
-         if(bank == 3)
-            ret = readPageExtraNV(bank,portnum,SNum,page,rd_cont,buff,extra);
-         else if(bank > 0)
-            ret = readPageExtraNVCRC(bank,portnum,SNum,page,rd_cont,buff,extra);
-         else if(bank == 0)
-            ret = readPageExtraScratch(bank,portnum,SNum,page,rd_cont,buff,extra);
-         break;
-
-      case 0x1A: case 0x1D:  //NVCRC Memory Bank and Scratch Ex Memory Bank
-         if(bank > 0)
-            ret = readPageExtraNVCRC(bank,portnum,SNum,page,rd_cont,buff,extra);
-         else if(bank == 0)
-            ret = readPageExtraScratch(bank,portnum,SNum,page,rd_cont,buff,extra);
-         break;
-
-      case 0x21:  //NVCRC Memory Bank and Scratch CRC Memory Bank
-         if(bank > 0)
-            ret = readPageExtraNVCRC(bank,portnum,SNum,page,rd_cont,buff,extra);
-         else if(bank == 0)
-            ret = readPageExtraScratch(bank,portnum,SNum,page,rd_cont,buff,extra);
-         break;
-
-      case 0x33: case 0xB3:  //SHAEE Memory Bank
-         ret = readPageExtraSHAEE(bank,portnum,SNum,page,rd_cont,buff,extra);
-         break;
-
-      case 0x09: case 0x0B: case 0x0F: case 0x12: case 0x13:  //EPROM Memory Bank
-         ret = readPageExtraEPROM(bank,portnum,SNum,page,rd_cont,buff,extra);
-         break;
-
-      case 0x37: case 0x77:
-         if(bank > 0)
-         {
-            ret = readPageExtraEE77(bank,portnum,SNum,page,rd_cont,buff,extra);
-         }
-         else if(bank == 0)
-         {
-            ret = readPageExtraScratchEx77(bank,portnum,SNum,page,rd_cont,
-                                           buff,extra);
-         }
-         break;
+   ops = FindBankOps(bank,SNum);
+   if(ops == NULL)
+      return FALSE;
 
-      default:
-         break;
-   }
-
-   return ret;
+   return ops->readPageExtra(bank,portnum,SNum,page,rd_cont,buff,extra);
 }
 
 /**
@@ -471,72 +320,13 @@ SMALLINT owReadPageExtra(SMALLINT bank, int portnum, uchar *SNum, int page,
 SMALLINT owReadPageExtraCRC(SMALLINT bank, int portnum, uchar *SNum, int page,
                             uchar *read_buff, uchar *extra)
 {
-   SMALLINT ret = 0;
-
-   switch(SNum[0] & 0x7F)
-   {
-      case 0x14:  //EE Memory Bank and AppReg Memory Bank
-         if(bank > 0)
-            ret = readPageExtraCRCEE(bank,portnum,SNum,page,read_buff,extra);
-         else if(bank == 0)
-            ret = readPageExtraCRCAppReg(bank,portnum,SNum,page,read_buff,extra);
-         break;
-
-      case 0x04: case 0x06: case 0x08: case 0x0A:
-      case 0x0C: case 0x23:  //NV Memory Bank and Scratch Memory Bank
-         if(bank > 0)
-            ret = readPageExtraCRCNV(bank,portnum,SNum,page,read_buff,extra);
-         else if(bank == 0)
-            ret = readPageExtraCRCScratch(bank,portnum,SNum,page,read_buff,extra);
-         break;
+   const OWBankOps *ops;
 
-      case (0x18):  //NV Memory Bank and Scratch SHA Memory Bank
-         if(bank == 3)
-            ret = readPageExtraCRCNV(bank,portnum,SNum,page,read_buff,extra);
-         else if(bank > 0)
-            ret = readPageExtraCRCNVCRC(bank,portnum,SNum,page,read_buff,extra);
-         else if(bank == 0)
-            ret = readPageExtraCRCScratch(bank,portnum,SNum,page,read_buff,extra);
-         break;
+   ops = FindBankOps(bank,SNum);
+   if(ops == NULL)
+      return FALSE;
 
-      case 0x1A: case 0x1D:  //NVCRC Memory Bank and Scratch Ex Memory Bank
-         if(bank > 0)
-            ret = readPageExtraCRCNVCRC(bank,portnum,SNum,page,read_buff,extra);
-         else if(bank == 0)
-            ret = readPageExtraCRCScratch(bank,portnum,SNum,page,read_buff,extra);
-         break;
-
-      case 0x21:  //NVCRC Memory Bank and Scratch CRC Memory Bank
-         if(bank > 0)
-            ret = readPageExtraCRCNVCRC(bank,portnum,SNum,page,read_buff,extra);
-         else if(bank == 0)
-            ret = readPageExtraCRCScratch(bank,portnum,SNum,page,read_buff,extra);
-         break;
-
-      case 0x33: case 0xB3:  //SHAEE Memory Bank
-         ret = readPageExtraCRCSHAEE(bank,portnum,SNum,page,read_buff,extra);
-         break;
-
-      case 0x09: case 0x0B: case 0x0F: case 0x12: case 0x13:  //EPROM Memory Bank
-         ret = readPageExtraCRCEPROM(bank,portnum,SNum,page,read_buff,extra);
-         break;
-
-      case 0x37: case 0x77:
-         if(bank > 0)
-         {
-            ret = readPageExtraCRCEE77(bank,portnum,SNum,page,read_buff,extra);
-         }
-         else if(bank == 0)
-         {
-            ret = readPageExtraCRCScratchEx77(bank,portnum,SNum,page,read_buff,extra);
-         }
-         break;
-
-      default:
-         break;
-   }
-
-   return ret;
+   return ops->readPageExtraCRC(bank,portnum,SNum,page,read_buff,extra);
 }
 
 
@@ -560,72 +350,13 @@ SMALLINT owReadPageExtraCRC(SMALLINT bank, int portnum, uchar *SNum, int page,
  */
 SMALLINT owReadPageCRC(SMALLINT bank, int portnum, uchar *SNum, int page, uchar *buff)
 {
-   SMALLINT ret = 0;
-
-   switch(SNum[0] & 0x7F)
-   {
-      case 0x14:  //EE Memory Bank and AppReg Memory Bank
-         if(bank > 0)
-            ret = readPageCRCEE(bank,portnum,SNum,page,buff);
-         else if(bank == 0)
-            ret = readPageCRCAppReg(bank,portnum,SNum,page,buff);
-         break;
-
-      case 0x04: case 0x06: case 0x08: case 0x0A:
-      case 0x0C: case 0x23:  //NV Memory Bank and Scratch Memory Bank
-         if(bank > 0)
-            ret = readPageCRCNV(bank,portnum,SNum,page,buff);
-         else if(bank == 0)
-            ret = readPageCRCScratch(bank,portnum,SNum,page,buff);
-         break;
-
-      case (0x18):  //NV Memory Bank and Scratch SHA Memory Bank
-         if(bank == 3)
-            ret = readPageCRCNV(bank,portnum,SNum,page,buff);
-         else if(bank > 0)
-            ret = readPageCRCNVCRC(bank,portnum,SNum,page,buff);
-         else if(bank == 0)
-            ret = readPageCRCScratch(bank,portnum,SNum,page,buff);
-         break;
-
-      case 0x1A: case 0x1D:  //NVCRC Memory Bank and Scratch Ex Memory Bank
-         if(bank > 0)
-            ret = readPageCRCNVCRC(bank,portnum,SNum,page,buff);
-         else if(bank == 0)
-            ret = readPageCRCScratch(bank,portnum,SNum,page,buff);
-         break;
-
-      case 0x21:  //NVCRC Memory Bank and Scratch CRC Memory Bank
-         if(bank > 0)
-            ret = readPageCRCNVCRC(bank,portnum,SNum,page,buff);
-         else if(bank == 0)
-            ret = readPageCRCScratch(bank,portnum,SNum,page,buff);
-         break;
-
-      case 0x33: case 0xB3:  //SHAEE Memory Bank
-         ret = readPageCRCSHAEE(bank,portnum,SNum,page,buff);
-         break;
-
-      case 0x09: case 0x0B: case 0x0F: case 0x12: case 0x13:  //EPROM Memory Bank
-         ret = readPageCRCEPROM(bank,portnum,SNum,page,buff);
-         break;
+   const OWBankOps *ops;
 
-      case 0x37: case 0x77:
-         if(bank > 0)
-         {
-            ret = readPageCRCEE77(bank,portnum,SNum,page,buff);
-         }
-         else
-         {
-            ret = readPageCRCScratchEx77(bank,portnum,SNum,page,buff);
-         }
-         break;
+   ops = FindBankOps(bank,SNum);
+   if(ops == NULL)
+      return FALSE;
 
-      default:
-         break;
-   }
-
-   return ret;
+   return ops->readPageCRC(bank,portnum,SNum,page,buff);
 }
 
 /**
@@ -671,70 +402,13 @@ SMALLINT owReadPageCRC(SMALLINT bank, int portnum, uchar *SNum, int page, uchar
 SMALLINT owReadPagePacket(SMALLINT bank, int portnum, uchar *SNum, int page,
                           SMALLINT rd_cont, uchar *buff, int *len)
 {
-   SMALLINT ret = 0;
-
-   switch(SNum[0] & 0x7F)
-   {
-      case 0x14:  //EE Memory Bank and AppReg Memory Bank
-         if(bank > 0)
-            ret = readPagePacketEE(bank,portnum,SNum,page,rd_cont,buff,len);
-         else if(bank == 0)
-            ret = readPagePacketAppReg(bank,portnum,SNum,page,rd_cont,buff,len);
-         break;
-
-      case 0x04: case 0x06: case 0x08: case 0x0A:
-      case 0x0C: case 0x23:  //NV Memory Bank and Scratch Memory Bank
-         if(bank > 0)
-            ret = readPagePacketNV(bank,portnum,SNum,page,rd_cont,buff,len);
-         else if(bank == 0)
-            ret = readPagePacketScratch(bank,portnum,SNum,page,rd_cont,buff,len);
-         break;
-
-      case (0x18):  //NV Memory Bank and Scratch SHA Memory Bank
-         if(bank > 0)
-            ret = readPagePacketNV(bank,portnum,SNum,page,rd_cont,buff,len);
-         else if(bank == 0)
-            ret = readPagePacketScratch(bank,portnum,SNum,page,rd_cont,buff,len);
-         break;
-
-      case 0x1A: case 0x1D:  //NVCRC Memory Bank and Scratch Ex Memory Bank
-         if(bank > 0)
-            ret = readPagePacketNV(bank,portnum,SNum,page,rd_cont,buff,len);
-         else if(bank == 0)
-            ret = readPagePacketScratch(bank,portnum,SNum,page,rd_cont,buff,len);
-         break;
-
-      case 0x21:  //NVCRC Memory Bank and Scratch CRC Memory Bank
-         if(bank > 0)
-            ret = readPagePacketNV(bank,portnum,SNum,page,rd_cont,buff,len);
-         else if(bank == 0)
-            ret = readPagePacketScratch(bank,portnum,SNum,page,rd_cont,buff,len);
-         break;
-
-      case 0x33: case 0xB3:  //SHAEE Memory Bank
-         ret = readPagePacketSHAEE(bank,portnum,SNum,page,rd_cont,buff,len);
-         break;
+   const OWBankOps *ops;
 
-      case 0x09: case 0x0B: case 0x0F: case 0x12: case 0x13:  //EPROM Memory Bank
-         ret = readPagePacketEPROM(bank,portnum,SNum,page,rd_cont,buff,len);
-         break;
-
-      case 0x37: case 0x77:
-         if(bank > 0)
-         {
-            ret = readPagePacketEE77(bank,portnum,SNum,page,rd_cont,buff,len);
-         }
-         else if(bank == 0)
-         {
-            ret = readPagePacketScratchEx77(bank,portnum,SNum,page,rd_cont,buff,len);
-         }
-         break;
-
-      default:
-         break;
-   }
+   ops = FindBankOps(bank,SNum);
+   if(ops == NULL)
+      return FALSE;
 
-   return ret;
+   return ops->readPagePacket(bank,portnum,SNum,page,rd_cont,buff,len);
 }
 
 /**
@@ -768,73 +442,13 @@ SMALLINT owReadPagePacket(SMALLINT bank, int portnum, uchar *SNum, int page,
 SMALLINT owReadPagePacketExtra(SMALLINT bank, int portnum, uchar *SNum, int page,
                                SMALLINT rd_cont, uchar *buff, int *len, uchar *extra)
 {
-   SMALLINT ret = 0;
-
-   switch(SNum[0] & 0x7F)
-   {
-      case 0x14:  //EE Memory Bank and AppReg Memory Bank
-         if(bank > 0)
-            ret = readPagePacketExtraEE(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         else if(bank == 0)
-            ret = readPagePacketExtraAppReg(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         break;
-
-      case 0x04: case 0x06: case 0x08: case 0x0A:
-      case 0x0C: case 0x23:  //NV Memory Bank and Scratch Memory Bank
-         if(bank > 0)
-            ret = readPagePacketExtraNV(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         else if(bank == 0)
-            ret = readPagePacketExtraScratch(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         break;
-
-      case (0x18):  //NV Memory Bank and Scratch SHA Memory Bank
-         if(bank == 3)
-            ret = readPagePacketExtraNV(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         else if(bank > 0)
-            ret = readPagePacketExtraNVCRC(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         else if(bank == 0)
-            ret = readPagePacketExtraScratch(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         break;
-
-      case 0x1A: case 0x1D:  //NVCRC Memory Bank and Scratch Ex Memory Bank
-         if(bank > 0)
-            ret = readPagePacketExtraNVCRC(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         else if(bank == 0)
-            ret = readPagePacketExtraScratch(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         break;
-
-      case 0x21:  //NVCRC Memory Bank and Scratch CRC Memory Bank
-         if(bank > 0)
-            ret = readPagePacketExtraNVCRC(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         else if(bank == 0)
-            ret = readPagePacketExtraScratch(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         break;
-
-      case 0x33: case 0xB3:  //SHAEE Memory Bank
-         ret = readPagePacketExtraSHAEE(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         break;
-
-      case 0x09: case 0x0B: case 0x0F: case 0x12: case 0x13:  //EPROM Memory Bank
-         ret = readPagePacketExtraEPROM(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         break;
-
-      case 0x37: case 0x77:
-         if(bank > 0)
-         {
-            ret = readPagePacketExtraEE77(bank,portnum,SNum,page,rd_cont,buff,len,extra);
-         }
-         else if(bank == 0)
-         {
-            ret = readPagePacketExtraScratchEx77(bank,portnum,SNum,page,rd_cont,
-                                                          buff,len,extra);
-         }
-         break;
+   const OWBankOps *ops;
 
-      default:
-         break;
-   }
+   ops = FindBankOps(bank,SNum);
+   if(ops == NULL)
+      return FALSE;
 
-   return ret;
+   return ops->readPagePacketExtra(bank,portnum,SNum,page,rd_cont,buff,len,extra);
 }
 
 /**
@@ -856,70 +470,188 @@ SMALLINT owReadPagePacketExtra(SMALLINT bank, int portnum, uchar *SNum, int page
 SMALLINT owWritePagePacket(SMALLINT bank, int portnum, uchar *SNum, int page,
                            uchar *buff, int len)
 {
-   SMALLINT ret = 0;
+   const OWBankOps *ops;
 
+   ops = FindBankOps(bank,SNum);
+   if(ops == NULL)
+      return FALSE;
+
+   return ops->writePagePacket(bank,portnum,SNum,page,buff,len);
+}
+
+/**
+ * Reads a run of pages in this memory bank.  NV memory is read with
+ * one Read Memory command for the whole run and NVCRC memory with one
+ * Read Page with CRC command, verifying the CRC of every page.  Other
+ * memory banks are read a page at a time, with the page CRC checked on
+ * banks that have one.
+ *
+ * bank       to tell what memory bank of the ibutton to use.
+ * portnum    the port number of the port being used for the
+ *            1-Wire Network.
+ * SNum       the serial number for the part that the operation is
+ *            to be done on.
+ * page       first page number to read
+ * num_pages  number of pages to read
+ * buff       location for num_pages * owGetPageLength bytes of data
+ *
+ * @return 'true' if the read was complete
+ */
+SMALLINT owReadPages(SMALLINT bank, int portnum, uchar *SNum, int page,
+                     int num_pages, uchar *buff)
+{
+   const OWBankOps *ops;
+   int i,page_len;
+   SMALLINT crc,result;
+
+   ops = FindBankOps(bank,SNum);
+   if(ops == NULL)
+      return FALSE;
+
+   page_len = owGetPageLength(bank,SNum);
+
+   if(ops == &NVOps)
+      return readNV(bank,portnum,SNum,page * page_len,FALSE,buff,
+                    num_pages * page_len);
+
+   if(ops == &NVCRCOps)
+      return readPagesCRCNVCRC(bank,portnum,SNum,page,num_pages,buff);
+
+   crc = owHasPageAutoCRC(bank,SNum);
+   for(i=0;i<num_pages;i++)
+   {
+      if(crc)
+         result = ops->readPageCRC(bank,portnum,SNum,page + i,&buff[i * page_len]);
+      else
+         result = ops->readPage(bank,portnum,SNum,page + i,FALSE,&buff[i * page_len]);
+
+      if(!result)
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+/**
+ * Resolves a memory bank of a device once so a program working through
+ * many pages can call the bank functions in hbank->ops and use the
+ * geometry in hbank without the family lookup on every call.
+ *
+ * bank       to tell what memory bank of the ibutton to use.
+ * SNum       the serial number for the part that the operation is
+ *            to be done on.
+ * hbank      the resolved bank is returned here
+ *
+ * @return 'true' if the device has the memory bank
+ */
+SMALLINT owOpenBank(SMALLINT bank, uchar *SNum, OWBank *hbank)
+{
+   int i;
+
+   hbank->ops = FindBankOps(bank,SNum);
+   if(hbank->ops == NULL)
+      return FALSE;
+
+   hbank->bank = bank;
+   for(i=0;i<8;i++)
+      hbank->SNum[i] = SNum[i];
+
+   hbank->size       = owGetSize(bank,SNum);
+   hbank->start      = owGetStartingAddress(bank,SNum);
+   hbank->pages      = owGetNumberPages(bank,SNum);
+   hbank->page_len   = owGetPageLength(bank,SNum);
+   hbank->max_packet = owGetMaxPacketDataLength(bank,SNum);
+   hbank->extra_len  = owHasExtraInfo(bank,SNum) ? 
+                       owGetExtraInfoLength(bank,SNum) : 0;
+   hbank->auto_crc   = owHasPageAutoCRC(bank,SNum);
+
+   return TRUE;
+}
+
+/**
+ * Finds the functions for a memory bank of a device.
+ *
+ * bank       to tell what memory bank of the ibutton to use.
+ * SNum       the serial number for the part
+ *
+ * @return the bank functions or NULL if the device does not have the bank
+ */
+static const OWBankOps *FindBankOps(SMALLINT bank, uchar *SNum)
+{
    switch(SNum[0] & 0x7F)
    {
       case 0x14:  //EE Memory Bank and AppReg Memory Bank
          if(bank > 0)
-            ret = writePagePacketEE(bank,portnum,SNum,page,buff,len);
+            return &EEOps;
          else if(bank == 0)
-            ret = writePagePacketAppReg(bank,portnum,SNum,page,buff,len);
+            return &AppRegOps;
          break;
 
       case 0x04: case 0x06: case 0x08: case 0x0A:
       case 0x0C: case 0x23:  //NV Memory Bank and Scratch Memory Bank
          if(bank > 0)
-            ret = writePagePacketNV(bank,portnum,SNum,page,buff,len);
+            return &NVOps;
          else if(bank == 0)
-            ret = writePagePacketScratch(bank,portnum,SNum,page,buff,len);
+            return &ScratchOps;
          break;
 
       case (0x18):  //NV Memory Bank and Scratch SHA Memory Bank
-         if(bank > 0)
-            ret = writePagePacketNV(bank,portnum,SNum,page,buff,len);
+         if(bank == 3)
+            return &NVOps;
+         else if(bank > 0)
+            return &NVCRCOps;
          else if(bank == 0)
-            ret = writePagePacketScratch(bank,portnum,SNum,page,buff,len);
+            return &ScratchOps;
          break;
 
       case 0x1A: case 0x1D:  //NVCRC Memory Bank and Scratch Ex Memory Bank
-         if(bank > 0)
-            ret = writePagePacketNV(bank,portnum,SNum,page,buff,len);
-         else if(bank == 0)
-            ret = writePagePacketScratch(bank,portnum,SNum,page,buff,len);
-         break;
-
       case 0x21:  //NVCRC Memory Bank and Scratch CRC Memory Bank
          if(bank > 0)
-            ret = writePagePacketNV(bank,portnum,SNum,page,buff,len);
+            return &NVCRCOps;
          else if(bank == 0)
-            ret = writePagePacketScratch(bank,portnum,SNum,page,buff,len);
+            return &ScratchOps;
          break;
 
       case 0x33: case 0xB3:  //SHAEE Memory Bank
-         ret = writePagePacketSHAEE(bank,portnum,SNum,page,buff,len);
-         break;
+         return &SHAEEOps;
 
       case 0x09: case 0x0B: case 0x0F: case 0x12: case 0x13:  //EPROM Memory Bank
-         ret = writePagePacketEPROM(bank,portnum,SNum,page,buff,len);
-         break;
+         return &EPROMOps;
 
       case 0x37: case 0x77:
          if(bank > 0)
-         {
-            ret = writePagePacketEE77(bank,portnum,SNum,page,buff,len);
-         }
+            return &EE77Ops;
          else if(bank == 0)
-         {
-            ret = writePagePacketScratchEx77(bank,portnum,SNum,page,buff,len);
-         }
+            return &Scratch77Ops;
          break;
 
       default:
          break;
    }
 
-   return ret;
+   return NULL;
+}
+
+/**
+ * owRead for the Scratch Ex77 Memory Bank, always reads the scratchpad
+ * from the start.
+ */
+static SMALLINT readScratch77(SMALLINT bank, int portnum, uchar *SNum, 
+                              int str_add, SMALLINT rd_cont, uchar *buff, 
+                              int len)
+{
+   uchar extra[5];
+
+   return readScratchPadCRC77(portnum,SNum,buff,len,&extra[0]);
+}
+
+/**
+ * owWrite for the Scratch Ex77 Memory Bank.
+ */
+static SMALLINT writeScratch77(SMALLINT bank, int portnum, uchar *SNum, 
+                               int str_add, uchar *buff, int len)
+{
+   return writeScratchPadEx77(portnum,SNum,str_add,buff,len);
 }
 
 /**
@@ -31,6 +31,51 @@
 
 #include "owfile.h"
 
+#ifndef RAWMEM_H
+#define RAWMEM_H
+
+// memory bank functions, one table for each kind of memory bank
+typedef struct
+{
+   SMALLINT (*read)(SMALLINT bank, int portnum, uchar *SNum, int str_add,
+                    SMALLINT rd_cont, uchar *buff, int len);
+   SMALLINT (*write)(SMALLINT bank, int portnum, uchar *SNum, int str_add,
+                     uchar *buff, int len);
+   SMALLINT (*readPage)(SMALLINT bank, int portnum, uchar *SNum, int page,
+                        SMALLINT rd_cont, uchar *buff);
+   SMALLINT (*readPageExtra)(SMALLINT bank, int portnum, uchar *SNum, int page,
+                             SMALLINT rd_cont, uchar *buff, uchar *extra);
+   SMALLINT (*readPageExtraCRC)(SMALLINT bank, int portnum, uchar *SNum, int page,
+                                uchar *read_buff, uchar *extra);
+   SMALLINT (*readPageCRC)(SMALLINT bank, int portnum, uchar *SNum, int page,
+                           uchar *buff);
+   SMALLINT (*readPagePacket)(SMALLINT bank, int portnum, uchar *SNum, int page,
+                              SMALLINT rd_cont, uchar *buff, int *len);
+   SMALLINT (*readPagePacketExtra)(SMALLINT bank, int portnum, uchar *SNum, 
+                                   int page, SMALLINT rd_cont, uchar *buff, 
+                                   int *len, uchar *extra);
+   SMALLINT (*writePagePacket)(SMALLINT bank, int portnum, uchar *SNum, int page,
+                               uchar *buff, int len);
+} OWBankOps;
+
+// a memory bank of one device resolved by owOpenBank
+typedef struct
+{
+   SMALLINT         bank;           // memory bank number
+   uchar            SNum[8];        // serial number of the device
+   const OWBankOps *ops;            // functions for the bank
+   int              size;           // size of the bank in bytes
+   int              start;          // starting physical address
+   SMALLINT         pages;          // number of pages
+   SMALLINT         page_len;       // raw page length
+   SMALLINT         max_packet;     // max packet data length
+   SMALLINT         extra_len;      // extra info length, 0 if none
+   SMALLINT         auto_crc;       // TRUE if the device sends a page CRC
+} OWBank;
+
+#endif
+
+SMALLINT owOpenBank(SMALLINT bank, uchar *SNum, OWBank *hbank);
 
 SMALLINT owRead(SMALLINT bank, int portnum, uchar *SNum, int str_add,
                 SMALLINT rd_cont, uchar *buff, int len);
@@ -49,6 +94,8 @@ SMALLINT owReadPagePacketExtra(SMALLINT bank, int portnum, uchar *SNum, int page
                                SMALLINT rd_cont, uchar *buff, int *len, uchar *extra);
 SMALLINT owWritePagePacket(SMALLINT bank, int portnum, uchar *SNum, int page,
                            uchar *buff, int len);
+SMALLINT owReadPages(SMALLINT bank, int portnum, uchar *SNum, int page,
+                     int num_pages, uchar *buff);
 SMALLINT owGetNumberBanks(uchar family);
 SMALLINT owGetNumberPages(SMALLINT bank, uchar *SNum);
 int owGetSize(SMALLINT bank, uchar *SNum);
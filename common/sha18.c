@@ -26,10 +26,13 @@
 //
 // sha18.c - Low-level memory and SHA functions for the DS1963S.
 //
-// Version: 2.10
+// Version: 2.11
+//
+// History: 2.10 -> 2.11  Overdrive state is kept in the OWPort state
 //
 
 #include "ownet.h"
+#include "owport.h"
 #include "shaib.h"
 
 //--------------------------------------------------------------------------
@@ -64,7 +67,7 @@ SMALLINT EraseScratchpadSHA18(int portnum, int address, SMALLINT resume)
    }
 
    // change number of verification bytes if in overdrive
-   num_verf = (in_overdrive[portnum&0x0FF]) ? 6 : 2;
+   num_verf = (owGetPort(portnum)->InOverdrive) ? 6 : 2;
 
    // erase scratchpad command
    send_block[send_cnt++] = CMD_ERASE_SCRATCHPAD;
@@ -292,7 +295,7 @@ SMALLINT CopyScratchpadSHA18(int portnum, int address,
    }
 
    // change number of verification bytes if in overdrive
-   num_verf = (in_overdrive[portnum&0x0FF]) ? 4 : 2;
+   num_verf = (owGetPort(portnum)->InOverdrive) ? 4 : 2;
 
    // copy scratchpad command
    send_block[send_cnt++] = CMD_COPY_SCRATCHPAD;
@@ -494,7 +497,7 @@ int ReadAuthPageSHA18(int portnum, SMALLINT pagenum, uchar* data,
    setcrc16(portnum,0);
 
    // change number of verification bytes if in overdrive
-   num_verf = (in_overdrive[portnum&0x0FF]) ? 10 : 2;
+   num_verf = (owGetPort(portnum)->InOverdrive) ? 10 : 2;
 
    // create the send block
    // Read Authenticated Page command
@@ -635,7 +638,7 @@ SMALLINT SHAFunction18(int portnum, uchar control_byte,
 
    setcrc16(portnum,0);
    // change number of verification bytes if in overdrive
-   num_verf = (in_overdrive[portnum&0x0FF]) ? 10 : 2;
+   num_verf = (owGetPort(portnum)->InOverdrive) ? 10 : 2;
 
    // Compute SHA Command
    send_block[send_cnt] = CMD_COMPUTE_SHA;
@@ -695,7 +698,7 @@ SMALLINT SHAFunction18(int portnum, uchar control_byte,
 SMALLINT CopySecretSHA18(int portnum, SMALLINT secretnum)
 {
    // change number of verification bytes if in overdrive
-   SMALLINT num_verf = (in_overdrive[portnum&0x0FF]) ? 10 : 2;
+   SMALLINT num_verf = (owGetPort(portnum)->InOverdrive) ? 10 : 2;
 
    // each page has 4 secrets, so look at 2 LS bits to
    // determine offset in the page.
@@ -26,10 +26,13 @@
 //
 // sha33.c - Low-level memory and SHA functions for the DS1961S.
 //
-// Version: 2.10
+// Version: 2.11
+//
+// History: 2.10 -> 2.11  ComputeSHAVM uses the MAC engine in shamac.c
 //
 
 #include "shaib.h"
+#include "shamac.h"
 
 //this global is in mbshaee.c - necessary for writing to the part
 //using the file I/O utilities - yecch...
@@ -796,22 +799,6 @@ SMALLINT BindSecretToiButton33(int portnum, SMALLINT pagenum,
    return TRUE;
 }
 
-//constants used in SHA computation
-static const long KTN[4] = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
-
-// calculation used for the SHA MAC
-static long NLF (long B, long C, long D, int n)
-{
-   if(n<20)
-      return ((B&C)|((~B)&D));
-   else if(n<40)
-      return (B^C^D);
-   else if(n<60)
-      return ((B&C)|(B&D)|(C&D));
-   else
-      return (B^C^D);
-}
-
 //----------------------------------------------------------------------
 // computes a SHA given the 64 byte MT digest buffer.  The resulting 5
 // long values are stored in the given long array, hash.
@@ -819,48 +806,19 @@ static long NLF (long B, long C, long D, int n)
 // Note: This algorithm is the SHA-1 algorithm as specified in the
 // datasheet for the DS1961S, where the last step of the official
 // FIPS-180 SHA routine is omitted (which only involves the addition of
-// constant values).
+// constant values).  It is done by ComputeSHAMAC (shamac.c).
 //
 // 'MT'        - buffer containing the message digest
 // 'hash'      - result buffer
 //
 void ComputeSHAVM(uchar* MT, long* hash)
 {
-   unsigned long MTword[80];
+   uint32_t result[5];
    int i;
-   long ShftTmp;
-   long Temp;
 
-   for(i=0;i<16;i++)
-   {
-      MTword[i] = ((MT[i*4]&0x00FF) << 24) | ((MT[i*4+1]&0x00FF) << 16) |
-                  ((MT[i*4+2]&0x00FF) << 8) | (MT[i*4+3]&0x00FF);
-   }
-
-   for(;i<80;i++)
-   {
-      ShftTmp = MTword[i-3] ^ MTword[i-8] ^ MTword[i-14] ^ MTword[i-16];
-      MTword[i] = ((ShftTmp << 1) & 0xFFFFFFFE) |
-                  ((ShftTmp >> 31) & 0x00000001);
-   }
-
-   hash[0] = 0x67452301;
-   hash[1] = 0xEFCDAB89;
-   hash[2] = 0x98BADCFE;
-   hash[3] = 0x10325476;
-   hash[4] = 0xC3D2E1F0;
-
-   for(i=0;i<80;i++)
-   {
-      ShftTmp = ((hash[0] << 5) & 0xFFFFFFE0) | ((hash[0] >> 27) & 0x0000001F);
-      Temp = NLF(hash[1],hash[2],hash[3],i) + hash[4]
-               + KTN[i/20] + MTword[i] + ShftTmp;
-      hash[4] = hash[3];
-      hash[3] = hash[2];
-      hash[2] = ((hash[1] << 30) & 0xC0000000) | ((hash[1] >> 2) & 0x3FFFFFFF);
-      hash[1] = hash[0];
-      hash[0] = Temp;
-   }
+   ComputeSHAMAC(MT, result);
+   for(i=0;i<5;i++)
+      hash[i] = (long)result[i];
 }
 
 //----------------------------------------------------------------------
@@ -29,7 +29,13 @@
 //                Protocol-level functions to replace their 'hardware-only'
 //                counterparts..
 //
-// Version: 2.10
+// Version: 2.11
+//
+// History: 2.10 -> 2.11  Split the CPU-only steps out of the service-level
+//                        functions (VerifyAuthSecretVM, VerifyDataVM,
+//                        DebitAccountVM, SignServiceDataVM and
+//                        WriteDataPageSHA33VM) so they can be run from
+//                        several threads by shapipe.c
 
 #include "ownet.h"
 #include "shaib.h"
@@ -232,7 +238,43 @@ SMALLINT InstallServiceData(SHACopr* copr, SHAUser* user,
 //
 SMALLINT UpdateServiceData(SHACopr* copr, SHAUser* user)
 {
-   ushort crc16, i;
+   if(!SignServiceDataVM(copr, user))
+      return FALSE;
+
+   // set the serial number to that of the user
+   owSerialNum(user->portnum, user->devAN, FALSE);
+
+   if(user->devAN[0]==0x18)
+   {
+      //DS1963S - not too tough
+      OWASSERT( WriteDataPageSHA18(user->portnum,
+                                 user->accountPageNumber,
+                                 user->accountFile, FALSE),
+                OWERROR_WRITE_DATA_PAGE_FAILED, FALSE );
+   }
+   else
+   {
+      OWASSERT( WriteDataPageSHA33(copr, user),
+                OWERROR_WRITE_DATA_PAGE_FAILED, FALSE );
+   }
+
+   return TRUE;
+}
+
+//-------------------------------------------------------------------------
+// Updates the account data in memory for writing and signs it if the
+// part is a DS1963S.  No 1-Wire I/O is done and the port CRC is not used
+// so this can be called from any thread.
+//
+// 'copr'      - Structure for holding coprocessor information.
+// 'user'      - Structure for holding user token information.
+//
+// Return: If TRUE, the account data is ready to be written.
+//         If FALSE, an error occurred.
+//
+SMALLINT SignServiceDataVM(SHACopr* copr, SHAUser* user)
+{
+   ushort crc16;
    uchar scratchpad[32];
 
    if(user->devAN[0] == 0x18)
@@ -285,10 +327,8 @@ SMALLINT UpdateServiceData(SHACopr* copr, SHAUser* user)
                 OWERROR_SIGN_SERVICE_DATA_FAILED, FALSE );
 
       //add the crc at the end of the data.
-      setcrc16(user->portnum, user->accountPageNumber);
-      for (i = 0; i < 30; i++)
-         crc16 = docrc16(user->portnum,user->accountFile[i]);
-      crc16 = ~crc16;
+      crc16 = ~crc16_block((ushort)user->accountPageNumber,
+                           user->accountFile, 30);
       accountFile->crc16[0] = (uchar)crc16;
       accountFile->crc16[1] = (uchar)(crc16>>8);
    }
@@ -321,10 +361,8 @@ SMALLINT UpdateServiceData(SHACopr* copr, SHAUser* user)
          memset(accountFile33->crc16_B, 0x00, 2);
 
          //add the crc at the end of the data.
-         setcrc16(user->portnum, user->accountPageNumber);
-         for (i = 0; i < RECORD_B_LENGTH+1; i++)
-            crc16 = docrc16(user->portnum,user->accountFile[i]);
-         crc16 = ~crc16;
+         crc16 = ~crc16_block((ushort)user->accountPageNumber,
+                              user->accountFile, RECORD_B_LENGTH+1);
          accountFile33->crc16_B[0] = (uchar)crc16;
          accountFile33->crc16_B[1] = (uchar)(crc16>>8);
       }
@@ -346,34 +384,18 @@ SMALLINT UpdateServiceData(SHACopr* copr, SHAUser* user)
          memset(accountFile33->crc16_A, 0x00, 2);
 
          //add the crc at the end of the data.
-         setcrc16(user->portnum, user->accountPageNumber);
-         for (i = 0; i < RECORD_A_LENGTH+1; i++)
-            crc16 = docrc16(user->portnum,user->accountFile[i]);
-         crc16 = ~crc16;
+         crc16 = ~crc16_block((ushort)user->accountPageNumber,
+                              user->accountFile, RECORD_A_LENGTH+1);
          accountFile33->crc16_A[0] = (uchar)crc16;
          accountFile33->crc16_A[1] = (uchar)(crc16>>8);
       }
 
    }
-
-   // set the serial number to that of the user
-   owSerialNum(user->portnum, user->devAN, FALSE);
-
-   if(user->devAN[0]==0x18)
-   {
-      //DS1963S - not too tough
-      OWASSERT( WriteDataPageSHA18(user->portnum,
-                                 user->accountPageNumber,
-                                 user->accountFile, FALSE),
-                OWERROR_WRITE_DATA_PAGE_FAILED, FALSE );
-   }
-   else if((user->devAN[0]&0x7F)==0x33)
-   {
-      OWASSERT( WriteDataPageSHA33(copr, user),
-                OWERROR_WRITE_DATA_PAGE_FAILED, FALSE );
-   }
    else
+   {
+      OWERROR(OWERROR_WRONG_TYPE);
       return FALSE;
+   }
 
    return TRUE;
 }
@@ -432,16 +454,49 @@ SMALLINT VerifyUser(SHACopr* copr, SHAUser* user, SMALLINT doBind)
 //         If FALSE, an error occurred or data verification failed.
 //
 SMALLINT VerifyData(SHACopr* copr, SHAUser* user)
+{
+   SMALLINT repaired = FALSE;
+
+   if(!VerifyDataVM(copr, user, &repaired))
+      return FALSE;
+
+   // a DS1961S record recovered from an aborted debit is written back
+   // before it is used
+   if(repaired)
+   {
+      OWASSERT( WriteDataPageSHA33(copr, user),
+                OWERROR_WRITE_DATA_PAGE_FAILED, FALSE );
+   }
+
+   return TRUE;
+}
+
+//-------------------------------------------------------------------------
+// Verifies the service data read into the user structure without doing
+// any 1-Wire I/O.  The port CRC is not used so this can be called from
+// any thread.  A DS1961S account left between records by an aborted
+// debit is fixed in memory and 'repaired' is set, the caller must write
+// it to the part before it is debited.
+//
+// 'copr'      - Structure for holding coprocessor information.
+// 'user'      - Structure for holding user token information.
+// 'repaired'  - set TRUE if the account data was fixed and must be
+//               written back, FALSE otherwise
+//
+// Return: If TRUE, data was verified.
+//         If FALSE, an error occurred or data verification failed.
+//
+SMALLINT VerifyDataVM(SHACopr* copr, SHAUser* user, SMALLINT* repaired)
 {
    uchar scratchpad[32];
    DebitFile acctFile;
    ushort lastcrc16;
-   uchar i;
+
+   *repaired = FALSE;
 
    // Check the CRC of the file
-   setcrc16(user->portnum, user->accountPageNumber);
-   for (i = 0; i < user->accountFile[0]+3; i++)
-      lastcrc16 = docrc16(user->portnum,user->accountFile[i]);
+   lastcrc16 = crc16_block((ushort)user->accountPageNumber,
+                           user->accountFile, user->accountFile[0]+3);
 
    if((user->devAN[0]&0x7F)==0x33)
    {
@@ -475,18 +530,14 @@ SMALLINT VerifyData(SHACopr* copr, SHAUser* user)
 
       // lets try Record A and check the crc
       user->accountFile[0] = RECORD_A_LENGTH;
-      setcrc16(user->portnum, user->accountPageNumber);
-      for (i = 0; i < user->accountFile[0]+3; i++)
-         lastcrc16 = docrc16(user->portnum,user->accountFile[i]);
-      if(lastcrc16==0xB001)
+      if(crc16_block((ushort)user->accountPageNumber,
+                     user->accountFile, RECORD_A_LENGTH+3)==0xB001)
          validA = TRUE;
 
       // lets try Record B and check the crc
       user->accountFile[0] = RECORD_B_LENGTH;
-      setcrc16(user->portnum, user->accountPageNumber);
-      for (i = 0; i < user->accountFile[0]+3; i++)
-         lastcrc16 = docrc16(user->portnum,user->accountFile[i]);
-      if(lastcrc16==0xB001)
+      if(crc16_block((ushort)user->accountPageNumber,
+                     user->accountFile, RECORD_B_LENGTH+3)==0xB001)
          validB = TRUE;
 
       if(validA && validB)
@@ -497,8 +548,7 @@ SMALLINT VerifyData(SHACopr* copr, SHAUser* user)
          // header got hosed and the debit was not finished...
          // which means A is the last known good value, let's go with A.
          user->accountFile[0] = RECORD_A_LENGTH;
-         OWASSERT( WriteDataPageSHA33(copr, user),
-                   OWERROR_WRITE_DATA_PAGE_FAILED, FALSE );
+         *repaired = TRUE;
          return TRUE;
       }
       else if(validA)
@@ -508,14 +558,11 @@ SMALLINT VerifyData(SHACopr* copr, SHAUser* user)
          // to point to A before debit was aborted.  Let's go with B
          user->accountFile[0] = RECORD_B_LENGTH;
          // must fix B's CRC
-         setcrc16(user->portnum, user->accountPageNumber);
-         for (i = 0; i < RECORD_B_LENGTH+1; i++)
-            lastcrc16 = docrc16(user->portnum,user->accountFile[i]);
-         lastcrc16 = ~lastcrc16;
+         lastcrc16 = ~crc16_block((ushort)user->accountPageNumber,
+                                  user->accountFile, RECORD_B_LENGTH+1);
          ((DebitFile33*)user->accountFile)->crc16_B[0] = (uchar)lastcrc16;
          ((DebitFile33*)user->accountFile)->crc16_B[1] = (uchar)(lastcrc16>>8);
-         OWASSERT( WriteDataPageSHA33(copr, user),
-                   OWERROR_WRITE_DATA_PAGE_FAILED, FALSE );
+         *repaired = TRUE;
          return TRUE;
       }
       else if(validB)
@@ -587,55 +634,11 @@ SMALLINT ExecuteTransaction(SHACopr* copr, SHAUser* user,
    SMALLINT success, dataOK = TRUE;
    uchar oldAcctData[32], newAcctData[32];
    int cnt = MAX_RETRY_CNT;
-   int balance, oldBalance ;
 
    memcpy(oldAcctData, user->accountFile, 32);
 
-   if(user->devAN[0]==0x18)
-   {
-      DebitFile* accountFile = (DebitFile*)user->accountFile;
-
-      oldBalance = BytesToInt(accountFile->balanceBytes, 3);
-      if(oldBalance<=0)
-      {
-         OWERROR(OWERROR_BAD_SERVICE_DATA);
-         return FALSE;
-      }
-      balance = oldBalance - debitAmount;
-      IntToBytes(accountFile->balanceBytes, 3, balance);
-   }
-   else if((user->devAN[0]&0x7F)==0x33)
-   {
-      DebitFile33* accountFile = (DebitFile33*)user->accountFile;
-
-      if(accountFile->fileLength==RECORD_A_LENGTH)
-      {
-         oldBalance = BytesToInt(accountFile->balanceBytes_A, 3);
-         if(oldBalance<=0)
-         {
-            OWERROR(OWERROR_BAD_SERVICE_DATA);
-            return FALSE;
-         }
-         balance = oldBalance - debitAmount;
-         IntToBytes(accountFile->balanceBytes_B, 3, balance);
-      }
-      else if(accountFile->fileLength==RECORD_B_LENGTH)
-      {
-         oldBalance = BytesToInt(accountFile->balanceBytes_B, 3);
-         if(oldBalance<=0)
-         {
-            OWERROR(OWERROR_BAD_SERVICE_DATA);
-            return FALSE;
-         }
-         balance = oldBalance - debitAmount;
-         IntToBytes(accountFile->balanceBytes_A, 3, balance);
-      }
-      else
-      {
-         OWERROR(OWERROR_BAD_SERVICE_DATA);
-         return FALSE;
-      }
-   }
+   if(!DebitAccountVM(user, debitAmount))
+      return FALSE;
 
    success = UpdateServiceData(copr, user);
 
@@ -690,6 +693,75 @@ SMALLINT ExecuteTransaction(SHACopr* copr, SHAUser* user,
    return success;
 }
 
+//-------------------------------------------------------------------------
+// Debits the balance of the account data in memory.  For the DS1961S the
+// new balance goes in the record not pointed to by the file length.  No
+// 1-Wire I/O is done so this can be called from any thread.
+//
+// 'user'          - Structure for holding user token information.
+// 'debitAmount'   - the amount of money to debit from balance in cents.
+//
+// Return: If TRUE, the balance was debited.
+//         If FALSE, the account data is not valid.
+//
+SMALLINT DebitAccountVM(SHAUser* user, int debitAmount)
+{
+   int balance, oldBalance;
+
+   if(user->devAN[0]==0x18)
+   {
+      DebitFile* accountFile = (DebitFile*)user->accountFile;
+
+      oldBalance = BytesToInt(accountFile->balanceBytes, 3);
+      if(oldBalance<=0)
+      {
+         OWERROR(OWERROR_BAD_SERVICE_DATA);
+         return FALSE;
+      }
+      balance = oldBalance - debitAmount;
+      IntToBytes(accountFile->balanceBytes, 3, balance);
+   }
+   else if((user->devAN[0]&0x7F)==0x33)
+   {
+      DebitFile33* accountFile = (DebitFile33*)user->accountFile;
+
+      if(accountFile->fileLength==RECORD_A_LENGTH)
+      {
+         oldBalance = BytesToInt(accountFile->balanceBytes_A, 3);
+         if(oldBalance<=0)
+         {
+            OWERROR(OWERROR_BAD_SERVICE_DATA);
+            return FALSE;
+         }
+         balance = oldBalance - debitAmount;
+         IntToBytes(accountFile->balanceBytes_B, 3, balance);
+      }
+      else if(accountFile->fileLength==RECORD_B_LENGTH)
+      {
+         oldBalance = BytesToInt(accountFile->balanceBytes_B, 3);
+         if(oldBalance<=0)
+         {
+            OWERROR(OWERROR_BAD_SERVICE_DATA);
+            return FALSE;
+         }
+         balance = oldBalance - debitAmount;
+         IntToBytes(accountFile->balanceBytes_A, 3, balance);
+      }
+      else
+      {
+         OWERROR(OWERROR_BAD_SERVICE_DATA);
+         return FALSE;
+      }
+   }
+   else
+   {
+      OWERROR(OWERROR_WRONG_TYPE);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
 //-------------------------------------------------------------------------
 // Verifies the authentication response of a user token without a
 // hardware coprocessor.
@@ -708,6 +780,29 @@ SMALLINT ExecuteTransaction(SHACopr* copr, SHAUser* user,
 //
 SMALLINT VerifyAuthResponseVM(SHACopr* copr, SHAUser* user,
                               uchar* chlg, SMALLINT doBind)
+{
+   return VerifyAuthSecretVM(copr, user, chlg, wspc_secret, doBind);
+}
+
+//-------------------------------------------------------------------------
+// Verifies the authentication response of a user token with the user's
+// unique secret kept in the caller's buffer instead of the shared one
+// used by VerifyAuthResponseVM.  No 1-Wire I/O is done so this can be
+// called from any thread with its own 'secret'.
+//
+// 'copr'      - Structure for holding coprocessor information.
+// 'user'      - Structure for holding user token information.
+// 'chlg'      - 3-byte buffer of challenge data.
+// 'secret'    - 8-byte buffer for the user's unique secret
+// 'doBind'    - if true, the user's unique secret is recreated in
+//               'secret', otherwise 'secret' already holds it.
+//
+// Return: If TRUE, the user's authentication response matched exactly the
+//            signature generated by the coprocessor.
+//         If FALSE, an error occurred or the signature did not match.
+//
+SMALLINT VerifyAuthSecretVM(SHACopr* copr, SHAUser* user,
+                            uchar* chlg, uchar* secret, SMALLINT doBind)
 {
    int wcc = user->writeCycleCounter;
    uchar scratchpad[32];
@@ -758,7 +853,7 @@ SMALLINT VerifyAuthResponseVM(SHACopr* copr, SHAUser* user,
    memset(temp_buf, 0x00, 32);
    memcpy(&temp_buf[8],fullBindCode,15);
 
-   // install user's unique secret on the wspc secret
+   // install user's unique secret in the secret buffer
    // Just like BindSecretToiButton for standard coprocessor
    if(doBind)
    {
@@ -768,11 +863,11 @@ SMALLINT VerifyAuthResponseVM(SHACopr* copr, SHAUser* user,
                                       temp_buf,
                                       TRUE),
                 OWERROR_BIND_SECRET_FAILED, FALSE );
-      memcpy(wspc_secret, temp_buf, 8);
+      memcpy(secret, temp_buf, 8);
    }
 
    // recreate the signature and verify
-   OWASSERT( CreateDataSignatureVM(copr, wspc_secret,
+   OWASSERT( CreateDataSignatureVM(copr, secret,
                                    user->accountFile,
                                    scratchpad,
                                    user->responseMAC,
@@ -1110,8 +1205,26 @@ static int GetSecretVM(char* name, uchar** secret)
 //
 SMALLINT WriteDataPageSHA33(SHACopr* copr, SHAUser* user)
 {
-   //DS1961S - a bit tougher
    //assumes wspc_secret already contains device's unique secret.
+   return WriteDataPageSHA33VM(copr, user, wspc_secret);
+}
+
+//----------------------------------------------------------------------
+// Writes the contents of the user's account file to the page specified
+// by the user's account page number for DS1961 with the user's unique
+// secret from the caller's buffer.
+//
+// 'copr'       - Structure for holding coprocessor information.
+// 'user'       - Structure for holding user token information.
+// 'secret'     - 8-byte unique secret of the user, made by
+//                VerifyAuthSecretVM
+//
+// Return: TRUE - Write successfull
+//         FALSE - error occurred during write.
+//
+SMALLINT WriteDataPageSHA33VM(SHACopr* copr, SHAUser* user, uchar* secret)
+{
+   //DS1961S - a bit tougher
    uchar pageContents[32], data[32], scratchpad[32];
    uchar MAC[20];
    int addr = user->accountPageNumber << 5;
@@ -1133,7 +1246,7 @@ SMALLINT WriteDataPageSHA33(SHACopr* copr, SHAUser* user)
          memcpy(&scratchpad[13], user->devAN, 7);
          memset(&scratchpad[20], 0xFF, 3);
 
-         OWASSERT( CreateDataSignatureVM(copr, wspc_secret, data,
+         OWASSERT( CreateDataSignatureVM(copr, secret, data,
                                          scratchpad, MAC, TRUE),
                    OWERROR_SIGN_SERVICE_DATA_FAILED, FALSE);
 
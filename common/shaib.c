@@ -27,15 +27,21 @@
 // shaibutton.c - Protocol-level functions as well as useful utility
 //                functions for sha applications.
 //
-// Version: 2.10
+// Version: 2.13
+//
+// History: 2.10 -> 2.11  FindNewSHA finds new buttons with the presence
+//                        monitor instead of searching the whole bus and
+//                        comparing the CRC bytes of the ROMs
+//          2.11 -> 2.12  in_overdrive moved to the OWPort state
+//          2.12 -> 2.13  SelectSHA uses the owSessionSelect session
 //
 
 #include "ownet.h"
+#include "owport.h"
+#include "owmon.h"
+#include "owsess.h"
 #include "shaib.h"
 
-//Global
-SMALLINT in_overdrive[MAX_PORTNUM];
-
 //---------------------------------------------------------------------
 // Uses File I/O API to find the coprocessor with a specific
 // coprocessor file name.  Usually 'COPR.0'.
@@ -186,35 +192,24 @@ SMALLINT FindUserSHA(SHAUser* user, FileEntry* fe,
    }
 }
 
-//final buffer for tracking list of known SHA parts
-//only holds the CRC for each part
-static uchar ListOfKnownSHA[MAX_PORTNUM][MAX_SHA_IBUTTONS];
-static int listIndex = 0;
-//intermediate buffer for tracking list of known SHA parts
-static uchar listBuffer[MAX_PORTNUM][MAX_SHA_IBUTTONS];
-static int indexBuffer = 0;
-//holds last state of FindNewSHA
-static SMALLINT needsFirst = FALSE;
-
 //---------------------------------------------------------------------
-// Finds new SHA iButtons on the given port.  Uses 'triple-buffer'
-// technique to insure it only finds 'new' buttons.
+// Finds new SHA iButtons on the given port.  The port is watched with
+// the presence monitor (owmon.c), a button is new when it arrives.
+// Buttons that arrive in the same poll are returned by the following
+// calls before the bus is looked at again.
 //
 // 'portnum'     - number 0 to MAX_PORTNUM-1.  This number is provided to
 //                 indicate the symbolic port number.
 // 'devAN'       - pointer to buffer for device address
-// 'resetList'   - if TRUE, final buffer is cleared.
+// 'resetList'   - if TRUE, the buttons already found are forgotten.
 //
 // Returns: TRUE, found a new SHA iButton.
 //          FALSE, no new buttons are present.
 //
 SMALLINT FindNewSHA(int portnum, uchar* devAN, SMALLINT resetList)
 {
-   uchar ROM[8];
-   uchar tempList[MAX_SHA_IBUTTONS] = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-                                       0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00};
-   int tempIndex = 0, i;
-   SMALLINT hasDevices = TRUE, completeList = FALSE;
+   OWMonEvent ev;
+   SMALLINT polled = FALSE;
 
    // force back to standard speed
    if(MODE_NORMAL != owSpeed(portnum,MODE_NORMAL))
@@ -223,81 +218,45 @@ SMALLINT FindNewSHA(int portnum, uchar* devAN, SMALLINT resetList)
       return FALSE;
    }
 
-   in_overdrive[portnum&0x0FF] = FALSE;
+   owGetPort(portnum)->InOverdrive = FALSE;
 
-   // get first device in list with the specified family
-   if(needsFirst || resetList)
-   {
-      hasDevices = owFirst(portnum, TRUE, FALSE);
-      completeList = TRUE;
-      if(resetList)
-         listIndex = 0;
-   }
-   else
-   {
-      hasDevices = owNext(portnum, TRUE, FALSE);
-   }
+   // forget the buttons found so every one present arrives again
+   if(resetList)
+      owMonStop(portnum);
+   if(!owMonStart(portnum, 0, NULL, NULL))
+      return FALSE;
 
-   if(hasDevices)
+   for(;;)
    {
-      do
+      if(!owMonGetEvent(portnum, &ev))
       {
-         // verify correct device type
-         owSerialNum(portnum, ROM, TRUE);
-         tempList[tempIndex++] = ROM[7];
-
-         // compare crc to complete list of ROMs
-         for(i=0; i<listIndex; i++)
-         {
-            if(ROM[7] == ListOfKnownSHA[portnum&0x0FF][i])
-               break;
-         }
-
-         // found no match;
-         if(i==listIndex)
-         {
-            // check if correct type and not copr_rom
-            if ((SHA_FAMILY_CODE   == (ROM[0] & 0x7F)) ||
-                (SHA33_FAMILY_CODE == (ROM[0] & 0x7F)))
-            {
-               // save the ROM to the return buffer
-               owSerialNum(portnum,devAN,TRUE);
-               ListOfKnownSHA[portnum&0x0FF][listIndex++] = devAN[7];
-               return TRUE;
-            }
-         }
+         if(polled || (owMonPoll(portnum) <= 0))
+            break;
+         polled = TRUE;
+         continue;
       }
-      while(owNext(portnum, TRUE, FALSE));
-   }
-
-   // depleted the list, start over from beginning next time
-   needsFirst = TRUE;
 
-   if(completeList)
-   {
-      // known list is triple-buffered, listBuffer is intermediate
-      // buffer.  tempList is the immediate buffer, while
-      // ListOfKnownSHA is the final buffer.
-      if( (memcmp(tempList, listBuffer[portnum&0x0FF], MAX_SHA_IBUTTONS)==0) &&
-          tempIndex == indexBuffer )
+      // check if correct type and not copr_rom
+      if((ev.event == OWMON_ARRIVED) &&
+         ((SHA_FAMILY_CODE   == (ev.SerialNum[0] & 0x7F)) ||
+          (SHA33_FAMILY_CODE == (ev.SerialNum[0] & 0x7F))))
       {
-         memcpy(ListOfKnownSHA[portnum&0x0FF], tempList, MAX_SHA_IBUTTONS);
-         listIndex = tempIndex;
-      }
-      else
-      {
-         memcpy(listBuffer[portnum&0x0FF], tempList, MAX_SHA_IBUTTONS);
-         indexBuffer = tempIndex;
+         // save the ROM to the return buffer
+         memcpy(devAN, ev.SerialNum, 8);
+         owSerialNum(portnum, devAN, FALSE);
+         return TRUE;
       }
-
    }
+
    return FALSE;
 }
 
 
 //-------------------------------------------------------------------------
 // Select the current device and attempt overdrive if possible.  Usable
-// for both DS1963S and DS1961S.
+// for both DS1963S and DS1961S.  The device is selected with the
+// owSessionSelect session, so selecting the same button again is a reset
+// and Resume ROM instead of a full search of its ROM.
 //
 // 'portnum'     - number 0 to MAX_PORTNUM-1.  This number is provided to
 //                 indicate the symbolic port number.
@@ -307,19 +266,23 @@ SMALLINT FindNewSHA(int portnum, uchar* devAN, SMALLINT resetList)
 //
 SMALLINT SelectSHA(int portnum)
 {
-   int rt,cnt=0;
+   int rt;
+#ifndef __MC68K__
+   uchar ROM[8];
+   #ifdef DEBUG_DUMP
+      int i, mcnt;
+      char msg[255];
+   #endif
+#endif
 
 #ifdef __MC68K__
    // Used in when overdrive isn't...Used owVerify for overdrive
    rt = owAccess(portnum);
 #else
+   owSerialNum(portnum,ROM,TRUE);
+
    //\\//\\//\\//\\//\\//\\//\\//\\//\\//
    #ifdef DEBUG_DUMP
-      uchar ROM[8];
-      int i, mcnt;
-      char msg[255];
-
-      owSerialNum(portnum,ROM, TRUE);
       mcnt = sprintf(msg,"\n  Device select ");
       for (i = 0; i < 8; i++)
          mcnt += sprintf(msg + mcnt, "%02X",ROM[i]);
@@ -328,42 +291,12 @@ SMALLINT SelectSHA(int portnum)
    #endif
    //\\//\\//\\//\\//\\//\\//\\//\\//\\//
 
-   // loop to access the device and optionally do overdrive
-   do
-   {
-      rt = owVerify(portnum,FALSE);
+   // resume the device or select it, in overdrive when it can
+   rt = owSessionSelect(portnum,ROM);
 
-      // check not present
-      if (rt != 1)
-      {
-         // if in overdrive, drop back
-         if (in_overdrive[portnum&0x0FF])
-         {
-            // set to normal speed
-            if(MODE_NORMAL == owSpeed(portnum,MODE_NORMAL))
-            	in_overdrive[portnum&0x0FF] = FALSE;
-         }
-      }
-      // present but not in overdrive
-      else if (!in_overdrive[portnum&0x0FF])
-      {
-         // put all devices in overdrive
-         if (owTouchReset(portnum))
-         {
-            if (owWriteByte(portnum,0x3C))
-            {
-               // set to overdrive speed
-               if(MODE_OVERDRIVE == owSpeed(portnum,MODE_OVERDRIVE))
-               		in_overdrive[portnum&0x0FF] = TRUE;
-            }
-         }
-
-         rt = 0;
-      }
-      else
-         break;
-   }
-   while ((rt != 1) && (cnt++ < 3));
+   // the verification byte counts follow the speed it was selected at
+   owGetPort(portnum)->InOverdrive =
+      (owSessionSpeed(portnum) == OWSESS_OVERDRIVE);
 #endif
 
    return rt;
@@ -294,17 +294,21 @@ extern SMALLINT InstallAuthSecretVM(SHACopr* copr,
                                     int secret_length);
 extern SMALLINT VerifyAuthResponseVM(SHACopr* copr, SHAUser* user,
                                      uchar* chlg, SMALLINT doBind);
+extern SMALLINT VerifyAuthSecretVM(SHACopr* copr, SHAUser* user,
+                                   uchar* chlg, uchar* secret,
+                                   SMALLINT doBind);
+extern SMALLINT VerifyDataVM(SHACopr* copr, SHAUser* user,
+                             SMALLINT* repaired);
+extern SMALLINT DebitAccountVM(SHAUser* user, int debitAmount);
+extern SMALLINT SignServiceDataVM(SHACopr* copr, SHAUser* user);
+extern SMALLINT WriteDataPageSHA33VM(SHACopr* copr, SHAUser* user,
+                                     uchar* secret);
 extern SMALLINT CreateDataSignatureVM(SHACopr* copr, uchar* secret,
                                       uchar* data, uchar* scratchpad,
                                       uchar* signature, SMALLINT readSignature);
 extern SMALLINT GetCoprVM(SHACopr* copr, FileEntry* fe);
 // ********************************************************************** //
 
-// ********************************************************************** //
-// Global - defined in shaibutton.c
-extern SMALLINT in_overdrive[MAX_PORTNUM];
-// ********************************************************************** //
-
 extern void PrintHexLabeled(char* label,uchar* buffer, int cnt);
 
 extern void ReadChars(uchar* buffer, int len);
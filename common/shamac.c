@@ -0,0 +1,421 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  shamac.c - SHA-1 MAC engine.  The C engine keeps every value in 32
+//             bits, builds the 80 word schedule once and runs the rounds
+//             five at a time without a function call for the round
+//             function.  ComputeSHAMACMulti runs SHAMAC_LANES blocks in
+//             step so a compiler can put the lanes in vector registers.
+//             With GCC or clang on x86 the SHA extensions are used when
+//             the processor has them.
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  The engine is picked once with pthread_once
+//                         under OW_THREADS.  Added SHAMACSetEngine.
+//
+
+#include "shamac.h"
+
+#ifdef OW_THREADS
+#include <pthread.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SHAMAC_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+// initial values
+#define H0     0x67452301UL
+#define H1     0xEFCDAB89UL
+#define H2     0x98BADCFEUL
+#define H3     0x10325476UL
+#define H4     0xC3D2E1F0UL
+
+// round constants
+#define K1     0x5A827999UL
+#define K2     0x6ED9EBA1UL
+#define K3     0x8F1BBCDCUL
+#define K4     0xCA62C1D6UL
+
+#define ROL(x,n)     ((uint32_t)(((x) << (n)) | ((x) >> (32 - (n)))))
+
+// round functions of rounds 0-19, 20-39 and 60-79, 40-59
+#define F1(b,c,d)    ((d) ^ ((b) & ((c) ^ (d))))
+#define F2(b,c,d)    ((b) ^ (c) ^ (d))
+#define F3(b,c,d)    (((b) & (c)) | ((d) & ((b) | (c))))
+
+// one round with the variables renamed instead of moved
+#define ROUND(a,b,c,d,e,f,k,w) \
+   e += ROL(a,5) + f(b,c,d) + (k) + (w); \
+   b = ROL(b,30);
+
+// five rounds starting at 'i', after them the names are back in place
+#define ROUND5(f,k,i) \
+   ROUND(a,b,c,d,e,f,k,w[(i)]) \
+   ROUND(e,a,b,c,d,f,k,w[(i) + 1]) \
+   ROUND(d,e,a,b,c,f,k,w[(i) + 2]) \
+   ROUND(c,d,e,a,b,f,k,w[(i) + 3]) \
+   ROUND(b,c,d,e,a,f,k,w[(i) + 4])
+
+// local functions
+static void Schedule(uchar *MT, uint32_t *w);
+static void ComputeC(uchar *MT, uint32_t *hash);
+static void ComputeLanes(uchar MT[][64], uint32_t hash[][5]);
+#ifdef SHAMAC_X86
+static int  HasSHANI(void);
+static void ComputeSHANI(uchar *MT, uint32_t *hash);
+#endif
+static void PickEngine(void);
+
+// engine picked on the first call
+static int engine = SHAMAC_PORTABLE;
+#ifdef OW_THREADS
+static pthread_once_t EngineOnce = PTHREAD_ONCE_INIT;
+#else
+static SMALLINT EnginePicked = FALSE;
+#endif
+
+//----------------------------------------------------------------------
+// Compute the MAC of a 64 byte digest buffer, as ComputeSHAVM.
+//
+// 'MT'        - buffer containing the message digest
+// 'hash'      - receives the 5 words A to E
+//
+void ComputeSHAMAC(uchar *MT, uint32_t *hash)
+{
+#ifdef SHAMAC_X86
+   if (SHAMACEngine() == SHAMAC_SHANI)
+   {
+      ComputeSHANI(MT,hash);
+      return;
+   }
+#endif
+   ComputeC(MT,hash);
+}
+
+//----------------------------------------------------------------------
+// Compute the MACs of several digest buffers, for example the
+// signatures of a batch of roaming transactions.
+//
+// 'MT'        - the digest buffers
+// 'hash'      - receives the 5 words A to E of each buffer
+// 'num'       - number of buffers
+//
+void ComputeSHAMACMulti(uchar MT[][64], uint32_t hash[][5], int num)
+{
+   int i = 0;
+
+   if (SHAMACEngine() == SHAMAC_PORTABLE)
+   {
+      for (; (i + SHAMAC_LANES) <= num; i += SHAMAC_LANES)
+         ComputeLanes(&MT[i],&hash[i]);
+   }
+
+   // the rest, or every buffer when each is done in a few instructions
+   for (; i < num; i++)
+      ComputeSHAMAC(MT[i],hash[i]);
+}
+
+//----------------------------------------------------------------------
+// Convert a result into the 20 byte, LSB first MAC of the SHA iButtons
+// (E-D-C-B-A), as HashToMAC.
+//
+// 'hash'      - result of ComputeSHAMAC
+// 'MAC'       - receives the 20 bytes
+//
+void SHAMACToBytes(uint32_t *hash, uchar *MAC)
+{
+   int i,j;
+
+   for (j = 4; j >= 0; j--)
+      for (i = 0; i < 4; i++)
+         *MAC++ = (uchar)(hash[j] >> (i * 8));
+}
+
+//----------------------------------------------------------------------
+// Get the engine ComputeSHAMAC uses.  It is picked on the first call,
+// once for all threads with OW_THREADS.
+//
+// Returns:  SHAMAC_SHANI or SHAMAC_PORTABLE
+//
+int SHAMACEngine(void)
+{
+#ifdef OW_THREADS
+   pthread_once(&EngineOnce,PickEngine);
+#else
+   if (!EnginePicked)
+   {
+      PickEngine();
+      EnginePicked = TRUE;
+   }
+#endif
+
+   return engine;
+}
+
+//----------------------------------------------------------------------
+// Choose the engine instead of the one picked from the processor.  Call
+// at startup, before other threads compute MACs.
+//
+// 'eng'       - SHAMAC_SHANI or SHAMAC_PORTABLE
+//
+// Returns:  TRUE if the engine can run on this processor
+//
+SMALLINT SHAMACSetEngine(int eng)
+{
+   // the first pick is done so it does not replace this one later
+   SHAMACEngine();
+
+   if ((eng != SHAMAC_PORTABLE) && (eng != SHAMAC_SHANI))
+      return FALSE;
+#ifdef SHAMAC_X86
+   if ((eng == SHAMAC_SHANI) && !HasSHANI())
+      return FALSE;
+#else
+   if (eng == SHAMAC_SHANI)
+      return FALSE;
+#endif
+
+   engine = eng;
+   return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Pick the fastest engine the processor has.
+//
+static void PickEngine(void)
+{
+#ifdef SHAMAC_X86
+   engine = HasSHANI() ? SHAMAC_SHANI : SHAMAC_PORTABLE;
+#else
+   engine = SHAMAC_PORTABLE;
+#endif
+}
+
+//----------------------------------------------------------------------
+// Build the 80 word message schedule of a digest buffer.
+//
+static void Schedule(uchar *MT, uint32_t *w)
+{
+   int i;
+
+   for (i = 0; i < 16; i++)
+      w[i] = ((uint32_t)MT[i * 4] << 24) | ((uint32_t)MT[i * 4 + 1] << 16) |
+             ((uint32_t)MT[i * 4 + 2] << 8) | (uint32_t)MT[i * 4 + 3];
+
+   for (; i < 80; i++)
+      w[i] = ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16],1);
+}
+
+//----------------------------------------------------------------------
+// C engine for one buffer.
+//
+static void ComputeC(uchar *MT, uint32_t *hash)
+{
+   uint32_t w[80],a = H0,b = H1,c = H2,d = H3,e = H4;
+   int i;
+
+   Schedule(MT,w);
+
+   for (i = 0; i < 20; i += 5)
+   {
+      ROUND5(F1,K1,i)
+   }
+   for (; i < 40; i += 5)
+   {
+      ROUND5(F2,K2,i)
+   }
+   for (; i < 60; i += 5)
+   {
+      ROUND5(F3,K3,i)
+   }
+   for (; i < 80; i += 5)
+   {
+      ROUND5(F2,K4,i)
+   }
+
+   hash[0] = a;
+   hash[1] = b;
+   hash[2] = c;
+   hash[3] = d;
+   hash[4] = e;
+}
+
+//----------------------------------------------------------------------
+// C engine for SHAMAC_LANES buffers.  Each round is done for every lane
+// before the next one, the loops over the lanes have no dependencies
+// between them.
+//
+static void ComputeLanes(uchar MT[][64], uint32_t hash[][5])
+{
+   uint32_t w[80][SHAMAC_LANES];
+   uint32_t a[SHAMAC_LANES],b[SHAMAC_LANES],c[SHAMAC_LANES];
+   uint32_t d[SHAMAC_LANES],e[SHAMAC_LANES];
+   int i,l;
+
+   for (i = 0; i < 16; i++)
+      for (l = 0; l < SHAMAC_LANES; l++)
+         w[i][l] = ((uint32_t)MT[l][i * 4] << 24) | ((uint32_t)MT[l][i * 4 + 1] << 16) |
+                   ((uint32_t)MT[l][i * 4 + 2] << 8) | (uint32_t)MT[l][i * 4 + 3];
+   for (; i < 80; i++)
+      for (l = 0; l < SHAMAC_LANES; l++)
+         w[i][l] = ROL(w[i - 3][l] ^ w[i - 8][l] ^ w[i - 14][l] ^ w[i - 16][l],1);
+
+   for (l = 0; l < SHAMAC_LANES; l++)
+   {
+      a[l] = H0;
+      b[l] = H1;
+      c[l] = H2;
+      d[l] = H3;
+      e[l] = H4;
+   }
+
+// ROUND and ROUND5 over every lane
+#define LANE_ROUND(a,b,c,d,e,f,k,i) \
+   for (l = 0; l < SHAMAC_LANES; l++) \
+   { \
+      e[l] += ROL(a[l],5) + f(b[l],c[l],d[l]) + (k) + w[i][l]; \
+      b[l] = ROL(b[l],30); \
+   }
+#define LANE_ROUND5(f,k,i) \
+   LANE_ROUND(a,b,c,d,e,f,k,(i)) \
+   LANE_ROUND(e,a,b,c,d,f,k,(i) + 1) \
+   LANE_ROUND(d,e,a,b,c,f,k,(i) + 2) \
+   LANE_ROUND(c,d,e,a,b,f,k,(i) + 3) \
+   LANE_ROUND(b,c,d,e,a,f,k,(i) + 4)
+
+   for (i = 0; i < 20; i += 5)
+   {
+      LANE_ROUND5(F1,K1,i)
+   }
+   for (; i < 40; i += 5)
+   {
+      LANE_ROUND5(F2,K2,i)
+   }
+   for (; i < 60; i += 5)
+   {
+      LANE_ROUND5(F3,K3,i)
+   }
+   for (; i < 80; i += 5)
+   {
+      LANE_ROUND5(F2,K4,i)
+   }
+
+#undef LANE_ROUND5
+#undef LANE_ROUND
+
+   for (l = 0; l < SHAMAC_LANES; l++)
+   {
+      hash[l][0] = a[l];
+      hash[l][1] = b[l];
+      hash[l][2] = c[l];
+      hash[l][3] = d[l];
+      hash[l][4] = e[l];
+   }
+}
+
+#ifdef SHAMAC_X86
+//----------------------------------------------------------------------
+// Check for the SHA extensions and the SSSE3 and SSE4.1 instructions
+// ComputeSHANI also uses.
+//
+static int HasSHANI(void)
+{
+   unsigned int eax,ebx,ecx,edx;
+
+   if (!__get_cpuid(1,&eax,&ebx,&ecx,&edx))
+      return 0;
+   if (!(ecx & (1 << 9)) || !(ecx & (1 << 19)))
+      return 0;
+   if (__get_cpuid_max(0,0) < 7)
+      return 0;
+   __cpuid_count(7,0,eax,ebx,ecx,edx);
+   return (ebx & (1 << 29)) != 0;
+}
+
+// four rounds 'g' to 'g'+3 with round function 'f' (0 to 3).  Each new
+// group of four schedule words is made from the four groups before it.
+#define SHANI_ROUNDS(g,f) \
+   if ((g) >= 16) \
+      msg[(g) / 4 & 3] = _mm_sha1msg2_epu32(_mm_xor_si128( \
+            _mm_sha1msg1_epu32(msg[(g) / 4 & 3],msg[((g) / 4 + 1) & 3]), \
+            msg[((g) / 4 + 2) & 3]),msg[((g) / 4 + 3) & 3]); \
+   e = _mm_sha1nexte_epu32(prev,msg[(g) / 4 & 3]); \
+   prev = abcd; \
+   abcd = _mm_sha1rnds4_epu32(abcd,e,f);
+
+//----------------------------------------------------------------------
+// Engine with the x86 SHA extensions for one buffer.
+//
+__attribute__((target("sha,ssse3,sse4.1")))
+static void ComputeSHANI(uchar *MT, uint32_t *hash)
+{
+   __m128i abcd,prev,e,msg[4],mask;
+   int i;
+
+   // the words of the buffer are big endian
+   mask = _mm_set_epi64x(0x0001020304050607LL,0x08090A0B0C0D0E0FLL);
+   for (i = 0; i < 4; i++)
+      msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)&MT[i * 16]),mask);
+
+   abcd = _mm_set_epi32((int)H0,(int)H1,(int)H2,(int)H3);
+
+   // rounds 0-3 add E to the first words, the later ones get it from
+   // A of the rounds before ('prev')
+   e = _mm_add_epi32(_mm_set_epi32((int)H4,0,0,0),msg[0]);
+   prev = abcd;
+   abcd = _mm_sha1rnds4_epu32(abcd,e,0);
+
+   for (i = 4; i < 20; i += 4)
+   {
+      SHANI_ROUNDS(i,0)
+   }
+   for (; i < 40; i += 4)
+   {
+      SHANI_ROUNDS(i,1)
+   }
+   for (; i < 60; i += 4)
+   {
+      SHANI_ROUNDS(i,2)
+   }
+   for (; i < 80; i += 4)
+   {
+      SHANI_ROUNDS(i,3)
+   }
+
+   // E is A of four rounds back rotated, there is no final addition
+   e = _mm_sha1nexte_epu32(prev,_mm_setzero_si128());
+
+   hash[0] = (uint32_t)_mm_extract_epi32(abcd,3);
+   hash[1] = (uint32_t)_mm_extract_epi32(abcd,2);
+   hash[2] = (uint32_t)_mm_extract_epi32(abcd,1);
+   hash[3] = (uint32_t)_mm_extract_epi32(abcd,0);
+   hash[4] = (uint32_t)_mm_extract_epi32(e,3);
+}
+#endif
@@ -0,0 +1,57 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  shamac.h - SHA-1 MAC engine for the SHA iButtons (DS1963S, DS1961S)
+//             and software coprocessors.  The result is the one of
+//             ComputeSHAVM: one 64 byte block from the standard initial
+//             values, without the final addition of FIPS-180.
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  Added SHAMACSetEngine.
+//
+
+#ifndef SHAMAC_H
+#define SHAMAC_H
+
+#include <stdint.h>
+#include "ownet.h"
+
+// engines
+#define SHAMAC_PORTABLE        0     // C, any compiler
+#define SHAMAC_SHANI           1     // x86 SHA extensions
+
+// blocks ComputeSHAMACMulti runs side by side with the C engine
+#define SHAMAC_LANES           4
+
+// functions defined in shamac.c
+void ComputeSHAMAC(uchar *MT, uint32_t *hash);
+void ComputeSHAMACMulti(uchar MT[][64], uint32_t hash[][5], int num);
+void SHAMACToBytes(uint32_t *hash, uchar *MAC);
+int  SHAMACEngine(void);
+SMALLINT SHAMACSetEngine(int eng);
+
+#endif
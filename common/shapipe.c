@@ -0,0 +1,633 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  shapipe.c - Debit pipeline for DS1963S and DS1961S user tokens with a
+//              software coprocessor.  Each transaction is read from the
+//              user on the owbus worker of its port, checked and signed
+//              by the MAC thread pool and then written back on the port
+//              worker again.  While one user is being signed the next
+//              can be read, on every started bus.  The finished queue of
+//              owbus is taken over by the pipeline while it is running.
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  The account page is found by reading the root
+//                         directory of the user on its port instead of
+//                         owOpenFile under a lock, so the buses do not
+//                         wait on each other.  A transaction that cannot
+//                         go back to its port, or is read after
+//                         SHAPipeStop, is returned by SHAPipeComplete
+//                         with a failure status.
+//
+
+#include <ctype.h>
+#include "ownet.h"
+#include "owbus.h"
+#include "rawmem.h"
+#include "shaib.h"
+#include "shapipe.h"
+
+#ifdef OW_THREADS
+
+#include <pthread.h>
+
+#define SHAPIPE_RETRY_CNT 255
+// longest wait on the ports while the MAC pool has transactions
+#define SHAPIPE_POLL_MS   10
+
+// coprocessor and service file of the pipeline
+static SHACopr        *Copr = NULL;
+static FileEntry       Service;
+
+// MAC thread pool and its queue
+static pthread_t       Threads[SHAPIPE_THREADS];
+static int             NumThreads = 0;
+static pthread_mutex_t MacLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  MacReady = PTHREAD_COND_INITIALIZER;
+static SHAPipeTxn     *MacHead = NULL;
+static SHAPipeTxn     *MacTail = NULL;
+static SMALLINT        MacStop = TRUE;
+// transactions taken by the pool and not handed back yet
+static int             MacBusy = 0;
+// transactions the pool could not hand back to their port
+static SHAPipeTxn     *DoneHead = NULL;
+static SHAPipeTxn     *DoneTail = NULL;
+
+// local functions
+static void *MacWorker(void *);
+static void MacStage(SHAPipeTxn *txn);
+static int  ReadStage(int portnum, void *arg);
+static SMALLINT FindAccountPage(int portnum, uchar *SNum, uchar *page);
+static int  WriteStage(int portnum, void *arg);
+static int  FinishStage(int portnum, void *arg);
+static SMALLINT ConfirmWrite(SHAPipeTxn *txn, SMALLINT success);
+static void NewChallenge(uchar *chlg);
+
+//--------------------------------------------------------------------------
+// Start the MAC thread pool.  The coprocessor must have been set up with
+// GetCoprVM and the ports to be used started with owBusStart.
+//
+// 'copr'     - software coprocessor, it must stay valid until
+//              SHAPipeStop
+// 'fe'       - file entry with the service filename of the accounts
+// 'threads'  - number of MAC threads, 1 to SHAPIPE_THREADS
+//
+// Returns: TRUE(1)  pipeline running
+//          FALSE(0) could not start the threads
+//
+SMALLINT SHAPipeStart(SHACopr* copr, FileEntry* fe, int threads)
+{
+   // already running
+   if (NumThreads > 0)
+      return TRUE;
+
+   if (threads < 1)
+      threads = 1;
+   else if (threads > SHAPIPE_THREADS)
+      threads = SHAPIPE_THREADS;
+
+   // the name is matched in upper case like owOpenFile does
+   memcpy(&Service,fe,sizeof(FileEntry));
+   if (!Valid_FileName(&Service) || ((Service.Ext & 0x7F) > 102))
+   {
+      OWERROR(OWERROR_XBAD_FILENAME);
+      return FALSE;
+   }
+   Service.Ext &= 0x7F;
+
+   Copr = copr;
+   MacHead = MacTail = NULL;
+   DoneHead = DoneTail = NULL;
+   MacBusy = 0;
+   MacStop = FALSE;
+
+   for (NumThreads = 0; NumThreads < threads; NumThreads++)
+   {
+      if (pthread_create(&Threads[NumThreads],NULL,MacWorker,NULL) != 0)
+      {
+         SHAPipeStop();
+         OWERROR(OWERROR_SYSTEM_RESOURCE_INIT_FAILED);
+         return FALSE;
+      }
+   }
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Stop the MAC thread pool.  Transactions already queued for it are
+// signed and handed to their port first, SHAPipeComplete still returns
+// them.  Transactions read after this are returned by SHAPipeComplete
+// with SHAPIPE_STOPPED.
+//
+void SHAPipeStop(void)
+{
+   int i;
+
+   pthread_mutex_lock(&MacLock);
+   MacStop = TRUE;
+   pthread_cond_broadcast(&MacReady);
+   pthread_mutex_unlock(&MacLock);
+
+   for (i = 0; i < NumThreads; i++)
+      pthread_join(Threads[i],NULL);
+   NumThreads = 0;
+}
+
+//--------------------------------------------------------------------------
+// Start a debit of a user token.  A new challenge is made and the
+// transaction is queued on the worker of the user's port.
+//
+// 'txn'           - transaction with 'user.portnum' and 'user.devAN' set,
+//                   it must stay valid until it is returned by
+//                   SHAPipeComplete
+// 'debitAmount'   - the amount of money to debit from balance in cents.
+// 'verifySuccess' - Paranoid double-check of account write by reading
+//                   the account again
+//
+// Returns: TRUE(1)  transaction queued
+//          FALSE(0) the pipeline or the port is not running
+//
+SMALLINT SHAPipeSubmit(SHAPipeTxn* txn, int debitAmount,
+                       SMALLINT verifySuccess)
+{
+   if (NumThreads == 0)
+   {
+      OWERROR(OWERROR_SYSTEM_RESOURCE_INIT_FAILED);
+      return FALSE;
+   }
+
+   txn->debitAmount = debitAmount;
+   txn->verifySuccess = verifySuccess;
+   txn->status = SHAPIPE_OK;
+   txn->error = 0;
+   txn->balance = 0;
+   txn->repaired = FALSE;
+   txn->next = NULL;
+   NewChallenge(txn->chlg);
+
+   return owBusSubmit(txn->user.portnum,&txn->req,ReadStage,txn);
+}
+
+//--------------------------------------------------------------------------
+// Get the next finished transaction from any port.  Transactions that
+// have only been read are passed on to the MAC pool here.
+//
+// 'timeout_ms' - milliseconds to wait for a transaction to finish, 0 to
+//                poll or -1 to wait forever
+//
+// Returns: the finished transaction, NULL if none finished in time
+//
+SHAPipeTxn *SHAPipeComplete(int timeout_ms)
+{
+   owBusRequest *req;
+   SHAPipeTxn *txn;
+   long stop = msGettick() + timeout_ms;
+   int wait = timeout_ms, slice, busy;
+   SMALLINT timedout = FALSE;
+
+   for (;;)
+   {
+      // finished by the MAC pool without going back to a port
+      pthread_mutex_lock(&MacLock);
+      txn = DoneHead;
+      if (txn != NULL)
+      {
+         DoneHead = txn->next;
+         if (DoneHead == NULL)
+            DoneTail = NULL;
+         txn->next = NULL;
+      }
+      busy = MacBusy;
+      pthread_mutex_unlock(&MacLock);
+      if (txn != NULL)
+         return txn;
+      if (timedout)
+         return NULL;
+
+      if (timeout_ms > 0)
+      {
+         wait = (int)(stop - msGettick());
+         if (wait < 0)
+            wait = 0;
+      }
+
+      // the pool finishing a transaction does not wake owBusComplete, so
+      // wait in steps while it has any
+      slice = wait;
+      if ((busy > 0) && ((slice < 0) || (slice > SHAPIPE_POLL_MS)))
+         slice = SHAPIPE_POLL_MS;
+
+      req = owBusComplete(slice);
+      if (req == NULL)
+      {
+         timedout = (slice == wait);
+         continue;
+      }
+      txn = (SHAPipeTxn *)req->arg;
+
+      if (req->func != ReadStage)
+      {
+         // written, or failed and cleaned up on the port
+         if ((req->func == WriteStage) && !req->result)
+         {
+            txn->status = SHAPIPE_WRITE_FAILED;
+            txn->error = req->error;
+         }
+         return txn;
+      }
+
+      if (!req->result)
+      {
+         txn->status = SHAPIPE_READ_FAILED;
+         txn->error = req->error;
+         return txn;
+      }
+
+      // read, queue it for the MAC pool
+      pthread_mutex_lock(&MacLock);
+      if (MacStop)
+      {
+         // nothing will check and sign it
+         pthread_mutex_unlock(&MacLock);
+         txn->status = SHAPIPE_STOPPED;
+         return txn;
+      }
+      if (MacTail != NULL)
+         MacTail->next = txn;
+      else
+         MacHead = txn;
+      MacTail = txn;
+      MacBusy++;
+      pthread_cond_signal(&MacReady);
+      pthread_mutex_unlock(&MacLock);
+   }
+}
+
+//--------------------------------------------------------------------------
+// MAC pool thread.  Takes the read transactions in order and hands each
+// back to its port when it is done.
+//
+static void *MacWorker(void *arg)
+{
+   SHAPipeTxn *txn;
+
+   for (;;)
+   {
+      pthread_mutex_lock(&MacLock);
+      while ((MacHead == NULL) && !MacStop)
+         pthread_cond_wait(&MacReady,&MacLock);
+      txn = MacHead;
+      if (txn == NULL)
+      {
+         // stopped with nothing left to do
+         pthread_mutex_unlock(&MacLock);
+         break;
+      }
+      MacHead = txn->next;
+      if (MacHead == NULL)
+         MacTail = NULL;
+      txn->next = NULL;
+      pthread_mutex_unlock(&MacLock);
+
+      MacStage(txn);
+   }
+
+   return NULL;
+}
+
+//--------------------------------------------------------------------------
+// Check the user's answer and account data, then debit and sign it.  The
+// user's unique secret is kept in the transaction so no state is shared
+// with the other MAC threads.  The transaction goes back to its port to
+// be written, or to be cleaned up if a check failed.  If the port has
+// been stopped it is returned by SHAPipeComplete instead, not written.
+//
+// 'txn'      - transaction read by ReadStage
+//
+static void MacStage(SHAPipeTxn *txn)
+{
+   SHAUser *user = &txn->user;
+   owBusFunc next = FinishStage;
+
+   OWERROR_CLEAR();
+
+   if (!VerifyAuthSecretVM(Copr,user,txn->chlg,txn->secret,TRUE))
+   {
+      OWERROR(OWERROR_VERIFY_AUTH_RESPONSE_FAILED);
+      txn->status = SHAPIPE_AUTH_FAILED;
+   }
+   else if (!VerifyDataVM(Copr,user,&txn->repaired))
+      txn->status = SHAPIPE_DATA_FAILED;
+   else
+   {
+      memcpy(txn->oldAcct,user->accountFile,32);
+      if (!DebitAccountVM(user,txn->debitAmount) ||
+          !SignServiceDataVM(Copr,user))
+         txn->status = SHAPIPE_DEBIT_FAILED;
+      else
+      {
+         txn->balance = GetBalance(user);
+         next = WriteStage;
+      }
+   }
+
+   txn->error = owHasErrors() ? owGetErrorNum() : 0;
+   OWERROR_CLEAR();
+
+   if (owBusSubmit(user->portnum,&txn->req,next,txn))
+      next = NULL;
+   else if (next == WriteStage)
+   {
+      txn->status = SHAPIPE_WRITE_FAILED;
+      txn->error = owGetErrorNum();
+   }
+   OWERROR_CLEAR();
+
+   pthread_mutex_lock(&MacLock);
+   if (next != NULL)
+   {
+      // port stopped, SHAPipeComplete returns it
+      if (DoneTail != NULL)
+         DoneTail->next = txn;
+      else
+         DoneHead = txn;
+      DoneTail = txn;
+   }
+   MacBusy--;
+   pthread_mutex_unlock(&MacLock);
+}
+
+//--------------------------------------------------------------------------
+// Port stage: find the account file and have the user answer the
+// challenge.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'arg'      - the SHAPipeTxn
+//
+// Returns: TRUE(1)  account read and challenge answered
+//          FALSE(0) failed, see the request error
+//
+static int ReadStage(int portnum, void *arg)
+{
+   SHAPipeTxn *txn = (SHAPipeTxn *)arg;
+   SHAUser *user = &txn->user;
+
+   if (!FindAccountPage(portnum,user->devAN,&user->accountPageNumber))
+      return FALSE;
+
+   OWASSERT( AnswerChallenge(user,txn->chlg)>=0,
+             OWERROR_ANSWER_CHALLENGE_FAILED, FALSE );
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Find the start page of the service file in the root directory of a
+// user, the same way as FindDirectoryInfo.  The directory packets are
+// read from the user with owReadPagePacket instead of through owfile.c,
+// whose handles, current directory and page cache are shared by all of
+// the ports.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'SNum'     - serial number of the user
+// 'page'     - receives the start page of the file
+//
+// Returns: TRUE(1)  file found
+//          FALSE(0) not found or the directory could not be read
+//
+static SMALLINT FindAccountPage(int portnum, uchar *SNum, uchar *page)
+{
+   uchar pgbuf[32];
+   int pg = 0,len,i,j,cnt;
+
+   // a directory is never longer than the pages of the device
+   for (cnt = 0; cnt < 256; cnt++)
+   {
+      if (!owReadPagePacket(getBank(portnum,SNum,(PAGE_TYPE)pg,REGMEM),
+                            portnum,SNum,
+                            getPage(portnum,SNum,(PAGE_TYPE)pg,REGMEM),
+                            FALSE,pgbuf,&len))
+         return FALSE;
+
+      // the first page starts with the directory control entry
+      i = 0;
+      if (cnt == 0)
+      {
+         if ((len < 8) || (pgbuf[0] != 0xAA) || (pgbuf[1] != 0))
+         {
+            OWERROR(OWERROR_FILE_READ_ERR);
+            return FALSE;
+         }
+         i = 7;
+      }
+      else if (len < 1)
+      {
+         OWERROR(OWERROR_FILE_READ_ERR);
+         return FALSE;
+      }
+
+      // entries of 7 bytes, the last byte points to the next page
+      for (; (i + 7) < len; i += 7)
+      {
+         for (j = 0; j < 4; j++)
+            if ((toupper(pgbuf[i+j]) != Service.Name[j]) &&
+                !((pgbuf[i+j] == 0x20) && (Service.Name[j] == 0xCC)))
+               break;
+
+         if ((j == 4) && ((pgbuf[i+4] & 0x7F) == Service.Ext))
+         {
+            *page = pgbuf[i+5];
+            return TRUE;
+         }
+      }
+
+      pg = pgbuf[len-1];
+      if (pg == 0)
+         break;
+   }
+
+   OWERROR(OWERROR_FILE_NOT_FOUND);
+   return FALSE;
+}
+
+//--------------------------------------------------------------------------
+// Port stage: write the debited account back to the user, the same way
+// as ExecuteTransaction.  A DS1961S record fixed by VerifyDataVM is
+// written before the debit.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'arg'      - the SHAPipeTxn
+//
+// Returns: TRUE(1)  account written
+//          FALSE(0) failed, see the request error
+//
+static int WriteStage(int portnum, void *arg)
+{
+   SHAPipeTxn *txn = (SHAPipeTxn *)arg;
+   SHAUser *user = &txn->user;
+   SHAUser fixed;
+   SMALLINT success;
+
+   owSerialNum(portnum,user->devAN,FALSE);
+
+   if (txn->repaired)
+   {
+      memcpy(&fixed,user,sizeof(SHAUser));
+      memcpy(fixed.accountFile,txn->oldAcct,32);
+      OWASSERT( WriteDataPageSHA33VM(Copr,&fixed,txn->secret),
+                OWERROR_WRITE_DATA_PAGE_FAILED, FALSE );
+   }
+
+   if (user->devAN[0] == 0x18)
+      success = WriteDataPageSHA18(portnum,user->accountPageNumber,
+                                   user->accountFile,FALSE);
+   else
+      success = WriteDataPageSHA33VM(Copr,user,txn->secret);
+   if (!success)
+      OWERROR(OWERROR_WRITE_DATA_PAGE_FAILED);
+
+   if (txn->verifySuccess || !success)
+      success = ConfirmWrite(txn,success);
+
+   return success;
+}
+
+//--------------------------------------------------------------------------
+// Port stage: end a transaction that failed its checks.  A DS1961S that
+// did not authenticate has its page refreshed like VerifyUser does.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'arg'      - the SHAPipeTxn
+//
+// Returns: TRUE(1)
+//
+static int FinishStage(int portnum, void *arg)
+{
+   SHAPipeTxn *txn = (SHAPipeTxn *)arg;
+
+   if ((txn->status == SHAPIPE_AUTH_FAILED) &&
+       ((txn->user.devAN[0] & 0x7F) == 0x33))
+   {
+      owSerialNum(portnum,txn->user.devAN,FALSE);
+      RefreshPage33(portnum,txn->user.accountPageNumber,FALSE);
+   }
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Read the account again to see if the write took, re-signing and
+// writing it again if neither the new nor the old data is found.  The
+// user's secret from the first check is used, it is not bound again.
+//
+// 'txn'      - transaction being written
+// 'success'  - result of the write
+//
+// Returns: TRUE(1)  the new account data is on the user
+//          FALSE(0) the debit was not done
+//
+static SMALLINT ConfirmWrite(SHAPipeTxn *txn, SMALLINT success)
+{
+   SHAUser *user = &txn->user;
+   uchar newAcct[32], chlg[3];
+   SMALLINT dataOK = FALSE;
+   int cnt = SHAPIPE_RETRY_CNT;
+
+   //save what the account data is supposed to look like
+   memcpy(newAcct,user->accountFile,32);
+   do
+   {
+      NewChallenge(chlg);
+      if ((AnswerChallenge(user,chlg) >= 0) &&
+          VerifyAuthSecretVM(Copr,user,chlg,txn->secret,FALSE))
+      {
+         if (memcmp(user->accountFile,newAcct,32) == 0)
+         {
+            //looks like it worked
+            dataOK = TRUE;
+         }
+         else if (memcmp(user->accountFile,txn->oldAcct,32) == 0)
+         {
+            //still the old data, we didn't do a debit
+            dataOK = TRUE;
+            success = FALSE;
+            OWERROR(OWERROR_SERVICE_DATA_NOT_UPDATED);
+         }
+         else
+         {
+            // retry the write
+            success = SignServiceDataVM(Copr,user);
+            if (success)
+            {
+               owSerialNum(user->portnum,user->devAN,FALSE);
+               if (user->devAN[0] == 0x18)
+                  success = WriteDataPageSHA18(user->portnum,
+                                               user->accountPageNumber,
+                                               user->accountFile,FALSE);
+               else
+                  success = WriteDataPageSHA33VM(Copr,user,txn->secret);
+            }
+            memcpy(newAcct,user->accountFile,32);
+         }
+      }
+   }
+   while (!dataOK && (cnt-- > 0));
+
+   if (!dataOK)
+   {
+      //couldn't fix the data
+      OWERROR(OWERROR_CATASTROPHIC_SERVICE_FAILURE);
+      success = FALSE;
+   }
+   else if (success)
+      txn->balance = GetBalance(user);
+
+   return success;
+}
+
+//--------------------------------------------------------------------------
+// Make a random 3 byte challenge.
+//
+// 'chlg'     - 3-byte buffer for the challenge
+//
+static void NewChallenge(uchar *chlg)
+{
+   int randomNum = rand();
+   int i;
+
+   for (i = 0; i < 3; i++)
+   {
+      chlg[i] = (uchar)randomNum;
+      randomNum >>= 8;
+   }
+}
+
+#endif
@@ -0,0 +1,83 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  shapipe.h - Debit pipeline for DS1963S and DS1961S user tokens with a
+//              software coprocessor.  The 1-Wire I/O of each user runs on
+//              the owbus worker of its port while the MAC checks and
+//              signing run on a pool of threads, so several buses and
+//              several users are worked on at once.  Requires OW_THREADS
+//              (POSIX threads).
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  Added SHAPIPE_STOPPED.
+//
+
+#ifndef SHAPIPE_H
+#define SHAPIPE_H
+
+#include "ownet.h"
+#include "owbus.h"
+#include "shaib.h"
+
+// most threads in the MAC pool
+#define SHAPIPE_THREADS      16
+
+// transaction 'status' values
+#define SHAPIPE_OK           0     // debited and written
+#define SHAPIPE_READ_FAILED  1     // account file or challenge answer failed
+#define SHAPIPE_AUTH_FAILED  2     // authentication response did not match
+#define SHAPIPE_DATA_FAILED  3     // account data CRC or signature bad
+#define SHAPIPE_DEBIT_FAILED 4     // balance could not be debited or signed
+#define SHAPIPE_WRITE_FAILED 5     // account data not written, see 'error'
+#define SHAPIPE_STOPPED      6     // read after SHAPipeStop, not debited
+
+// one debit, owned by the caller until it comes back from SHAPipeComplete
+typedef struct SHAPipeTxn
+{
+   SHAUser   user;                 // 'portnum' and 'devAN' set by the caller
+   int       debitAmount;          // amount to debit in cents
+   SMALLINT  verifySuccess;        // re-read the account after the write
+   int       status;               // SHAPIPE_xxx result
+   int       error;                // error raised by the failed step, 0 if none
+   int       balance;              // balance after the debit
+   // internal
+   uchar     chlg[3];              // challenge answered by the user
+   uchar     secret[8];            // user's unique secret
+   uchar     oldAcct[32];          // account data before the debit
+   SMALLINT  repaired;             // 'oldAcct' must be written first
+   owBusRequest req;               // current 1-Wire stage
+   struct SHAPipeTxn *next;        // MAC queue link
+} SHAPipeTxn;
+
+// functions defined in shapipe.c
+SMALLINT    SHAPipeStart(SHACopr* copr, FileEntry* fe, int threads);
+SMALLINT    SHAPipeSubmit(SHAPipeTxn* txn, int debitAmount,
+                          SMALLINT verifySuccess);
+SHAPipeTxn *SHAPipeComplete(int timeout_ms);
+void        SHAPipeStop(void);
+
+#endif
@@ -25,13 +25,16 @@
 //--------------------------------------------------------------------------
 //
 //  swt1f.c - Does commands on the DS2409 device
-//  version 2.00
+//  version 2.01
 //  - future version will have branch of a branch searches
+//  History: 2.00 -> 2.01  SetSwitch1F ends the owsess.c session before
+//                         its own Match ROM
 //
 
 // Include files
 #include <stdio.h>
 #include "ownet.h"
+#include "owsess.h"
 #include "swt1f.h"
 
 //----------------------------------------------------------------------
@@ -66,6 +69,9 @@ int SetSwitch1F(int portnum, uchar *SerialNum, int Swtch, int NumExtra,
 
    if(owAccess(portnum))
    {
+      // the Match ROM below deselects the device of the session
+      owSessionEnd(portnum);
+
       send_cnt = 0;
       // add the match command
       send_block[send_cnt++] = 0x55;
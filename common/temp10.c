@@ -26,14 +26,43 @@
 //
 //  temp10.C - Module to read the DS1920/DS1820 - temperature measurement.
 //
-//  Version: 2.00
+//  Version: 2.05
+//
+//  History: 2.00 -> 2.01  Added ReadTemperatureAll to convert every sensor
+//                         with one Skip ROM Convert T.  Moved the scratchpad
+//                         to temperature math to ScratchTemp.
+//           2.01 -> 2.02  ReadTemperature done with one owTxn transaction.
+//                         ReadTemperatureAll pipelines the scratchpad reads.
+//           2.02 -> 2.03  The end of the conversion of VDD powered sensors
+//                         is polled with owConvPoll.  Parasite powered
+//                         sensors wait the time of their resolution.
+//           2.03 -> 2.04  Added ConvertTemperatureAll, split out of
+//                         ReadTemperatureAll, and ReadLastTemperature.
+//           2.04 -> 2.05  ConvertTemperatureAll reports a polled
+//                         conversion that does not finish and
+//                         ReadTemperatureAll converts again.
 //
 // ---------------------------------------------------------------------------
 //
 //
 #include "ownet.h"
+#include "owtxn.h"
+#include "owconv.h"
 #include "temp10.h"
 
+// internal status for a DS1820 that needs another conversion
+#define TEMP_RETRY         -1
+
+// scratchpad reads sent back to back by ReadTemperatureAll
+#define TEMP_PIPE          8
+
+// longest conversion of any of the sensors (ms)
+#define TEMP_MAX_MS        1000
+
+// local functions
+static int ScratchTemp(uchar,uchar *,int,float *);
+static int ConvertTime(uchar,uchar);
+
 //----------------------------------------------------------------------
 // Read the temperature of a DS1920/DS1820
 //
@@ -49,95 +78,348 @@
 //
 int ReadTemperature(int portnum, uchar *SerialNum, float *Temp)
 {
-   uchar rt=FALSE;
-   uchar send_block[30],lastcrc8=0;
-   int send_cnt, tsht, i, loop=0;
-   float tmp,cr,cpc;
+   OWTxn txn;
+   uchar cmd = 0xBE, convert = 0x44, *data;
+   int i, rd, pwr = -1, len, ms, loop=0;
+   SMALLINT power;
+   float tmp;
 
    // set the device serial number to the counter device
    owSerialNum(portnum,SerialNum,FALSE);
 
+   // find out once if the end of the conversion can be polled
+   power = owConvPower(portnum,SerialNum);
+   if (power == OWCONV_UNKNOWN)
+      power = owConvReadPower(portnum,SerialNum);
+
    for (loop = 0; loop < 2; loop ++)
    {
-      // access the device
-      if (owAccess(portnum))
+      owTxnInit(&txn);
+      owTxnReset(&txn);
+      owTxnMatchROM(&txn,SerialNum);
+      if (power == OWCONV_EXTERNAL)
       {
-         // send the convert command and start power delivery
-         if (!owWriteBytePower(portnum,0x44))
-            return FALSE;
+         // VDD powered, convert and read time slots until it is done,
+         // sleeping through most of the time it took last time
+         owTxnWrite(&txn,&convert,1);
+         if (!owTxnExecute(portnum,&txn))
+            continue;
+         ms = owConvPoll(portnum,owConvTime(portnum,SerialNum,0) * 3 / 4,
+                         TEMP_MAX_MS);
+         if (ms < 0)
+            continue;
+         owConvSetTime(portnum,SerialNum,ms);
+         owTxnInit(&txn);
+      }
+      else
+      {
+         // convert with power delivery for the time the resolution needs
+         pwr = owTxnPower(&txn,0x44);
+         owTxnDelay(&txn,owConvTime(portnum,SerialNum,TEMP_MAX_MS));
+      }
 
-         // sleep for 1 second
-         msDelay(1000);
+      // select again and read the scratchpad and crc8
+      owTxnReset(&txn);
+      owTxnMatchROM(&txn,SerialNum);
+      owTxnWrite(&txn,&cmd,1);
+      rd = owTxnRead(&txn,9,OWTXN_CRC8);
 
-         // turn off the 1-Wire Net strong pull-up
-         if (owLevel(portnum,MODE_NORMAL) != MODE_NORMAL)
+      if (!owTxnExecute(portnum,&txn))
+      {
+         // the strong pull-up could not be used or turned off
+         if ((pwr >= 0) && (owTxnStatus(&txn,pwr) == OWTXN_LINK_ERROR))
             return FALSE;
+         continue;
+      }
+
+      data = owTxnData(&txn,rd,&len);
+
+      // learn the time of the resolution for the next parasite conversion
+      if ((power != OWCONV_EXTERNAL) && (SerialNum[0] != 0x10))
+         owConvSetTime(portnum,SerialNum,ConvertTime(SerialNum[0],data[4]));
+
+      i = ScratchTemp(SerialNum[0],data,loop,&tmp);
+      if (i == TEMP_RETRY)
+         continue;
+      if (i != TEMP_OK)
+         return FALSE;
+
+      *Temp = tmp;
+      // success
+      return TRUE;
+   }
+
+   return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Read the temperature of every DS1920/DS1820/DS18B20 in 'readings'.
+// All of the sensors are started with one Skip ROM Convert T (with the
+// strong pull-up), the wait is done once for the slowest configured
+// resolution and then the scratchpads are read with owTxnPipeline,
+// TEMP_PIPE reset, MATCH ROM and read scratchpad transactions at a time.
+//
+// 'portnum'     - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                 OpenCOM to indicate the port number.
+// 'readings'    - array of devices to read, 'SerialNum' must be set by
+//                 the caller and 'Config' should be left from the last
+//                 sweep (0 the first time).  'Temp' and 'Status' are
+//                 filled in for each device.
+// 'num'         - number of entries in 'readings'
+//
+// Returns: number of devices with Status TEMP_OK
+//
+int ReadTemperatureAll(int portnum, TempReading *readings, int num)
+{
+   OWTxn txn[TEMP_PIPE], *list[TEMP_PIPE];
+   int which[TEMP_PIPE];
+   uchar cmd = 0xBE, *scratch;
+   int i, j, k, m, n, rd = 0, len, loop, wait, good=0;
 
-         // access the device
-         if (owAccess(portnum))
+   for (i = 0; i < num; i++)
+      readings[i].Status = TEMP_RETRY;
+
+   for (loop = 0; loop < 2; loop++)
+   {
+      // wait for the slowest device left to read
+      wait = 0;
+      for (i = 0; i < num; i++)
+      {
+         m = ConvertTime(readings[i].SerialNum[0],readings[i].Config);
+         if ((readings[i].Status == TEMP_RETRY) && (m > wait))
+            wait = m;
+      }
+      if (wait == 0)
+         break;
+
+      // convert again like ReadTemperature if it failed the first time
+      if (!ConvertTemperatureAll(portnum,wait))
+         continue;
+
+      for (i = 0; i < num; i += n)
+      {
+         // reset, match ROM and read scratchpad of a group of devices, 
+         // sent back to back with owTxnPipeline
+         for (n = 0, j = 0; ((i + n) < num) && (j < TEMP_PIPE); n++)
          {
-            // create a block to send that reads the temperature
-            // read scratchpad command
-            send_cnt = 0;
-            send_block[send_cnt++] = 0xBE;
-            // now add the read bytes for data bytes and crc8
-            for (i = 0; i < 9; i++)
-               send_block[send_cnt++] = 0xFF;
-
-            // now send the block
-            if (owBlock(portnum,FALSE,send_block,send_cnt))
+            if (readings[i + n].Status != TEMP_RETRY)
+               continue;
+
+            owTxnInit(&txn[j]);
+            owTxnReset(&txn[j]);
+            owTxnMatchROM(&txn[j],readings[i + n].SerialNum);
+            owTxnWrite(&txn[j],&cmd,1);
+            rd = owTxnRead(&txn[j],9,OWTXN_CRC8);
+            which[j] = i + n;
+            list[j] = &txn[j];
+            j++;
+         }
+         if (j == 0)
+            continue;
+
+         owTxnPipeline(portnum,list,j);
+
+         for (k = 0; k < j; k++)
+         {
+            TempReading *tr = &readings[which[k]];
+
+            scratch = owTxnData(&txn[k],rd,&len);
+            switch (owTxnStatus(&txn[k],rd))
             {
-               // initialize the CRC8 
-               setcrc8(portnum,0);
-               // perform the CRC8 on the last 8 bytes of packet
-               for (i = send_cnt - 9; i < send_cnt; i++)
-                  lastcrc8 = docrc8(portnum,send_block[i]);
-
-               // verify CRC8 is correct
-               if (lastcrc8 == 0x00)
-               {
-                 if (SerialNum[0] == 0x28) {
-
-                   tsht = send_block[1];
-                   tsht |= send_block[2] << 8;
-
-                   if (send_block[2] & 0x80) {
-
-                     tsht ^= 0xffff;
-                     tsht++;
-                     tsht = -tsht;
-
-                   }
-
-                   tmp = tsht / 16.0;
-                 }
-                 else {
-                  // calculate the high-res temperature
-                  tsht = send_block[1]/2;
-                  if (send_block[2] & 0x01)
-                     tsht |= -128;
-                  tmp = (float)(tsht);
-                  cr = send_block[7];
-                  cpc = send_block[8];
-                  if (((cpc - cr) == 1) && (loop == 0))
-                     continue;
-                  if (cpc == 0)
-                     return FALSE;
-                  else
-                     tmp = tmp - (float)0.25 + (cpc - cr)/cpc;
-                 }
-
-                  *Temp = tmp;
-                  // success
-                  rt = TRUE;
+               case OWTXN_OK:
                   break;
-               }
+               case OWTXN_CRC_ERROR:
+                  // nobody answered the match
+                  for (m = 0; m < len; m++)
+                     if (scratch[m] != 0xFF)
+                        break;
+                  tr->Status = (m == len) ? TEMP_NO_DEVICE : TEMP_CRC_ERROR;
+                  continue;
+               default:
+                  tr->Status = TEMP_NO_DEVICE;
+                  continue;
             }
+
+            // remember the resolution for the next sweep
+            if (tr->SerialNum[0] != 0x10)
+               tr->Config = scratch[4];
+
+            tr->Status = ScratchTemp(tr->SerialNum[0],scratch,loop,&tr->Temp);
+            if (tr->Status == TEMP_OK)
+               good++;
          }
       }
+   }
+
+   // anything not read is an error
+   for (i = 0; i < num; i++)
+      if (readings[i].Status == TEMP_RETRY)
+         readings[i].Status = TEMP_READ_ERROR;
+
+   return good;
+}
+
+//----------------------------------------------------------------------
+// Start a conversion on every DS1920/DS1820/DS18B20 with one Skip ROM
+// Convert T and wait for it.  With no parasite powered device on the
+// bus the end of the conversions is polled, otherwise the strong
+// pull-up is held for 'wait'.
+//
+// 'portnum'     - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                 OpenCOM to indicate the port number.
+// 'wait'        - conversion time of the slowest device (ms)
+//
+// Returns: TRUE(1)  conversions done
+//          FALSE(0) no device on the bus, the pull-up failed or the
+//                   polled conversions did not finish in 'wait'
+//
+int ConvertTemperatureAll(int portnum, int wait)
+{
+   SMALLINT polled;
+
+   // with no parasite powered device on the bus the end of the
+   // conversions can be polled instead of waiting the worst case
+   polled = (owConvReadPower(portnum,NULL) == OWCONV_EXTERNAL);
+
+   // Skip ROM and Convert T on every device
+   if (!owTouchReset(portnum))
+   {
+      OWERROR(OWERROR_NO_DEVICES_ON_NET);
+      return FALSE;
+   }
+   if (!owWriteByte(portnum,0xCC))
+      return FALSE;
+
+   if (polled)
+   {
+      // every device holds the read time slots low until it is done
+      if (!owWriteByte(portnum,0x44))
+         return FALSE;
+      if (owConvPoll(portnum,0,wait) < 0)
+      {
+         OWERROR(OWERROR_CONVERSION_TIMEOUT);
+         return FALSE;
+      }
+   }
+   else
+   {
+      // start power delivery and wait for the slowest device
+      if (!owWriteBytePower(portnum,0x44))
+         return FALSE;
+
+      msDelay(wait);
 
+      // turn off the 1-Wire Net strong pull-up
+      if (owLevel(portnum,MODE_NORMAL) != MODE_NORMAL)
+         return FALSE;
    }
 
-   // return the result flag rt
-   return rt;
+   return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Read the temperature left in the scratchpad by the last conversion
+// of a DS1920/DS1820/DS18B20 without starting a new one.
+//
+// 'portnum'     - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                 OpenCOM to indicate the port number.
+// 'SerialNum'   - Serial Number of the device to read
+// 'Temp '       - pointer to variable where that temperature will be
+//                 returned
+//
+// Returns: TRUE(1)  temperature has been read and verified
+//          FALSE(0) could not read the temperature or the device has
+//                   not converted since power on
+//
+int ReadLastTemperature(int portnum, uchar *SerialNum, float *Temp)
+{
+   OWTxn txn;
+   uchar cmd = 0xBE;
+   int rd, len;
+
+   owTxnInit(&txn);
+   owTxnReset(&txn);
+   owTxnMatchROM(&txn,SerialNum);
+   owTxnWrite(&txn,&cmd,1);
+   rd = owTxnRead(&txn,9,OWTXN_CRC8);
+
+   if (!owTxnExecute(portnum,&txn))
+      return FALSE;
+
+   return (ScratchTemp(SerialNum[0],owTxnData(&txn,rd,&len),0,Temp) == TEMP_OK);
+}
+
+//----------------------------------------------------------------------
+// Calculate the temperature from a scratchpad.
+//
+// 'family'      - family code of the device
+// 'scratch'     - the 9 scratchpad bytes (CRC already checked)
+// 'loop'        - conversion attempt number (0 first)
+// 'Temp '       - pointer to variable where that temperature will be
+//                 returned
+//
+// Returns: TEMP_OK         temperature calculated
+//          TEMP_RETRY      DS1820 power on value, convert again
+//          TEMP_READ_ERROR invalid count per degree
+//
+static int ScratchTemp(uchar family, uchar *scratch, int loop, float *Temp)
+{
+   int tsht;
+   float tmp,cr,cpc;
+
+   if (family == 0x28)
+   {
+      tsht = scratch[0];
+      tsht |= scratch[1] << 8;
+
+      if (scratch[1] & 0x80)
+      {
+         tsht ^= 0xffff;
+         tsht++;
+         tsht = -tsht;
+      }
+
+      tmp = tsht / 16.0;
+   }
+   else
+   {
+      // calculate the high-res temperature
+      tsht = scratch[0]/2;
+      if (scratch[1] & 0x01)
+         tsht |= -128;
+      tmp = (float)(tsht);
+      cr = scratch[6];
+      cpc = scratch[7];
+      if (((cpc - cr) == 1) && (loop == 0))
+         return TEMP_RETRY;
+      if (cpc == 0)
+         return TEMP_READ_ERROR;
+      else
+         tmp = tmp - (float)0.25 + (cpc - cr)/cpc;
+   }
+
+   *Temp = tmp;
+   return TEMP_OK;
+}
+
+//----------------------------------------------------------------------
+// Conversion time in milliseconds for a device.  The DS18B20 time
+// depends on the resolution in its configuration register, an unknown
+// configuration is taken as 12 bits.
+//
+// 'family'      - family code of the device
+// 'config'      - configuration register (0 unknown)
+//
+// Returns: milliseconds to wait after Convert T
+//
+static int ConvertTime(uchar family, uchar config)
+{
+   if (family == 0x10)
+      return TEMP_MAX_MS;
+
+   if (config == 0)
+      return 750;
+
+   // 94, 188, 375 or 750 ms for 9 to 12 bits
+   return 94 << ((config >> 5) & 0x03);
 }
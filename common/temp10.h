@@ -26,8 +26,30 @@
 //
 //  temp10.h - Header to read the DS1920/DS1820 - temperature measurement.
 //
-//  Version: 2.00
+//  Version: 2.02
+//
+//  History: 2.00 -> 2.01  Added ReadTemperatureAll bus sweep.
+//           2.01 -> 2.02  Added ConvertTemperatureAll and
+//                         ReadLastTemperature.
 //
 // ---------------------------------------------------------------------------
 
+// status of a TempReading
+#define TEMP_OK             0
+#define TEMP_NO_DEVICE      1
+#define TEMP_CRC_ERROR      2
+#define TEMP_READ_ERROR     3
+
+// one device of a ReadTemperatureAll sweep
+typedef struct
+{
+   uchar SerialNum[8];   // ROM of the DS1920/DS1820/DS18B20 (set by caller)
+   uchar Config;         // last configuration register read (0 unknown)
+   float Temp;           // temperature in degrees C when Status == TEMP_OK
+   int   Status;         // TEMP_OK or TEMP_xxx error
+} TempReading;
+
 int ReadTemperature(int,uchar *,float *);
+int ReadTemperatureAll(int,TempReading *,int);
+int ConvertTemperatureAll(int,int);
+int ReadLastTemperature(int,uchar *,float *);
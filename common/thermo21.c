@@ -26,14 +26,16 @@
 //
 //  thermo21.c - Thermochron iButton utility functions 
 //
-//  Version: 2.00
+//  Version: 2.01
 //    
 //    History:
 //           1.03 -> 2.00  Reorganization of Public Domain Kit 
 //                         Convert to global CRC utility functions
 //                         Y2K fix.
+//           2.00 -> 2.01  current_speed moved to the OWPort state
 
 #include "ownet.h"
+#include "owport.h"
 #include "thermo21.h"   
 #include <time.h>
 #include <stdio.h>
@@ -53,9 +55,6 @@ static int WriteScratch(int,uchar *,int,int);
 static int CopyScratch(int,int,int);
 static int WriteMemory(int,uchar *, int, int);
 
-// global state information
-static int current_speed[MAX_PORTNUM];
-
 
 //--------------------------------------------------------------------------
 // The 'DownloadThermo' downloads the specified Thermochron in 'SerialNum'
@@ -434,7 +433,7 @@ int ReadPages(int portnum, int start_pg, int num_pgs, int *last_pg, uchar *final
 
 #ifndef __MC68K__
    // verify device is in overdrive
-   if (current_speed[portnum] == MODE_OVERDRIVE)
+   if (owGetPort(portnum)->ThermoSpeed == MODE_OVERDRIVE)
    {
       if (owVerify(portnum,FALSE)) 
          skip_overaccess = 1;
@@ -443,9 +442,9 @@ int ReadPages(int portnum, int start_pg, int num_pgs, int *last_pg, uchar *final
    if (!skip_overaccess)
    {
       if (owOverdriveAccess(portnum))
-         current_speed[portnum] = MODE_OVERDRIVE;
+         owGetPort(portnum)->ThermoSpeed = MODE_OVERDRIVE;
       else
-         current_speed[portnum] = MODE_NORMAL;
+         owGetPort(portnum)->ThermoSpeed = MODE_NORMAL;
    }
 #endif
 
@@ -454,7 +453,7 @@ int ReadPages(int portnum, int start_pg, int num_pgs, int *last_pg, uchar *final
    {
       // create a packet to read a page
       len = 0;
-      setcrc16(portnum,0);
+      lastcrc16 = 0;
       // optional skip access on subsequent pages 
       if (!skip_access)
       {  
@@ -464,13 +463,11 @@ int ReadPages(int portnum, int start_pg, int num_pgs, int *last_pg, uchar *final
          for (i = 0; i < 8; i++)
             pkt[len++] = SerialNumber[i];
          // read memory with crc command 
-         pkt[len] = 0xA5; 
-         lastcrc16 = docrc16(portnum,pkt[len++]);         
+         pkt[len++] = 0xA5; 
          // address
-         pkt[len] = (uchar)((*last_pg << 5) & 0xFF);
-         lastcrc16 = docrc16(portnum,pkt[len++]);         
-         pkt[len] = (uchar)(*last_pg >> 3); 
-         lastcrc16 = docrc16(portnum,pkt[len++]);         
+         pkt[len++] = (uchar)((*last_pg << 5) & 0xFF);
+         pkt[len++] = (uchar)(*last_pg >> 3); 
+         lastcrc16 = crc16_block(0,&pkt[len - 3],3);
       }
 
       // set 32 reads for data and 2 for crc
@@ -481,8 +478,7 @@ int ReadPages(int portnum, int start_pg, int num_pgs, int *last_pg, uchar *final
       if (owBlock(portnum,!skip_access,pkt,len))
       {
          // calucate the CRC over the last 34 bytes
-         for (i = 0; i < 34; i++)
-            lastcrc16 = docrc16(portnum,pkt[len - 34 + i]);
+         lastcrc16 = crc16_block(lastcrc16,&pkt[len - 34],34);
 
          // check crc
          if (lastcrc16 == 0xB001)
@@ -54,6 +54,7 @@ SMALLINT getRTC(int, uchar *, timedate *);
 SMALLINT getRTCA(int, uchar *, timedate *);
 SMALLINT getControlRegisterBit(int, uchar *, int, SMALLINT *);
 SMALLINT getStatusRegisterBit(int, uchar *, int, SMALLINT *);
+SMALLINT getStatusRegister(int, uchar *, uchar *);
 
 // The "setters"
 SMALLINT setRTC(int, uchar *, ulong, SMALLINT);
@@ -253,6 +254,27 @@ SMALLINT getStatusRegisterBit(int portnum, uchar * SNum, int statusbit, SMALLINT
    return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Retrieves the whole status register of the 1-Wire clock.  Reading it
+// clears the alarm indicators (CCF, ITF and RTF) so they are all
+// returned from the one read.
+//
+// Parameters:
+//  portnum      The port number of the port being used for the
+//               1-Wire network.
+//  SNum         The 1-Wire address of the device with which to communicate.
+//  * status     A pointer to receive the status register.
+//
+// Returns:      TRUE  if the read worked.
+//               FALSE if there was an error in reading the status register.
+//
+SMALLINT getStatusRegister(int portnum, uchar * SNum, uchar * status)
+{
+   // read the status register from 1-Wire clock device (memory bank 2) 
+   // at address 0x00.
+   return readNV(2, portnum, SNum, 0x00, FALSE, status, 1);
+}
+
 //----------------------------------------------------------------------
 // Sets the Real-Time clock (RTC) of the 1-Wire device from the 
 // input parameter settime.  The settime parameter should be the 
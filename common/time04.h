@@ -66,6 +66,7 @@ SMALLINT getRTC(int, uchar *, timedate *);
 SMALLINT getRTCA(int, uchar *, timedate *);
 SMALLINT getControlRegisterBit(int, uchar *, int, SMALLINT *);
 SMALLINT getStatusRegisterBit(int, uchar *, int, SMALLINT *);
+SMALLINT getStatusRegister(int, uchar *, uchar *);
 
 // The "setters" functions
 SMALLINT setRTC(int, uchar *, ulong, SMALLINT);
@@ -28,8 +28,11 @@
 //              There are also modules to find the direction of the weather
 //              station and read/write output files
 //
-//  Version: 2.00
+//  Version: 2.01
 //
+//  History: 2.00 -> 2.01  FindSetupWeather finds the DS1820, DS2450 and
+//                         DS2423 with one owInvScan instead of a search
+//                         for each family.
 //
 // --------------------------------------------------------------------------
 
@@ -40,6 +43,7 @@
 #include "ownet.h"
 #include "swt12.h"
 #include "findtype.h"
+#include "owinv.h"
 #include "weather.h"
 #include "atod20.h"
 #include "temp10.h"
@@ -124,8 +128,11 @@ int FindSetupWeather(int portnum, WeatherStruct *wet)
 
       // Create ini.txt if weather station has DS2450
 
+      // one search for the three families
+      owInvScan(portnum);
+
       // find the DS1820 temperature
-      num = FindDevices(portnum, &temp[0], TEMP_FAMILY, MAXTEMPS);
+      num = owInvFamily(portnum, TEMP_FAMILY, &temp[0], MAXTEMPS);
 
       // check if not at least 1 temperature device
       if(num == 0)
@@ -138,7 +145,7 @@ int FindSetupWeather(int portnum, WeatherStruct *wet)
       }
 
       // find the DS2450 switch
-      num = FindDevices(portnum, &temp[0], ATOD_FAMILY, MAXATOD);
+      num = owInvFamily(portnum, ATOD_FAMILY, &temp[0], MAXATOD);
 
       // check if not at least 1 switch device
       if(num == 0)
@@ -151,7 +158,7 @@ int FindSetupWeather(int portnum, WeatherStruct *wet)
       }
 
       // find the DS2423 switch
-      num = FindDevices(portnum, &temp[0], COUNT_FAMILY, MAXCOUNT);
+      num = owInvFamily(portnum, COUNT_FAMILY, &temp[0], MAXCOUNT);
 
       // check if not at least 1 count device
       if(num == 0)
@@ -27,13 +27,14 @@
 //  OWMLNK.C - Link Layer functions for the 1-Wire Master (OWM) on the
 //               DS80C400 microcontroller.
 //
-//  Version: 1.00
+//  Version: 1.01
 //
-//  History: 
+//  History: 1.00 -> 1.01  owTouchReset ends the owsess.c session
 //
 
 #include <reg400.h>
 #include "ownet.h"
+#include "owsess.h"
 #include "owm.h"          // 1-Wire Master defines
 
 // exportable link-level functions
@@ -71,6 +72,9 @@ SMALLINT owTouchReset(int portnum)
    uchar result;
    portnum = 0;
 
+   // a reset deselects the device of the session
+   owSessionEnd(portnum);
+
    // Perform a 1-Wire reset
    OWMAD = OWM_COMMAND;
    OWMDR = OWM_1WR_MASK;
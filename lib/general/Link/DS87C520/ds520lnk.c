@@ -27,13 +27,14 @@
 //  DS520LNK.C - Link Layer functions required by general 1-Wire drive
 //           implementation for DS80C520 microcontroller.
 //
-//  Version: 2.00
+//  Version: 3.01
 //
 //  History: 1.00 -> 1.01  Added function msDelay.
 //           1.02 -> 1.03  Added function msGettick.
 //           1.03 -> 2.00  Changed 'MLan' to 'ow'. Added support for
 //                         multiple ports.
 //           2.10 -> 3.00  Added owReadBitPower and owWriteBytePower
+//           3.00 -> 3.01  owTouchReset ends the owsess.c session
 //
 
 // -- Keil c51 control directives
@@ -44,6 +45,7 @@
 // -- End directives
 
 #include "ownet.h"
+#include "owsess.h"
 #include <ds8xc520.h>
 #include <intrins.h>
 
@@ -90,6 +92,9 @@ SMALLINT owTouchReset(int portnum)
    uchar result;
    portnum = 0;
 
+   // a reset deselects the device of the session
+   owSessionEnd(portnum);
+
    // Code from appnote 126.
    OW_PORT = 0; // drive bus low.
    usDelay(500); // 500-(3% error) ~= 480 us
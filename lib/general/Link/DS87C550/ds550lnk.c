@@ -27,7 +27,7 @@
 //  DS550LNK.C - Link Layer functions required by general 1-Wire drive
 //           implementation for DS80C550 microcontroller.
 //
-//  Version: 2.00
+//  Version: 3.01
 //
 //  History: 1.00 -> 1.01  Added function msDelay.
 //           1.02 -> 1.03  Added function msGettick.
@@ -35,6 +35,7 @@
 //                         multiple ports.
 //
 //           2.10 -> 3.00  Added owReadBitPower and owWriteBytePower
+//           3.00 -> 3.01  owTouchReset ends the owsess.c session
 
 // -- Keil c51 control directives
 // Using inline assembly means we have to dump the output of the entire file to
@@ -44,6 +45,7 @@
 // -- End directives
 
 #include "ownet.h"
+#include "owsess.h"
 #include "ser550.h"
 
 // exportable link-level functions
@@ -83,6 +85,9 @@ SMALLINT owTouchReset(int portnum)
    uchar result;
    portnum = 0;
 
+   // a reset deselects the device of the session
+   owSessionEnd(portnum);
+
    // Code from appnote 126.
    OW_PORT = 0; // drive bus low.
    usDelay(500); // 500-(3% error) ~= 480 us
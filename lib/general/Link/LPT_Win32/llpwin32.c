@@ -27,13 +27,15 @@
 //  Win32P.C - Link Layer functions general 1-Wire driver
 //           implimentation for DS1410E/DS1410D parallel adapter.
 //
-//  Version: 3.00
+//  Version: 3.01
 //
 //  History: 2.00 -> 3.00 Added call to setup() before each low level call
 //                        to get base port address correct if multiple
 //                        ports open
+//           3.00 -> 3.01 owTouchReset ends the owsess.c session
  
 #include "ownet.h"
+#include "owsess.h"
 #include <windows.h>
 #include "sacwd32.h"
 
@@ -81,6 +83,9 @@ SMALLINT owTouchReset(int portnum)
 {
    int rt;
 
+   // a reset deselects the device of the session
+   owSessionEnd(portnum);
+
    // make sure normal level
    owLevel(portnum,MODE_NORMAL);
 
@@ -28,7 +28,7 @@
 //              excersize the general 1-Wire Net functions.
 //              (Requires TMEX 3.11 or newer)
 //
-//  Version: 3.00
+//  Version: 3.01
 //
 //  History: 1.00 -> 1.01  Return values in owLevel corrected.
 //                         Added function msDelay.
@@ -38,8 +38,10 @@
 //           1.03 -> 2.00  Changed 'MLan' to 'ow'. Added support for
 //                         multiple ports.
 //           2.10 -> 3.00  Added owReadBitPower and owWriteBytePower
+//           3.00 -> 3.01  owTouchReset ends the owsess.c session
 
 #include "ownet.h"
+#include "owsess.h"
 #include <windows.h>
 
 // external TMEX variables
@@ -68,6 +70,9 @@ SMALLINT owTouchReset(int portnum)
 {
    int result;
 
+   // a reset deselects the device of the session
+   owSessionEnd(portnum);
+
    // Assume valid Session
    result = TMTouchReset(SessionHandle[portnum]);
 
@@ -0,0 +1,166 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  ds2490.h - DS2490 constants and support functions for the libusb
+//             based Linux link (usbtran.c, usbnet.c).
+//
+//  Version: 3.00
+//
+
+#ifndef _ds2490linux_h_
+#define _ds2490linux_h_
+
+#include "ownet.h"
+
+// endpoints
+#define DS2490_EP_STATUS                  0x81
+#define DS2490_EP_WRITE                   0x02
+#define DS2490_EP_READ                    0x83
+
+// size of the EP2/EP3 FIFOs used per transfer
+#define DS2490_FIFO_CHUNK                 64
+
+// libusb timeout (ms)
+#define DS2490_TIMEOUT                    5000
+
+// Request byte, Command Type Code Constants
+#define CONTROL_CMD                       0x00
+#define COMM_CMD                          0x01
+#define MODE_CMD                          0x02
+#define TEST_CMD                          0x03
+
+// Control Command Code Constants
+#define CTL_RESET_DEVICE                  0x0000
+#define CTL_START_EXE                     0x0001
+#define CTL_RESUME_EXE                    0x0002
+#define CTL_HALT_EXE_IDLE                 0x0003
+#define CTL_HALT_EXE_DONE                 0x0004
+#define CTL_FLUSH_COMM_CMDS               0x0007
+#define CTL_FLUSH_RCV_BUFFER              0x0008
+#define CTL_FLUSH_XMT_BUFFER              0x0009
+
+// COMM Bits (bitwise or into COMM commands to build full value byte pairs)
+// Byte 1
+#define COMM_TYPE                         0x0008
+#define COMM_SE                           0x0008
+#define COMM_D                            0x0008
+#define COMM_Z                            0x0008
+#define COMM_CH                           0x0008
+#define COMM_SM                           0x0008
+#define COMM_R                            0x0008
+#define COMM_IM                           0x0001
+
+// Byte 2
+#define COMM_PS                           0x4000
+#define COMM_PST                          0x4000
+#define COMM_CIB                          0x4000
+#define COMM_RTS                          0x4000
+#define COMM_DT                           0x2000
+#define COMM_SPU                          0x1000
+#define COMM_F                            0x0800
+#define COMM_ICP                          0x0200
+#define COMM_RST                          0x0100
+
+// Read Straight command, special bits
+#define COMM_READ_STRAIGHT_NTF            0x0008
+#define COMM_READ_STRAIGHT_ICP            0x0004
+#define COMM_READ_STRAIGHT_RST            0x0002
+#define COMM_READ_STRAIGHT_IM             0x0001
+
+// Value field COMM Command options (0-F plus assorted bits)
+#define COMM_ERROR_ESCAPE                 0x0601
+#define COMM_SET_DURATION                 0x0012
+#define COMM_BIT_IO                       0x0020
+#define COMM_PULSE                        0x0030
+#define COMM_1_WIRE_RESET                 0x0042
+#define COMM_BYTE_IO                      0x0052
+#define COMM_MATCH_ACCESS                 0x0064
+#define COMM_BLOCK_IO                     0x0074
+#define COMM_READ_STRAIGHT                0x0080
+#define COMM_DO_RELEASE                   0x6092
+#define COMM_SET_PATH                     0x00A2
+#define COMM_WRITE_SRAM_PAGE              0x00B2
+#define COMM_WRITE_EPROM                  0x00C4
+#define COMM_READ_CRC_PROT_PAGE           0x00D4
+#define COMM_READ_REDIRECT_PAGE_CRC       0x21E4
+#define COMM_SEARCH_ACCESS                0x00F4
+
+// Mode Command Code Constants
+#define MOD_PULSE_EN                      0x0000
+#define MOD_SPEED_CHANGE_EN               0x0001
+#define MOD_1WIRE_SPEED                   0x0002
+
+// Device Status Flags
+#define STATUSFLAGS_SPUA                  0x01
+#define STATUSFLAGS_PRGA                  0x02
+#define STATUSFLAGS_12VP                  0x04
+#define STATUSFLAGS_PMOD                  0x08
+#define STATUSFLAGS_HALT                  0x10
+#define STATUSFLAGS_IDLE                  0x20
+
+// Result Registers
+#define ONEWIREDEVICEDETECT               0xA5
+#define COMMCMDERRORRESULT_NRS            0x01
+#define COMMCMDERRORRESULT_SH             0x02
+#define COMMCMDERRORRESULT_APP            0x04
+#define COMMCMDERRORRESULT_VPP            0x08
+#define COMMCMDERRORRESULT_CMP            0x10
+#define COMMCMDERRORRESULT_CRC            0x20
+#define COMMCMDERRORRESULT_RDP            0x40
+#define COMMCMDERRORRESULT_EOS            0x80
+
+// status packet as read from EP1
+typedef struct
+{
+   uchar EnableFlags;
+   uchar OneWireSpeed;
+   uchar StrongPullUpDuration;
+   uchar ProgPulseDuration;
+   uchar PullDownSlewRate;
+   uchar Write1LowTime;
+   uchar DSOW0RecoveryTime;
+   uchar Reserved1;
+   uchar StatusFlags;
+   uchar CurrentCommCmd1;
+   uchar CurrentCommCmd2;
+   uchar CommBufferStatus;
+   uchar WriteBufferStatus;
+   uchar ReadBufferStatus;
+   uchar Reserved2;
+   uchar Reserved3;
+   uchar CommResultCodes[16];
+} STATUS_PACKET;
+
+// support functions in usbtran.c
+SMALLINT DS2490Command(int portnum, int request, int value, int index);
+SMALLINT DS2490GetStatus(int portnum, STATUS_PACKET *status, uchar *nresult);
+SMALLINT DS2490WaitIdle(int portnum, STATUS_PACKET *status, uchar *nresult);
+SMALLINT DS2490WaitRead(int portnum, int min_bytes);
+SMALLINT DS2490Write(int portnum, uchar *buf, int len);
+SMALLINT DS2490Read(int portnum, uchar *buf, int len);
+void     DS2490Recover(int portnum);
+
+#endif
@@ -25,12 +25,16 @@
 //
 //  usb_drv.c - General 1-Wire link layer for the DS2490 on Linux 
 //
-//  Version: 3.00B
+//  Version: 3.01
+//
+//  History: 3.00B -> 3.01  owTouchReset ends the owsess.c session
 // 
 
 #include "ownet.h"
+#include "owsess.h"
 #include "usb.h"
 #include <errno.h>
+#include <time.h>
 
 #define CONTROL_CMD	0x00
 #define COMM_CMD	0x01
@@ -76,6 +80,9 @@ int owTouchReset(int portnum)
 	int result; 
 	unsigned char buffer[0x20];
 
+	/* a reset deselects the device of the session */
+	owSessionEnd(portnum);
+
 	/* issue the 1-wire reset */
 	result = usb_control_msg(usb_dev_handle_list[portnum], 0x40,
 			COMM_CMD, 0x0043, 0x0000, NULL, 0x0, TIMEOUT_VALUE);
@@ -329,9 +336,17 @@ void msDelay(int len)
 {
    struct timespec s;              // Set aside memory space on the stack
 
-   s.tv_sec = len / 1000;
-   s.tv_nsec = (len - (s.tv_sec * 1000)) * 1000000;
-   nanosleep(&s, NULL);
+   // sleep to an absolute time so a signal does not cut the delay short
+   clock_gettime(CLOCK_MONOTONIC, &s);
+   s.tv_sec += len / 1000;
+   s.tv_nsec += (len % 1000) * 1000000;
+   if (s.tv_nsec >= 1000000000)
+   {
+      s.tv_sec++;
+      s.tv_nsec -= 1000000000;
+   }
+   while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &s, NULL) == EINTR)
+      ;
 }
 
 //--------------------------------------------------------------------------
@@ -340,13 +355,11 @@ void msDelay(int len)
 //
 long msGettick(void)
 {
-   struct timezone tmzone;
-   struct timeval  tmval;
-   long ms;
+   struct timespec ts;
 
-   gettimeofday(&tmval,&tmzone);
-   ms = (tmval.tv_sec & 0xFFFF) * 1000 + tmval.tv_usec / 1000;
-   return ms;
+   // the monotonic clock does not jump with the time of day or wrap
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
 //--------------------------------------------------------------------------
@@ -0,0 +1,609 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  usbnet.c - Network functions for the libusb Linux DS2490 link.
+//              Replaces lib/general/ownet.c when building with usblnk.c.
+//              owFirst/owNext use the DS2490 SEARCH_ACCESS command and
+//              owAccess uses MATCH_ACCESS so a search step or a device
+//              select is one adapter command instead of bit-by-bit I/O.
+//
+//  Version: 3.02
+//
+//  History: 3.00 -> 3.01  Search state moved to the OWPort state so port
+//                         numbers past MAX_PORTNUM can be used
+//           3.01 -> 3.02  owNext, owSearchAll, owAccess, owVerify and
+//                         owOverdriveAccess end the owsess.c session
+//
+
+#include <stdio.h>
+#include "ownet.h"
+#include "owport.h"
+#include "owsess.h"
+#include "ds2490.h"
+
+// exportable functions defined in usbnet.c
+SMALLINT bitacc(SMALLINT,SMALLINT,SMALLINT,uchar *);
+
+//--------------------------------------------------------------------------
+// The 'owFirst' finds the first device on the 1-Wire Net  This function
+// contains one parameter 'alarm_only'.  When
+// 'alarm_only' is TRUE (1) the find alarm command 0xEC is
+// sent instead of the normal search command 0xF0.
+// Using the find alarm command 0xEC will limit the search to only
+// 1-Wire devices that are in an 'alarm' state.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'do_reset'   - TRUE (1) perform reset before search, FALSE (0) do not
+//                perform reset before search.
+// 'alarm_only' - TRUE (1) the find alarm command 0xEC is
+//                sent instead of the normal search command 0xF0
+//
+// Returns:   TRUE (1) : when a 1-Wire device was found and it's
+//                        Serial Number placed in the global SerialNum[portnum]
+//            FALSE (0): There are no devices on the 1-Wire Net.
+//
+SMALLINT owFirst(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
+{
+   OWPort *port = owGetPort(portnum);
+
+   // reset the search state
+   port->LastDiscrepancy = 0;
+   port->LastDevice = FALSE;
+   port->LastFamilyDiscrepancy = 0;
+
+   return owNext(portnum,do_reset,alarm_only);
+}
+
+//--------------------------------------------------------------------------
+// The 'owNext' function does a general search.  This function
+// continues from the previos search state. The search state
+// can be reset by using the 'owFirst' function.
+// This function contains one parameter 'alarm_only'.
+// When 'alarm_only' is TRUE (1) the find alarm command
+// 0xEC is sent instead of the normal search command 0xF0.
+// Using the find alarm command 0xEC will limit the search to only
+// 1-Wire devices that are in an 'alarm' state.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'do_reset'   - TRUE (1) perform reset before search, FALSE (0) do not
+//                perform reset before search.
+// 'alarm_only' - TRUE (1) the find alarm command 0xEC is
+//                sent instead of the normal search command 0xF0
+//
+// Returns:   TRUE (1) : when a 1-Wire device was found and it's
+//                       Serial Number placed in the global SerialNum[portnum]
+//            FALSE (0): when no new device was found.  Either the
+//                       last search was the last device or there
+//                       are no devices on the 1-Wire Net.
+//
+SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
+{
+   OWPort *port = owGetPort(portnum);
+   STATUS_PACKET status;
+   uchar rom_buf[16];
+   uchar nresult,lastcrc8=0;
+   int i,value,len;
+
+   // a search deselects the device of the session
+   owSessionEnd(portnum);
+
+   // if the last call was the last one
+   if (port->LastDevice)
+   {
+      // reset the search
+      port->LastDiscrepancy = 0;
+      port->LastDevice = FALSE;
+      port->LastFamilyDiscrepancy = 0;
+      return FALSE;
+   }
+
+   // extra reset if last part was a DS1994/DS2404 (due to alarm)
+   if (do_reset && ((port->SerialNum[0] & 0x7F) == 0x04))
+      owTouchReset(portnum);
+
+   // build the ROM to follow up to the last discrepancy
+   for (i = 0; i < 8; i++)
+      rom_buf[i] = port->SerialNum[i];
+   if (port->LastDiscrepancy > 0)
+      bitacc(WRITE_FUNCTION,1,(SMALLINT)(port->LastDiscrepancy - 1),rom_buf);
+   for (i = port->LastDiscrepancy; i < 64; i++)
+      bitacc(WRITE_FUNCTION,0,(SMALLINT)i,rom_buf);
+
+   // put the ROM in EP2
+   if (!DS2490Write(portnum,rom_buf,8))
+   {
+      DS2490Recover(portnum);
+      return FALSE;
+   }
+
+   // search for one device, the reset is done by the DS2490 (RST)
+   value = COMM_SEARCH_ACCESS | COMM_IM | COMM_SM | COMM_F | COMM_RTS;
+   if (do_reset)
+      value |= COMM_RST;
+   if (!DS2490Command(portnum,COMM_CMD,value,0x0100 | ((alarm_only) ? 0xEC : 0xF0)))
+   {
+      DS2490Recover(portnum);
+      return FALSE;
+   }
+
+   // wait for the search to finish
+   if (!DS2490WaitIdle(portnum,&status,&nresult))
+   {
+      DS2490Recover(portnum);
+      return FALSE;
+   }
+
+   // no presence on the reset
+   for (i = 0; i < nresult; i++)
+   {
+      if ((status.CommResultCodes[i] != ONEWIREDEVICEDETECT) &&
+          (status.CommResultCodes[i] & COMMCMDERRORRESULT_NRS))
+      {
+         port->LastDiscrepancy = 0;
+         port->LastFamilyDiscrepancy = 0;
+         OWERROR(OWERROR_NO_DEVICES_ON_NET);
+         DS2490Recover(portnum);
+         return FALSE;
+      }
+   }
+
+   // ROM (8) and discrepancy bits (8) unless this was the last device
+   len = status.ReadBufferStatus;
+   if ((len != 8) && (len != 16))
+   {
+      if (len > 0)
+         DS2490Recover(portnum);
+      len = 0;
+   }
+   else if (!DS2490Read(portnum,rom_buf,len))
+   {
+      DS2490Recover(portnum);
+      len = 0;
+   }
+
+   if (len > 0)
+   {
+      // extract the ROM (and check crc)
+      setcrc8(portnum,0);
+      for (i = 0; i < 8; i++)
+      {
+         port->SerialNum[i] = rom_buf[i];
+         lastcrc8 = docrc8(portnum,rom_buf[i]);
+      }
+
+      // crc OK and family code is not 0
+      if (!lastcrc8 && port->SerialNum[0])
+      {
+         port->LastDiscrepancy = 0;
+         port->LastDevice = (len == 8);
+
+         // last discrepancy where the '0' path was taken
+         if (len == 16)
+         {
+            for (i = 0; i < 64; i++)
+            {
+               if (bitacc(READ_FUNCTION,0,(SMALLINT)i,&rom_buf[8]) &&
+                   !bitacc(READ_FUNCTION,0,(SMALLINT)i,&rom_buf[0]))
+               {
+                  port->LastDiscrepancy = i + 1;
+                  if (i < 8)
+                     port->LastFamilyDiscrepancy = i + 1;
+               }
+            }
+            port->LastDevice = (port->LastDiscrepancy == 0);
+         }
+
+         return TRUE;
+      }
+   }
+
+   // no device found so reset counters so next 'next' will be
+   // like a first
+   port->LastDiscrepancy = 0;
+   port->LastDevice = FALSE;
+   port->LastFamilyDiscrepancy = 0;
+
+   return FALSE;
+}
+
+//--------------------------------------------------------------------------
+// The 'owSearchAll' function finds every device on the 1-Wire Net (or
+// every device of one family) in one call.  A family search stops as
+// soon as the search leaves the family instead of walking the rest of
+// the 1-Wire Net.  The search state used by 'owNext' is reset and
+// SerialNum is left as the last device found.
+//
+// 'portnum'       - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                   indicate the symbolic port number.
+// 'ROMs'          - array to receive the serial numbers found
+// 'max'           - number of entries in 'ROMs'
+// 'search_family' - family code to limit the search to or 0 for all
+//                   devices
+// 'alarm_only'    - TRUE (1) the find alarm command 0xEC is
+//                   sent instead of the normal search command 0xF0
+//
+// Returns:   number of devices placed in 'ROMs'
+//
+int owSearchAll(int portnum, uchar ROMs[][8], int max, SMALLINT search_family,
+                SMALLINT alarm_only)
+{
+   OWPort *port = owGetPort(portnum);
+   SMALLINT rslt;
+   int found = 0;
+
+   if (max <= 0)
+      return 0;
+
+   // a search deselects the device of the session
+   owSessionEnd(portnum);
+
+   // start the search at the family or at the first device
+   if (search_family)
+   {
+      owFamilySearchSetup(portnum,search_family);
+      rslt = owNext(portnum,TRUE,alarm_only);
+   }
+   else
+      rslt = owFirst(portnum,TRUE,alarm_only);
+
+   while (rslt)
+   {
+      // stop when past the family
+      if (search_family && (port->SerialNum[0] != (uchar)search_family))
+         break;
+
+      owSerialNum(portnum,ROMs[found],TRUE);
+      if (++found >= max)
+         break;
+
+      rslt = owNext(portnum,TRUE,alarm_only);
+   }
+
+   // reset the search state
+   port->LastDiscrepancy = 0;
+   port->LastDevice = FALSE;
+   port->LastFamilyDiscrepancy = 0;
+   if (found > 0)
+      owSerialNum(portnum,ROMs[found - 1],FALSE);
+
+   return found;
+}
+
+//--------------------------------------------------------------------------
+// The 'owSerialNum' function either reads or sets the SerialNum buffer
+// that is used in the search functions 'owFirst' and 'owNext'.
+// This function contains two parameters, 'serialnum_buf' is a pointer
+// to a buffer provided by the caller.  'serialnum_buf' should point to
+// an array of 8 unsigned chars.  The second parameter is a flag called
+// 'do_read' that is TRUE (1) if the operation is to read and FALSE
+// (0) if the operation is to set the internal SerialNum buffer from
+// the data in the provided buffer.
+//
+// 'portnum'       - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                   indicate the symbolic port number.
+// 'serialnum_buf' - buffer to that contains the serial number to set
+//                   when do_read = FALSE (0) and buffer to get the serial
+//                   number when do_read = TRUE (1).
+// 'do_read'       - flag to indicate reading (1) or setting (0) the current
+//                   serial number.
+//
+void owSerialNum(int portnum, uchar *serialnum_buf, SMALLINT do_read)
+{
+   OWPort *port = owGetPort(portnum);
+   uchar i;
+
+   // read the internal buffer and place in 'serialnum_buf'
+   if (do_read)
+   {
+      for (i = 0; i < 8; i++)
+         serialnum_buf[i] = port->SerialNum[i];
+   }
+   // set the internal buffer from the data in 'serialnum_buf'
+   else
+   {
+      for (i = 0; i < 8; i++)
+         port->SerialNum[i] = serialnum_buf[i];
+   }
+}
+
+//--------------------------------------------------------------------------
+// Setup the search algorithm to find a certain family of devices
+// the next time a search function is called 'owNext'.
+//
+// 'portnum'       - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                   OpenCOM to indicate the port number.
+// 'search_family' - family code type to set the search algorithm to find
+//                   next.
+//
+void owFamilySearchSetup(int portnum, SMALLINT search_family)
+{
+   OWPort *port = owGetPort(portnum);
+   uchar i;
+
+   // set the search state to find SearchFamily type devices
+   port->SerialNum[0] = search_family;
+   for (i = 1; i < 8; i++)
+      port->SerialNum[i] = 0;
+   port->LastDiscrepancy = 64;
+   port->LastDevice = FALSE;
+}
+
+//--------------------------------------------------------------------------
+// Set the current search state to skip the current family code.
+//
+// 'portnum'     - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                 indicate the symbolic port number.
+//
+void owSkipFamily(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+
+   // set the Last discrepancy to last family discrepancy
+   port->LastDiscrepancy = port->LastFamilyDiscrepancy;
+   port->LastFamilyDiscrepancy = 0;
+
+   // check for end of list
+   if (port->LastDiscrepancy == 0)
+      port->LastDevice = TRUE;
+}
+
+//--------------------------------------------------------------------------
+// The 'owAccess' function resets the 1-Wire and sends a MATCH Serial
+// Number command followed by the current SerialNum code. After this
+// function is complete the 1-Wire device is ready to accept device-specific
+// commands.
+//
+// 'portnum'     - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                 indicate the symbolic port number.
+//
+// Returns:   TRUE (1) : reset indicates present and device is ready
+//                       for commands.
+//            FALSE (0): reset does not indicate presence or echos 'writes'
+//                       are not correct.
+//
+SMALLINT owAccess(int portnum)
+{
+   STATUS_PACKET status;
+   uchar nresult,i;
+
+   // this select ends the session
+   owSessionEnd(portnum);
+
+   // put the ROM in EP2
+   if (!DS2490Write(portnum,&owGetPort(portnum)->SerialNum[0],8))
+   {
+      DS2490Recover(portnum);
+      return FALSE;
+   }
+
+   // reset and MATCH ROM 0x55 in one command
+   if (!DS2490Command(portnum,COMM_CMD,COMM_MATCH_ACCESS | COMM_IM | COMM_RST,0x0055))
+   {
+      DS2490Recover(portnum);
+      return FALSE;
+   }
+
+   if (!DS2490WaitIdle(portnum,&status,&nresult))
+   {
+      DS2490Recover(portnum);
+      return FALSE;
+   }
+
+   // check for no presence
+   for (i = 0; i < nresult; i++)
+   {
+      if ((status.CommResultCodes[i] != ONEWIREDEVICEDETECT) &&
+          (status.CommResultCodes[i] & (COMMCMDERRORRESULT_NRS | COMMCMDERRORRESULT_SH)))
+      {
+         OWERROR(OWERROR_NO_DEVICES_ON_NET);
+         return FALSE;
+      }
+   }
+
+   return TRUE;
+}
+
+//----------------------------------------------------------------------
+// The function 'owVerify' verifies that the current device
+// is in contact with the 1-Wire Net.
+// Using the find alarm command 0xEC will verify that the device
+// is in contact with the 1-Wire Net and is in an 'alarm' state.
+//
+// 'portnum'     - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                 indicate the symbolic port number.
+// 'alarm_only'  - TRUE (1) the find alarm command 0xEC
+//                 is sent instead of the normal search
+//                 command 0xF0.
+//
+// Returns:   TRUE (1) : when the 1-Wire device was verified
+//                       to be on the 1-Wire Net
+//                       with alarm_only == FALSE
+//                       or verified to be on the 1-Wire Net
+//                       AND in an alarm state when
+//                       alarm_only == TRUE.
+//            FALSE (0): the 1-Wire device was not on the
+//                       1-Wire Net or if alarm_only
+//                       == TRUE, the device may be on the
+//                       1-Wire Net but in a non-alarm state.
+//
+SMALLINT owVerify(int portnum, SMALLINT alarm_only)
+{
+   OWPort *port = owGetPort(portnum);
+   uchar i,sendlen=0,goodbits=0,cnt=0,s,tst;
+   uchar sendpacket[50];
+
+   // this search ends the session
+   owSessionEnd(portnum);
+
+   // construct the search
+   if (alarm_only)
+      sendpacket[sendlen++] = 0xEC; // issue the alarming search command
+   else
+      sendpacket[sendlen++] = 0xF0; // issue the search command
+   // set all bits at first
+   for (i = 1; i <= 24; i++)
+      sendpacket[sendlen++] = 0xFF;
+   // now set or clear apropriate bits for search
+   for (i = 0; i < 64; i++)
+      bitacc(WRITE_FUNCTION,bitacc(READ_FUNCTION,0,i,&port->SerialNum[0]),(int)((i+1)*3-1),&sendpacket[1]);
+
+   // send/recieve the transfer buffer
+   if (owBlock(portnum,TRUE,sendpacket,sendlen))
+   {
+      // check results to see if it was a success
+      for (i = 0; i < 192; i += 3)
+      {
+         tst = (bitacc(READ_FUNCTION,0,i,&sendpacket[1]) << 1) |
+                bitacc(READ_FUNCTION,0,(int)(i+1),&sendpacket[1]);
+
+         s = bitacc(READ_FUNCTION,0,cnt++,&port->SerialNum[0]);
+
+         if (tst == 0x03)  // no device on line
+         {
+              goodbits = 0;    // number of good bits set to zero
+              break;     // quit
+         }
+
+         if (((s == 0x01) && (tst == 0x02)) ||
+             ((s == 0x00) && (tst == 0x01))    )  // correct bit
+            goodbits++;  // count as a good bit
+      }
+
+      // check too see if there were enough good bits to be successful
+      if (goodbits >= 8)
+         return TRUE;
+   }
+   else
+      OWERROR(OWERROR_BLOCK_FAILED);
+
+   // block fail or device not present
+   return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Perform a overdrive MATCH command to select the 1-Wire device with
+// the address in the ID data register.
+//
+// 'portnum'     - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                 indicate the symbolic port number.
+//
+// Returns:  TRUE: If the device is present on the 1-Wire Net and
+//                 can do overdrive then the device is selected.
+//           FALSE: Device is not present or not capable of overdrive.
+//
+//  *Note: This function could be converted to send DS2480
+//         commands in one packet.
+//
+SMALLINT owOverdriveAccess(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+   uchar sendpacket[8];
+   uchar i, bad_echo = FALSE;
+
+   // this select ends the session
+   owSessionEnd(portnum);
+
+   // make sure normal level
+   owLevel(portnum,MODE_NORMAL);
+
+   // force to normal communication speed
+   owSpeed(portnum,MODE_NORMAL);
+
+   // call the 1-Wire Net reset function
+   if (owTouchReset(portnum))
+   {
+      // send the match command 0x69
+      if (owWriteByte(portnum,0x69))
+      {
+         // switch to overdrive communication speed
+         owSpeed(portnum,MODE_OVERDRIVE);
+
+         // create a buffer to use with block function
+         // Serial Number
+         for (i = 0; i < 8; i++)
+            sendpacket[i] = port->SerialNum[i];
+
+         // send/recieve the transfer buffer
+         if (owBlock(portnum,FALSE,sendpacket,8))
+         {
+            // verify that the echo of the writes was correct
+            for (i = 0; i < 8; i++)
+               if (sendpacket[i] != port->SerialNum[i])
+                  bad_echo = TRUE;
+            // if echo ok then success
+            if (!bad_echo)
+               return TRUE;
+            else
+               OWERROR(OWERROR_WRITE_VERIFY_FAILED);
+         }
+         else
+            OWERROR(OWERROR_BLOCK_FAILED);
+      }
+      else
+         OWERROR(OWERROR_WRITE_BYTE_FAILED);
+   }
+   else
+      OWERROR(OWERROR_NO_DEVICES_ON_NET);
+
+   // failure, force back to normal communication speed
+   owSpeed(portnum,MODE_NORMAL);
+
+   return FALSE;
+}
+
+//--------------------------------------------------------------------------
+// Bit utility to read and write a bit in the buffer 'buf'.
+//
+// 'op'    - operation (1) to set and (0) to read
+// 'state' - set (1) or clear (0) if operation is write (1)
+// 'loc'   - bit number location to read or write
+// 'buf'   - pointer to array of bytes that contains the bit
+//           to read or write
+//
+// Returns: 1   if operation is set (1)
+//          0/1 state of bit number 'loc' if operation is reading
+//
+SMALLINT bitacc(SMALLINT op, SMALLINT state, SMALLINT loc, uchar *buf)
+{
+   SMALLINT nbyt,nbit;
+
+   nbyt = (loc / 8);
+   nbit = loc - (nbyt * 8);
+
+   if (op == WRITE_FUNCTION)
+   {
+      if (state)
+         buf[nbyt] |= (0x01 << nbit);
+      else
+         buf[nbyt] &= ~(0x01 << nbit);
+
+      return 1;
+   }
+   else
+      return ((buf[nbyt] >> nbit) & 0x01);
+}
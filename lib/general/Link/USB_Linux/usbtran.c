@@ -0,0 +1,629 @@
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//---------------------------------------------------------------------------
+//
+//  usbtran.c - DS2490 transport functions for the libusb Linux link.
+//              Replaces lib/general/owtran.c when building with usblnk.c.
+//              owBlock is done with the DS2490 BLOCK_IO (or READ_STRAIGHT)
+//              command so a whole block costs one command plus the FIFO
+//              transfers instead of a command per byte.
+//
+//  Version: 3.01
+//
+//  History: 3.00 -> 3.01  A reset in owBlock or in a transaction ends the
+//                         owsess.c session
+//
+
+#include "ownet.h"
+#include "owtxn.h"
+#include "owsess.h"
+#include "ds2490.h"
+#include "usb.h"
+
+// the structure we'll use to access other devices
+extern struct usb_dev_handle *usb_dev_handle_list[MAX_PORTNUM];
+
+// minimum number of trailing read bytes to use READ_STRAIGHT in owBlock
+#define READ_STRAIGHT_MIN     32
+// time limit to wait for the DS2490 to finish a command (ms)
+#define IDLE_LIMIT            300
+
+//--------------------------------------------------------------------------
+// The 'owBlock' transfers a block of data to and from the
+// 1-Wire Net with an optional reset at the begining of communication.
+// The result is returned in the same buffer.
+//
+// The reset is folded into the DS2490 command (RST bit).  If the block
+// ends in a long run of 0xFF read bytes the leading bytes are sent as a
+// READ_STRAIGHT preamble and only the reads are clocked back, in that
+// case the preamble bytes are left as written in 'tran_buf'.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'do_reset' - cause a owTouchReset to occure at the begining of
+//              communication TRUE(1) or not FALSE(0)
+// 'tran_buf' - pointer to a block of unsigned
+//              chars of length 'tran_len' that will be sent
+//              to the 1-Wire Net
+// 'tran_len' - length in bytes to transfer
+//
+// Supported devices: all
+//
+// Returns:   TRUE (1) : The optional reset returned a valid
+//                       presence (do_reset == TRUE) or there
+//                       was no reset required.
+//            FALSE (0): The reset did not return a valid prsence
+//                       (do_reset == TRUE).
+//
+//  The maximum tran_length is (160)
+//
+SMALLINT owBlock(int portnum, SMALLINT do_reset, uchar *tran_buf, SMALLINT tran_len)
+{
+   STATUS_PACKET status;
+   uchar nresult,i;
+   int pre_len,read_len,index,len,value;
+
+   // check for a block too big
+   if (tran_len > 160)
+   {
+      OWERROR(OWERROR_BLOCK_TOO_BIG);
+      return FALSE;
+   }
+
+   // nothing to transfer
+   if (tran_len <= 0)
+      return (do_reset) ? owTouchReset(portnum) : TRUE;
+
+   // the reset is done by the DS2490 command, not owTouchReset, and it
+   // deselects the device of the session
+   if (do_reset)
+      owSessionEnd(portnum);
+
+   // find the run of read bytes at the end of the block
+   for (pre_len = tran_len; pre_len > 0; pre_len--)
+      if (tran_buf[pre_len - 1] != 0xFF)
+         break;
+   read_len = tran_len - pre_len;
+
+   if ((read_len >= READ_STRAIGHT_MIN) && (pre_len <= DS2490_FIFO_CHUNK))
+   {
+      // preamble goes to EP2 first
+      if ((pre_len > 0) && !DS2490Write(portnum,tran_buf,pre_len))
+      {
+         DS2490Recover(portnum);
+         return FALSE;
+      }
+
+      // READ_STRAIGHT, preamble length in the upper byte of the value
+      value = COMM_READ_STRAIGHT | COMM_READ_STRAIGHT_IM | (pre_len << 8);
+      if (do_reset)
+         value |= COMM_READ_STRAIGHT_RST;
+      if (!DS2490Command(portnum,COMM_CMD,value,read_len))
+      {
+         DS2490Recover(portnum);
+         return FALSE;
+      }
+
+      index = pre_len;
+   }
+   else
+   {
+      // first chunk goes to EP2 before the BLOCK_IO command
+      len = (tran_len > DS2490_FIFO_CHUNK) ? DS2490_FIFO_CHUNK : tran_len;
+      if (!DS2490Write(portnum,tran_buf,len))
+      {
+         DS2490Recover(portnum);
+         return FALSE;
+      }
+
+      value = COMM_BLOCK_IO | COMM_IM | COMM_F;
+      if (do_reset)
+         value |= COMM_RST;
+      if (!DS2490Command(portnum,COMM_CMD,value,tran_len))
+      {
+         DS2490Recover(portnum);
+         return FALSE;
+      }
+
+      index = 0;
+   }
+
+   // collect the results a FIFO chunk at a time
+   while (index < tran_len)
+   {
+      len = tran_len - index;
+      if (len > DS2490_FIFO_CHUNK)
+         len = DS2490_FIFO_CHUNK;
+
+      if (!DS2490WaitRead(portnum,len) || !DS2490Read(portnum,&tran_buf[index],len))
+      {
+         OWERROR(OWERROR_ADAPTER_ERROR);
+         DS2490Recover(portnum);
+         return FALSE;
+      }
+      index += len;
+
+      // BLOCK_IO needs the next chunk to send
+      if ((read_len < READ_STRAIGHT_MIN) || (pre_len > DS2490_FIFO_CHUNK))
+      {
+         len = tran_len - index;
+         if (len > DS2490_FIFO_CHUNK)
+            len = DS2490_FIFO_CHUNK;
+         if ((len > 0) && !DS2490Write(portnum,&tran_buf[index],len))
+         {
+            DS2490Recover(portnum);
+            return FALSE;
+         }
+      }
+   }
+
+   // check the presence result of the folded reset
+   if (do_reset)
+   {
+      if (!DS2490WaitIdle(portnum,&status,&nresult))
+      {
+         DS2490Recover(portnum);
+         return FALSE;
+      }
+      for (i = 0; i < nresult; i++)
+      {
+         if (status.CommResultCodes[i] == ONEWIREDEVICEDETECT)
+            continue;
+         if (status.CommResultCodes[i] & (COMMCMDERRORRESULT_NRS | COMMCMDERRORRESULT_SH))
+         {
+            OWERROR(OWERROR_NO_DEVICES_ON_NET);
+            return FALSE;
+         }
+      }
+   }
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Run a transaction built with the owTxn functions.  A reset is done
+// with the block that follows it and a run of byte steps is sent with
+// as few owBlock calls as OW_BLOCK_MAX allows.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+// 'txn'      - transaction to run, the bytes read replace the bytes
+//              written in its buffer
+//
+// Returns:  TRUE (1)  : every step ran and every CRC checked is good
+//           FALSE (0) : a step failed, see owTxnStatus
+//
+SMALLINT owTxnExecute(int portnum, OWTxn *txn)
+{
+   int i,j,pos,end,len;
+   SMALLINT do_reset = FALSE, powered = FALSE;
+   OWTxnStep *st;
+
+   if (txn->overflow)
+   {
+      OWERROR(OWERROR_BLOCK_TOO_BIG);
+      return FALSE;
+   }
+
+   // a reset or ROM function in the transaction deselects the session
+   // device
+   for (i = 0; i < txn->nsteps; i++)
+      if (txn->step[i].rom || (txn->step[i].type == OWTXN_RESET))
+      {
+         owSessionEnd(portnum);
+         break;
+      }
+
+   for (i = 0; i < txn->nsteps; i++)
+   {
+      st = &txn->step[i];
+      st->status = OWTXN_OK;
+
+      // turn off the strong pull-up before anything else is done
+      if (powered && (st->type != OWTXN_DELAY))
+      {
+         if (owLevel(portnum,MODE_NORMAL) != MODE_NORMAL)
+         {
+            st->status = OWTXN_LINK_ERROR;
+            break;
+         }
+         powered = FALSE;
+      }
+
+      switch (st->type)
+      {
+         case OWTXN_RESET:
+            // done with the block that follows if there is one
+            if (((i + 1) < txn->nsteps) && (txn->step[i + 1].type == OWTXN_BYTES))
+               do_reset = TRUE;
+            else if (!owTouchReset(portnum))
+               st->status = OWTXN_NO_PRESENCE;
+            break;
+
+         case OWTXN_BYTES:
+            // the bytes of a run of steps are next to each other in 'buf'
+            for (j = i; ((j + 1) < txn->nsteps) && 
+                        (txn->step[j + 1].type == OWTXN_BYTES); j++)
+               ;
+            end = txn->step[j].offset + txn->step[j].len;
+
+            for (pos = st->offset; pos < end; pos += len)
+            {
+               len = ((end - pos) > OW_BLOCK_MAX) ? OW_BLOCK_MAX : (end - pos);
+               if (!owBlock(portnum,do_reset,&txn->buf[pos],(SMALLINT)len))
+               {
+                  if (do_reset)
+                     txn->step[i - 1].status = OWTXN_NO_PRESENCE;
+                  st->status = OWTXN_LINK_ERROR;
+                  break;
+               }
+               do_reset = FALSE;
+            }
+
+            if (st->status == OWTXN_OK)
+            {
+               for (; i < j; i++)
+                  txn->step[i + 1].status = OWTXN_OK;
+            }
+            break;
+
+         case OWTXN_POWER:
+            if (owWriteBytePower(portnum,txn->buf[st->offset]))
+               powered = TRUE;
+            else
+               st->status = OWTXN_LINK_ERROR;
+            break;
+
+         case OWTXN_DELAY:
+            msDelay(st->ms);
+            break;
+      }
+
+      if (st->status != OWTXN_OK)
+         break;
+   }
+
+   return owTxnVerify(txn);
+}
+
+//--------------------------------------------------------------------------
+// Run several independent transactions.  This link has no way to queue
+// one exchange behind another so they are run one at a time.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+// 'txns'     - transactions to run
+// 'num'      - number of transactions
+//
+// Returns:  number of transactions that ran with every CRC good
+//
+int owTxnPipeline(int portnum, OWTxn **txns, int num)
+{
+   int i,good = 0;
+
+   for (i = 0; i < num; i++)
+      if (owTxnExecute(portnum,txns[i]))
+         good++;
+
+   return good;
+}
+
+//--------------------------------------------------------------------------
+// Write a byte to an EPROM 1-Wire device.
+//
+// Supported devices: crc_type=0(CRC8)
+//                        DS1982
+//                    crc_type=1(CRC16)
+//                        DS1985, DS1986, DS2407
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'write_byte' - byte to program
+// 'addr'       - address of byte to program
+// 'write_cmd'  - command used to write (0x0F reg mem, 0x55 status)
+// 'crc_type'   - CRC used (0 CRC8, 1 CRC16)
+// 'do_access'  - Flag to access device for each byte
+//                (0 skip access, 1 do the access)
+//                WARNING, only use do_access=0 if programing the NEXT
+//                byte immediatly after the previous byte.
+//
+// Returns: >=0   success, this is the resulting byte from the program
+//                effort
+//          -1    error, device not connected or program pulse voltage
+//                not available
+//
+SMALLINT owProgramByte(int portnum, SMALLINT write_byte, int addr, SMALLINT write_cmd,
+                       SMALLINT crc_type, SMALLINT do_access)
+{
+   ushort lastcrc16;
+   uchar lastcrc8;
+
+   // optionally access the device
+   if (do_access)
+   {
+      if (!owAccess(portnum))
+      {
+         OWERROR(OWERROR_ACCESS_FAILED);
+         return -1;
+      }
+
+      // send the write command
+      if (!owWriteByte(portnum,write_cmd))
+      {
+         OWERROR(OWERROR_WRITE_BYTE_FAILED);
+         return -1;
+      }
+
+      // send the address
+      if (!owWriteByte(portnum,addr & 0xFF) || !owWriteByte(portnum,addr >> 8))
+      {
+         OWERROR(OWERROR_WRITE_BYTE_FAILED);
+         return -1;
+      }
+   }
+
+   // send the data to write
+   if (!owWriteByte(portnum,write_byte))
+   {
+      OWERROR(OWERROR_WRITE_BYTE_FAILED);
+      return -1;
+   }
+
+   // read the CRC
+   if (crc_type == 0)
+   {
+      // calculate CRC8
+      if (do_access)
+      {
+         setcrc8(portnum,0);
+         docrc8(portnum,(uchar)write_cmd);
+         docrc8(portnum,(uchar)(addr & 0xFF));
+         docrc8(portnum,(uchar)(addr >> 8));
+      }
+      else
+         setcrc8(portnum,(uchar)(addr & 0xFF));
+
+      docrc8(portnum,(uchar)write_byte);
+      // read and calculate the read crc
+      lastcrc8 = docrc8(portnum,(uchar)owReadByte(portnum));
+      // crc should now be 0x00
+      if (lastcrc8 != 0)
+      {
+         OWERROR(OWERROR_CRC_FAILED);
+         return -1;
+      }
+   }
+   else
+   {
+      // CRC16
+      if (do_access)
+      {
+         setcrc16(portnum,0);
+         docrc16(portnum,(ushort)write_cmd);
+         docrc16(portnum,(ushort)(addr & 0xFF));
+         docrc16(portnum,(ushort)(addr >> 8));
+      }
+      else
+         setcrc16(portnum,(ushort)addr);
+      docrc16(portnum,(ushort)write_byte);
+      // read and calculate the read crc
+      docrc16(portnum,(ushort)owReadByte(portnum));
+      lastcrc16 = docrc16(portnum,(ushort)owReadByte(portnum));
+      // crc should now be 0xB001
+      if (lastcrc16 != 0xB001)
+         return -1;
+   }
+
+   // send the program pulse
+   if (!owProgramPulse(portnum))
+   {
+      OWERROR(OWERROR_PROGRAM_PULSE_FAILED);
+      return -1;
+   }
+
+   // read back and return the resulting byte
+   return owReadByte(portnum);
+}
+
+//--------------------------------------------------------------------------
+// Send a vendor command to the DS2490 on EP0.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'request'  - CONTROL_CMD, COMM_CMD or MODE_CMD
+// 'value'    - command value field
+// 'index'    - command index field
+//
+// Returns:  TRUE  command accepted
+//           FALSE usb error
+//
+SMALLINT DS2490Command(int portnum, int request, int value, int index)
+{
+   if (usb_control_msg(usb_dev_handle_list[portnum], 0x40, request,
+                       value, index, NULL, 0, DS2490_TIMEOUT) < 0)
+   {
+      OWERROR(OWERROR_ADAPTER_ERROR);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Read the DS2490 status packet from EP1.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'status'   - status packet to fill
+// 'nresult'  - number of result codes returned (can be NULL)
+//
+// Returns:  TRUE  status read
+//           FALSE usb error
+//
+SMALLINT DS2490GetStatus(int portnum, STATUS_PACKET *status, uchar *nresult)
+{
+   int len;
+
+   len = usb_bulk_read(usb_dev_handle_list[portnum], DS2490_EP_STATUS,
+                       (char *)status, sizeof(STATUS_PACKET), DS2490_TIMEOUT);
+   if (len < 16)
+   {
+      OWERROR(OWERROR_ADAPTER_ERROR);
+      return FALSE;
+   }
+
+   if (nresult != NULL)
+      *nresult = (uchar)(len - 16);
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Wait for the DS2490 to go idle.  The result codes of the finished
+// commands are returned in the last status read.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'status'   - status packet to fill
+// 'nresult'  - number of result codes returned
+//
+// Returns:  TRUE  idle
+//           FALSE usb error or timeout
+//
+SMALLINT DS2490WaitIdle(int portnum, STATUS_PACKET *status, uchar *nresult)
+{
+   long limit = msGettick() + IDLE_LIMIT;
+
+   do
+   {
+      if (!DS2490GetStatus(portnum,status,nresult))
+         return FALSE;
+      if (status->StatusFlags & STATUSFLAGS_IDLE)
+         return TRUE;
+   }
+   while (limit > msGettick());
+
+   OWERROR(OWERROR_ADAPTER_ERROR);
+   return FALSE;
+}
+
+//--------------------------------------------------------------------------
+// Wait for at least 'min_bytes' to be waiting in EP3 (or the DS2490 to
+// go idle).
+//
+// 'portnum'   - number 0 to MAX_PORTNUM-1.  This number is provided to
+//               indicate the symbolic port number.
+// 'min_bytes' - bytes that the caller is going to read
+//
+// Returns:  TRUE  data ready
+//           FALSE usb error or timeout
+//
+SMALLINT DS2490WaitRead(int portnum, int min_bytes)
+{
+   STATUS_PACKET status;
+   long limit = msGettick() + IDLE_LIMIT;
+
+   do
+   {
+      if (!DS2490GetStatus(portnum,&status,NULL))
+         return FALSE;
+      if ((status.ReadBufferStatus >= min_bytes) ||
+          (status.StatusFlags & STATUSFLAGS_IDLE))
+         return (status.ReadBufferStatus >= min_bytes);
+   }
+   while (limit > msGettick());
+
+   return FALSE;
+}
+
+//--------------------------------------------------------------------------
+// Write data to EP2.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'buf'      - data to write
+// 'len'      - number of bytes, at most DS2490_FIFO_CHUNK
+//
+// Returns:  TRUE  all bytes written
+//           FALSE usb error
+//
+SMALLINT DS2490Write(int portnum, uchar *buf, int len)
+{
+   if (usb_bulk_write(usb_dev_handle_list[portnum], DS2490_EP_WRITE,
+                      (char *)buf, len, DS2490_TIMEOUT) != len)
+   {
+      OWERROR(OWERROR_ADAPTER_ERROR);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Read data from EP3.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'buf'      - buffer for the data
+// 'len'      - number of bytes to read
+//
+// Returns:  TRUE  all bytes read
+//           FALSE usb error
+//
+SMALLINT DS2490Read(int portnum, uchar *buf, int len)
+{
+   if (usb_bulk_read(usb_dev_handle_list[portnum], DS2490_EP_READ,
+                     (char *)buf, len, DS2490_TIMEOUT) != len)
+   {
+      usb_clear_halt(usb_dev_handle_list[portnum], DS2490_EP_READ);
+      OWERROR(OWERROR_ADAPTER_ERROR);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Get the DS2490 back into a known state after a failed command by
+// flushing the pending commands and both data FIFOs.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+//
+void DS2490Recover(int portnum)
+{
+   usb_control_msg(usb_dev_handle_list[portnum], 0x40, CONTROL_CMD,
+                   CTL_HALT_EXE_IDLE, 0, NULL, 0, DS2490_TIMEOUT);
+   usb_control_msg(usb_dev_handle_list[portnum], 0x40, CONTROL_CMD,
+                   CTL_FLUSH_COMM_CMDS, 0, NULL, 0, DS2490_TIMEOUT);
+   usb_control_msg(usb_dev_handle_list[portnum], 0x40, CONTROL_CMD,
+                   CTL_FLUSH_RCV_BUFFER, 0, NULL, 0, DS2490_TIMEOUT);
+   usb_control_msg(usb_dev_handle_list[portnum], 0x40, CONTROL_CMD,
+                   CTL_FLUSH_XMT_BUFFER, 0, NULL, 0, DS2490_TIMEOUT);
+   usb_control_msg(usb_dev_handle_list[portnum], 0x40, CONTROL_CMD,
+                   CTL_RESUME_EXE, 0, NULL, 0, DS2490_TIMEOUT);
+   usb_clear_halt(usb_dev_handle_list[portnum], DS2490_EP_WRITE);
+   usb_clear_halt(usb_dev_handle_list[portnum], DS2490_EP_READ);
+}
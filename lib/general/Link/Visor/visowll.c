@@ -27,11 +27,13 @@
 //  VisowLL.C - Link Layer 1-Wire Net functions.
 //
 //           2.00 -> 3.00  Added owReadBitPower and owWriteBytePower
+//           3.00 -> 3.01  owTouchReset ends the owsess.c session
 
 
 #include <PalmOS.h>
 #include <SystemMgr.h>
 #include "SauthPalm.h"
+#include "owsess.h"
 
 // External functions
 uchar DOWReset(void);
@@ -80,6 +82,9 @@ int old_speed[MAX_PORTNUM];
 //
 SMALLINT owTouchReset(int portnum)
 {   
+   // a reset deselects the device of the session
+   owSessionEnd(portnum);
+
    iBSetup(RetPort(portnum)); 
    return((int)DOWReset());
    		
@@ -26,7 +26,7 @@
 //
 //  ownet.C - Network functions for 1-Wire net devices.
 //
-//  Version: 3.00
+//  Version: 3.03
 //
 //  History: 1.00 -> 1.01  Change to owFamilySearchSetup, LastDiscrepancy[portnum]
 //                         was set to 64 instead of 8 to enable devices with
@@ -36,20 +36,20 @@
 //                         multiple ports.
 //           2.00 -> 2.01  Added support for owError library
 //           2.01 -> 3.00  Make search functions consistent with AN187
+//           3.00 -> 3.01  Added owSearchAll
+//           3.01 -> 3.02  Selects and searches end the owsess.c session
+//           3.02 -> 3.03  Search state moved to the OWPort state so port
+//                         numbers past MAX_PORTNUM can be used
 //
 
 #include <stdio.h>
 #include "ownet.h"
+#include "owport.h"
+#include "owsess.h"
 
 // exportable functions defined in ownet.c
 SMALLINT bitacc(SMALLINT,SMALLINT,SMALLINT,uchar *);
 
-// global variables for this module to hold search state information
-static SMALLINT LastDiscrepancy[MAX_PORTNUM];
-static SMALLINT LastFamilyDiscrepancy[MAX_PORTNUM];
-static SMALLINT LastDevice[MAX_PORTNUM];
-uchar SerialNum[MAX_PORTNUM][8];
-
 //--------------------------------------------------------------------------
 // The 'owFirst' finds the first device on the 1-Wire Net  This function
 // contains one parameter 'alarm_only'.  When
@@ -71,10 +71,12 @@ uchar SerialNum[MAX_PORTNUM][8];
 //
 SMALLINT owFirst(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 {
+   OWPort *port = owGetPort(portnum);
+
    // reset the search state
-   LastDiscrepancy[portnum] = 0;
-   LastDevice[portnum] = FALSE;
-   LastFamilyDiscrepancy[portnum] = 0;
+   port->LastDiscrepancy = 0;
+   port->LastDevice = FALSE;
+   port->LastFamilyDiscrepancy = 0;
 
    return owNext(portnum,do_reset,alarm_only);
 }
@@ -104,11 +106,15 @@ SMALLINT owFirst(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 //
 SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 {
+   OWPort *port = owGetPort(portnum);
    uchar bit_test, search_direction, bit_number;
    uchar last_zero, serial_byte_number, next_result;
    uchar serial_byte_mask;
    uchar lastcrc8=0;
 
+   // a search deselects the device of the session
+   owSessionEnd(portnum);
+
    // initialize for search
    bit_number = 1;
    last_zero = 0;
@@ -118,7 +124,7 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
    setcrc8(portnum,0);
 
    // if the last call was not the last one
-   if (!LastDevice[portnum])
+   if (!port->LastDevice)
    {
       // check if reset first is requested
       if (do_reset)
@@ -129,8 +135,8 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
          {
             // printf("owTouchReset failed\r\n");
             // reset the search
-            LastDiscrepancy[portnum] = 0;
-            LastFamilyDiscrepancy[portnum] = 0;
+            port->LastDiscrepancy = 0;
+            port->LastFamilyDiscrepancy = 0;
             OWERROR(OWERROR_NO_DEVICES_ON_NET);
             return FALSE;
          }
@@ -164,11 +170,11 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
             {
                // if this discrepancy if before the Last Discrepancy
                // on a previous next then pick the same as last time
-               if (bit_number < LastDiscrepancy[portnum])
-                  search_direction = ((SerialNum[portnum][serial_byte_number] & serial_byte_mask) > 0);
+               if (bit_number < port->LastDiscrepancy)
+                  search_direction = ((port->SerialNum[serial_byte_number] & serial_byte_mask) > 0);
                else
                   // if equal to last pick 1, if not then pick 0
-                  search_direction = (bit_number == LastDiscrepancy[portnum]);
+                  search_direction = (bit_number == port->LastDiscrepancy);
 
                // if 0 was picked then record its position in LastZero
                if (search_direction == 0)
@@ -177,16 +183,16 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 
                   // check for Last discrepancy in family
                   if (last_zero < 9)
-                     LastFamilyDiscrepancy[portnum] = last_zero;
+                     port->LastFamilyDiscrepancy = last_zero;
                }
             }
 
             // set or clear the bit in the SerialNum[portnum] byte serial_byte_number
             // with mask serial_byte_mask
             if (search_direction == 1)
-              SerialNum[portnum][serial_byte_number] |= serial_byte_mask;
+              port->SerialNum[serial_byte_number] |= serial_byte_mask;
             else
-              SerialNum[portnum][serial_byte_number] &= ~serial_byte_mask;
+              port->SerialNum[serial_byte_number] &= ~serial_byte_mask;
 
             // serial number search direction write bit
             owTouchBit(portnum,search_direction);
@@ -200,7 +206,7 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
             // and reset mask
             if (serial_byte_mask == 0)
             {
-                lastcrc8 = docrc8(portnum,SerialNum[portnum][serial_byte_number]);  // accumulate the CRC
+                lastcrc8 = docrc8(portnum,port->SerialNum[serial_byte_number]);  // accumulate the CRC
                 serial_byte_number++;
                 serial_byte_mask = 1;
             }
@@ -212,25 +218,85 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
       if (!((bit_number < 65) || lastcrc8))
       {
          // search successful so set LastDiscrepancy[portnum],LastDevice[portnum],next_result
-         LastDiscrepancy[portnum] = last_zero;
-         LastDevice[portnum] = (LastDiscrepancy[portnum] == 0);
+         port->LastDiscrepancy = last_zero;
+         port->LastDevice = (port->LastDiscrepancy == 0);
          next_result = TRUE;
       }
    }
 
    // if no device found then reset counters so next 'next' will be
    // like a first
-   if (!next_result || !SerialNum[portnum][0])
+   if (!next_result || !port->SerialNum[0])
    {
-      LastDiscrepancy[portnum] = 0;
-      LastDevice[portnum] = FALSE;
-      LastFamilyDiscrepancy[portnum] = 0;
+      port->LastDiscrepancy = 0;
+      port->LastDevice = FALSE;
+      port->LastFamilyDiscrepancy = 0;
       next_result = FALSE;
    }
 
    return next_result;
 }
 
+//--------------------------------------------------------------------------
+// The 'owSearchAll' function finds every device on the 1-Wire Net (or
+// every device of one family) in one call.  A family search stops as
+// soon as the search leaves the family instead of walking the rest of
+// the 1-Wire Net.  The search state used by 'owNext' is reset and
+// SerialNum is left as the last device found.
+//
+// 'portnum'       - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                   indicate the symbolic port number.
+// 'ROMs'          - array to receive the serial numbers found
+// 'max'           - number of entries in 'ROMs'
+// 'search_family' - family code to limit the search to or 0 for all
+//                   devices
+// 'alarm_only'    - TRUE (1) the find alarm command 0xEC is
+//                   sent instead of the normal search command 0xF0
+//
+// Returns:   number of devices placed in 'ROMs'
+//
+int owSearchAll(int portnum, uchar ROMs[][8], int max, SMALLINT search_family,
+                SMALLINT alarm_only)
+{
+   OWPort *port = owGetPort(portnum);
+   SMALLINT rslt;
+   int found = 0;
+
+   if (max <= 0)
+      return 0;
+
+   // start the search at the family or at the first device
+   if (search_family)
+   {
+      owFamilySearchSetup(portnum,search_family);
+      rslt = owNext(portnum,TRUE,alarm_only);
+   }
+   else
+      rslt = owFirst(portnum,TRUE,alarm_only);
+
+   while (rslt)
+   {
+      // stop when past the family
+      if (search_family && (port->SerialNum[0] != (uchar)search_family))
+         break;
+
+      owSerialNum(portnum,ROMs[found],TRUE);
+      if (++found >= max)
+         break;
+
+      rslt = owNext(portnum,TRUE,alarm_only);
+   }
+
+   // reset the search state
+   port->LastDiscrepancy = 0;
+   port->LastDevice = FALSE;
+   port->LastFamilyDiscrepancy = 0;
+   if (found > 0)
+      owSerialNum(portnum,ROMs[found - 1],FALSE);
+
+   return found;
+}
+
 //--------------------------------------------------------------------------
 // The 'owSerialNum' function either reads or sets the SerialNum buffer
 // that is used in the search functions 'owFirst' and 'owNext'.
@@ -251,19 +317,20 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 //
 void owSerialNum(int portnum, uchar *serialnum_buf, SMALLINT do_read)
 {
+   OWPort *port = owGetPort(portnum);
    uchar i;
 
    // read the internal buffer and place in 'serialnum_buf'
    if (do_read)
    {
       for (i = 0; i < 8; i++)
-         serialnum_buf[i] = SerialNum[portnum][i];
+         serialnum_buf[i] = port->SerialNum[i];
    }
    // set the internal buffer from the data in 'serialnum_buf'
    else
    {
       for (i = 0; i < 8; i++)
-         SerialNum[portnum][i] = serialnum_buf[i];
+         port->SerialNum[i] = serialnum_buf[i];
    }
 }
 
@@ -278,14 +345,15 @@ void owSerialNum(int portnum, uchar *serialnum_buf, SMALLINT do_read)
 //
 void owFamilySearchSetup(int portnum, SMALLINT search_family)
 {
+   OWPort *port = owGetPort(portnum);
    uchar i;
 
    // set the search state to find SearchFamily type devices
-   SerialNum[portnum][0] = search_family;
+   port->SerialNum[0] = search_family;
    for (i = 1; i < 8; i++)
-      SerialNum[portnum][i] = 0;
-   LastDiscrepancy[portnum] = 64;
-   LastDevice[portnum] = FALSE;
+      port->SerialNum[i] = 0;
+   port->LastDiscrepancy = 64;
+   port->LastDevice = FALSE;
 }
 
 //--------------------------------------------------------------------------
@@ -296,13 +364,15 @@ void owFamilySearchSetup(int portnum, SMALLINT search_family)
 //
 void owSkipFamily(int portnum)
 {
+   OWPort *port = owGetPort(portnum);
+
    // set the Last discrepancy to last family discrepancy
-   LastDiscrepancy[portnum] = LastFamilyDiscrepancy[portnum];
-   LastFamilyDiscrepancy[portnum] = 0;
+   port->LastDiscrepancy = port->LastFamilyDiscrepancy;
+   port->LastFamilyDiscrepancy = 0;
 
    // check for end of list
-   if (LastDiscrepancy[portnum] == 0)
-      LastDevice[portnum] = TRUE;
+   if (port->LastDiscrepancy == 0)
+      port->LastDevice = TRUE;
 }
 
 //--------------------------------------------------------------------------
@@ -321,9 +391,13 @@ void owSkipFamily(int portnum)
 //
 SMALLINT owAccess(int portnum)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[9];
    uchar i;
 
+   // this select ends the session
+   owSessionEnd(portnum);
+
    // reset the 1-wire
    if (owTouchReset(portnum))
    {
@@ -332,14 +406,14 @@ SMALLINT owAccess(int portnum)
       sendpacket[0] = 0x55;
       // Serial Number
       for (i = 1; i < 9; i++)
-         sendpacket[i] = SerialNum[portnum][i-1];
+         sendpacket[i] = port->SerialNum[i-1];
 
       // send/recieve the transfer buffer
       if (owBlock(portnum,FALSE,sendpacket,9))
       {
          // verify that the echo of the writes was correct
          for (i = 1; i < 9; i++)
-            if (sendpacket[i] != SerialNum[portnum][i-1])
+            if (sendpacket[i] != port->SerialNum[i-1])
                return FALSE;
          if (sendpacket[0] != 0x55)
          {
@@ -384,9 +458,13 @@ SMALLINT owAccess(int portnum)
 //
 SMALLINT owVerify(int portnum, SMALLINT alarm_only)
 {
+   OWPort *port = owGetPort(portnum);
    uchar i,sendlen=0,goodbits=0,cnt=0,s,tst;
    uchar sendpacket[50];
 
+   // this search ends the session
+   owSessionEnd(portnum);
+
    // construct the search
    if (alarm_only)
       sendpacket[sendlen++] = 0xEC; // issue the alarming search command
@@ -397,7 +475,7 @@ SMALLINT owVerify(int portnum, SMALLINT alarm_only)
       sendpacket[sendlen++] = 0xFF;
    // now set or clear apropriate bits for search
    for (i = 0; i < 64; i++)
-      bitacc(WRITE_FUNCTION,bitacc(READ_FUNCTION,0,i,&SerialNum[portnum][0]),(int)((i+1)*3-1),&sendpacket[1]);
+      bitacc(WRITE_FUNCTION,bitacc(READ_FUNCTION,0,i,&port->SerialNum[0]),(int)((i+1)*3-1),&sendpacket[1]);
 
    // send/recieve the transfer buffer
    if (owBlock(portnum,TRUE,sendpacket,sendlen))
@@ -408,7 +486,7 @@ SMALLINT owVerify(int portnum, SMALLINT alarm_only)
          tst = (bitacc(READ_FUNCTION,0,i,&sendpacket[1]) << 1) |
                 bitacc(READ_FUNCTION,0,(int)(i+1),&sendpacket[1]);
 
-         s = bitacc(READ_FUNCTION,0,cnt++,&SerialNum[portnum][0]);
+         s = bitacc(READ_FUNCTION,0,cnt++,&port->SerialNum[0]);
 
          if (tst == 0x03)  // no device on line
          {
@@ -448,9 +526,13 @@ SMALLINT owVerify(int portnum, SMALLINT alarm_only)
 //
 SMALLINT owOverdriveAccess(int portnum)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[8];
    uchar i, bad_echo = FALSE;
 
+   // this select ends the session
+   owSessionEnd(portnum);
+
    // make sure normal level
    owLevel(portnum,MODE_NORMAL);
 
@@ -469,14 +551,14 @@ SMALLINT owOverdriveAccess(int portnum)
          // create a buffer to use with block function
          // Serial Number
          for (i = 0; i < 8; i++)
-            sendpacket[i] = SerialNum[portnum][i];
+            sendpacket[i] = port->SerialNum[i];
 
          // send/recieve the transfer buffer
          if (owBlock(portnum,FALSE,sendpacket,8))
          {
             // verify that the echo of the writes was correct
             for (i = 0; i < 8; i++)
-               if (sendpacket[i] != SerialNum[portnum][i])
+               if (sendpacket[i] != port->SerialNum[i])
                   bad_echo = TRUE;
             // if echo ok then success
             if (!bad_echo)
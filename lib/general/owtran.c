@@ -26,14 +26,24 @@
 //
 //  owTran.C - Transport functions for 1-Wire devices.
 //
-//  Version: 2.01
+//  Version: 2.04
 //
 //  History: 1.03 -> 2.00  Changed 'MLan' to 'ow'. Added support for
 //                         multiple ports.
 //           2.00 -> 2.01  Added support for owError library
+//           2.01 -> 2.02  Added owTxnExecute and owTxnPipeline
+//           2.02 -> 2.03  Transaction delays are timed from the end of the
+//                         step before them with usDelayUntil
+//           2.03 -> 2.04  The 8051 builds (__C51__) have no long long and
+//                         do not link owtime.c, they wait with msDelay
 //
 
 #include "ownet.h"
+#include "owtxn.h"
+#include "owsess.h"
+#ifndef __C51__
+   #include "owtime.h"
+#endif
 
 //--------------------------------------------------------------------------
 // The 'owBlock' transfers a block of data to and from the
@@ -84,6 +94,147 @@ SMALLINT owBlock(int portnum, SMALLINT do_reset, uchar *tran_buf, SMALLINT tran_
    return TRUE;
 }
 
+//--------------------------------------------------------------------------
+// Run a transaction built with the owTxn functions.  A reset is done
+// with the block that follows it and a run of byte steps is sent with
+// as few owBlock calls as OW_BLOCK_MAX allows.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+// 'txn'      - transaction to run, the bytes read replace the bytes
+//              written in its buffer
+//
+// Returns:  TRUE (1)  : every step ran and every CRC checked is good
+//           FALSE (0) : a step failed, see owTxnStatus
+//
+SMALLINT owTxnExecute(int portnum, OWTxn *txn)
+{
+   int i,j,pos,end,len;
+   SMALLINT do_reset = FALSE, powered = FALSE;
+   OWTxnStep *st;
+#ifndef __C51__
+   long long done = usGettick();
+#endif
+
+   if (txn->overflow)
+   {
+      OWERROR(OWERROR_BLOCK_TOO_BIG);
+      return FALSE;
+   }
+
+   // a ROM function in the transaction deselects the session device
+   for (i = 0; i < txn->nsteps; i++)
+      if (txn->step[i].rom)
+      {
+         owSessionEnd(portnum);
+         break;
+      }
+
+   for (i = 0; i < txn->nsteps; i++)
+   {
+      st = &txn->step[i];
+      st->status = OWTXN_OK;
+
+      // turn off the strong pull-up before anything else is done
+      if (powered && (st->type != OWTXN_DELAY))
+      {
+         if (owLevel(portnum,MODE_NORMAL) != MODE_NORMAL)
+         {
+            st->status = OWTXN_LINK_ERROR;
+            break;
+         }
+         powered = FALSE;
+      }
+
+      switch (st->type)
+      {
+         case OWTXN_RESET:
+            // done with the block that follows if there is one
+            if (((i + 1) < txn->nsteps) && (txn->step[i + 1].type == OWTXN_BYTES))
+               do_reset = TRUE;
+            else if (!owTouchReset(portnum))
+               st->status = OWTXN_NO_PRESENCE;
+            break;
+
+         case OWTXN_BYTES:
+            // the bytes of a run of steps are next to each other in 'buf'
+            for (j = i; ((j + 1) < txn->nsteps) && 
+                        (txn->step[j + 1].type == OWTXN_BYTES); j++)
+               ;
+            end = txn->step[j].offset + txn->step[j].len;
+
+            for (pos = st->offset; pos < end; pos += len)
+            {
+               len = ((end - pos) > OW_BLOCK_MAX) ? OW_BLOCK_MAX : (end - pos);
+               if (!owBlock(portnum,do_reset,&txn->buf[pos],(SMALLINT)len))
+               {
+                  if (do_reset)
+                     txn->step[i - 1].status = OWTXN_NO_PRESENCE;
+                  st->status = OWTXN_LINK_ERROR;
+                  break;
+               }
+               do_reset = FALSE;
+            }
+
+            if (st->status == OWTXN_OK)
+            {
+               for (; i < j; i++)
+                  txn->step[i + 1].status = OWTXN_OK;
+            }
+            break;
+
+         case OWTXN_POWER:
+            if (owWriteBytePower(portnum,txn->buf[st->offset]))
+               powered = TRUE;
+            else
+               st->status = OWTXN_LINK_ERROR;
+            break;
+
+         case OWTXN_DELAY:
+#ifdef __C51__
+            msDelay(st->ms);
+#else
+            // counted from the end of the step before it
+            done += (long long)st->ms * 1000;
+            usDelayUntil(done);
+#endif
+            break;
+      }
+
+#ifndef __C51__
+      if (st->type != OWTXN_DELAY)
+         done = usGettick();
+#endif
+
+      if (st->status != OWTXN_OK)
+         break;
+   }
+
+   return owTxnVerify(txn);
+}
+
+//--------------------------------------------------------------------------
+// Run several independent transactions.  This link has no way to queue
+// one exchange behind another so they are run one at a time.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+// 'txns'     - transactions to run
+// 'num'      - number of transactions
+//
+// Returns:  number of transactions that ran with every CRC good
+//
+int owTxnPipeline(int portnum, OWTxn **txns, int num)
+{
+   int i,good = 0;
+
+   for (i = 0; i < num; i++)
+      if (owTxnExecute(portnum,txns[i]))
+         good++;
+
+   return good;
+}
+
 //--------------------------------------------------------------------------
 // Write a byte to an EPROM 1-Wire device.
 //
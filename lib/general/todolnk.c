@@ -27,16 +27,18 @@
 //  TODO.C - Link Layer functions required by general 1-Wire drive
 //           implimentation.  Fill in the platform specific code.
 //
-//  Version: 3.00
+//  Version: 3.01
 //
 //  History: 1.00 -> 1.01  Added function msDelay.
 //           1.02 -> 1.03  Added function msGettick.
 //           1.03 -> 2.00  Changed 'MLan' to 'ow'. Added support for
 //                         multiple ports.
 //           2.10 -> 3.00  Added owReadBitPower and owWriteBytePower
+//           3.00 -> 3.01  owTouchReset ends the owsess.c session
 //
 
 #include "ownet.h"
+#include "owsess.h"
 
 // exportable link-level functions
 SMALLINT owTouchReset(int);
@@ -66,6 +68,9 @@ SMALLINT owReadBitPower(int, SMALLINT);
 //
 SMALLINT owTouchReset(int portnum)
 {
+   // a reset deselects the device of the session
+   owSessionEnd(portnum);
+
    // add platform specific code here
    return 0;
 }
@@ -82,6 +82,25 @@
 //                         return values to OpenCOM.  Replace 'makeraw' call.
 //                         Should now be POSIX.
 //           2.00 -> 2.01  Added support for owError library.
+//           2.01 -> 2.02  ReadCOM reads all available bytes per read() and
+//                         waits on a single deadline computed from the baud
+//                         rate instead of select() per byte.  WriteCOM no
+//                         longer calls tcdrain(), FlushCOM only discards
+//                         input.  Added GetCOMStats()/ClearCOMStats().
+//           2.02 -> 2.03  Port state moved to OWPort, OpenCOMEx is no
+//                         longer limited to MAX_PORTNUM ports.
+//                         Signal mask is per thread with OW_THREADS.
+//           2.03 -> 2.04  Added the owAsync functions (Linux only) to run
+//                         DS2480B packet exchanges from one epoll fd.
+//           2.04 -> 2.05  WriteCOM and ReadCOM are timed by owstats.c.
+//           2.05 -> 2.06  msGettick uses the monotonic clock and no longer
+//                         wraps.  msDelay sleeps to an absolute deadline
+//                         with usDelayUntil.  The read deadlines use
+//                         usGettick.
+//           2.06 -> 2.07  ReadCOM and WriteCOM wait with poll() so any
+//                         fd number can be used.
+//           2.07 -> 2.08  An idle async port is not watched for input so
+//                         stray bytes do not spin the epoll loop.
 //
 
 #include <unistd.h>
@@ -95,18 +114,39 @@
 #include <sys/time.h>
 #include <string.h>
 #include <signal.h>
+#include <poll.h>
+#include <stdlib.h>
+#ifdef __linux__
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
 
 #ifdef SMALL_MEMORY_TARGET
 #include <picoos.h>
 #endif
+
+// only change the signal mask of the calling thread when threaded
+#ifdef OW_THREADS
+#include <pthread.h>
+#define SIGMASK pthread_sigmask
+#else
+#define SIGMASK sigprocmask
+#endif
 #include "ds2480.h"
 #include "ownet.h"
+#include "owasync.h"
+#include "owstats.h"
+#include "owtime.h"
 
-// LinuxLNK global
-int fd[MAX_PORTNUM];
-SMALLINT fd_init;
+// LinuxLNK global, the file descriptors and statistics are in OWPort
 struct termios origterm;
 
+// fixed allowance added to every read deadline (ms)
+#define READ_SLACK_MS       10
+// worst case 1-Wire time for each DS2480B response byte (us)
+#define OW_BYTE_US          1000
+
 SMALLINT _OpenCOM(int portnum, char *port_zstr);
 void _CloseCOM(int portnum);
 SMALLINT _WriteCOM(int portnum, int outlen, uchar *outbuf);
@@ -116,6 +156,37 @@ void _BreakCOM(int portnum);
 void _SetBaudCOM(int portnum, uchar new_baud);
 static void sigBlock(sigset_t* old);
 static void sigRestore(sigset_t* old);
+static long ReadTimeoutUs(int portnum, int inlen);
+
+#ifdef __linux__
+// queue of one port started with owAsyncStart, kept in OWPort 'async'
+typedef struct AsyncPort
+{
+   int             portnum;
+   owAsyncRequest *head;            // request on the wire
+   owAsyncRequest *tail;
+   int             events;          // epoll events registered for the fd
+   struct AsyncPort *next;          // list of started ports
+} AsyncPort;
+
+// epoll data of the timer, port numbers are never negative
+#define ASYNC_TIMER         -1
+// events taken per epoll_wait
+#define ASYNC_EVENTS        32
+
+static int             AsyncEpoll = -1;
+static int             AsyncTimer = -1;
+static AsyncPort      *AsyncPorts = NULL;
+static owAsyncRequest *AsyncDoneHead = NULL;
+static owAsyncRequest *AsyncDoneTail = NULL;
+
+static SMALLINT AsyncInit(void);
+static void AsyncBegin(AsyncPort *ap);
+static void AsyncDone(AsyncPort *ap);
+static void AsyncProgress(AsyncPort *ap);
+static void AsyncArm(void);
+static void AsyncPoll(int timeout_ms);
+#endif
 
 //---------------------------------------------------------------------------
 // Attempt to open a com port.  Keep the handle in ComID.
@@ -130,23 +201,15 @@ static void sigRestore(sigset_t* old);
 //
 int OpenCOMEx(char *port_zstr)
 {
-   int i;
    int portnum;
 
-   if(!fd_init)
-   {
-      for(i=0; i<MAX_PORTNUM; i++)
-         fd[i] = 0;
-      fd_init = 1;
-   }
-
    // check to find first available handle slot
-   for(portnum = 0; portnum<MAX_PORTNUM; portnum++)
+   for(portnum = 0; portnum<OWPORT_MAX; portnum++)
    {
-      if(!fd[portnum])
+      if(!owGetPort(portnum)->fd)
          break;
    }
-   OWASSERT( portnum<MAX_PORTNUM, OWERROR_PORTNUM_ERROR, -1 );
+   OWASSERT( portnum<OWPORT_MAX, OWERROR_PORTNUM_ERROR, -1 );
 
    if(!OpenCOM(portnum, port_zstr))
    {
@@ -175,30 +238,24 @@ SMALLINT _OpenCOM(int portnum, char *port_zstr)
 {
    struct termios t;               // see man termios - declared as above
    int rc;
+   OWPort *port;
 
-   if(!fd_init)
-   {
-      int i;
-      for(i=0; i<MAX_PORTNUM; i++)
-         fd[i] = 0;
-      fd_init = 1;
-   }
-
-   OWASSERT( portnum<MAX_PORTNUM && portnum>=0 && !fd[portnum],
+   OWASSERT( portnum<OWPORT_MAX && portnum>=0 && !owGetPort(portnum)->fd,
              OWERROR_PORTNUM_ERROR, FALSE );
+   port = owGetPort(portnum);
 
-   fd[portnum] = open(port_zstr, O_RDWR|O_NONBLOCK);
-   if (fd[portnum]<0)
+   port->fd = open(port_zstr, O_RDWR|O_NONBLOCK);
+   if (port->fd<0)
    {
       OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
       return FALSE;  // changed (2.00), used to return fd;
    }
-   rc = tcgetattr (fd[portnum], &t);
+   rc = tcgetattr (port->fd, &t);
    if (rc < 0)
    {
       int tmp;
       tmp = errno;
-      close(fd[portnum]);
+      close(port->fd);
       errno = tmp;
       OWERROR(OWERROR_SYSTEM_RESOURCE_INIT_FAILED);
       return FALSE; // changed (2.00), used to return rc;
@@ -208,7 +265,7 @@ SMALLINT _OpenCOM(int portnum, char *port_zstr)
    cfsetispeed (&t, B9600);
 
    // Get terminal parameters. (2.00) removed raw
-   tcgetattr(fd[portnum],&t);
+   tcgetattr(port->fd,&t);
    // Save original settings.
    origterm = t;
 
@@ -222,14 +279,16 @@ SMALLINT _OpenCOM(int portnum, char *port_zstr)
    t.c_cc[VMIN] = 0;
    t.c_cc[VTIME] = 3;
 
-   rc = tcsetattr(fd[portnum], TCSAFLUSH, &t);
-   tcflush(fd[portnum],TCIOFLUSH);
+   rc = tcsetattr(port->fd, TCSAFLUSH, &t);
+   tcflush(port->fd,TCIOFLUSH);
+   port->txpending = 0;
+   ClearCOMStats(portnum);
 
    if (rc < 0)
    {
       int tmp;
       tmp = errno;
-      close(fd[portnum]);
+      close(port->fd);
       errno = tmp;
       OWERROR(OWERROR_SYSTEM_RESOURCE_INIT_FAILED);
       return FALSE; // changed (2.00), used to return rc;
@@ -247,11 +306,15 @@ SMALLINT _OpenCOM(int portnum, char *port_zstr)
 //
 void _CloseCOM(int portnum)
 {
+#ifdef __linux__
+   owAsyncStop(portnum);
+#endif
+
    // restore tty settings
-   tcsetattr(fd[portnum], TCSAFLUSH, &origterm);
+   tcsetattr(owGetPort(portnum)->fd, TCSAFLUSH, &origterm);
    FlushCOM(portnum);
-   close(fd[portnum]);
-   fd[portnum] = 0;
+   close(owGetPort(portnum)->fd);
+   owGetPort(portnum)->fd = 0;
 }
 
 
@@ -266,67 +329,165 @@ void _CloseCOM(int portnum)
 //
 SMALLINT _WriteCOM(int portnum, int outlen, uchar *outbuf)
 {
-   long count = outlen;
-   int i = write(fd[portnum], outbuf, outlen);
+   OWPort *port = owGetPort(portnum);
+   struct pollfd pfd;
+   int cnt = 0, n;
+
+   // the port is non-blocking so loop on partial writes, the data is
+   // left to drain while the response is read (no tcdrain)
+   while (cnt < outlen)
+   {
+      n = write(port->fd, &outbuf[cnt], outlen - cnt);
+      port->comstats.write_syscalls++;
+      if (n > 0)
+      {
+         cnt += n;
+         continue;
+      }
+      if ((n < 0) && (errno != EAGAIN) && (errno != EINTR))
+         break;
 
-   tcdrain(fd[portnum]);
-   return (i == count);
+      // output queue full so wait for room
+      pfd.fd = port->fd;
+      pfd.events = POLLOUT;
+      port->comstats.poll_calls++;
+      if (poll(&pfd, 1, (int)((ReadTimeoutUs(portnum, 0) + 999) / 1000)) <= 0)
+         break;
+   }
+
+   port->comstats.bytes_written += cnt;
+   port->txpending += cnt;
+   return (cnt == outlen);
 }
 
 
 //--------------------------------------------------------------------------
-// Read an array of bytes to the COM port, verify that it was
-// sent out.  Assume that baud rate has been set.
+// Read an array of bytes from the COM port.  Whatever the kernel already
+// has buffered is taken in one read(), then the remainder is waited for
+// with one deadline computed from the current baud rate, the bytes still
+// being written and the number of bytes expected.
 //
 // 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
 //              OpenCOM to indicate the port number.
-// 'outlen'   - number of bytes to write to COM port
-// 'outbuf'   - pointer ot an array of bytes to write
+// 'inlen'    - number of bytes to read from COM port
+// 'inbuf'    - pointer to an array of bytes to read into
 //
-// Returns:  TRUE(1)  - success
-//           FALSE(0) - failure
+// Returns:  number of bytes read
 //
 int _ReadCOM(int portnum, int inlen, uchar *inbuf)
 {
-   fd_set         filedescr;
-   struct timeval tval;
-   int            cnt;
+   OWPort        *port = owGetPort(portnum);
+   struct pollfd  pfd;
+   int            cnt = 0, n;
+   long long      start, now, deadline;
 
-   // loop to wait until each byte is available and read it
-   for (cnt = 0; cnt < inlen; cnt++)
+   start = usGettick();
+   deadline = start + ReadTimeoutUs(portnum, inlen);
+   port->txpending = 0;
+   port->comstats.read_calls++;
+
+   while (cnt < inlen)
    {
-      // set a descriptor to wait for a character available
-      FD_ZERO(&filedescr);
-      FD_SET(fd[portnum],&filedescr);
-      // set timeout to 10ms
-      tval.tv_sec = 0;
-      tval.tv_usec = 10000;
-
-      // if byte available read or return bytes read
-      if (select(fd[portnum]+1,&filedescr,NULL,NULL,&tval) != 0)
+      // take everything available up to the requested length
+      n = read(port->fd, &inbuf[cnt], inlen - cnt);
+      port->comstats.read_syscalls++;
+      if (n > 0)
       {
-         if (read(fd[portnum],&inbuf[cnt],1) != 1)
-            return cnt;
+         cnt += n;
+         continue;
       }
-      else
-         return cnt;
+      if ((n < 0) && (errno != EAGAIN) && (errno != EINTR))
+         break;
+
+      // wait for the rest until the deadline
+      now = usGettick();
+      if (now >= deadline)
+         break;
+      pfd.fd = port->fd;
+      pfd.events = POLLIN;
+      port->comstats.poll_calls++;
+      n = poll(&pfd, 1, (int)((deadline - now + 999) / 1000));
+      if ((n == 0) || ((n < 0) && (errno != EINTR)))
+         break;
+   }
+
+   // record the result
+   now = usGettick();
+   if (cnt < inlen)
+      port->comstats.read_timeouts++;
+   port->comstats.bytes_read += cnt;
+   port->comstats.read_us_total += (ulong)(now - start);
+   if ((ulong)(now - start) > port->comstats.read_us_max)
+      port->comstats.read_us_max = (ulong)(now - start);
+
+   return cnt;
+}
+
+
+//--------------------------------------------------------------------------
+// Compute how long a read of 'inlen' bytes may take on the port.  Each
+// byte still being written and each byte expected costs 10 bit times at
+// the current baud and each response byte is allowed a 1-Wire byte time.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+// 'inlen'    - number of bytes expected
+//
+// Returns:  timeout in microseconds
+//
+static long ReadTimeoutUs(int portnum, int inlen)
+{
+   long byte_us;
+
+   switch (owGetPort(portnum)->UBaud)
+   {
+      case PARMSET_19200:  byte_us = 521;  break;
+      case PARMSET_57600:  byte_us = 174;  break;
+      case PARMSET_115200: byte_us = 87;   break;
+      default:             byte_us = 1042; break;
    }
 
-   // success, so return desired length
-   return inlen;
+   return READ_SLACK_MS * 1000L + (long)owGetPort(portnum)->txpending * byte_us +
+          (long)inlen * (byte_us + OW_BYTE_US);
+}
+
+
+//--------------------------------------------------------------------------
+// Get a copy of the COM statistics of a port.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+// 'stats'    - structure to receive the counters
+//
+void GetCOMStats(int portnum, COMStats *stats)
+{
+   *stats = owGetPort(portnum)->comstats;
+}
+
+
+//--------------------------------------------------------------------------
+// Clear the COM statistics of a port.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+//
+void ClearCOMStats(int portnum)
+{
+   memset(&owGetPort(portnum)->comstats, 0, sizeof(COMStats));
 }
 
 
 //---------------------------------------------------------------------------
 //  Description:
-//     flush the rx and tx buffers
+//     flush the rx buffer, data still being written is left to go out
+//     since WriteCOM does not wait for it
 //
 // 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
 //              OpenCOM to indicate the port number.
 //
 void _FlushCOM(int portnum)
 {
-   tcflush(fd[portnum], TCIOFLUSH);
+   tcflush(owGetPort(portnum)->fd, TCIFLUSH);
 }
 
 
@@ -340,7 +501,7 @@ void _FlushCOM(int portnum)
 void _BreakCOM(int portnum)
 {
    int duration = 0;              // see man termios break may be
-   tcsendbreak(fd[portnum], duration);     // too long
+   tcsendbreak(owGetPort(portnum)->fd, duration);     // too long
 }
 
 
@@ -362,10 +523,10 @@ void _SetBaudCOM(int portnum, uchar new_baud)
    speed_t baud = B9600;
 
    // read the attribute structure
-   rc = tcgetattr(fd[portnum], &t);
+   rc = tcgetattr(owGetPort(portnum)->fd, &t);
    if (rc < 0)
    {
-      close(fd[portnum]);
+      close(owGetPort(portnum)->fd);
       return;
    }
 
@@ -391,25 +552,20 @@ void _SetBaudCOM(int portnum, uchar new_baud)
    cfsetispeed(&t, baud);
 
    // change baud on port
-   rc = tcsetattr(fd[portnum], TCSAFLUSH, &t);
+   rc = tcsetattr(owGetPort(portnum)->fd, TCSAFLUSH, &t);
    if (rc < 0)
-      close(fd[portnum]);
+      close(owGetPort(portnum)->fd);
 }
 
 
 //--------------------------------------------------------------------------
 // Get the current millisecond tick count.  Does not have to represent
-// an actual time, it just needs to be an incrementing timer.
+// an actual time, it just needs to be an incrementing timer.  It is the
+// monotonic clock so it does not jump with the time of day.
 //
 long msGettick(void)
 {
-   struct timezone tmzone;
-   struct timeval  tmval;
-   long ms;
-
-   gettimeofday(&tmval,&tmzone);
-   ms = (tmval.tv_sec & 0xFFFF) * 1000 + tmval.tv_usec / 1000;
-   return ms;
+   return (long)(usGettick() / 1000);
 }
 
 
@@ -422,21 +578,7 @@ void msDelay(int len)
 #ifdef SMALL_MEMORY_TARGET
    posTaskSleep(MS(len));
 #else
-   struct timespec s;              // Set aside memory space on the stack
-   struct timespec left;
-   sigset_t set;
-   sigset_t save;
- 
-   sigemptyset(&set);
-   sigaddset(&set, SIGALRM);
-   sigprocmask(SIG_UNBLOCK, &set, &save);
-
-   s.tv_sec = len / 1000;
-   s.tv_nsec = (len - (s.tv_sec * 1000)) * 1000000;
-   while (nanosleep(&s, &left) == -1 && errno == EINTR)
-     s = left;
-
-   sigprocmask(SIG_SETMASK, &save, NULL);
+   usDelayUntil(usGettick() + (long long)len * 1000);
 #endif
 }
 
@@ -446,12 +588,12 @@ static void sigBlock(sigset_t* save)
  
   sigemptyset(&set);
   sigaddset(&set, SIGALRM);
-  sigprocmask(SIG_BLOCK, &set, save);
+  SIGMASK(SIG_BLOCK, &set, save);
 }
 
 static void sigRestore(sigset_t* old)
 {
-  sigprocmask(SIG_SETMASK, old, NULL);
+  SIGMASK(SIG_SETMASK, old, NULL);
 }
 
 SMALLINT OpenCOM(int portnum, char *port_zstr)
@@ -487,10 +629,12 @@ SMALLINT WriteCOM(int portnum, int outlen, uchar *outbuf)
 {
    SMALLINT ret;
    sigset_t save;
+   long long start = owStatsStart(portnum);
 
    sigBlock(&save);
    ret = _WriteCOM(portnum, outlen, outbuf);
    sigRestore(&save);
+   owStatsEnd(portnum, OWSTAT_COMWRITE, start, ret);
    return ret;
 }
 
@@ -498,10 +642,12 @@ int ReadCOM(int portnum, int inlen, uchar *inbuf)
 {
    int ret;
    sigset_t save;
+   long long start = owStatsStart(portnum);
 
    sigBlock(&save);
    ret = _ReadCOM(portnum, inlen, inbuf);
    sigRestore(&save);
+   owStatsEnd(portnum, OWSTAT_COMREAD, start, (ret == inlen));
    return ret;
 }
 
@@ -523,3 +669,425 @@ void SetBaudCOM(int portnum, uchar new_baud)
    sigRestore(&save);
 }
 
+
+#ifdef __linux__
+//--------------------------------------------------------------------------
+// Asynchronous packet exchanges (owasync.h).  Each started port has a
+// queue of requests and only the one at the head is on the wire.  The
+// port fd is in the epoll set for input while a request is on the wire,
+// and for output while the head packet is still being written.  A
+// timerfd in the same set fires at the earliest deadline so the epoll
+// fd is readable whenever there is something to do.
+//
+
+// create the epoll set and the timer on first use
+static SMALLINT AsyncInit(void)
+{
+   struct epoll_event ev;
+
+   if (AsyncEpoll >= 0)
+      return TRUE;
+
+   AsyncEpoll = epoll_create1(EPOLL_CLOEXEC);
+   AsyncTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC);
+   memset(&ev, 0, sizeof(ev));
+   ev.events = EPOLLIN;
+   ev.data.fd = ASYNC_TIMER;
+   if ((AsyncEpoll < 0) || (AsyncTimer < 0) ||
+       (epoll_ctl(AsyncEpoll, EPOLL_CTL_ADD, AsyncTimer, &ev) < 0))
+   {
+      if (AsyncEpoll >= 0)
+         close(AsyncEpoll);
+      if (AsyncTimer >= 0)
+         close(AsyncTimer);
+      AsyncEpoll = AsyncTimer = -1;
+      OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+//--------------------------------------------------------------------------
+// Get the file descriptor to wait on for asynchronous completions.  It
+// is an epoll fd, readable when owAsyncComplete(0) has work to do.
+//
+// Returns:  file descriptor, -1 if it could not be created
+//
+int owAsyncFd(void)
+{
+   if (!AsyncInit())
+      return -1;
+
+   return AsyncEpoll;
+}
+
+
+//--------------------------------------------------------------------------
+// Start asynchronous requests on an opened port.  Until owAsyncStop the
+// port must only be used with owAsyncSubmit, the synchronous functions
+// would take the responses of the queued requests.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+//
+// Returns:  TRUE(1)  - port started (or was already started)
+//           FALSE(0) - port not open or the epoll set failed
+//
+SMALLINT owAsyncStart(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+   AsyncPort *ap;
+   struct epoll_event ev;
+
+   OWASSERT( port->fd > 0, OWERROR_PORTNUM_ERROR, FALSE );
+   if (port->async != NULL)
+      return TRUE;
+   if (!AsyncInit())
+      return FALSE;
+
+   ap = (AsyncPort *)calloc(1, sizeof(AsyncPort));
+   if (ap == NULL)
+   {
+      OWERROR(OWERROR_GET_SYSTEM_RESOURCE_FAILED);
+      return FALSE;
+   }
+   ap->portnum = portnum;
+   // idle, input is not watched until a request is on the wire
+   ap->events = 0;
+
+   memset(&ev, 0, sizeof(ev));
+   ev.events = ap->events;
+   ev.data.fd = portnum;
+   if (epoll_ctl(AsyncEpoll, EPOLL_CTL_ADD, port->fd, &ev) < 0)
+   {
+      free(ap);
+      OWERROR(OWERROR_SYSTEM_RESOURCE_INIT_FAILED);
+      return FALSE;
+   }
+
+   ap->next = AsyncPorts;
+   AsyncPorts = ap;
+   port->async = ap;
+   return TRUE;
+}
+
+
+//--------------------------------------------------------------------------
+// Stop asynchronous requests on a port.  Requests still queued complete
+// with OWASYNC_CANCELLED.  The DS2480B may be left part way through a
+// packet so it should be re-synchronized (DS2480Detect) before the
+// synchronous functions are used again.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+//
+void owAsyncStop(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+   AsyncPort *ap = (AsyncPort *)port->async, **pp;
+
+   if (ap == NULL)
+      return;
+
+   epoll_ctl(AsyncEpoll, EPOLL_CTL_DEL, port->fd, NULL);
+
+   // only the head was started, the rest never went out
+   while (ap->head != NULL)
+   {
+      ap->head->status = OWASYNC_CANCELLED;
+      AsyncDone(ap);
+   }
+
+   for (pp = &AsyncPorts; *pp != NULL; pp = &(*pp)->next)
+      if (*pp == ap)
+      {
+         *pp = ap->next;
+         break;
+      }
+
+   free(ap);
+   port->async = NULL;
+   AsyncArm();
+}
+
+
+//--------------------------------------------------------------------------
+// Queue a packet exchange on a started port.  Writing starts right away
+// if the port is idle, the rest is done by owAsyncComplete.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+// 'req'      - request to fill in and queue, must stay valid until it
+//              is returned by owAsyncComplete
+// 'sendbuf'  - DS2480B packet to write
+// 'sendlen'  - length of the packet
+// 'readbuf'  - buffer for the response
+// 'readlen'  - number of response bytes expected
+//
+// Returns:  TRUE(1)  - request queued
+//           FALSE(0) - port not started with owAsyncStart
+//
+SMALLINT owAsyncSubmit(int portnum, owAsyncRequest *req, uchar *sendbuf,
+                       int sendlen, uchar *readbuf, int readlen)
+{
+   AsyncPort *ap = (AsyncPort *)owGetPort(portnum)->async;
+
+   OWASSERT( ap != NULL, OWERROR_PORTNUM_ERROR, FALSE );
+
+   req->sendbuf = sendbuf;
+   req->sendlen = sendlen;
+   req->readbuf = readbuf;
+   req->readlen = readlen;
+   req->portnum = portnum;
+   req->status = OWASYNC_PENDING;
+   req->count = 0;
+   req->sent = 0;
+   req->next = NULL;
+
+   if (ap->tail != NULL)
+      ap->tail->next = req;
+   else
+      ap->head = req;
+   ap->tail = req;
+
+   // port was idle
+   if (ap->head == req)
+   {
+      AsyncBegin(ap);
+      AsyncProgress(ap);
+      AsyncArm();
+   }
+
+   return TRUE;
+}
+
+
+//--------------------------------------------------------------------------
+// Do the I/O that is ready on the started ports and return a request
+// that has completed.  Call with 0 when owAsyncFd is readable, until it
+// returns NULL.
+//
+// 'timeout_ms' - time to wait for a completion, 0 does not wait and -1
+//                waits until there is one
+//
+// Returns:  completed request, NULL if none completed in the time
+//
+owAsyncRequest *owAsyncComplete(int timeout_ms)
+{
+   owAsyncRequest *req;
+   long long end, now;
+   int wait = timeout_ms;
+
+   if (!AsyncInit())
+      return NULL;
+
+   end = usGettick() + (long long)timeout_ms * 1000;
+   while (AsyncDoneHead == NULL)
+   {
+      AsyncPoll(wait);
+
+      if (timeout_ms >= 0)
+      {
+         now = usGettick();
+         if (now >= end)
+            break;
+         wait = (int)((end - now + 999) / 1000);
+      }
+   }
+
+   req = AsyncDoneHead;
+   if (req != NULL)
+   {
+      AsyncDoneHead = req->next;
+      if (AsyncDoneHead == NULL)
+         AsyncDoneTail = NULL;
+      req->next = NULL;
+   }
+
+   return req;
+}
+
+
+//--------------------------------------------------------------------------
+// Put the request at the head of a port on the wire: discard any stale
+// input and set its deadline as ReadCOM would.
+//
+static void AsyncBegin(AsyncPort *ap)
+{
+   OWPort *port = owGetPort(ap->portnum);
+   owAsyncRequest *req = ap->head;
+
+   tcflush(port->fd, TCIFLUSH);
+   port->txpending = req->sendlen;
+   req->deadline = usGettick() + ReadTimeoutUs(ap->portnum, req->readlen);
+   port->txpending = 0;
+   port->comstats.read_calls++;
+}
+
+
+//--------------------------------------------------------------------------
+// Move the request at the head of a port to the completed list and put
+// the next one on the wire.  The request 'status' must already be set.
+//
+static void AsyncDone(AsyncPort *ap)
+{
+   owAsyncRequest *req = ap->head;
+
+   ap->head = req->next;
+   if (ap->head == NULL)
+      ap->tail = NULL;
+
+   req->next = NULL;
+   if (AsyncDoneTail != NULL)
+      AsyncDoneTail->next = req;
+   else
+      AsyncDoneHead = req;
+   AsyncDoneTail = req;
+
+   if ((ap->head != NULL) && (req->status != OWASYNC_CANCELLED))
+      AsyncBegin(ap);
+}
+
+
+//--------------------------------------------------------------------------
+// Write and read what the port allows without blocking, completing
+// requests as their responses arrive.
+//
+static void AsyncProgress(AsyncPort *ap)
+{
+   OWPort *port = owGetPort(ap->portnum);
+   owAsyncRequest *req;
+   struct epoll_event ev;
+   int n, events;
+
+   while ((req = ap->head) != NULL)
+   {
+      // write what the output queue takes
+      while (req->sent < req->sendlen)
+      {
+         n = write(port->fd, &req->sendbuf[req->sent], req->sendlen - req->sent);
+         port->comstats.write_syscalls++;
+         if (n > 0)
+         {
+            req->sent += n;
+            port->comstats.bytes_written += n;
+            continue;
+         }
+         if ((n < 0) && (errno != EAGAIN) && (errno != EINTR))
+            req->status = OWASYNC_IOERROR;
+         break;
+      }
+
+      // take the response bytes that have arrived
+      while ((req->status == OWASYNC_PENDING) && (req->count < req->readlen))
+      {
+         n = read(port->fd, &req->readbuf[req->count], req->readlen - req->count);
+         port->comstats.read_syscalls++;
+         if (n > 0)
+         {
+            req->count += n;
+            port->comstats.bytes_read += n;
+            continue;
+         }
+         if ((n < 0) && (errno != EAGAIN) && (errno != EINTR))
+            req->status = OWASYNC_IOERROR;
+         break;
+      }
+
+      if ((req->status == OWASYNC_PENDING) && (req->sent == req->sendlen) &&
+          (req->count == req->readlen))
+         req->status = OWASYNC_OK;
+
+      if (req->status == OWASYNC_PENDING)
+         break;
+      AsyncDone(ap);
+   }
+
+   // an idle port is not watched for input, stray bytes stay in the
+   // driver until AsyncBegin flushes them, and output room is only
+   // waited for while a packet is part way out
+   events = 0;
+   if (ap->head != NULL)
+   {
+      events = EPOLLIN;
+      if (ap->head->sent < ap->head->sendlen)
+         events |= EPOLLOUT;
+   }
+   if (events != ap->events)
+   {
+      memset(&ev, 0, sizeof(ev));
+      ev.events = events;
+      ev.data.fd = ap->portnum;
+      epoll_ctl(AsyncEpoll, EPOLL_CTL_MOD, port->fd, &ev);
+      ap->events = events;
+   }
+}
+
+
+//--------------------------------------------------------------------------
+// Set the timer to the earliest deadline of the requests on the wire.
+//
+static void AsyncArm(void)
+{
+   struct itimerspec its;
+   AsyncPort *ap;
+   long long first = 0;
+
+   for (ap = AsyncPorts; ap != NULL; ap = ap->next)
+      if ((ap->head != NULL) && ((first == 0) || (ap->head->deadline < first)))
+         first = ap->head->deadline;
+
+   // a zero it_value disarms the timer
+   memset(&its, 0, sizeof(its));
+   if (first != 0)
+   {
+      its.it_value.tv_sec = (time_t)(first / 1000000);
+      its.it_value.tv_nsec = (long)(first % 1000000) * 1000;
+   }
+   timerfd_settime(AsyncTimer, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+
+//--------------------------------------------------------------------------
+// Wait for and handle the events of the epoll set, then time out the
+// requests that are past their deadline.
+//
+// 'timeout_ms' - epoll_wait timeout
+//
+static void AsyncPoll(int timeout_ms)
+{
+   struct epoll_event ev[ASYNC_EVENTS];
+   AsyncPort *ap;
+   uint64_t expirations;
+   long long now;
+   int i, n;
+
+   n = epoll_wait(AsyncEpoll, ev, ASYNC_EVENTS, timeout_ms);
+   for (i = 0; i < n; i++)
+   {
+      if (ev[i].data.fd == ASYNC_TIMER)
+      {
+         if (read(AsyncTimer, &expirations, sizeof(expirations)) < 0)
+            continue;
+      }
+      else if ((ap = (AsyncPort *)owGetPort(ev[i].data.fd)->async) != NULL)
+         AsyncProgress(ap);
+   }
+
+   now = usGettick();
+   for (ap = AsyncPorts; ap != NULL; ap = ap->next)
+   {
+      if ((ap->head != NULL) && (ap->head->deadline <= now))
+      {
+         owGetPort(ap->portnum)->comstats.read_timeouts++;
+         ap->head->status = OWASYNC_TIMEOUT;
+         AsyncDone(ap);
+         AsyncProgress(ap);
+      }
+   }
+
+   AsyncArm();
+}
+#endif
@@ -33,6 +33,7 @@
 //
 
 #include "ownet.h"
+#include "owport.h"
 
 #ifndef __MC68K__
 #include <stdlib.h>
@@ -194,6 +195,10 @@
 // exportable functions defined in ds2480ut.c
 SMALLINT DS2480Detect(int portnum);
 SMALLINT DS2480ChangeBaud(int portnum, uchar newbaud);
+SMALLINT DS2480MaxBaud(int portnum, uchar maxbaud);
+
+// exportable functions defined in owsesu.c
+int      owAcquireExBaud(char *port_zstr, SMALLINT max_baud);
 
 // link functions from win32lnk.c or other link files
 SMALLINT  OpenCOM(int portnum, char *port_zstr);
@@ -204,3 +209,8 @@ SMALLINT  WriteCOM(int portnum, int outlen, uchar *outbuf);
 int       ReadCOM(int portnum, int inlen, uchar *inbuf);
 void      BreakCOM(int portnum);
 void      SetBaudCOM(int portnum, uchar new_baud);
+
+// COM statistics kept by linuxlnk.c (COMStats is in owport.h)
+
+void      GetCOMStats(int portnum, COMStats *stats);
+void      ClearCOMStats(int portnum);
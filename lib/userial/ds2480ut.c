@@ -40,20 +40,25 @@
 //           2.01 -> 2.10 Added raw memory error handling and SMALLINT
 //           2.10 -> 3.00 Added memory bank functionality
 //                        Added file I/O operations
+//           3.00 -> 3.01 DS2480B state moved to the OWPort state
+//           3.01 -> 3.02 Added DS2480MaxBaud, DS2480Detect restores the
+//                        negotiated baud rate
 //
 
 #include "ownet.h"
 #include "ds2480.h"
 
-// global DS2480B state
-SMALLINT ULevel[MAX_PORTNUM]; // current DS2480B 1-Wire Net level
-SMALLINT UBaud[MAX_PORTNUM];  // current DS2480B baud rate
-SMALLINT UMode[MAX_PORTNUM];  // current DS2480B command or data mode state
-SMALLINT USpeed[MAX_PORTNUM]; // current DS2480B 1-Wire Net communication speed
-SMALLINT UVersion[MAX_PORTNUM]; // current DS2480B version 
+// parameter read groups sent by BaudLoopback
+#define LOOPBACK_READS     4
+
+// local functions
+static SMALLINT Detect9600(int portnum);
+static SMALLINT BaudLoopback(int portnum);
 
 //---------------------------------------------------------------------------
-// Attempt to resyc and detect a DS2480B
+// Attempt to resyc and detect a DS2480B.  If a higher baud rate was
+// negotiated with DS2480MaxBaud the DS2480B is put back to it, stepping
+// the preferred rate down when it no longer passes the loopback.
 //
 // 'portnum'    - number 0 to MAX_PORTNUM-1.  This number was provided to
 //                OpenCOM to indicate the port number.
@@ -63,16 +68,140 @@ SMALLINT UVersion[MAX_PORTNUM]; // current DS2480B version
 //
 SMALLINT DS2480Detect(int portnum)
 {
+   OWPort *port = owGetPort(portnum);
+
+   if (!Detect9600(portnum))
+      return FALSE;
+
+   // re-negotiate the preferred rate
+   while (port->UPrefBaud > PARMSET_9600)
+   {
+      if ((DS2480ChangeBaud(portnum,(uchar)port->UPrefBaud) == port->UPrefBaud) &&
+          BaudLoopback(portnum))
+         break;
+
+      // fall back to the next lower rate
+      port->UPrefBaud -= 2;
+      if (!Detect9600(portnum))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+//---------------------------------------------------------------------------
+// Negotiate the highest baud rate that works with the DS2480B, starting
+// at 'maxbaud' and stepping down.  Each rate is checked with a loopback
+// of parameter reads.  The rate found is kept as the preferred rate of
+// the port: owSpeed(MODE_NORMAL) goes back to it instead of 9600 and
+// DS2480Detect restores it after a re-sync.
+//
+// 'portnum' - number 0 to MAX_PORTNUM-1.  This number was provided to
+//             OpenCOM to indicate the port number.
+// 'maxbaud' - highest baud rate to try, defined as:
+//               PARMSET_9600     0x00
+//               PARMSET_19200    0x02
+//               PARMSET_57600    0x04
+//               PARMSET_115200   0x06
+//
+// Returns:  the baud rate the DS2480B was left at
+//
+SMALLINT DS2480MaxBaud(int portnum, uchar maxbaud)
+{
+   OWPort *port = owGetPort(portnum);
+
+   port->UPrefBaud = (maxbaud > PARMSET_115200) ? PARMSET_115200 : (maxbaud & 0x06);
+
+   // DS2480Detect does the stepping down
+   if (!DS2480Detect(portnum))
+      port->UPrefBaud = PARMSET_9600;
+
+   return port->UBaud;
+}
+
+//---------------------------------------------------------------------------
+// Read back the configuration DS2480Detect and DS2480ChangeBaud set, 
+// LOOPBACK_READS times, to check the link at the current baud rate.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                OpenCOM to indicate the port number.
+//
+// Returns:  TRUE  - every parameter read back correctly
+//           FALSE - the link is not reliable at this rate
+//
+static SMALLINT BaudLoopback(int portnum)
+{
+   uchar sendpacket[LOOPBACK_READS * 4 + 1],readbuffer[LOOPBACK_READS * 4];
+   uchar expect[LOOPBACK_READS * 4];
+   int i,sendlen=0,rdlen=0;
+   OWPort *port = owGetPort(portnum);
+
+   // check if correct mode
+   if (port->UMode != MODSEL_COMMAND)
+   {
+      port->UMode = MODSEL_COMMAND;
+      sendpacket[sendlen++] = MODE_COMMAND;
+   }
+
+   for (i = 0; i < LOOPBACK_READS; i++)
+   {
+      sendpacket[sendlen++] = CMD_CONFIG | PARMSEL_PARMREAD | (PARMSEL_SLEW >> 3);
+      expect[rdlen++] = PARMSET_Slew1p37Vus;
+      sendpacket[sendlen++] = CMD_CONFIG | PARMSEL_PARMREAD | (PARMSEL_WRITE1LOW >> 3);
+      expect[rdlen++] = PARMSET_Write10us;
+      sendpacket[sendlen++] = CMD_CONFIG | PARMSEL_PARMREAD | (PARMSEL_SAMPLEOFFSET >> 3);
+      expect[rdlen++] = PARMSET_SampOff8us;
+      sendpacket[sendlen++] = CMD_CONFIG | PARMSEL_PARMREAD | (PARMSEL_BAUDRATE >> 3);
+      expect[rdlen++] = (uchar)port->UBaud;
+   }
+
+   // flush the buffers
+   FlushCOM(portnum);
+
+   if (!WriteCOM(portnum,sendlen,sendpacket))
+   {
+      OWERROR(OWERROR_WRITECOM_FAILED);
+      return FALSE;
+   }
+   if (ReadCOM(portnum,rdlen,readbuffer) != rdlen)
+   {
+      OWERROR(OWERROR_READCOM_FAILED);
+      return FALSE;
+   }
+
+   // the value is in bits 1-3, the rest of the response is 0
+   for (i = 0; i < rdlen; i++)
+      if (readbuffer[i] != expect[i])
+      {
+         OWERROR(OWERROR_DS2480_BAD_RESPONSE);
+         return FALSE;
+      }
+
+   return TRUE;
+}
+
+//---------------------------------------------------------------------------
+// Reset the DS2480B with a break and detect it at 9600 baud.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                OpenCOM to indicate the port number.
+//
+// Returns:  TRUE  - DS2480B detected successfully
+//           FALSE - Could not detect DS2480B
+//
+static SMALLINT Detect9600(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[10],readbuffer[10];
    uchar sendlen=0;
 
    // reset modes
-   UMode[portnum] = MODSEL_COMMAND;
-   UBaud[portnum] = PARMSET_9600;
-   USpeed[portnum] = SPEEDSEL_FLEX;
+   port->UMode = MODSEL_COMMAND;
+   port->UBaud = PARMSET_9600;
+   port->USpeed = SPEEDSEL_FLEX;
 
    // set the baud rate to 9600
-   SetBaudCOM(portnum,(uchar)UBaud[portnum]);
+   SetBaudCOM(portnum,(uchar)port->UBaud);
 
    // send a break to reset the DS2480
    BreakCOM(portnum);
@@ -106,7 +235,7 @@ SMALLINT DS2480Detect(int portnum)
    sendpacket[sendlen++] = CMD_CONFIG | PARMSEL_PARMREAD | (PARMSEL_BAUDRATE >> 3);
 
    // also do 1 bit operation (to test 1-Wire block)
-   sendpacket[sendlen++] = CMD_COMM | FUNCTSEL_BIT | UBaud[portnum] | BITPOL_ONE;
+   sendpacket[sendlen++] = CMD_COMM | FUNCTSEL_BIT | port->UBaud | BITPOL_ONE;
 
    // flush the buffers
    FlushCOM(portnum);
@@ -120,9 +249,9 @@ SMALLINT DS2480Detect(int portnum)
          // look at the baud rate and bit operation
          // to see if the response makes sense
          if (((readbuffer[3] & 0xF1) == 0x00) &&
-             ((readbuffer[3] & 0x0E) == UBaud[portnum]) &&
+             ((readbuffer[3] & 0x0E) == port->UBaud) &&
              ((readbuffer[4] & 0xF0) == 0x90) &&
-             ((readbuffer[4] & 0x0C) == UBaud[portnum]))
+             ((readbuffer[4] & 0x0C) == port->UBaud))
             return TRUE;
          else
             OWERROR(OWERROR_DS2480_BAD_RESPONSE);
@@ -151,20 +280,21 @@ SMALLINT DS2480Detect(int portnum)
 //
 SMALLINT DS2480ChangeBaud(int portnum, uchar newbaud)
 {
+   OWPort *port = owGetPort(portnum);
    uchar rt=FALSE;
    uchar readbuffer[5],sendpacket[5],sendpacket2[5];
    uchar sendlen=0,sendlen2=0;
 
    // see if diffenent then current baud rate
-   if (UBaud[portnum] == newbaud)
-      return UBaud[portnum];
+   if (port->UBaud == newbaud)
+      return port->UBaud;
    else
    {
       // build the command packet
       // check if correct mode
-      if (UMode[portnum] != MODSEL_COMMAND)
+      if (port->UMode != MODSEL_COMMAND)
       {
-         UMode[portnum] = MODSEL_COMMAND;
+         port->UMode = MODSEL_COMMAND;
          sendpacket[sendlen++] = MODE_COMMAND;
       }
       // build the command
@@ -186,7 +316,7 @@ SMALLINT DS2480ChangeBaud(int portnum, uchar newbaud)
 
          // change our baud rate
          SetBaudCOM(portnum,newbaud);
-         UBaud[portnum] = newbaud;
+         port->UBaud = newbaud;
 
          // wait for things to settle
          msDelay(5);
@@ -217,9 +347,15 @@ SMALLINT DS2480ChangeBaud(int portnum, uchar newbaud)
       }
    }
 
-   // if lost communication with DS2480 then reset
+   // if lost communication with DS2480 then reset, a failure at the
+   // preferred rate is left to the re-negotiation in DS2480Detect
    if (rt != TRUE)
-      DS2480Detect(portnum);
+   {
+      if (newbaud == port->UPrefBaud)
+         Detect9600(portnum);
+      else
+         DS2480Detect(portnum);
+   }
 
-   return UBaud[portnum];
+   return port->UBaud;
 }
@@ -27,7 +27,7 @@
 //  owLLU.C - Link Layer 1-Wire Net functions using the DS2480/DS2480B (U)
 //            serial interface chip.
 //
-//  Version: 3.00
+//  Version: 3.04
 //
 //  History: 1.00 -> 1.01  DS2480 version number now ignored in
 //                         owTouchReset.
@@ -43,26 +43,25 @@
 //                        Added owReadBitPower and owWriteBytePower
 //                        Added support for THE LINK
 //                        Updated owLevel to match AN192
+//           3.00 -> 3.01 DS2480B state moved to the OWPort state
+//           3.01 -> 3.02 owSpeed uses the baud rate found by DS2480MaxBaud
+//           3.02 -> 3.03 owTouchReset and owLevel are timed by owstats.c
+//           3.03 -> 3.04 owTouchReset ends the owsess.c session
 //
 
 #include "ownet.h"
+#include "owsess.h"
+#include "owstats.h"
 #include "ds2480.h"
 
-int dodebug=0;
+// local functions
+static uchar OverdriveBaud(int portnum);
 
-// external globals
-extern SMALLINT ULevel[MAX_PORTNUM]; // current DS2480B 1-Wire Net level
-extern SMALLINT UBaud[MAX_PORTNUM];  // current DS2480B baud rate
-extern SMALLINT UMode[MAX_PORTNUM];  // current DS2480B command or data mode state
-extern SMALLINT USpeed[MAX_PORTNUM]; // current DS2480B 1-Wire Net communication speed
-extern SMALLINT UVersion[MAX_PORTNUM]; // current DS2480B version
+int dodebug=0;
 
 // new global for DS1994/DS2404/DS1427.  If TRUE, puts a delay in owTouchReset to compensate for alarming clocks.
 SMALLINT FAMILY_CODE_04_ALARM_TOUCHRESET_COMPLIANCE = FALSE; // default owTouchReset to quickest response.
 
-// local varable flag, true if program voltage available
-static SMALLINT ProgramAvailable[MAX_PORTNUM];
-
 //--------------------------------------------------------------------------
 // Reset all of the devices on the 1-Wire Net and return the result.
 //
@@ -80,24 +79,29 @@ static SMALLINT ProgramAvailable[MAX_PORTNUM];
 //
 SMALLINT owTouchReset(int portnum)
 {
+   OWPort *port = owGetPort(portnum);
    uchar readbuffer[10],sendpacket[10];
    uchar sendlen=0;
+   long long start = owStatsStart(portnum);
 
    if (dodebug)
       printf("\nRST ");//??????????????
 
+   // a reset deselects the device of the session
+   owSessionEnd(portnum);
+
    // make sure normal level
    owLevel(portnum,MODE_NORMAL);
 
    // check if correct mode
-   if (UMode[portnum] != MODSEL_COMMAND)
+   if (port->UMode != MODSEL_COMMAND)
    {
-      UMode[portnum] = MODSEL_COMMAND;
+      port->UMode = MODSEL_COMMAND;
       sendpacket[sendlen++] = MODE_COMMAND;
    }
 
    // construct the command
-   sendpacket[sendlen++] = (uchar)(CMD_COMM | FUNCTSEL_RESET | USpeed[portnum]);
+   sendpacket[sendlen++] = (uchar)(CMD_COMM | FUNCTSEL_RESET | port->USpeed);
 
    // flush the buffers
    FlushCOM(portnum);
@@ -113,16 +117,17 @@ SMALLINT owTouchReset(int portnum)
              ((readbuffer[0] & RB_RESET_MASK) == RB_ALARMPRESENCE))
          {
             // check if programming voltage available
-            ProgramAvailable[portnum] = ((readbuffer[0] & 0x20) == 0x20);
-            UVersion[portnum] = (readbuffer[0] & VERSION_MASK);
+            port->ProgramAvailable = ((readbuffer[0] & 0x20) == 0x20);
+            port->UVersion = (readbuffer[0] & VERSION_MASK);
 
             // only check for alarm pulse if DS2404 present and not using THE LINK
             if ((FAMILY_CODE_04_ALARM_TOUCHRESET_COMPLIANCE) &&
-                (UVersion[portnum] != VER_LINK))
+                (port->UVersion != VER_LINK))
             {
                msDelay(5); // delay 5 ms to give DS1994 enough time
                FlushCOM(portnum);
             }
+            owStatsEnd(portnum,OWSTAT_RESET,start,TRUE);
             return TRUE;
          }
          else
@@ -138,6 +143,7 @@ SMALLINT owTouchReset(int portnum)
    // an error occured so re-sync with DS2480
    DS2480Detect(portnum);
 
+   owStatsEnd(portnum,OWSTAT_RESET,start,FALSE);
    return FALSE;
 }
 
@@ -156,6 +162,7 @@ SMALLINT owTouchReset(int portnum)
 //
 SMALLINT owTouchBit(int portnum, SMALLINT sendbit)
 {
+   OWPort *port = owGetPort(portnum);
    uchar readbuffer[10],sendpacket[10];
    uchar sendlen=0;
 
@@ -163,15 +170,15 @@ SMALLINT owTouchBit(int portnum, SMALLINT sendbit)
    owLevel(portnum,MODE_NORMAL);
 
    // check if correct mode
-   if (UMode[portnum] != MODSEL_COMMAND)
+   if (port->UMode != MODSEL_COMMAND)
    {
-      UMode[portnum] = MODSEL_COMMAND;
+      port->UMode = MODSEL_COMMAND;
       sendpacket[sendlen++] = MODE_COMMAND;
    }
 
    // construct the command
    sendpacket[sendlen] = (sendbit != 0) ? BITPOL_ONE : BITPOL_ZERO;
-   sendpacket[sendlen++] |= CMD_COMM | FUNCTSEL_BIT | USpeed[portnum];
+   sendpacket[sendlen++] |= CMD_COMM | FUNCTSEL_BIT | port->USpeed;
 
    // flush the buffers
    FlushCOM(portnum);
@@ -247,6 +254,7 @@ SMALLINT owReadByte(int portnum)
 //
 SMALLINT owTouchByte(int portnum, SMALLINT sendbyte)
 {
+   OWPort *port = owGetPort(portnum);
    uchar readbuffer[10],sendpacket[10];
    uchar sendlen=0;
 
@@ -254,9 +262,9 @@ SMALLINT owTouchByte(int portnum, SMALLINT sendbyte)
    owLevel(portnum,MODE_NORMAL);
 
    // check if correct mode
-   if (UMode[portnum] != MODSEL_DATA)
+   if (port->UMode != MODSEL_DATA)
    {
-      UMode[portnum] = MODSEL_DATA;
+      port->UMode = MODSEL_DATA;
       sendpacket[sendlen++] = MODE_DATA;
    }
 
@@ -307,34 +315,36 @@ SMALLINT owTouchByte(int portnum, SMALLINT sendbyte)
 //
 SMALLINT owSpeed(int portnum, SMALLINT new_speed)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[5];
    uchar sendlen=0;
    uchar rt = FALSE;
 
    // check if change from current mode
    if (((new_speed == MODE_OVERDRIVE) &&
-        (USpeed[portnum] != SPEEDSEL_OD)) ||
+        (port->USpeed != SPEEDSEL_OD)) ||
        ((new_speed == MODE_NORMAL) &&
-        (USpeed[portnum] != SPEEDSEL_FLEX)))
+        (port->USpeed != SPEEDSEL_FLEX)))
    {
       if (new_speed == MODE_OVERDRIVE)
       {
          // check for unsupported mode in THE LINK
-         if (UVersion[portnum] == VER_LINK)
+         if (port->UVersion == VER_LINK)
             OWERROR(OWERROR_FUNC_NOT_SUP);
          // if overdrive then switch to higher baud
-         else if (DS2480ChangeBaud(portnum,MAX_BAUD) == MAX_BAUD)
+         else if (DS2480ChangeBaud(portnum,OverdriveBaud(portnum)) == OverdriveBaud(portnum))
          {
-            USpeed[portnum] = SPEEDSEL_OD;
+            port->USpeed = SPEEDSEL_OD;
             rt = TRUE;
          }
       }
       else if (new_speed == MODE_NORMAL)
       {
-         // else normal so set to 9600 baud
-         if (DS2480ChangeBaud(portnum,PARMSET_9600) == PARMSET_9600)
+         // else normal so back to 9600 or the rate DS2480MaxBaud found
+         if (DS2480ChangeBaud(portnum,(uchar)port->UPrefBaud) == 
+             port->UPrefBaud)
          {
-            USpeed[portnum] = SPEEDSEL_FLEX;
+            port->USpeed = SPEEDSEL_FLEX;
             rt = TRUE;
          }
 
@@ -344,14 +354,14 @@ SMALLINT owSpeed(int portnum, SMALLINT new_speed)
       if (rt)
       {
          // check if correct mode
-         if (UMode[portnum] != MODSEL_COMMAND)
+         if (port->UMode != MODSEL_COMMAND)
          {
-            UMode[portnum] = MODSEL_COMMAND;
+            port->UMode = MODSEL_COMMAND;
             sendpacket[sendlen++] = MODE_COMMAND;
          }
 
          // proceed to set the DS2480 communication speed
-         sendpacket[sendlen++] = CMD_COMM | FUNCTSEL_SEARCHOFF | USpeed[portnum];
+         sendpacket[sendlen++] = CMD_COMM | FUNCTSEL_SEARCHOFF | port->USpeed;
 
          // send the packet
          if (!WriteCOM(portnum,sendlen,sendpacket))
@@ -365,7 +375,26 @@ SMALLINT owSpeed(int portnum, SMALLINT new_speed)
    }
 
    // return the current speed
-   return (USpeed[portnum] == SPEEDSEL_OD) ? MODE_OVERDRIVE : MODE_NORMAL;
+   return (port->USpeed == SPEEDSEL_OD) ? MODE_OVERDRIVE : MODE_NORMAL;
+}
+
+//--------------------------------------------------------------------------
+// Get the baud rate to run overdrive at, the rate found by DS2480MaxBaud
+// if it was used and MAX_BAUD if not.
+//
+// 'portnum'   - number 0 to MAX_PORTNUM-1.  This number was provided to
+//               OpenCOM to indicate the port number.
+//
+// Returns:  PARMSET_xxx baud rate
+//
+static uchar OverdriveBaud(int portnum)
+{
+   OWPort *port = owGetPort(portnum);
+
+   if (port->UPrefBaud > PARMSET_9600)
+      return (uchar)port->UPrefBaud;
+
+   return MAX_BAUD;
 }
 
 //--------------------------------------------------------------------------
@@ -384,17 +413,21 @@ SMALLINT owSpeed(int portnum, SMALLINT new_speed)
 //
 SMALLINT owLevel(int portnum, SMALLINT new_level)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[10],readbuffer[10];
    uchar sendlen=0;
    uchar rt=FALSE;
+   long long start;
 
    // check if need to change level
-   if (new_level != ULevel[portnum])
+   if (new_level != port->ULevel)
    {
+      start = owStatsStart(portnum);
+
       // check if correct mode
-      if (UMode[portnum] != MODSEL_COMMAND)
+      if (port->UMode != MODSEL_COMMAND)
       {
-         UMode[portnum] = MODSEL_COMMAND;
+         port->UMode = MODSEL_COMMAND;
          sendpacket[sendlen++] = MODE_COMMAND;
       }
 
@@ -424,7 +457,8 @@ SMALLINT owLevel(int portnum, SMALLINT new_level)
                    ((readbuffer[1] & 0xE0) == 0xE0))
                {
                   rt = TRUE;
-                  ULevel[portnum] = MODE_NORMAL;
+                  port->ULevel = MODE_NORMAL;
+                  owStatsLevel(portnum,MODE_NORMAL);
                }
             }
             else
@@ -448,8 +482,11 @@ SMALLINT owLevel(int portnum, SMALLINT new_level)
          else if (new_level == MODE_PROGRAM)
          {
             // check if programming voltage available
-            if (!ProgramAvailable[portnum])
+            if (!port->ProgramAvailable)
+            {
+               owStatsEnd(portnum,OWSTAT_LEVEL,start,FALSE);
                return MODE_NORMAL;
+            }
 
             // set the PPD time value
             sendpacket[sendlen++] = CMD_CONFIG | PARMSEL_12VPULSE | PARMSET_infinite;
@@ -469,7 +506,8 @@ SMALLINT owLevel(int portnum, SMALLINT new_level)
                // check response byte
                if ((readbuffer[0] & 0x81) == 0)
                {
-                  ULevel[portnum] = new_level;
+                  port->ULevel = new_level;
+                  owStatsLevel(portnum,new_level);
                   rt = TRUE;
                }
             }
@@ -483,10 +521,12 @@ SMALLINT owLevel(int portnum, SMALLINT new_level)
       // if lost communication with DS2480 then reset
       if (rt != TRUE)
          DS2480Detect(portnum);
+
+      owStatsEnd(portnum,OWSTAT_LEVEL,start,rt);
    }
 
    // return the current level
-   return ULevel[portnum];
+   return port->ULevel;
 }
 
 //--------------------------------------------------------------------------
@@ -501,20 +541,21 @@ SMALLINT owLevel(int portnum, SMALLINT new_level)
 //
 SMALLINT owProgramPulse(int portnum)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[10],readbuffer[10];
    uchar sendlen=0;
 
    // check if programming voltage available
-   if (!ProgramAvailable[portnum])
+   if (!port->ProgramAvailable)
       return FALSE;
 
    // make sure normal level
    owLevel(portnum,MODE_NORMAL);
 
    // check if correct mode
-   if (UMode[portnum] != MODSEL_COMMAND)
+   if (port->UMode != MODSEL_COMMAND)
    {
-      UMode[portnum] = MODSEL_COMMAND;
+      port->UMode = MODSEL_COMMAND;
       sendpacket[sendlen++] = MODE_COMMAND;
    }
 
@@ -567,6 +608,7 @@ SMALLINT owProgramPulse(int portnum)
 //
 SMALLINT owWriteBytePower(int portnum, SMALLINT sendbyte)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[10],readbuffer[10];
    uchar sendlen=0;
    uchar rt=FALSE;
@@ -576,9 +618,9 @@ SMALLINT owWriteBytePower(int portnum, SMALLINT sendbyte)
       printf("P%02X ",sendbyte);//??????????????
 
    // check if correct mode
-   if (UMode[portnum] != MODSEL_COMMAND)
+   if (port->UMode != MODSEL_COMMAND)
    {
-      UMode[portnum] = MODSEL_COMMAND;
+      port->UMode = MODSEL_COMMAND;
       sendpacket[sendlen++] = MODE_COMMAND;
    }
 
@@ -591,7 +633,7 @@ SMALLINT owWriteBytePower(int portnum, SMALLINT sendbyte)
    for (i = 0; i < 8; i++)
    {
       sendpacket[sendlen++] = ((temp_byte & 0x01) ? BITPOL_ONE : BITPOL_ZERO)
-                              | CMD_COMM | FUNCTSEL_BIT | USpeed[portnum] |
+                              | CMD_COMM | FUNCTSEL_BIT | port->USpeed |
                               ((i == 7) ? PRIME5V_TRUE : PRIME5V_FALSE);
       temp_byte >>= 1;
    }
@@ -609,7 +651,8 @@ SMALLINT owWriteBytePower(int portnum, SMALLINT sendbyte)
          if ((readbuffer[0] & 0x81) == 0)
          {
             // indicate the port is now at power delivery
-            ULevel[portnum] = MODE_STRONG5;
+            port->ULevel = MODE_STRONG5;
+            owStatsLevel(portnum,MODE_STRONG5);
 
             // reconstruct the echo byte
             temp_byte = 0;
@@ -651,15 +694,16 @@ SMALLINT owWriteBytePower(int portnum, SMALLINT sendbyte)
 //
 SMALLINT owReadBytePower(int portnum)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[10],readbuffer[10];
    uchar sendlen=0;
    uchar rt=FALSE;
    uchar i, temp_byte;
 
    // check if correct mode
-   if (UMode[portnum] != MODSEL_COMMAND)
+   if (port->UMode != MODSEL_COMMAND)
    {
-      UMode[portnum] = MODSEL_COMMAND;
+      port->UMode = MODSEL_COMMAND;
       sendpacket[sendlen++] = MODE_COMMAND;
    }
 
@@ -672,7 +716,7 @@ SMALLINT owReadBytePower(int portnum)
    for (i = 0; i < 8; i++)
    {
       sendpacket[sendlen++] = ((temp_byte & 0x01) ? BITPOL_ONE : BITPOL_ZERO)
-                              | CMD_COMM | FUNCTSEL_BIT | USpeed[portnum] |
+                              | CMD_COMM | FUNCTSEL_BIT | port->USpeed |
                               ((i == 7) ? PRIME5V_TRUE : PRIME5V_FALSE);
       temp_byte >>= 1;
    }
@@ -690,7 +734,8 @@ SMALLINT owReadBytePower(int portnum)
          if ((readbuffer[0] & 0x81) == 0)
          {
             // indicate the port is now at power delivery
-            ULevel[portnum] = MODE_STRONG5;
+            port->ULevel = MODE_STRONG5;
+            owStatsLevel(portnum,MODE_STRONG5);
 
             // reconstruct the return byte
             temp_byte = 0;
@@ -736,14 +781,15 @@ SMALLINT owReadBytePower(int portnum)
 //
 SMALLINT owReadBitPower(int portnum, SMALLINT applyPowerResponse)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[3],readbuffer[3];
    uchar sendlen=0;
    uchar rt=FALSE;
 
    // check if correct mode
-   if (UMode[portnum] != MODSEL_COMMAND)
+   if (port->UMode != MODSEL_COMMAND)
    {
-      UMode[portnum] = MODSEL_COMMAND;
+      port->UMode = MODSEL_COMMAND;
       sendpacket[sendlen++] = MODE_COMMAND;
    }
 
@@ -752,7 +798,7 @@ SMALLINT owReadBitPower(int portnum, SMALLINT applyPowerResponse)
 
    // enabling the strong-pullup after bit
    sendpacket[sendlen++] = BITPOL_ONE
-                           | CMD_COMM | FUNCTSEL_BIT | USpeed[portnum] |
+                           | CMD_COMM | FUNCTSEL_BIT | port->USpeed |
                            PRIME5V_TRUE;
    // flush the buffers
    FlushCOM(portnum);
@@ -767,7 +813,8 @@ SMALLINT owReadBitPower(int portnum, SMALLINT applyPowerResponse)
          if ((readbuffer[0] & 0x81) == 0)
          {
             // indicate the port is now at power delivery
-            ULevel[portnum] = MODE_STRONG5;
+            port->ULevel = MODE_STRONG5;
+            owStatsLevel(portnum,MODE_STRONG5);
 
             // check the response bit
             if ((readbuffer[1] & 0x01) == applyPowerResponse)
@@ -827,5 +874,5 @@ SMALLINT owHasOverDrive(int portnum)
 //           FALSE program voltage not available
 SMALLINT owHasProgramPulse(int portnum)
 {
-   return ProgramAvailable[portnum];
+   return owGetPort(portnum)->ProgramAvailable;
 }
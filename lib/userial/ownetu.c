@@ -37,23 +37,35 @@
 //          2.10 -> 3.00 Added memory bank functionality
 //                       Added file I/O operations
 //                       Updated search functions to be consistent with AN192
+//          3.00 -> 3.01 Added owSearchAll
+//                       Search state moved to the OWPort state
+//          3.01 -> 3.02 Selects and searches end the owsess.c session
+//          3.02 -> 3.03 Searches are timed by owstats.c
+//          3.03 -> 3.04 owSearchAll ends a branch no device answers
+//                       without a search error
 //
 
 #include "ownet.h"
+#include "owsess.h"
+#include "owstats.h"
 #include "ds2480.h"
 
 // local functions defined in ownetu.c
 static SMALLINT bitacc(SMALLINT,SMALLINT,SMALLINT,uchar *);
 
-// global variables for this module to hold search state information
-static int LastDiscrepancy[MAX_PORTNUM];
-static int LastFamilyDiscrepancy[MAX_PORTNUM];
-static uchar LastDevice[MAX_PORTNUM];
-uchar SerialNum[MAX_PORTNUM][8];
+// search passes sent in one packet by owSearchAll
+#define SEARCH_BATCH      8
+// pending branches owSearchAll can hold
+#define SEARCH_STACK      (64 * SEARCH_BATCH + 64)
+
+// a branch of the ROM tree still to search, the first 'forced' bits
+// of 'rom' are the path to it
+typedef struct
+{
+   uchar rom[8];
+   uchar forced;
+} SearchBranch;
 
-// external globals
-extern int UMode[MAX_PORTNUM];
-extern uchar USpeed[MAX_PORTNUM];
 
 //--------------------------------------------------------------------------
 // The 'owFirst' finds the first device on the 1-Wire Net  This function
@@ -76,10 +88,12 @@ extern uchar USpeed[MAX_PORTNUM];
 //
 SMALLINT owFirst(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 {
+   OWPort *port = owGetPort(portnum);
+
    // reset the search state
-   LastDiscrepancy[portnum] = 0;
-   LastDevice[portnum] = FALSE;
-   LastFamilyDiscrepancy[portnum] = 0;
+   port->LastDiscrepancy = 0;
+   port->LastDevice = FALSE;
+   port->LastFamilyDiscrepancy = 0;
 
    return owNext(portnum, do_reset, alarm_only);
 }
@@ -109,22 +123,29 @@ SMALLINT owFirst(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 //
 SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 {
+   OWPort *port = owGetPort(portnum);
    uchar last_zero,pos;
    uchar tmp_serial_num[8];
    uchar readbuffer[20],sendpacket[40];
    uchar i,sendlen=0;
    uchar lastcrc8;
+   long long start;
+
+   // a search deselects the device of the session
+   owSessionEnd(portnum);
 
    // if the last call was the last one
-   if (LastDevice[portnum])
+   if (port->LastDevice)
    {
       // reset the search
-      LastDiscrepancy[portnum] = 0;
-      LastDevice[portnum] = FALSE;
-      LastFamilyDiscrepancy[portnum] = 0;
+      port->LastDiscrepancy = 0;
+      port->LastDevice = FALSE;
+      port->LastFamilyDiscrepancy = 0;
       return FALSE;
    }
 
+   start = owStatsStart(portnum);
+
    // check if reset first is requested
    if (do_reset)
    {
@@ -133,9 +154,10 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
       if (!owTouchReset(portnum))
       {
          // reset the search
-         LastDiscrepancy[portnum] = 0;
-         LastFamilyDiscrepancy[portnum] = 0;
+         port->LastDiscrepancy = 0;
+         port->LastFamilyDiscrepancy = 0;
          OWERROR(OWERROR_NO_DEVICES_ON_NET);
+         owStatsEnd(portnum,OWSTAT_SEARCH,start,FALSE);
          return FALSE;
       }
    }
@@ -143,9 +165,9 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
    // build the command stream
    // call a function that may add the change mode command to the buff
    // check if correct mode
-   if (UMode[portnum] != MODSEL_DATA)
+   if (port->UMode != MODSEL_DATA)
    {
-      UMode[portnum] = MODSEL_DATA;
+      port->UMode = MODSEL_DATA;
       sendpacket[sendlen++] = MODE_DATA;
    }
 
@@ -156,14 +178,14 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
       sendpacket[sendlen++] = 0xF0; // issue the search command
 
    // change back to command mode
-   UMode[portnum] = MODSEL_COMMAND;
+   port->UMode = MODSEL_COMMAND;
    sendpacket[sendlen++] = MODE_COMMAND;
 
    // search mode on
-   sendpacket[sendlen++] = (uchar)(CMD_COMM | FUNCTSEL_SEARCHON | USpeed[portnum]);
+   sendpacket[sendlen++] = (uchar)(CMD_COMM | FUNCTSEL_SEARCHON | port->USpeed);
 
    // change back to data mode
-   UMode[portnum] = MODSEL_DATA;
+   port->UMode = MODSEL_DATA;
    sendpacket[sendlen++] = MODE_DATA;
 
    // set the temp Last Descrep to none
@@ -175,19 +197,19 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
       sendpacket[sendlen++] = 0;
 
    // only modify bits if not the first search
-   if (LastDiscrepancy[portnum] != 0)
+   if (port->LastDiscrepancy != 0)
    {
       // set the bits in the added buffer
       for (i = 0; i < 64; i++)
       {
          // before last discrepancy
-         if (i < (LastDiscrepancy[portnum] - 1))
+         if (i < (port->LastDiscrepancy - 1))
                bitacc(WRITE_FUNCTION,
-                   bitacc(READ_FUNCTION,0,i,&SerialNum[portnum][0]),
+                   bitacc(READ_FUNCTION,0,i,&port->SerialNum[0]),
                    (short)(i * 2 + 1),
                    &sendpacket[pos]);
          // at last discrepancy
-         else if (i == (LastDiscrepancy[portnum] - 1))
+         else if (i == (port->LastDiscrepancy - 1))
                 bitacc(WRITE_FUNCTION,1,
                    (short)(i * 2 + 1),
                    &sendpacket[pos]);
@@ -196,11 +218,11 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
    }
 
    // change back to command mode
-   UMode[portnum] = MODSEL_COMMAND;
+   port->UMode = MODSEL_COMMAND;
    sendpacket[sendlen++] = MODE_COMMAND;
 
    // search OFF
-   sendpacket[sendlen++] = (uchar)(CMD_COMM | FUNCTSEL_SEARCHOFF | USpeed[portnum]);
+   sendpacket[sendlen++] = (uchar)(CMD_COMM | FUNCTSEL_SEARCHOFF | port->USpeed);
 
    // flush the buffers
    FlushCOM(portnum);
@@ -226,7 +248,7 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
                last_zero = i + 1;
                // check LastFamilyDiscrepancy
                if (i < 8)
-                  LastFamilyDiscrepancy[portnum] = i + 1;
+                  port->LastFamilyDiscrepancy = i + 1;
             }
          }
 
@@ -236,31 +258,33 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
             lastcrc8 = docrc8(portnum,tmp_serial_num[i]);
 
          // check results
-         if ((lastcrc8 != 0) || (LastDiscrepancy[portnum] == 63) || (tmp_serial_num[0] == 0))
+         if ((lastcrc8 != 0) || (port->LastDiscrepancy == 63) || (tmp_serial_num[0] == 0))
          {
             // error during search
             // reset the search
-            LastDiscrepancy[portnum] = 0;
-            LastDevice[portnum] = FALSE;
-            LastFamilyDiscrepancy[portnum] = 0;
+            port->LastDiscrepancy = 0;
+            port->LastDevice = FALSE;
+            port->LastFamilyDiscrepancy = 0;
             OWERROR(OWERROR_SEARCH_ERROR);
+            owStatsEnd(portnum,OWSTAT_SEARCH,start,FALSE);
             return FALSE;
          }
          // successful search
          else
          {
             // set the last discrepancy
-            LastDiscrepancy[portnum] = last_zero;
+            port->LastDiscrepancy = last_zero;
 
             // check for last device 
-            if (LastDiscrepancy[portnum] == 0)
-               LastDevice[portnum] = TRUE;
+            if (port->LastDiscrepancy == 0)
+               port->LastDevice = TRUE;
 
             // copy the SerialNum to the buffer
             for (i = 0; i < 8; i++)
-               SerialNum[portnum][i] = tmp_serial_num[i];
+               port->SerialNum[i] = tmp_serial_num[i];
 
             // set the count
+            owStatsEnd(portnum,OWSTAT_SEARCH,start,TRUE);
             return TRUE;
          }
       }
@@ -274,13 +298,231 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
    DS2480Detect(portnum);
 
    // reset the search
-   LastDiscrepancy[portnum] = 0;
-   LastDevice[portnum] = FALSE;
-   LastFamilyDiscrepancy[portnum] = 0;
+   port->LastDiscrepancy = 0;
+   port->LastDevice = FALSE;
+   port->LastFamilyDiscrepancy = 0;
 
+   owStatsEnd(portnum,OWSTAT_SEARCH,start,FALSE);
    return FALSE;
 }
 
+//--------------------------------------------------------------------------
+// The 'owSearchAll' function finds every device on the 1-Wire Net (or
+// every device of one family) in one call.  The ROM tree is walked depth
+// first: each search pass follows a known branch and every discrepancy
+// where the '0' path was taken is kept as a new branch, so each device
+// costs exactly one search pass.  The reset is sent in the same DS2480
+// packet as the search and up to SEARCH_BATCH branches are sent in one
+// serial packet.  The search state used by 'owNext' is reset and
+// SerialNum is left as the last device found.
+//
+// 'portnum'       - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                   OpenCOM to indicate the port number.
+// 'ROMs'          - array to receive the serial numbers found
+// 'max'           - number of entries in 'ROMs'
+// 'search_family' - family code to limit the search to or 0 for all
+//                   devices
+// 'alarm_only'    - TRUE (1) the find alarm command 0xEC is
+//                   sent instead of the normal search command 0xF0
+//
+// Returns:   number of devices placed in 'ROMs'
+//
+int owSearchAll(int portnum, uchar ROMs[][8], int max, SMALLINT search_family,
+                SMALLINT alarm_only)
+{
+   OWPort *port = owGetPort(portnum);
+   SearchBranch stack[SEARCH_STACK],batch[SEARCH_BATCH];
+   uchar sendpacket[SEARCH_BATCH * 26],readbuffer[SEARCH_BATCH * 18];
+   uchar rom[8],*rb,lastcrc8=0;
+   int top,found=0,presence=FALSE,nbatch,sendlen,pos,i,b;
+   long long start;
+
+   // a search deselects the device of the session
+   owSessionEnd(portnum);
+
+   // reset the search state
+   port->LastDiscrepancy = 0;
+   port->LastDevice = FALSE;
+   port->LastFamilyDiscrepancy = 0;
+
+   if (max <= 0)
+      return 0;
+
+   start = owStatsStart(portnum);
+
+   // start at the root of the tree or at the family branch
+   for (i = 0; i < 8; i++)
+      stack[0].rom[i] = 0;
+   stack[0].forced = 0;
+   if (search_family)
+   {
+      stack[0].rom[0] = (uchar)search_family;
+      stack[0].forced = 8;
+   }
+   top = 1;
+
+   // make sure normal level
+   owLevel(portnum,MODE_NORMAL);
+
+   while ((top > 0) && (found < max))
+   {
+      // take the deepest branches, leaving room for what they can add
+      nbatch = 0;
+      do
+         batch[nbatch++] = stack[--top];
+      while ((top > 0) && (nbatch < SEARCH_BATCH) && ((found + nbatch) < max) &&
+             ((top - 1 + (nbatch + 1) * 64) <= SEARCH_STACK));
+
+      // build the command stream, one reset and search for each branch
+      sendlen = 0;
+      for (b = 0; b < nbatch; b++)
+      {
+         // check if correct mode
+         if (port->UMode != MODSEL_COMMAND)
+         {
+            port->UMode = MODSEL_COMMAND;
+            sendpacket[sendlen++] = MODE_COMMAND;
+         }
+
+         // reset
+         sendpacket[sendlen++] = (uchar)(CMD_COMM | FUNCTSEL_RESET | port->USpeed);
+
+         // search command
+         port->UMode = MODSEL_DATA;
+         sendpacket[sendlen++] = MODE_DATA;
+         sendpacket[sendlen++] = (alarm_only) ? 0xEC : 0xF0;
+
+         // search mode on
+         port->UMode = MODSEL_COMMAND;
+         sendpacket[sendlen++] = MODE_COMMAND;
+         sendpacket[sendlen++] = (uchar)(CMD_COMM | FUNCTSEL_SEARCHON | port->USpeed);
+
+         // the 16 bytes of the search with the forced path
+         port->UMode = MODSEL_DATA;
+         sendpacket[sendlen++] = MODE_DATA;
+         pos = sendlen;
+         for (i = 0; i < 16; i++)
+            sendpacket[sendlen++] = 0;
+         for (i = 0; i < batch[b].forced; i++)
+            bitacc(WRITE_FUNCTION,
+                   bitacc(READ_FUNCTION,0,(short)i,&batch[b].rom[0]),
+                   (short)(i * 2 + 1),
+                   &sendpacket[pos]);
+
+         // search OFF
+         port->UMode = MODSEL_COMMAND;
+         sendpacket[sendlen++] = MODE_COMMAND;
+         sendpacket[sendlen++] = (uchar)(CMD_COMM | FUNCTSEL_SEARCHOFF | port->USpeed);
+      }
+
+      // flush the buffers
+      FlushCOM(portnum);
+
+      // send the packet and read the reset, search echo and 16 bytes of each
+      if (!WriteCOM(portnum,sendlen,sendpacket))
+      {
+         OWERROR(OWERROR_WRITECOM_FAILED);
+         DS2480Detect(portnum);
+         break;
+      }
+      if (ReadCOM(portnum,nbatch * 18,readbuffer) != (nbatch * 18))
+      {
+         OWERROR(OWERROR_READCOM_FAILED);
+         DS2480Detect(portnum);
+         break;
+      }
+
+      for (b = 0; b < nbatch; b++)
+      {
+         rb = &readbuffer[b * 18];
+
+         // no presence (device left the 1-Wire)
+         if (((rb[0] & RB_RESET_MASK) != RB_PRESENCE) &&
+             ((rb[0] & RB_RESET_MASK) != RB_ALARMPRESENCE))
+            continue;
+         presence = TRUE;
+
+         // interpret the bit stream
+         setcrc8(portnum,0);
+         for (i = 0; i < 64; i++)
+            bitacc(WRITE_FUNCTION,
+                   bitacc(READ_FUNCTION,0,(short)(i * 2 + 1),&rb[2]),
+                   (short)i,
+                   &rom[0]);
+         for (i = 0; i < 8; i++)
+            lastcrc8 = docrc8(portnum,rom[i]);
+
+         // nothing answered (no alarming device or no such family)
+         for (i = 0; i < 8; i++)
+            if (rom[i] != 0xFF)
+               break;
+         if (i == 8)
+            continue;
+
+         // the family branch does not exist, the search ended with no match
+         if (search_family && (rom[0] != (uchar)search_family))
+            continue;
+
+         // no device took the forced path, every bit after the devices
+         // stopped answering reads as a discrepancy
+         if (lastcrc8 != 0)
+         {
+            for (i = 63; i >= 0; i--)
+               if (bitacc(READ_FUNCTION,0,(short)(i * 2),&rb[2]) != 1)
+                  break;
+            if (i < batch[b].forced)
+               continue;
+         }
+
+         // only a ROM that was accepted has its CRC checked
+         if ((lastcrc8 != 0) || (rom[0] == 0))
+         {
+            OWERROR(OWERROR_SEARCH_ERROR);
+            continue;
+         }
+
+         // add a branch for each discrepancy past the forced path
+         // where the '0' path was taken, deepest ends up on top
+         for (i = batch[b].forced; i < 64; i++)
+         {
+            if ((bitacc(READ_FUNCTION,0,(short)(i * 2),&rb[2]) == 1) &&
+                (bitacc(READ_FUNCTION,0,(short)(i * 2 + 1),&rb[2]) == 0))
+            {
+               if (top >= SEARCH_STACK)
+               {
+                  OWERROR(OWERROR_SEARCH_ERROR);
+                  break;
+               }
+               for (pos = 0; pos < 8; pos++)
+                  stack[top].rom[pos] = rom[pos];
+               bitacc(WRITE_FUNCTION,1,(short)i,&stack[top].rom[0]);
+               stack[top].forced = (uchar)(i + 1);
+               top++;
+            }
+         }
+
+         // record the device
+         if (found < max)
+         {
+            for (i = 0; i < 8; i++)
+               ROMs[found][i] = rom[i];
+            found++;
+         }
+      }
+   }
+
+   if (found > 0)
+   {
+      for (i = 0; i < 8; i++)
+         port->SerialNum[i] = ROMs[found - 1][i];
+   }
+   else if (!presence)
+      OWERROR(OWERROR_NO_DEVICES_ON_NET);
+
+   owStatsEnd(portnum,OWSTAT_SEARCH,start,(found > 0));
+   return found;
+}
+
 //--------------------------------------------------------------------------
 // The 'owSerialNum' function either reads or sets the SerialNum buffer
 // that is used in the search functions 'owFirst' and 'owNext'.
@@ -301,19 +543,20 @@ SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 //
 void owSerialNum(int portnum, uchar *serialnum_buf, SMALLINT do_read)
 {
+   OWPort *port = owGetPort(portnum);
    uchar i;
 
    // read the internal buffer and place in 'serialnum_buf'
    if (do_read)
    {
       for (i = 0; i < 8; i++)
-         serialnum_buf[i] = SerialNum[portnum][i];
+         serialnum_buf[i] = port->SerialNum[i];
    }
    // set the internal buffer from the data in 'serialnum_buf'
    else
    {
       for (i = 0; i < 8; i++)
-         SerialNum[portnum][i] = serialnum_buf[i];
+         port->SerialNum[i] = serialnum_buf[i];
    }
 }
 
@@ -328,15 +571,16 @@ void owSerialNum(int portnum, uchar *serialnum_buf, SMALLINT do_read)
 //
 void owFamilySearchSetup(int portnum, SMALLINT search_family)
 {
+   OWPort *port = owGetPort(portnum);
    uchar i;
 
    // set the search state to find search_family type devices
-   SerialNum[portnum][0] = search_family;
+   port->SerialNum[0] = search_family;
    for (i = 1; i < 8; i++)
-      SerialNum[portnum][i] = 0;
-   LastDiscrepancy[portnum] = 64;
-   LastFamilyDiscrepancy[portnum] = 0;
-   LastDevice[portnum] = FALSE;
+      port->SerialNum[i] = 0;
+   port->LastDiscrepancy = 64;
+   port->LastFamilyDiscrepancy = 0;
+   port->LastDevice = FALSE;
 }
 
 //--------------------------------------------------------------------------
@@ -347,15 +591,17 @@ void owFamilySearchSetup(int portnum, SMALLINT search_family)
 //
 void owSkipFamily(int portnum)
 {
+   OWPort *port = owGetPort(portnum);
+
    // set the Last discrepancy to last family discrepancy
-   LastDiscrepancy[portnum] = LastFamilyDiscrepancy[portnum];
+   port->LastDiscrepancy = port->LastFamilyDiscrepancy;
 
    // clear the last family discrpepancy
-   LastFamilyDiscrepancy[portnum] = 0;
+   port->LastFamilyDiscrepancy = 0;
 
    // check for end of list
-   if (LastDiscrepancy[portnum] == 0)
-      LastDevice[portnum] = TRUE;
+   if (port->LastDiscrepancy == 0)
+      port->LastDevice = TRUE;
 }
 
 //--------------------------------------------------------------------------
@@ -374,9 +620,13 @@ void owSkipFamily(int portnum)
 //
 SMALLINT owAccess(int portnum)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[9];
    uchar i;
 
+   // this select ends the session
+   owSessionEnd(portnum);
+
    // reset the 1-wire
    if (owTouchReset(portnum))
    {
@@ -385,14 +635,14 @@ SMALLINT owAccess(int portnum)
       sendpacket[0] = 0x55;
       // Serial Number
       for (i = 1; i < 9; i++)
-         sendpacket[i] = SerialNum[portnum][i-1];
+         sendpacket[i] = port->SerialNum[i-1];
 
       // send/recieve the transfer buffer
       if (owBlock(portnum,FALSE,sendpacket,9))
       {
          // verify that the echo of the writes was correct
          for (i = 1; i < 9; i++)
-            if (sendpacket[i] != SerialNum[portnum][i-1])
+            if (sendpacket[i] != port->SerialNum[i-1])
                return FALSE;
          if (sendpacket[0] != 0x55)
          {
@@ -437,9 +687,13 @@ SMALLINT owAccess(int portnum)
 //
 SMALLINT owVerify(int portnum, SMALLINT alarm_only)
 {
+   OWPort *port = owGetPort(portnum);
    uchar i,sendlen=0,goodbits=0,cnt=0,s,tst;
    uchar sendpacket[50];
 
+   // this search ends the session
+   owSessionEnd(portnum);
+
    // construct the search rom
    if (alarm_only)
       sendpacket[sendlen++] = 0xEC; // issue the alarming search command
@@ -450,7 +704,7 @@ SMALLINT owVerify(int portnum, SMALLINT alarm_only)
       sendpacket[sendlen++] = 0xFF;
    // now set or clear apropriate bits for search
    for (i = 0; i < 64; i++)
-      bitacc(WRITE_FUNCTION,bitacc(READ_FUNCTION,0,i,&SerialNum[portnum][0]),(int)((i+1)*3-1),&sendpacket[1]);
+      bitacc(WRITE_FUNCTION,bitacc(READ_FUNCTION,0,i,&port->SerialNum[0]),(int)((i+1)*3-1),&sendpacket[1]);
 
    // send/recieve the transfer buffer
    if (owBlock(portnum,TRUE,sendpacket,sendlen))
@@ -461,7 +715,7 @@ SMALLINT owVerify(int portnum, SMALLINT alarm_only)
          tst = (bitacc(READ_FUNCTION,0,i,&sendpacket[1]) << 1) |
                 bitacc(READ_FUNCTION,0,(int)(i+1),&sendpacket[1]);
 
-         s = bitacc(READ_FUNCTION,0,cnt++,&SerialNum[portnum][0]);
+         s = bitacc(READ_FUNCTION,0,cnt++,&port->SerialNum[0]);
 
          if (tst == 0x03)  // no device on line
          {
@@ -501,9 +755,13 @@ SMALLINT owVerify(int portnum, SMALLINT alarm_only)
 //
 SMALLINT owOverdriveAccess(int portnum)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[8];
    uchar i, bad_echo = FALSE;
 
+   // this select ends the session
+   owSessionEnd(portnum);
+
    // make sure normal level
    owLevel(portnum,MODE_NORMAL);
 
@@ -522,14 +780,14 @@ SMALLINT owOverdriveAccess(int portnum)
          // create a buffer to use with block function
          // Serial Number
          for (i = 0; i < 8; i++)
-            sendpacket[i] = SerialNum[portnum][i];
+            sendpacket[i] = port->SerialNum[i];
 
          // send/recieve the transfer buffer
          if (owBlock(portnum,FALSE,sendpacket,8))
          {
             // verify that the echo of the writes was correct
             for (i = 0; i < 8; i++)
-               if (sendpacket[i] != SerialNum[portnum][i])
+               if (sendpacket[i] != port->SerialNum[i])
                   bad_echo = TRUE;
             // if echo ok then success
             if (!bad_echo)
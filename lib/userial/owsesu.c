@@ -34,6 +34,7 @@
 //          2.01 -> 2.10 Added raw memory error handling and SMALLINT
 //          2.10 -> 3.00 Added memory bank functionality
 //                       Added file I/O operations
+//          3.00 -> 3.01 Added owAcquireExBaud
 //
 
 #include "ownet.h"
@@ -104,6 +105,31 @@ int owAcquireEx(char *port_zstr)
    return portnum;
 }
 
+//---------------------------------------------------------------------------
+// Attempt to acquire a 1-Wire net using a com port and a DS2480 based
+// adapter, then negotiate the highest baud rate up to 'max_baud' that
+// the adapter and serial link pass a loopback at.  The rate is restored
+// by DS2480Detect after a re-sync and lowered if it stops working.
+//
+// 'port_zstr'  - zero terminated port name.  For this platform
+//                use format COMX where X is the port number.
+// 'max_baud'   - highest rate to try, PARMSET_9600 to PARMSET_115200
+//                (MAX_BAUD is the platform default)
+//
+// Returns: valid handle, or -1 if an error occurred
+//
+int owAcquireExBaud(char *port_zstr, SMALLINT max_baud)
+{
+   int portnum;
+
+   if ((portnum = owAcquireEx(port_zstr)) < 0)
+      return -1;
+
+   DS2480MaxBaud(portnum,(uchar)max_baud);
+
+   return portnum;
+}
+
 //---------------------------------------------------------------------------
 // Release the previously acquired a 1-Wire net.
 //
@@ -27,7 +27,7 @@
 //  owTranU.C - Transport functions for 1-Wire Net
 //              using the DS2480B (U) serial interface chip.
 //
-//  Version: 2.01
+//  Version: 3.04
 //
 //  History: 1.02 -> 1.03  Removed caps in #includes for Linux capatibility
 //           1.03 -> 2.00  Changed 'MLan' to 'ow'. Added support for
@@ -37,19 +37,38 @@
 //                         handling plus the raw memory utilities.
 //           2.10 -> 3.00 Added memory bank functionality
 //                        Added file I/O operations
+//           3.00 -> 3.01 DS2480B state moved to the OWPort state
+//                        owReadPacketStd uses crc16_block
+//                        Added owTxnExecute
+//                        Added owTxnPipeline
+//           3.01 -> 3.02 owBlock and the transactions are timed by owstats.c
+//           3.02 -> 3.03 Transaction delays are timed from the end of the
+//                        exchange before them with usDelayUntil
+//           3.03 -> 3.04 A reset step in a transaction ends the owsess.c
+//                        session like a ROM step does
 //
 
+#include <string.h>
 #include "ownet.h"
+#include "owtxn.h"
+#include "owsess.h"
+#include "owstats.h"
+#include "owtime.h"
 #include "ds2480.h"
-// external defined in ds2480ut.c
-extern SMALLINT UBaud[MAX_PORTNUM];
-extern SMALLINT UMode[MAX_PORTNUM];
-extern SMALLINT USpeed[MAX_PORTNUM];
-extern uchar SerialNum[MAX_PORTNUM][8];
+
+// size of the packet and response buffers of owTxnExecute and
+// owTxnPipeline, room for a doubled byte for each transaction byte plus
+// the mode switches, stop pulse and power commands of each step.  This
+// is a limit of this file, not of the DS2480B, which runs the commands
+// as they come in and has no packet buffer to fill.
+#define TXN_PACKET_MAX     (OWTXN_MAX_BYTES * 2 + OWTXN_MAX_STEPS * 14)
+#define TXN_RESPONSE_MAX   (OWTXN_MAX_BYTES + OWTXN_MAX_STEPS * 11)
 
 // local static functions
 static SMALLINT Write_Scratchpad(int,uchar *,int,SMALLINT);
 static SMALLINT Copy_Scratchpad(int,int,SMALLINT);
+static int TxnPacket(int,OWTxn *,int,int *,SMALLINT *,uchar *,int *);
+static int TxnResponse(int,OWTxn *,int,int,SMALLINT *,uchar *,SMALLINT *);
 
 //--------------------------------------------------------------------------
 // The 'owBlock' transfers a block of data to and from the
@@ -77,8 +96,10 @@ static SMALLINT Copy_Scratchpad(int,int,SMALLINT);
 //
 SMALLINT owBlock(int portnum, SMALLINT do_reset, uchar *tran_buf, SMALLINT tran_len)
 {
+   OWPort *port = owGetPort(portnum);
    uchar sendpacket[320];
    uchar sendlen=0,pos,i;
+   long long start;
 
    // check for a block too big
    if (tran_len > 160)
@@ -87,21 +108,24 @@ SMALLINT owBlock(int portnum, SMALLINT do_reset, uchar *tran_buf, SMALLINT tran_
       return FALSE;
    }
 
+   start = owStatsStart(portnum);
+
    // check if need to do a owTouchReset first
    if (do_reset)
    {
       if (!owTouchReset(portnum))
       {
          OWERROR(OWERROR_NO_DEVICES_ON_NET);
+         owStatsEnd(portnum,OWSTAT_BLOCK,start,FALSE);
          return FALSE;
       }
    }
 
    // construct the packet to send to the DS2480
    // check if correct mode
-   if (UMode[portnum] != MODSEL_DATA)
+   if (port->UMode != MODSEL_DATA)
    {
-      UMode[portnum] = MODSEL_DATA;
+      port->UMode = MODSEL_DATA;
       sendpacket[sendlen++] = MODE_DATA;
    }
 
@@ -124,7 +148,10 @@ SMALLINT owBlock(int portnum, SMALLINT do_reset, uchar *tran_buf, SMALLINT tran_
    {
       // read back the response
       if (ReadCOM(portnum,tran_len,tran_buf) == tran_len)
+      {
+         owStatsEnd(portnum,OWSTAT_BLOCK,start,TRUE);
          return TRUE;
+      }
       else
          OWERROR(OWERROR_READCOM_FAILED);
    }
@@ -134,6 +161,7 @@ SMALLINT owBlock(int portnum, SMALLINT do_reset, uchar *tran_buf, SMALLINT tran_
    // an error occured so re-sync with DS2480
    DS2480Detect(portnum);
 
+   owStatsEnd(portnum,OWSTAT_BLOCK,start,FALSE);
    return FALSE;
 }
 
@@ -171,6 +199,7 @@ SMALLINT owBlock(int portnum, SMALLINT do_reset, uchar *tran_buf, SMALLINT tran_
 //
 SMALLINT owReadPacketStd(int portnum, SMALLINT do_access, int start_page, uchar *read_buf)
 {
+   OWPort *port = owGetPort(portnum);
    uchar i,length,sendlen=0,head_len=0;
    uchar sendpacket[50];
    ushort lastcrc16;
@@ -182,14 +211,14 @@ SMALLINT owReadPacketStd(int portnum, SMALLINT do_access, int start_page, uchar
       // match command
       sendpacket[sendlen++] = 0x55;
       for (i = 0; i < 8; i++)
-         sendpacket[sendlen++] = SerialNum[portnum][i];
+         sendpacket[sendlen++] = port->SerialNum[i];
       // read memory command
       sendpacket[sendlen++] = 0xF0;
       // write the target address
       sendpacket[sendlen++] = ((start_page << 5) & 0xFF);
       sendpacket[sendlen++] = (start_page >> 3);
       // check for DS1982 exception (redirection byte)
-      if (SerialNum[portnum][0] == 0x09)
+      if (port->SerialNum[0] == 0x09)
          sendpacket[sendlen++] = 0xFF;
       // record the header length
       head_len = sendlen;
@@ -201,26 +230,19 @@ SMALLINT owReadPacketStd(int portnum, SMALLINT do_access, int start_page, uchar
    // send/recieve the transfer buffer
    if (owBlock(portnum,do_access,sendpacket,sendlen))
    {
-      // seed crc with page number
-      setcrc16(portnum,(ushort)start_page);
-
       // attempt to read UDP from sendpacket
       length = sendpacket[head_len];
-      docrc16(portnum,(ushort)length);
 
       // verify length is not too large
       if (length <= 29)
       {
          // loop to read packet including CRC
          for (i = 0; i < length; i++)
-         {
              read_buf[i] = sendpacket[i+1+head_len];
-             docrc16(portnum,read_buf[i]);
-         }
 
-         // read and compute the CRC16
-         docrc16(portnum,sendpacket[i+1+head_len]);
-         lastcrc16 = docrc16(portnum,sendpacket[i+2+head_len]);
+         // compute the CRC16 over the length, data and CRC seeded
+         // with the page number
+         lastcrc16 = crc16_block((ushort)start_page,&sendpacket[head_len],length + 3);
 
          // verify the CRC16 is correct
          if (lastcrc16 == 0xB001)
@@ -238,6 +260,429 @@ SMALLINT owReadPacketStd(int portnum, SMALLINT do_access, int start_page, uchar
    return -1;
 }
 
+//--------------------------------------------------------------------------
+// Run a transaction built with the owTxn functions.  Every run of steps
+// up to a delay is sent to the DS2480B as one packet and all of the
+// responses are read back with one ReadCOM, so a reset, Match ROM,
+// command and read is a single exchange instead of three.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+// 'txn'      - transaction to run, the bytes read replace the bytes
+//              written in its buffer
+//
+// Returns:  TRUE (1)  : every step ran and every CRC checked is good
+//           FALSE (0) : a step failed, see owTxnStatus
+//
+SMALLINT owTxnExecute(int portnum, OWTxn *txn)
+{
+   OWPort *port = owGetPort(portnum);
+   uchar sendpacket[TXN_PACKET_MAX];
+   uchar readbuffer[TXN_RESPONSE_MAX];
+   int first,last,i,sendlen,rdlen;
+   SMALLINT level,rt,failed = FALSE;
+   long long start,done;
+
+   if (txn->overflow)
+   {
+      OWERROR(OWERROR_BLOCK_TOO_BIG);
+      return FALSE;
+   }
+
+   start = owStatsStart(portnum);
+
+   // a reset or ROM function in the transaction deselects the session
+   // device
+   for (i = 0; i < txn->nsteps; i++)
+      if (txn->step[i].rom || (txn->step[i].type == OWTXN_RESET))
+      {
+         owSessionEnd(portnum);
+         break;
+      }
+
+   // when the last exchange (or delay) finished
+   done = usGettick();
+
+   for (first = 0; first < txn->nsteps; first = last)
+   {
+      // a delay is counted from the end of the exchange before it,
+      // which is when a conversion or copy started
+      if (txn->step[first].type == OWTXN_DELAY)
+      {
+         done += (long long)txn->step[first].ms * 1000;
+         usDelayUntil(done);
+         txn->step[first].status = OWTXN_OK;
+         last = first + 1;
+         continue;
+      }
+
+      // a DS2404 alarm reset needs the wait in owTouchReset
+      if (FAMILY_CODE_04_ALARM_TOUCHRESET_COMPLIANCE && 
+          (txn->step[first].type == OWTXN_RESET))
+      {
+         if (!owTouchReset(portnum))
+         {
+            txn->step[first].status = OWTXN_NO_PRESENCE;
+            owStatsEnd(portnum,OWSTAT_TXN,start,FALSE);
+            return owTxnVerify(txn);
+         }
+         done = usGettick();
+         txn->step[first].status = OWTXN_OK;
+         last = first + 1;
+         continue;
+      }
+
+      // construct the packet for the steps up to the next delay
+      sendlen = 0;
+      level = port->ULevel;
+      rdlen = TxnPacket(portnum,txn,first,&last,&level,sendpacket,&sendlen);
+
+      // flush the buffers
+      FlushCOM(portnum);
+
+      // send the packet and read back all of the responses
+      if (!WriteCOM(portnum,sendlen,sendpacket))
+      {
+         OWERROR(OWERROR_WRITECOM_FAILED);
+         break;
+      }
+      if (ReadCOM(portnum,rdlen,readbuffer) != rdlen)
+      {
+         OWERROR(OWERROR_READCOM_FAILED);
+         break;
+      }
+      done = usGettick();
+
+      // pick the responses apart
+      level = port->ULevel;
+      TxnResponse(portnum,txn,first,last,&level,readbuffer,&failed);
+
+      // do not go on to the next run after a step failed
+      if (failed)
+      {
+         owStatsEnd(portnum,OWSTAT_TXN,start,FALSE);
+         return owTxnVerify(txn);
+      }
+   }
+
+   // a link failure leaves the rest of the steps not run
+   if (first < txn->nsteps)
+   {
+      for (i = first; i < txn->nsteps; i++)
+         txn->step[i].status = OWTXN_LINK_ERROR;
+
+      // an error occured so re-sync with DS2480
+      DS2480Detect(portnum);
+      owStatsEnd(portnum,OWSTAT_TXN,start,FALSE);
+      return FALSE;
+   }
+
+   rt = owTxnVerify(txn);
+   owStatsEnd(portnum,OWSTAT_TXN,start,rt);
+   return rt;
+}
+
+//--------------------------------------------------------------------------
+// Run several independent transactions back to back.  The packets of as
+// many transactions as fit in TXN_PACKET_MAX bytes are sent with one
+// WriteCOM and their responses are read with one ReadCOM, so there is
+// no turn around between them.  A transaction with a delay step (or
+// any transaction when the DS2404 reset compliance is on) is run on its
+// own with owTxnExecute.
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number was provided to
+//              OpenCOM to indicate the port number.
+// 'txns'     - transactions to run, the results are in each one as if
+//              it was run by owTxnExecute
+// 'num'      - number of transactions
+//
+// Returns:  number of transactions that ran with every CRC good
+//
+int owTxnPipeline(int portnum, OWTxn **txns, int num)
+{
+   OWPort *port = owGetPort(portnum);
+   uchar sendpacket[TXN_PACKET_MAX];
+   uchar readbuffer[TXN_RESPONSE_MAX];
+   int first,last,i,j,k,sendlen,rdlen,pos,good = 0;
+   SMALLINT level,failed,alone;
+   long long start;
+
+   for (first = 0; first < num; first = last)
+   {
+      // take the transactions that fit in one packet
+      sendlen = 0;
+      rdlen = 0;
+      level = port->ULevel;
+      for (last = first; last < num; last++)
+      {
+         OWTxn *txn = txns[last];
+
+         alone = txn->overflow || FAMILY_CODE_04_ALARM_TOUCHRESET_COMPLIANCE;
+         for (i = 0; (i < txn->nsteps) && !alone; i++)
+            if (txn->step[i].type == OWTXN_DELAY)
+               alone = TRUE;
+
+         if (alone)
+         {
+            // run it by itself, after the ones before it
+            if (last == first)
+            {
+               if (owTxnExecute(portnum,txn))
+                  good++;
+               last++;
+            }
+            break;
+         }
+
+         // worst case size of its packet and response
+         if ((sendlen + txn->len * 2 + txn->nsteps * 14 > TXN_PACKET_MAX) ||
+             (rdlen + txn->len + txn->nsteps * 11 > TXN_RESPONSE_MAX))
+            break;
+
+         for (i = 0; i < txn->nsteps; i++)
+            if (txn->step[i].rom || (txn->step[i].type == OWTXN_RESET))
+            {
+               owSessionEnd(portnum);
+               break;
+            }
+         rdlen += TxnPacket(portnum,txn,0,&i,&level,sendpacket,&sendlen);
+      }
+
+      if (sendlen == 0)
+         continue;
+
+      // one write and one read for the whole group, timed as one
+      start = owStatsStart(portnum);
+      FlushCOM(portnum);
+      if (!WriteCOM(portnum,sendlen,sendpacket))
+         OWERROR(OWERROR_WRITECOM_FAILED);
+      else if (ReadCOM(portnum,rdlen,readbuffer) != rdlen)
+         OWERROR(OWERROR_READCOM_FAILED);
+      else
+      {
+         pos = 0;
+         level = port->ULevel;
+         for (j = first; j < last; j++)
+         {
+            failed = FALSE;
+            pos += TxnResponse(portnum,txns[j],0,txns[j]->nsteps,&level,
+                               &readbuffer[pos],&failed);
+            if (owTxnVerify(txns[j]))
+               good++;
+         }
+         owStatsEnd(portnum,OWSTAT_TXN,start,TRUE);
+         continue;
+      }
+
+      // link failure, none of the group ran
+      for (j = first; j < last; j++)
+         for (k = 0; k < txns[j]->nsteps; k++)
+            txns[j]->step[k].status = OWTXN_LINK_ERROR;
+
+      // an error occured so re-sync with DS2480
+      DS2480Detect(portnum);
+      owStatsEnd(portnum,OWSTAT_TXN,start,FALSE);
+   }
+
+   return good;
+}
+
+//--------------------------------------------------------------------------
+// Append the DS2480B packet for a run of transaction steps, from 'first'
+// up to the next delay, to 'sendpacket'.  The DS2480B mode is kept in
+// the port state as the packet is built, the 1-Wire level the steps
+// leave is kept in 'level'.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                OpenCOM to indicate the port number.
+// 'txn'        - transaction
+// 'first'      - first step of the run
+// 'last'       - set to the step after the run
+// 'level'      - 1-Wire level before the run, updated
+// 'sendpacket' - packet to append to
+// 'sendlen'    - length of the packet, updated
+//
+// Returns:  number of response bytes the run will give
+//
+static int TxnPacket(int portnum, OWTxn *txn, int first, int *last,
+                     SMALLINT *level, uchar *sendpacket, int *sendlen)
+{
+   OWPort *port = owGetPort(portnum);
+   OWTxnStep *st;
+   uchar temp_byte;
+   int i,j,rdlen = 0,len = *sendlen;
+
+   for (i = first; i < txn->nsteps; i++)
+   {
+      st = &txn->step[i];
+      if ((st->type == OWTXN_DELAY) ||
+          ((i > first) && (st->type == OWTXN_RESET) &&
+           FAMILY_CODE_04_ALARM_TOUCHRESET_COMPLIANCE))
+         break;
+
+      // turn off the strong pull-up before anything else is done
+      if (*level != MODE_NORMAL)
+      {
+         if (port->UMode != MODSEL_COMMAND)
+         {
+            port->UMode = MODSEL_COMMAND;
+            sendpacket[len++] = MODE_COMMAND;
+         }
+         sendpacket[len++] = MODE_STOP_PULSE;
+         sendpacket[len++] = CMD_COMM | FUNCTSEL_CHMOD | SPEEDSEL_PULSE |
+                             BITPOL_5V | PRIME5V_FALSE;
+         sendpacket[len++] = MODE_STOP_PULSE;
+         rdlen += 2;
+         *level = MODE_NORMAL;
+      }
+
+      switch (st->type)
+      {
+         case OWTXN_RESET:
+            if (port->UMode != MODSEL_COMMAND)
+            {
+               port->UMode = MODSEL_COMMAND;
+               sendpacket[len++] = MODE_COMMAND;
+            }
+            sendpacket[len++] = (uchar)(CMD_COMM | FUNCTSEL_RESET | port->USpeed);
+            rdlen++;
+            break;
+
+         case OWTXN_BYTES:
+            if (port->UMode != MODSEL_DATA)
+            {
+               port->UMode = MODSEL_DATA;
+               sendpacket[len++] = MODE_DATA;
+            }
+            for (j = 0; j < st->len; j++)
+            {
+               sendpacket[len++] = txn->buf[st->offset + j];
+
+               // check for duplication of data that looks like COMMAND mode
+               if (txn->buf[st->offset + j] == MODE_COMMAND)
+                  sendpacket[len++] = MODE_COMMAND;
+            }
+            rdlen += st->len;
+            break;
+
+         case OWTXN_POWER:
+            if (port->UMode != MODSEL_COMMAND)
+            {
+               port->UMode = MODSEL_COMMAND;
+               sendpacket[len++] = MODE_COMMAND;
+            }
+            // set the SPUD time value then 8 bit commands with the 
+            // last one enabling the strong-pullup
+            sendpacket[len++] = CMD_CONFIG | PARMSEL_5VPULSE | PARMSET_infinite;
+            temp_byte = txn->buf[st->offset];
+            for (j = 0; j < 8; j++)
+            {
+               sendpacket[len++] = ((temp_byte & 0x01) ? BITPOL_ONE : BITPOL_ZERO)
+                                   | CMD_COMM | FUNCTSEL_BIT | port->USpeed |
+                                   ((j == 7) ? PRIME5V_TRUE : PRIME5V_FALSE);
+               temp_byte >>= 1;
+            }
+            rdlen += 9;
+            *level = MODE_STRONG5;
+            break;
+      }
+   }
+
+   *last = i;
+   *sendlen = len;
+   return rdlen;
+}
+
+//--------------------------------------------------------------------------
+// Pick apart the DS2480B responses of a run of transaction steps built
+// by TxnPacket and set the status of each step.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                OpenCOM to indicate the port number.
+// 'txn'        - transaction
+// 'first'      - first step of the run
+// 'last'       - step after the run
+// 'level'      - 1-Wire level before the run, updated
+// 'readbuffer' - responses of the run
+// 'failed'     - set to TRUE if a step failed
+//
+// Returns:  number of response bytes used
+//
+static int TxnResponse(int portnum, OWTxn *txn, int first, int last,
+                       SMALLINT *level, uchar *readbuffer, SMALLINT *failed)
+{
+   OWPort *port = owGetPort(portnum);
+   OWTxnStep *st;
+   uchar temp_byte;
+   int i,j,pos = 0;
+
+   for (i = first; i < last; i++)
+   {
+      st = &txn->step[i];
+      st->status = OWTXN_OK;
+
+      if (*level != MODE_NORMAL)
+      {
+         if (((readbuffer[pos] & 0xE0) != 0xE0) ||
+             ((readbuffer[pos + 1] & 0xE0) != 0xE0))
+            st->status = OWTXN_LINK_ERROR;
+         else
+         {
+            port->ULevel = MODE_NORMAL;
+            owStatsLevel(portnum,MODE_NORMAL);
+         }
+         pos += 2;
+         *level = MODE_NORMAL;
+      }
+
+      switch (st->type)
+      {
+         case OWTXN_RESET:
+            // make sure this byte looks like a reset byte
+            if (((readbuffer[pos] & RB_RESET_MASK) == RB_PRESENCE) ||
+                ((readbuffer[pos] & RB_RESET_MASK) == RB_ALARMPRESENCE))
+            {
+               port->ProgramAvailable = ((readbuffer[pos] & 0x20) == 0x20);
+               port->UVersion = (readbuffer[pos] & VERSION_MASK);
+            }
+            else if (st->status == OWTXN_OK)
+               st->status = OWTXN_NO_PRESENCE;
+            pos++;
+            break;
+
+         case OWTXN_BYTES:
+            memcpy(&txn->buf[st->offset],&readbuffer[pos],st->len);
+            pos += st->len;
+            break;
+
+         case OWTXN_POWER:
+            // reconstruct the echo byte
+            temp_byte = 0;
+            for (j = 0; j < 8; j++)
+            {
+               temp_byte >>= 1;
+               temp_byte |= (readbuffer[pos + j + 1] & 0x01) ? 0x80 : 0;
+            }
+            if (((readbuffer[pos] & 0x81) != 0) || 
+                (temp_byte != txn->buf[st->offset]))
+               st->status = OWTXN_LINK_ERROR;
+            else
+            {
+               port->ULevel = MODE_STRONG5;
+               owStatsLevel(portnum,MODE_STRONG5);
+            }
+            pos += 9;
+            *level = MODE_STRONG5;
+            break;
+      }
+
+      if (st->status != OWTXN_OK)
+         *failed = TRUE;
+   }
+
+   return pos;
+}
+
 //--------------------------------------------------------------------------
 // Write a Universal Data Packet onto a standard NVRAM 1-Wire device
 // on page 'start_page'.  This function is limited to UDPs that
@@ -478,13 +923,14 @@ SMALLINT owProgramByte(int portnum, SMALLINT write_byte, int addr, SMALLINT writ
 //
 SMALLINT Write_Scratchpad(int portnum, uchar *write_buf, int start_page, SMALLINT write_len)
 {
+   OWPort *port = owGetPort(portnum);
    uchar i,sendlen=0;
    uchar sendpacket[50];
 
    // match command
    sendpacket[sendlen++] = 0x55;
    for (i = 0; i < 8; i++)
-      sendpacket[sendlen++] = SerialNum[portnum][i];
+      sendpacket[sendlen++] = port->SerialNum[i];
    // write scratchpad command
    sendpacket[sendlen++] = 0x0F;
    // write the target address
@@ -503,7 +949,7 @@ SMALLINT Write_Scratchpad(int portnum, uchar *write_buf, int start_page, SMALLIN
       // match command
       sendpacket[sendlen++] = 0x55;
       for (i = 0; i < 8; i++)
-         sendpacket[sendlen++] = SerialNum[portnum][i];
+         sendpacket[sendlen++] = port->SerialNum[i];
       // read scratchpad command
       sendpacket[sendlen++] = 0xAA;
       // read the target address, offset and data
@@ -564,7 +1010,7 @@ SMALLINT Copy_Scratchpad(int portnum, int start_page, SMALLINT write_len)
    // match command
    sendpacket[sendlen++] = 0x55;
    for (i = 0; i < 8; i++)
-      sendpacket[sendlen++] = SerialNum[portnum][i];
+      sendpacket[sendlen++] = owGetPort(portnum)->SerialNum[i];
    // copy scratchpad command
    sendpacket[sendlen++] = 0x55;
    // write the target address